@@ -1,67 +1,217 @@
 #include "BleManager.h"
 #include <cmath> // For isnan and round
 #include <limits> // For INT16_MIN, UINT16_MAX
+#include "wire_protocol.h" // Little-endian helpers
+#include "heap_tracker.h"
+
+static const uint16_t ESS_SERVICE_UUID = 0x181A;
+static const uint16_t TEMPERATURE_CHAR_UUID = 0x2A6E;
+static const uint16_t HUMIDITY_CHAR_UUID = 0x2A6F;
+static const uint16_t ILLUMINANCE_CHAR_UUID = 0x2AFB;
+static const char* NOISE_CHAR_UUID = "5d3c0001-7a4e-4b8e-9a5b-2f6c1d0e5a01";
 
 BleManager::BleManager(DataManager& dataMgr) :
     dataManager_(dataMgr),
-    pAdvertising_(nullptr)
-{}
+    pAdvertising_(nullptr),
+    pServer_(nullptr),
+    connectedClients_(0),
+    history_(dataMgr),
+    extAdvertiser_(companyId_),
+    lastRecordSeq_(0),
+    advertised_(false),
+    extSets_(false),
+    lastAdvUpdate_(0),
+    serverCallbacks_(*this)
+{
+    for (int i = 0; i < CHAR_COUNT; ++i) {
+        chars_[i].characteristic = nullptr;
+        chars_[i].length = 0;
+        chars_[i].valid = false;
+    }
+    memset(manufData_, 0, sizeof(manufData_));
+    memset(advertisedManufData_, 0, sizeof(advertisedManufData_));
+}
 
 void BleManager::begin() {
+    HeapScope heapScope(HEAP_TAG_BLE);
     Serial.println("Initializing BLE...");
     BLEDevice::init("SoundScapeSensor"); // Set BLE device name
-    pAdvertising_ = BLEDevice::getAdvertising();
+    BLEDevice::setMTU(517);              // Largest ATT MTU, for history downloads
+    pServer_ = BLEDevice::createServer();
+    pServer_->setCallbacks(&serverCallbacks_);
+    createService();
+    history_.begin(pServer_);
 
-    // Set advertising parameters directly on the advertising object
-    // advertisementData.setAppearance(0); // Appearance is set on BLEAdvertisementData now
-    pAdvertising_->addServiceUUID(BLEUUID((uint16_t)0x181A)); // Advertise Environmental Sensing Service UUID - Set here
-    // pAdvertising_->setScanResponse(false); // This is usually set on the AdvertisementData object if needed
+    pAdvertising_ = BLEDevice::getAdvertising();
+    pAdvertising_->addServiceUUID(BLEUUID(ESS_SERVICE_UUID)); // Advertise Environmental Sensing Service UUID
 
     bleInitialized_ = true;
     Serial.println("BLE Initialized. Starting Advertising...");
-    updateAdvertisingData(); // Set initial advertising data using the new method
+    // Runs on the boot task while loop() writes the latest record: advertise an empty
+    // record (all values unknown) here, update() on the loop encodes the first real one
+    EnvironmentData unknown;
+    unknown.decibels = unknown.humidity = unknown.temperature = unknown.lux = NAN;
+
+    // The controller rejects legacy advertising commands once extended ones are used, so with
+    // BLE 5 both sets go through BleExtAdvertiser (connectable legacy PDUs on set 0)
+    size_t len = buildAdvertisingPayload(unknown);
+    extSets_ = extAdvertiser_.beginConnectable(advPayload_, len);
+    if (extSets_) {
+        memcpy(advertisedManufData_, manufData_, MANUF_DATA_SIZE);
+        advertised_ = true;
+        extAdvertiser_.begin();  // Second, non-connectable set with per-minute aggregates
+        return;
+    }
+    Serial.println("[BleManager] Legacy advertising only, no per-minute aggregate beacon.");
+    updateAdvertisingData(unknown);
     BLEDevice::startAdvertising();
 }
 
-void BleManager::updateAdvertisingData() {
-    if (!bleInitialized_ || !pAdvertising_) return;
+void BleManager::createService() {
+    BLEService* service = pServer_->createService(BLEUUID(ESS_SERVICE_UUID));
+    const uint32_t props = BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY;
 
-    std::string manufDataStr;
-    buildManufacturerData(manufDataStr);
+    chars_[CHAR_TEMP].characteristic = service->createCharacteristic(BLEUUID(TEMPERATURE_CHAR_UUID), props);
+    chars_[CHAR_HUM].characteristic = service->createCharacteristic(BLEUUID(HUMIDITY_CHAR_UUID), props);
+    chars_[CHAR_LUX].characteristic = service->createCharacteristic(BLEUUID(ILLUMINANCE_CHAR_UUID), props);
+    chars_[CHAR_NOISE].characteristic = service->createCharacteristic(BLEUUID(NOISE_CHAR_UUID), props);
 
-    // Create advertisement data object
-    BLEAdvertisementData advertisementData = BLEAdvertisementData();
+    for (int i = 0; i < CHAR_COUNT; ++i) {
+        chars_[i].characteristic->addDescriptor(new BLE2902()); // CCCD, lets clients enable notifications
+    }
+    BLEDescriptor* noiseDesc = new BLEDescriptor(BLEUUID((uint16_t)0x2901)); // User description
+    noiseDesc->setValue("Noise level (0.01 dB)");
+    chars_[CHAR_NOISE].characteristic->addDescriptor(noiseDesc);
 
-    // Set Flags (0x06 = LE General Discoverable Mode, BR/EDR Not Supported)
-    advertisementData.setFlags(0x06);
+    service->start();
+}
 
-    // Set Appearance (0 = Unknown/Generic)
-    advertisementData.setAppearance(0);
+void BleManager::update() {
+    HeapScope heapScope(HEAP_TAG_BLE);
+    if (!bleInitialized_) return;
 
-    // Add Service UUID (Removed from here, set directly on pAdvertising_ in begin())
-    // advertisementData.addServiceUUID(BLEUUID((uint16_t)0x181A));
+    uint32_t seq = dataManager_.getLastSeq();
+    if (seq != lastRecordSeq_) {
+        lastRecordSeq_ = seq;
+        const EnvironmentData& latest = dataManager_.getLatestData();
+        updateCharacteristics(latest);
+        extAdvertiser_.addRecord(latest);
+    }
 
-    // Set Manufacturer Data (Convert std::string to Arduino String, handling potential nulls)
-    advertisementData.setManufacturerData(String(manufDataStr.c_str(), manufDataStr.length()));
+    history_.update();
+    extAdvertiser_.update();
 
-    // Apply the advertisement data
-    pAdvertising_->setAdvertisementData(advertisementData);
+    if (lastAdvUpdate_ == 0 || millis() - lastAdvUpdate_ >= ADV_MIN_INTERVAL_MS) {
+        lastAdvUpdate_ = max(millis(), 1UL);
+        updateAdvertisingData(dataManager_.getLatestData());
+    }
+}
+
+void BleManager::updateCharacteristics(const EnvironmentData& latest) {
+    uint8_t buf[4];
+
+    // Temperature: sint16, 0.01 C (0x8000 = unknown, per GATT Specification Supplement)
+    int16_t temp = isnan(latest.temperature) ? std::numeric_limits<int16_t>::min()
+                                             : (int16_t)constrain(lroundf(latest.temperature * 100.0f), -32767L, 32767L);
+    WireProtocol::putU16(buf, (uint16_t)temp);
+    setCharValue(chars_[CHAR_TEMP], buf, 2);
+
+    // Humidity: uint16, 0.01 %
+    uint16_t hum = isnan(latest.humidity) ? std::numeric_limits<uint16_t>::max()
+                                          : (uint16_t)constrain(lroundf(latest.humidity * 100.0f), 0L, 10000L);
+    WireProtocol::putU16(buf, hum);
+    setCharValue(chars_[CHAR_HUM], buf, 2);
 
-    // Note: Scan Response data can be set similarly using pAdvertising_->setScanResponseData()
-    // if needed, but we are keeping it simple for now.
+    // Illuminance: uint24, 0.01 lx
+    uint32_t lux = isnan(latest.lux) ? 0xFFFFFF : (uint32_t)constrain(lroundf(latest.lux * 100.0f), 0L, 0xFFFFFEL);
+    buf[0] = (uint8_t)(lux & 0xFF);
+    buf[1] = (uint8_t)((lux >> 8) & 0xFF);
+    buf[2] = (uint8_t)((lux >> 16) & 0xFF);
+    setCharValue(chars_[CHAR_LUX], buf, 3);
 
-    // Restarting advertising might still be necessary on some platforms/versions if data doesn't update.
-    // If needed, uncomment:
-    // BLEDevice::stopAdvertising();
-    // BLEDevice::startAdvertising();
+    // Noise: uint16, 0.01 dB (custom)
+    uint16_t db = isnan(latest.decibels) ? std::numeric_limits<uint16_t>::max()
+                                         : (uint16_t)constrain(lroundf(latest.decibels * 100.0f), 0L, 65534L);
+    WireProtocol::putU16(buf, db);
+    setCharValue(chars_[CHAR_NOISE], buf, 2);
 }
 
-void BleManager::buildManufacturerData(std::string& data) {
-    const EnvironmentData& latest = dataManager_.getLatestData();
-    data.clear();
-    // Resize to 10 bytes: 2 bytes for Company ID + 8 bytes for sensor data
-    data.resize(10);
+// Updates the characteristic only if the encoded bytes changed, and notifies subscribers
+void BleManager::setCharValue(SensorChar& c, const uint8_t* value, uint8_t length) {
+    if (c.valid && c.length == length && memcmp(c.value, value, length) == 0) return;
+    memcpy(c.value, value, length);
+    c.length = length;
+    c.valid = true;
+    c.characteristic->setValue(c.value, length);
+    if (connectedClients_ > 0) {
+        c.characteristic->notify();
+    }
+}
 
+void BleManager::updateAdvertisingData(const EnvironmentData& latest) {
+    if (!bleInitialized_ || !pAdvertising_) return;
+
+    size_t len = buildAdvertisingPayload(latest);
+    if (advertised_ && memcmp(manufData_, advertisedManufData_, MANUF_DATA_SIZE) == 0) {
+        return; // Same bytes on air already
+    }
+    memcpy(advertisedManufData_, manufData_, MANUF_DATA_SIZE);
+
+    if (extSets_) {
+        if (!extAdvertiser_.setConnectableData(advPayload_, len)) {
+            Serial.println("[BleManager] WARN: Advertising update failed");
+        }
+        return;
+    }
+    if (!advertised_) {
+        // First time through the library, which also switches it to custom advertising
+        // data so that startAdvertising() after a connection keeps this payload
+        BLEAdvertisementData advertisementData;
+        advertisementData.addData(String((const char*)advPayload_, len));
+        pAdvertising_->setAdvertisementData(advertisementData);
+        advertised_ = true;
+        return;
+    }
+    // Later updates go straight to the stack, which copies the payload in its own task
+    esp_err_t err = esp_ble_gap_config_adv_data_raw(advPayload_, len);
+    if (err != ESP_OK) {
+        Serial.printf("[BleManager] WARN: Advertising update failed: %d\n", err);
+    }
+}
+
+// Encodes latest into manufData_ and the whole advertising payload into advPayload_
+size_t BleManager::buildAdvertisingPayload(const EnvironmentData& latest) {
+    buildManufacturerData(latest, manufData_);
+
+    // Same AD structures BLEAdvertisementData builds (flags, appearance, manufacturer data),
+    // written into a member buffer; the String payload of BLEAdvertisementData is only used once.
+    size_t len = 0;
+    advPayload_[len++] = 2;
+    advPayload_[len++] = ESP_BLE_AD_TYPE_FLAG;
+    advPayload_[len++] = 0x06; // LE General Discoverable Mode, BR/EDR Not Supported
+    advPayload_[len++] = 3;
+    advPayload_[len++] = ESP_BLE_AD_TYPE_APPEARANCE;
+    advPayload_[len++] = 0;
+    advPayload_[len++] = 0;
+    advPayload_[len++] = MANUF_DATA_SIZE + 1;
+    advPayload_[len++] = ESP_BLE_AD_MANUFACTURER_SPECIFIC_TYPE;
+    memcpy(advPayload_ + len, manufData_, MANUF_DATA_SIZE);
+    len += MANUF_DATA_SIZE;
+    return len;
+}
+
+// The stack stops connectable advertising when a connection is made or ends
+void BleManager::restartAdvertising() {
+    if (extSets_) {
+        extAdvertiser_.restartConnectable();
+    } else {
+        BLEDevice::startAdvertising();
+    }
+}
+
+// 10 bytes: Company ID (2), temperature sint16 0.01 C (2), humidity uint16 0.01 % (2),
+// illuminance uint24 0.01 lx (3), noise uint8 dB (1). All little endian.
+void BleManager::buildManufacturerData(const EnvironmentData& latest, uint8_t* data) {
     // 0. Company ID (uint16, Little Endian)
     data[0] = (uint8_t)(companyId_ & 0xFF);
     data[1] = (uint8_t)((companyId_ >> 8) & 0xFF);
@@ -92,4 +242,21 @@ void BleManager::buildManufacturerData(std::string& data) {
         }
     }
     data[9] = noise_ble;
-} 
\ No newline at end of file
+}
+
+void BleManager::ServerCallbacks::onConnect(BLEServer* server) {
+    owner_.connectedClients_++;
+    Serial.println("[BleManager] Client connected.");
+    owner_.restartAdvertising(); // Stay discoverable for other centrals
+}
+
+void BleManager::ServerCallbacks::onConnect(BLEServer* server, esp_ble_gatts_cb_param_t* param) {
+    owner_.history_.onConnect(server, param);
+}
+
+void BleManager::ServerCallbacks::onDisconnect(BLEServer* server) {
+    if (owner_.connectedClients_ > 0) owner_.connectedClients_--;
+    owner_.history_.onDisconnect();
+    Serial.println("[BleManager] Client disconnected.");
+    owner_.restartAdvertising();
+}
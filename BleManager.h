@@ -6,21 +6,89 @@
 #include <BLEServer.h>
 #include <BLEUtils.h>
 #include <BLEAdvertising.h>
+#include <BLE2902.h>
 #include "data_manager.h"
+#include "ble_history_service.h"
+#include "ble_ext_advertiser.h"
 
+/**
+ * BLE 环境传感服务 (Environmental Sensing Service, 0x181A)
+ *
+ * GATT 特征 (均为 READ | NOTIFY, 小端):
+ *   0x2A6E Temperature   sint16, 0.01 C   (0x8000 = 无效)
+ *   0x2A6F Humidity      uint16, 0.01 %   (0xFFFF = 无效)
+ *   0x2AFB Illuminance   uint24, 0.01 lx  (0xFFFFFF = 无效)
+ *   NOISE_CHAR_UUID      uint16, 0.01 dB  (0xFFFF = 无效, 自定义特征)
+ * 每条新记录编码一次到预分配的缓冲区, 只有字节发生变化的特征才 setValue + notify。
+ * begin() 在启动任务 (core 0) 中运行, 不读取 DataManager 的最新记录: 初始广播为空记录,
+ * 第一次真正的编码由主循环中的 update() 完成。
+ *
+ * 广播中的厂商数据 (10 bytes) 保持原格式, 同样只在编码结果变化时重建广播包;
+ * 广播包直接写入固定缓冲区交给 esp_ble_gap_config_adv_data_raw(), 不再每次构造 String。
+ * 支持 BLE 5 时可连接广播改由 BleExtAdvertiser 的扩展广播实例 0 (传统 PDU) 发出, 因为控制器
+ * 不允许传统和扩展广播命令混用; 不支持或启动失败时使用传统广播, 不发每分钟汇总帧。
+ *
+ * 历史数据批量下载由 BleHistoryService 提供 (ble_history_service.h),
+ * 每分钟统计汇总的 BLE 5 扩展广播由 BleExtAdvertiser 提供 (ble_ext_advertiser.h)。
+ */
 class BleManager {
 public:
     BleManager(DataManager& dataMgr);
     void begin();
-    void updateAdvertisingData();
+    void update(); // Called in loop; cheap when no new record is available
+
+    bool isClientConnected() const { return connectedClients_ > 0; }
 
 private:
+    static const unsigned long ADV_MIN_INTERVAL_MS = 2000; // Rate limit for advertising rebuilds
+    static const size_t MANUF_DATA_SIZE = 10;
+    static const size_t ADV_PAYLOAD_SIZE = 3 + 4 + 2 + MANUF_DATA_SIZE; // Flags, appearance, manufacturer data
+
+    // One notify characteristic with the last value sent
+    struct SensorChar {
+        BLECharacteristic* characteristic;
+        uint8_t value[4];
+        uint8_t length;
+        bool valid; // value has been set at least once
+    };
+    enum { CHAR_TEMP = 0, CHAR_HUM, CHAR_LUX, CHAR_NOISE, CHAR_COUNT };
+
     DataManager& dataManager_;
     BLEAdvertising* pAdvertising_;
+    BLEServer* pServer_;
     uint16_t companyId_ = 0xFFFF; // Default Company ID for Manufacturer Data
     bool bleInitialized_ = false;
+    volatile int connectedClients_;
+
+    SensorChar chars_[CHAR_COUNT];
+    BleHistoryService history_;
+    BleExtAdvertiser extAdvertiser_;
+    uint32_t lastRecordSeq_;
+    uint8_t manufData_[MANUF_DATA_SIZE];
+    uint8_t advertisedManufData_[MANUF_DATA_SIZE];
+    uint8_t advPayload_[ADV_PAYLOAD_SIZE];
+    bool advertised_;
+    bool extSets_;     // Advertising runs on BleExtAdvertiser's sets, not the legacy API
+    unsigned long lastAdvUpdate_;
+
+    void createService();
+    void updateCharacteristics(const EnvironmentData& latest);
+    void setCharValue(SensorChar& c, const uint8_t* value, uint8_t length);
+    void updateAdvertisingData(const EnvironmentData& latest);
+    size_t buildAdvertisingPayload(const EnvironmentData& latest);
+    void restartAdvertising();
+    void buildManufacturerData(const EnvironmentData& latest, uint8_t* data);
 
-    void buildManufacturerData(std::string& data);
+    class ServerCallbacks : public BLEServerCallbacks {
+    public:
+        explicit ServerCallbacks(BleManager& owner) : owner_(owner) {}
+        void onConnect(BLEServer* server) override;
+        void onConnect(BLEServer* server, esp_ble_gatts_cb_param_t* param) override;
+        void onDisconnect(BLEServer* server) override;
+    private:
+        BleManager& owner_;
+    };
+    ServerCallbacks serverCallbacks_;
 };
 
-#endif // BLE_MANAGER_H 
\ No newline at end of file
+#endif // BLE_MANAGER_H
@@ -2,9 +2,16 @@
 #define ENVIRONMENT_DATA_H
 
 #include <time.h>
+#include <stdint.h>
 
 struct EnvironmentData {
+    enum Flags : uint8_t {
+        FLAG_TIME_UNSYNCED = 0x01 // timestamp 为开机后的单调秒数 (尚未完成 NTP 同步)
+    };
+
     time_t timestamp;    // 时间戳
+    uint32_t seq;        // 记录序号 (单调递增, 跨重启持久化; 0 = 空记录)
+    uint8_t flags;       // Flags 位组合
     float decibels;      // 噪声值 (dB)
     float humidity;      // 湿度 (%)
     float temperature;   // 温度 (°C)
@@ -12,6 +19,8 @@ struct EnvironmentData {
     
     EnvironmentData() : 
         timestamp(0), 
+        seq(0),
+        flags(0),
         decibels(0.0f), 
         humidity(0.0f), 
         temperature(0.0f), 
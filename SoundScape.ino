@@ -7,10 +7,12 @@
  * 3. 使用 BH1750 监测光照 (LightSensor)
  * 4. 通过 WS2812B LED 显示状态 (LedController)
  * 5. SD卡数据存储和管理 (DataManager)
- * 6. WiFi连接和NTP时间同步 (Main Sketch / Future NetworkManager)
+ * 6. WiFi连接和NTP时间同步 (CommunicationManager, 非阻塞状态机)
  * 7. 网络通信服务 (CommunicationManager)
  * 8. 多按钮交互界面 (UIManager, InputManager)
  * 9. 内存监控 (memory_utils, Main Sketch)
+ * 10. UDP 组播遥测信标 (TelemetryBeacon, 可选)
+ * 11. 批量上行到 HTTP 采集端, 离线时以 SD 日志存储转发 (UplinkManager, 可选)
  * 硬件连接：
  * - INMP441: SCK->GPIO15, WS->GPIO16, SD->GPIO17
  * - Si7021和BH1750 (I2C): 
@@ -42,6 +44,8 @@
 
 // --- Include New Manager Headers ---
 #include "ui_manager.h"
+#include "display_flusher.h"
+#include "glyph_cache.h"
 #include "data_manager.h"
 #include "input_manager.h"
 #include "led_controller.h"
@@ -50,17 +54,25 @@
 #include "temp_hum_sensor.h"
 #include "light_sensor.h"
 #include "BleManager.h"
+#include "telemetry_beacon.h"
+#include "uplink_manager.h"
+#include "chart_history.h"
+#include "boot_timeline.h"
+#include "heap_tracker.h"
 
 // --- Include Screen Headers ---
 #include "main_screen.h"
 #include "noise_screen.h"
 #include "temp_hum_screen.h"
 #include "light_screen.h"
+#include "chart_screen.h"
+#include "level_meter_screen.h"
 #include "status_screen.h"
 
 // --- Include Utility Headers ---
 #include "ui.h" // For startup animation, constants
 #include "memory_utils.h"
+#include "metrics.h"
 // ui_constants.h is included by other headers
 // data_validator.h is included by other headers
 // EnvironmentData.h is included by other headers
@@ -108,8 +120,20 @@ const char* NTP_SERVER = "pool.ntp.org";
 const long GMT_OFFSET_SEC = 28800;
 const int DAYLIGHT_OFFSET_SEC = 0;
 
+// Telemetry beacons: one datagram per record to a multicast group (tools/beacon_receiver.py)
+const bool TELEMETRY_BEACON_ENABLED = true;
+const char* TELEMETRY_GROUP = "239.255.83.66";
+const uint16_t TELEMETRY_PORT = 8267;
+
+// Uplink: batched POSTs to a collector (tools/uplink_collector.py); backlog stays on SD while offline
+const bool UPLINK_ENABLED = false;
+const char* UPLINK_URL = "http://192.168.1.100:8270/ingest";
+const uint16_t UPLINK_BATCH_RECORDS = 60;        // Send when this many records are waiting...
+const uint32_t UPLINK_BATCH_INTERVAL_MS = 60000; // ...or this long after the previous batch
+
 // --- Global Objects / Instances ---
 TFT_eSPI tft = TFT_eSPI(); // TFT instance
+DisplayFlusher displayFlusher(tft); // Owns the TFT once started: screens draw into its back buffer
 
 // Instantiate Managers (Order matters for dependencies)
 UIManager uiManager; // Needs to be accessible by screens and other managers
@@ -123,30 +147,52 @@ LightSensor lightSensor; // Uses default address 0x23
 DataManager dataManager(micManager, tempHumSensor, lightSensor, uiManager);
 
 // Communication Manager (Pass network config and UIManager reference)
-CommunicationManager commManager(&micManager, &uiManager, WIFI_SSID, WIFI_PASSWORD, NTP_SERVER, GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC);
+CommunicationManager commManager(&micManager, &uiManager, &dataManager, WIFI_SSID, WIFI_PASSWORD, NTP_SERVER, GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC);
 
 // Input Manager (depends on UI Manager, Data Manager, Comm Manager)
 InputManager inputManager(uiManager, dataManager, commManager);
 
 // LED Controller (depends on UI Manager and Data Manager)
-LedController ledController(uiManager, dataManager);
+LedController ledController(uiManager, dataManager, micManager);
 
 // BLE Manager (depends on Data Manager)
 BleManager bleManager(dataManager);
 
+// Telemetry Beacon (depends on Data Manager)
+TelemetryBeacon telemetryBeacon(dataManager, TELEMETRY_GROUP, TELEMETRY_PORT, TELEMETRY_BEACON_ENABLED);
+
+// Uplink Manager (depends on Data Manager)
+UplinkManager uplinkManager(dataManager, UPLINK_URL, UPLINK_ENABLED, UPLINK_BATCH_RECORDS, UPLINK_BATCH_INTERVAL_MS);
+
+// Chart history envelopes (depend on Data Manager; fed from loop, drawn by ChartScreen)
+ChartHistory chartHistory(dataManager);
+
 // Web Server (passed to commManager for setup)
 AsyncWebServer httpServer(80);
 
 // Screens (depend on tft, dataManager providing data access)
 MainScreen mainScreen(tft, dataManager);
 NoiseScreen noiseScreen(tft, dataManager);
+LevelMeterScreen levelMeterScreen(tft, dataManager, micManager);
 TempHumScreen tempHumScreen(tft, dataManager);
 LightScreen lightScreen(tft, dataManager);
+ChartScreen chartScreen(tft, dataManager, chartHistory);
 StatusScreen statusScreen(tft, dataManager);
 
 // Watchdog Timer
 hw_timer_t* watchdog = NULL;
 
+// Boot stages that run in the background while sampling starts (see setup())
+void runSplash() { runStartupAnimation(tft, 1500); }
+void runBleInit() { bleManager.begin(); }
+BootStage splashStage("splash", runSplash);
+BootStage bleStage("ble", runBleInit, 8192);
+bool uiStarted = false;
+const uint32_t SERIAL_WAIT_MS = 250; // USB CDC: do not hold up sampling waiting for a host
+// Steady state (heap audit, see heap_tracker.h): UI and BLE up, and the network services
+// started, or this long after boot if WiFi never connects
+const uint32_t STEADY_STATE_FALLBACK_MS = 60000;
+
 // Memory Monitoring Variables
 unsigned long lastMemoryLog = 0;
 const unsigned long MEMORY_LOG_INTERVAL = 600000; // 10 minutes
@@ -169,6 +215,7 @@ void logMemoryStatus() {
     Serial.printf("内存分片率: %.1f%%\n", fragmentation);
   }
   if (fragmentation > 50) Serial.println("警告: 内存分片严重!");
+  heapTracker.printReport(); // Per-subsystem usage and largest-free-block trend
   
   Serial.printf("程序空间: %lu 字节\n", ESP.getFreeSketchSpace());
   Serial.println("==================");
@@ -203,6 +250,28 @@ void setupWatchdog() {
 /**
  * Performs cleanup before restarting.
  */
+// Called from loop() once the splash animation has released the display
+void startUi() {
+    HeapScope heapScope(HEAP_TAG_UI);
+    GlyphCache::instance().setPanel(&tft); // Direct drawing (no back buffers) blits to the panel
+    // 之后的屏幕绘制都在后台缓冲中完成, 由刷新任务推送到屏幕 (失败时直接绘制)
+    if (displayFlusher.begin()) {
+        uiManager.setDisplayFlusher(&displayFlusher);
+    }
+
+    // Add screens to UI Manager
+    uiManager.addScreen(&mainScreen);
+    uiManager.addScreen(&noiseScreen);
+    uiManager.addScreen(&levelMeterScreen);
+    uiManager.addScreen(&tempHumScreen);
+    uiManager.addScreen(&lightScreen);
+    uiManager.addScreen(&chartScreen);
+    uiManager.addScreen(&statusScreen);
+    uiManager.setInitialScreen(); // Set the first screen active
+    uiStarted = true;
+    bootTimeline.mark("ui");
+}
+
 void cleanup() {
   Serial.println("开始清理资源...");
   micManager.end(); // Stop I2S
@@ -213,14 +282,16 @@ void cleanup() {
   commManager.stop(); // Stop TCP/WebSocket clients/server
   httpServer.end();   // Stop HTTP server
 
-  // Clear display
+  // Clear display (take the TFT back from the flush task first)
+  uiManager.setDisplayFlusher(nullptr);
+  displayFlusher.end();
   tft.fillScreen(TFT_BLACK);
   tft.setTextColor(TFT_WHITE, TFT_BLACK);
   tft.setTextSize(2);
   tft.setTextDatum(MC_DATUM);
   tft.drawString("系统安全关闭", tft.width() / 2, tft.height() / 2);
   
-  ledController.setBrightness(0); // Turn off LEDs
+  ledController.end(); // Stop the LED animation, turn off LEDs
 
   Serial.println("资源清理完成");
 }
@@ -231,13 +302,13 @@ void cleanup() {
 void setup() {
     try {
         Serial.begin(115200);
-        while (!Serial) { yield(); }
+        while (!Serial && millis() < SERIAL_WAIT_MS) { yield(); }
+        heapTracker.begin();   // Before the managers allocate anything
         Serial.println("\n======================================");
         Serial.println(" ESP32S3 环境监测系统启动中 (Refactored)");
         Serial.println("======================================");
 
         // --- Initializations ---
-        initEmergencyMemory(); // Initialize emergency memory pool first
         logMemoryStatus();     // Log initial memory status
         setupWatchdog();       // Start watchdog early
 
@@ -252,62 +323,47 @@ void setup() {
         pinMode(TFT_BL, OUTPUT); // Setup backlight pin
         digitalWrite(TFT_BL, HIGH); // Turn on backlight
 
-        // --- Manager Initializations ---
+        bootTimeline.mark("display");
+
+        // --- 启动顺序 ---
+        // 先启动采样和 SD 记录, setup() 返回后的第一次 loop() 就写入第一条记录;
+        // 开机动画和 BLE 协议栈初始化在后台任务中进行, WiFi/NTP 本身就是非阻塞的。
+        // 各阶段完成时刻见串口 [Boot] 日志和 /metrics 中的 soundscape_boot_*。
         Serial.println("--- Initializing Managers ---");
         if (micManager.begin()) {
-            Serial.printf("初始噪声读数: %.2f dB\n", micManager.readNoiseLevel(50)); // Use updated timeout
+            // 后台采集任务: 实时声级屏、每秒噪声记录和 WebSocket 音频流都从这里取数据
+            if (!micManager.startCapture()) {
+                Serial.println("ERR: 麦克风采集任务启动失败, 使用阻塞读取");
+            }
         } else {
             Serial.println("ERR: I2S Mic Manager 初始化失败!");
         }
         tempHumSensor.begin(); // Logs success/failure internally
         lightSensor.begin();   // Logs success/failure internally
+        bootTimeline.mark("sensors");
 
         // DataManager needs sensors initialized, begin checks/inits SD card
         dataManager.begin();
         // Update UI with SD status AFTER DataManager has checked it in its begin() method
         uiManager.setSdCardStatus(dataManager.isSdCardInitialized());
+        bootTimeline.mark("sd_logger");
 
-        inputManager.begin();    // Initializes button pins
-        ledController.begin();   // Initializes NeoPixels
+        inputManager.begin();    // Button interrupts + decoder task
+        ledController.begin();   // RMT channel + 60 Hz animation timer
 
-        // --- BLE Initialization ---
-        bleManager.begin();            // Call BleManager's begin
+        // --- Background stages: splash owns the TFT until loop() starts the UI ---
+        Serial.println("--- Initializing UI / BLE (background) ---");
+        splashStage.start();
+        bleStage.start();
 
         // --- Network Initialization (using CommunicationManager) ---
         Serial.println("--- Initializing Network ---");
-        if (commManager.connectWiFi()) { // Try connecting (updates UI status internally)
-             commManager.syncNTPTime(); // Try syncing time (updates UI status internally)
-
-             // Start Communication Servers (Requires WiFi)
-             if (commManager.begin()) { // Start TCP command server
-                  Serial.println("Communication servers (TCP/WebSocket) potentially started.");
-                  // Setup HTTP/WebSocket server handlers via commManager
-                  commManager.setupHttpServer(&httpServer);
-                  commManager.setupWebSocketServer(&httpServer);
-                  httpServer.begin(); // Start the actual AsyncWebServer
-                  Serial.println("HTTP 和 WebSocket 服务器已启动 (Port 80)");
-             } else {
-                  Serial.println("Communication servers failed to start (likely WiFi issue during check).");
-             }
-        } else {
-             Serial.println("WARN: WiFi 未连接，网络服务未启动。");
-             // Ensure time status is false if WiFi failed initially
-             uiManager.setTimeStatus(false);
-             uiManager.forceRedraw();
-        }
-
-
-        // --- UI Initialization ---
-        Serial.println("--- Initializing UI ---");
-        runStartupAnimation(tft, 1500); // Run startup animation
-
-        // Add screens to UI Manager
-        uiManager.addScreen(&mainScreen);
-        uiManager.addScreen(&noiseScreen);
-        uiManager.addScreen(&tempHumScreen);
-        uiManager.addScreen(&lightScreen);
-        uiManager.addScreen(&statusScreen);
-        uiManager.setInitialScreen(); // Set the first screen active
+        // 非阻塞: 注册 WiFi 事件并发起连接; 链路建立/断开时由 commManager.update()
+        // 启动/停止 TCP、HTTP 和 WebSocket 服务, 失败后按指数退避自动重连
+        commManager.beginNetwork(&httpServer);
+        telemetryBeacon.begin(); // Sends once WiFi is up
+        uplinkManager.begin();   // Starts the upload task; drains the backlog once WiFi is up
+        bootTimeline.mark("network_started");
 
         // --- Final Steps ---
         lastMemoryLog = millis(); // Initialize memory log timer
@@ -315,6 +371,7 @@ void setup() {
         Serial.println("       系统初始化完成!");
         Serial.println("======================================");
         logMemoryStatus(); // Log memory status after all initializations
+        bootTimeline.mark("setup_done");
 
     } catch (const std::exception& e) {
         Serial.printf("设置过程中发生异常: %s\n", e.what());
@@ -330,23 +387,34 @@ void setup() {
 //=============================================================================
 void loop() {
     try {
+        uint32_t loopStartUs = micros();
+
         // --- Feed Watchdog ---
         timerWrite(watchdog, 0); // Reset watchdog counter
 
         // --- Core Updates ---
-        commManager.update();      // Handle TCP commands and WebSocket cleanup
+        commManager.update();      // WiFi state machine, TCP commands
         commManager.streamAudioViaWebSocket(); // Send audio stream if clients connected
-        inputManager.update();     // Check buttons (handles short/long presses)
+        inputManager.update();     // Run decoded button events (press/long/repeat)
         dataManager.update();      // Read sensors periodically, handle SD saving
-        ledController.update();    // Update LED strip based on mode and data
-        uiManager.update();        // Update active screen, handle transitions
-
-        // --- Update BLE Advertising Data ---
-        static unsigned long lastBleUpdate = 0;
-        const unsigned long BLE_UPDATE_INTERVAL = 2000; // Update advertising data every 2 seconds
-        if (millis() - lastBleUpdate >= BLE_UPDATE_INTERVAL) {
-            lastBleUpdate = millis();
-            bleManager.updateAdvertisingData();
+        chartHistory.update();     // Fold the new record into the chart's column envelopes
+        telemetryBeacon.update();  // Multicast the new record, if any
+        uplinkManager.update();    // Hand the next batch to the upload task
+        ledController.update();    // New LED target colour on mode/data change (the timer animates)
+        if (!uiStarted && splashStage.done()) {
+            startUi();             // Splash finished: screens take over the display
+        }
+        if (uiStarted) {
+            uiManager.update();    // Update active screen, handle transitions
+        }
+        if (bleStage.done()) {
+            bleManager.update();   // Notify GATT subscribers, refresh advertising on change
+        }
+        heapTracker.update();      // Heap history sample every 10 s
+        if (!heapTracker.inSteadyState() && uiStarted && bleStage.done() &&
+            (commManager.isServerRunning() || millis() >= STEADY_STATE_FALLBACK_MS)) {
+            bootTimeline.mark("steady_state");
+            heapTracker.markSteadyState(); // Allocations from here on are audited (HEAP_AUDIT_STEADY_STATE)
         }
 
         // --- Memory Monitoring ---
@@ -357,18 +425,17 @@ void loop() {
             // Optional: Add fragmentation check here too
         }
 
-        // Check for critical low memory
-        if (ESP.getFreeHeap() < 5000) { // Threshold slightly higher than emergency release
-             Serial.println("警告：内存严重不足，尝试释放紧急内存...");
-             releaseEmergencyMemory();
-             if (ESP.getFreeHeap() < 4096) { // Check again after release
-                  Serial.println("错误：内存仍然不足，准备重启");
-                  cleanup();
-                  ESP.restart();
-                  return; // Should not be reached
-             }
+        // Check for critical low memory. Steady-state paths use pools and arenas reserved at
+        // boot, so getting here means a leak or a runaway event; restart rather than limp on.
+        if (ESP.getFreeHeap() < 4096) {
+             Serial.println("错误：内存严重不足，准备重启");
+             cleanup();
+             ESP.restart();
+             return; // Should not be reached
         }
 
+        systemMetrics.loopTimeUs.observe(micros() - loopStartUs);
+
         // --- Yield/Delay ---
         yield(); // Allow background tasks (like WiFi, AsyncTCP) to run
         // delay(1); // Small delay can sometimes help stability but yield is preferred
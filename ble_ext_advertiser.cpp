@@ -0,0 +1,179 @@
+#include "ble_ext_advertiser.h"
+#include "wire_protocol.h" // Little-endian helpers
+#include <esp_mac.h>
+
+BleExtAdvertiser::BleExtAdvertiser(uint16_t companyId) :
+    companyId_(companyId),
+    active_(false),
+    windowStartMs_(0),
+    frameCounter_(0)
+#if BLE_EXT_ADV_AVAILABLE
+    , multiAdv_(INSTANCE + 1)
+#endif
+{
+    memset(advData_, 0, sizeof(advData_));
+}
+
+bool BleExtAdvertiser::beginConnectable(const uint8_t* data, size_t length) {
+#if BLE_EXT_ADV_AVAILABLE
+    esp_ble_gap_ext_adv_params_t params = {};
+    params.type = ESP_BLE_GAP_SET_EXT_ADV_PROP_LEGACY_IND; // Connectable, scannable, legacy PDUs
+    params.interval_min = 0x20;  // 20 ms, same as BLEAdvertising's defaults
+    params.interval_max = 0x40;  // 40 ms
+    params.channel_map = ADV_CHNL_ALL;
+    params.own_addr_type = BLE_ADDR_TYPE_PUBLIC;
+    params.peer_addr_type = BLE_ADDR_TYPE_PUBLIC;
+    params.filter_policy = ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY;
+    params.tx_power = EXT_ADV_TX_PWR_NO_PREFERENCE;
+    params.primary_phy = ESP_BLE_GAP_PHY_1M;
+    params.max_skip = 0;
+    params.secondary_phy = ESP_BLE_GAP_PHY_1M;
+    params.sid = CONNECTABLE_INSTANCE;
+    params.scan_req_notif = false;
+
+    if (!multiAdv_.setAdvertisingParams(CONNECTABLE_INSTANCE, &params) ||
+        !multiAdv_.setAdvertisingData(CONNECTABLE_INSTANCE, length, data) ||
+        !multiAdv_.start(1, CONNECTABLE_INSTANCE)) {
+        Serial.println("[BleExtAdvertiser] ERR: Failed to start connectable advertising on set 0.");
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool BleExtAdvertiser::setConnectableData(const uint8_t* data, size_t length) {
+#if BLE_EXT_ADV_AVAILABLE
+    // Legacy PDU sets take new data while running
+    return multiAdv_.setAdvertisingData(CONNECTABLE_INSTANCE, length, data);
+#else
+    return false;
+#endif
+}
+
+void BleExtAdvertiser::restartConnectable() {
+#if BLE_EXT_ADV_AVAILABLE
+    multiAdv_.start(1, CONNECTABLE_INSTANCE); // Only set 0; the aggregate set keeps running
+#endif
+}
+
+void BleExtAdvertiser::begin() {
+#if BLE_EXT_ADV_AVAILABLE
+    esp_ble_gap_ext_adv_params_t params = {};
+    params.type = ESP_BLE_GAP_SET_EXT_ADV_PROP_NONCONN_NONSCANNABLE_UNDIRECTED;
+    params.interval_min = 1600;  // 1 s (0.625 ms units): data changes once per window
+    params.interval_max = 1920;  // 1.2 s
+    params.channel_map = ADV_CHNL_ALL;
+    params.own_addr_type = BLE_ADDR_TYPE_RANDOM;
+    params.peer_addr_type = BLE_ADDR_TYPE_PUBLIC;
+    params.filter_policy = ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY;
+    params.tx_power = EXT_ADV_TX_PWR_NO_PREFERENCE;
+    params.primary_phy = ESP_BLE_GAP_PHY_1M;
+    params.max_skip = 0;
+    params.secondary_phy = ESP_BLE_GAP_PHY_2M;
+    params.sid = INSTANCE;
+    params.scan_req_notif = false;
+
+    // Static random address derived from the BT MAC, stable across reboots
+    uint8_t addr[6];
+    esp_read_mac(addr, ESP_MAC_BT);
+    addr[0] |= 0xC0;
+
+    encodeFrame(advData_, 0); // Empty frame until the first window closes
+    if (!multiAdv_.setAdvertisingParams(INSTANCE, &params) ||
+        !multiAdv_.setInstanceAddress(INSTANCE, addr) ||
+        !multiAdv_.setAdvertisingData(INSTANCE, sizeof(advData_), advData_) ||
+        !multiAdv_.start(1, INSTANCE)) {
+        Serial.println("[BleExtAdvertiser] ERR: Failed to start extended advertising.");
+        return;
+    }
+    active_ = true;
+    windowStartMs_ = millis();
+    Serial.println("[BleExtAdvertiser] Extended advertising started.");
+#else
+    Serial.println("[BleExtAdvertiser] BLE 5 extended advertising not supported by this build.");
+#endif
+}
+
+void BleExtAdvertiser::addRecord(const EnvironmentData& record) {
+    if (!active_) return;
+    for (int f = 0; f < QUERY_FIELD_COUNT; ++f) {
+        window_[f].add(queryFieldValue(record, (QueryField)f), f == QUERY_FIELD_DB);
+    }
+}
+
+void BleExtAdvertiser::update() {
+    if (!active_ || millis() - windowStartMs_ < WINDOW_MS) return;
+    closeWindow();
+}
+
+void BleExtAdvertiser::closeWindow() {
+    uint16_t windowSeconds = (uint16_t)min((millis() - windowStartMs_) / 1000UL, 65535UL);
+    windowStartMs_ = millis();
+    frameCounter_++;
+    encodeFrame(advData_, windowSeconds);
+#if BLE_EXT_ADV_AVAILABLE
+    // Advertising data can be replaced while the set is running
+    multiAdv_.setAdvertisingData(INSTANCE, sizeof(advData_), advData_);
+#endif
+    for (int f = 0; f < QUERY_FIELD_COUNT; ++f) {
+        window_[f].reset();
+    }
+}
+
+static void putScaledS16(uint8_t* p, const FieldStats& s, float v) {
+    int16_t raw = (s.count == 0 || isnan(v)) ? INT16_MIN : (int16_t)constrain(lroundf(v * 100.0f), -32767L, 32767L);
+    WireProtocol::putU16(p, (uint16_t)raw);
+}
+
+static void putScaledU16(uint8_t* p, const FieldStats& s, float v) {
+    uint16_t raw = (s.count == 0 || isnan(v)) ? 0xFFFF : (uint16_t)constrain(lroundf(v * 100.0f), 0L, 65534L);
+    WireProtocol::putU16(p, raw);
+}
+
+static void putScaledU24(uint8_t* p, const FieldStats& s, float v) {
+    uint32_t raw = (s.count == 0 || isnan(v)) ? 0xFFFFFF : (uint32_t)constrain(lroundf(v * 100.0f), 0L, 0xFFFFFEL);
+    p[0] = (uint8_t)(raw & 0xFF);
+    p[1] = (uint8_t)((raw >> 8) & 0xFF);
+    p[2] = (uint8_t)((raw >> 16) & 0xFF);
+}
+
+static float meanOf(const FieldStats& s) {
+    return s.count ? (float)(s.sum / s.count) : NAN;
+}
+
+void BleExtAdvertiser::encodeFrame(uint8_t* ad, uint16_t windowSeconds) {
+    ad[0] = (uint8_t)(1 + FRAME_SIZE); // AD structure length (type + data)
+    ad[1] = 0xFF;                      // Manufacturer Specific Data
+    uint8_t* out = ad + 2;
+
+    const FieldStats& temp = window_[QUERY_FIELD_TEMP];
+    const FieldStats& hum = window_[QUERY_FIELD_HUM];
+    const FieldStats& lux = window_[QUERY_FIELD_LUX];
+    const FieldStats& db = window_[QUERY_FIELD_DB];
+
+    WireProtocol::putU16(out + 0, companyId_);
+    out[2] = FRAME_VERSION;
+    WireProtocol::putU16(out + 3, frameCounter_);
+    WireProtocol::putU16(out + 5, windowSeconds);
+    uint32_t samples = max(max(temp.count, hum.count), max(lux.count, db.count));
+    WireProtocol::putU16(out + 7, (uint16_t)min(samples, (uint32_t)65535));
+
+    putScaledS16(out + 9, temp, temp.min);
+    putScaledS16(out + 11, temp, temp.max);
+    putScaledS16(out + 13, temp, meanOf(temp));
+    putScaledU16(out + 15, hum, hum.min);
+    putScaledU16(out + 17, hum, hum.max);
+    putScaledU16(out + 19, hum, meanOf(hum));
+    putScaledU24(out + 21, lux, lux.min);
+    putScaledU24(out + 24, lux, lux.max);
+    putScaledU24(out + 27, lux, meanOf(lux));
+    putScaledU16(out + 30, db, db.min);
+    putScaledU16(out + 32, db, meanOf(db));
+    putScaledU16(out + 34, db, db.max);                                   // Lmax
+    float laeq = db.count ? (float)(10.0 * log10(db.energy / db.count)) : NAN;
+    putScaledU16(out + 36, db, laeq);                                     // LAeq
+    out[38] = 0;
+    out[39] = 0;
+}
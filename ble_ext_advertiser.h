@@ -0,0 +1,80 @@
+#ifndef BLE_EXT_ADVERTISER_H
+#define BLE_EXT_ADVERTISER_H
+
+#include <Arduino.h>
+#include <BLEDevice.h>
+#include <BLEAdvertising.h>
+#include "EnvironmentData.h"
+#include "history_query.h" // FieldStats
+
+// BLE 5 extended advertising needs both the SoC and the Bluedroid build option
+#if defined(SOC_BLE_50_SUPPORTED) && defined(CONFIG_BT_BLE_50_FEATURES_SUPPORTED)
+#define BLE_EXT_ADV_AVAILABLE 1
+#else
+#define BLE_EXT_ADV_AVAILABLE 0
+#endif
+
+/**
+ * BLE 5 扩展广播: 每个窗口 (WINDOW_MS) 的统计汇总 (Per-window aggregates via extended advertising)
+ *
+ * 在普通 (可连接) 广播之外, 额外开启一个不可连接、不可扫描的扩展广播实例 (1 s 间隔, 辅助信道 2M PHY),
+ * 被动扫描器无需连接、也不会因为扫描间隙错过峰值。每个窗口结束时更新一次数据:
+ *
+ * 厂商数据 (AD type 0xFF), 小端, FRAME_SIZE = 40 bytes:
+ *   off  size
+ *   0    2    company id
+ *   2    1    frame version (FRAME_VERSION)
+ *   3    2    frame counter (+1 per window; scanners detect missed windows)
+ *   5    2    window length (s)
+ *   7    2    sample count
+ *   9    6    temperature min / max / mean   sint16, 0.01 C  (0x8000 = 无数据)
+ *   15   6    humidity min / max / mean      uint16, 0.01 %  (0xFFFF = 无数据)
+ *   21   9    illuminance min / max / mean   uint24, 0.01 lx (0xFFFFFF = 无数据)
+ *   30   6    noise min / mean / Lmax        uint16, 0.01 dB (0xFFFF = 无数据), Lmax = 窗口内最大值
+ *   36   2    LAeq                           uint16, 0.01 dB, 能量平均
+ *   38   2    reserved (0)
+ *
+ * 控制器不接受传统广播和扩展广播的 HCI 命令混用, 所以 BleManager 的可连接广播也由这里的
+ * BLEMultiAdvertising 发出: 实例 0 使用传统 PDU (ESP_BLE_GAP_SET_EXT_ADV_PROP_LEGACY_IND,
+ * 旧的扫描器照常可见), 实例 1 为本汇总帧。beginConnectable() 失败时 BleManager 改用库中的
+ * 传统广播, 且不调用 begin(), 即不发汇总帧。
+ *
+ * 芯片或蓝牙协议栈不支持 BLE 5 时 (BLE_EXT_ADV_AVAILABLE == 0) 本类不做任何事。
+ */
+class BleExtAdvertiser {
+public:
+    static const uint8_t FRAME_VERSION = 1;
+    static const size_t FRAME_SIZE = 40;
+    static const unsigned long WINDOW_MS = 60000;
+
+    explicit BleExtAdvertiser(uint16_t companyId);
+
+    // Connectable advertising (legacy PDUs) on set 0; false: unavailable, use BLEAdvertising
+    bool beginConnectable(const uint8_t* data, size_t length);
+    bool setConnectableData(const uint8_t* data, size_t length);
+    void restartConnectable();                   // The stack stops set 0 on connect / disconnect
+    void begin();                                // Aggregate set; only after beginConnectable()
+    void addRecord(const EnvironmentData& record); // Each new record
+    void update();                               // Called in loop; closes the window when due
+
+    bool isActive() const { return active_; }
+
+private:
+    static const uint8_t CONNECTABLE_INSTANCE = 0;
+    static const uint8_t INSTANCE = 1;
+
+    uint16_t companyId_;
+    bool active_;
+    FieldStats window_[QUERY_FIELD_COUNT];
+    unsigned long windowStartMs_;
+    uint16_t frameCounter_;
+    uint8_t advData_[2 + FRAME_SIZE]; // AD length + type + frame
+#if BLE_EXT_ADV_AVAILABLE
+    BLEMultiAdvertising multiAdv_;
+#endif
+
+    void closeWindow();
+    void encodeFrame(uint8_t* ad, uint16_t windowSeconds); // Writes the whole AD structure
+};
+
+#endif // BLE_EXT_ADVERTISER_H
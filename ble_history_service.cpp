@@ -0,0 +1,261 @@
+#include "ble_history_service.h"
+#include <esp_gap_ble_api.h>
+
+static const char* HISTORY_SERVICE_UUID = "5d3c0100-7a4e-4b8e-9a5b-2f6c1d0e5a01";
+static const char* HISTORY_CONTROL_UUID = "5d3c0101-7a4e-4b8e-9a5b-2f6c1d0e5a01";
+static const char* HISTORY_DATA_UUID    = "5d3c0102-7a4e-4b8e-9a5b-2f6c1d0e5a01";
+static const char* HISTORY_STATUS_UUID  = "5d3c0103-7a4e-4b8e-9a5b-2f6c1d0e5a01";
+
+BleHistoryService::BleHistoryService(DataManager& dataMgr) :
+    dataManager_(dataMgr),
+    server_(nullptr),
+    dataChar_(nullptr),
+    statusChar_(nullptr),
+    startPending_(false),
+    startSince_(0),
+    startWindow_(0),
+    stopPending_(false),
+    ackPending_(false),
+    ackPacketNo_(0),
+    nackPending_(false),
+    nackPacketNo_(0),
+    connected_(false),
+    active_(false),
+    sourceDone_(false),
+    ackedSeq_(0),
+    ackedPacketNo_(0),
+    nextPacketNo_(0),
+    window_(0),
+    inFlightHead_(0),
+    inFlightCount_(0),
+    lastAckMs_(0),
+    startMs_(0),
+    recordsAcked_(0),
+    controlCallbacks_(*this)
+{
+    portMUX_INITIALIZE(&mux_);
+    MetricsRegistry& r = MetricsRegistry::instance();
+    r.addCounter("soundscape_ble_history_records_total", "Records sent by BLE history transfers (incl. resends)", &recordsSent_);
+    r.addCounter("soundscape_ble_history_retransmits_total", "BLE history go-back-N rewinds", &retransmits_);
+    r.addGauge("soundscape_ble_history_records_per_second", "Throughput of the last completed BLE history transfer", &lastRate_);
+}
+
+void BleHistoryService::begin(BLEServer* server) {
+    server_ = server;
+    BLEService* service = server->createService(BLEUUID(HISTORY_SERVICE_UUID));
+
+    BLECharacteristic* control = service->createCharacteristic(BLEUUID(HISTORY_CONTROL_UUID),
+        BLECharacteristic::PROPERTY_WRITE | BLECharacteristic::PROPERTY_WRITE_NR);
+    control->setCallbacks(&controlCallbacks_);
+
+    dataChar_ = service->createCharacteristic(BLEUUID(HISTORY_DATA_UUID), BLECharacteristic::PROPERTY_NOTIFY);
+    dataChar_->addDescriptor(new BLE2902());
+
+    statusChar_ = service->createCharacteristic(BLEUUID(HISTORY_STATUS_UUID), BLECharacteristic::PROPERTY_READ);
+    statusChar_->setValue("idle");
+
+    service->start();
+}
+
+void BleHistoryService::onConnect(BLEServer* server, esp_ble_gatts_cb_param_t* param) {
+    connected_ = true;
+    // Larger link-layer packets (DLE) and a short connection interval for bulk transfer.
+    // The client still has to request the large ATT MTU (the local MTU is set to 517).
+    esp_ble_gap_set_pkt_data_len(param->connect.remote_bda, 251);
+    server->updateConnParams(param->connect.remote_bda, 6, 12, 0, 400); // 7.5-15 ms, 4 s timeout
+}
+
+void BleHistoryService::onDisconnect() {
+    connected_ = false;
+    portENTER_CRITICAL(&mux_);
+    stopPending_ = true; // The client resumes with START <last seq it stored>
+    portEXIT_CRITICAL(&mux_);
+}
+
+// BLE task: only record the command, update() acts on it
+void BleHistoryService::ControlCallbacks::onWrite(BLECharacteristic* characteristic) {
+    const uint8_t* data = characteristic->getData();
+    size_t len = characteristic->getLength();
+    if (!data || len == 0) return;
+
+    BleHistoryService& s = owner_;
+    portENTER_CRITICAL(&s.mux_);
+    switch (data[0]) {
+        case OP_START:
+            if (len >= 5) {
+                s.startSince_ = WireProtocol::getU32(data + 1);
+                s.startWindow_ = (len >= 6) ? data[5] : 8;
+                s.startPending_ = true;
+            }
+            break;
+        case OP_ACK:
+            if (len >= 3) {
+                s.ackPacketNo_ = WireProtocol::getU16(data + 1);
+                s.ackPending_ = true;
+            }
+            break;
+        case OP_NACK:
+            if (len >= 3) {
+                s.nackPacketNo_ = WireProtocol::getU16(data + 1);
+                s.nackPending_ = true;
+            }
+            break;
+        case OP_STOP:
+            s.stopPending_ = true;
+            break;
+        default:
+            break;
+    }
+    portEXIT_CRITICAL(&s.mux_);
+}
+
+void BleHistoryService::update() {
+    handleCommands();
+    if (!active_) return;
+
+    if (inFlightCount_ > 0 && millis() - lastAckMs_ > ACK_TIMEOUT_MS) {
+        rewind("ack timeout");
+    }
+
+    for (int i = 0; i < PACKETS_PER_UPDATE && inFlightCount_ < window_ && !sourceDone_; ++i) {
+        if (!sendRecordsPacket()) break;
+    }
+    if (sourceDone_ && inFlightCount_ == 0) {
+        finishTransfer();
+    }
+}
+
+void BleHistoryService::handleCommands() {
+    portENTER_CRITICAL(&mux_);
+    bool start = startPending_, stop = stopPending_, ack = ackPending_, nack = nackPending_;
+    uint32_t since = startSince_;
+    uint8_t window = startWindow_;
+    uint16_t ackNo = ackPacketNo_, nackNo = nackPacketNo_;
+    startPending_ = stopPending_ = ackPending_ = nackPending_ = false;
+    portEXIT_CRITICAL(&mux_);
+
+    if (stop && active_) {
+        Serial.printf("[BleHistory] Transfer stopped after %lu records.\n", (unsigned long)recordsAcked_);
+        active_ = false;
+    }
+    if (start) startTransfer(since, window);
+    if (ack && active_) acknowledge(ackNo);
+    if (nack && active_) {
+        acknowledge(nackNo);
+        rewind("nack");
+    }
+}
+
+void BleHistoryService::startTransfer(uint32_t since, uint8_t window) {
+    cursor_ = SyncCursor(since);
+    ackedSeq_ = since;
+    window_ = constrain(window, (uint8_t)1, (uint8_t)MAX_WINDOW);
+    ackedPacketNo_ = 0;
+    nextPacketNo_ = 1;
+    inFlightHead_ = 0;
+    inFlightCount_ = 0;
+    sourceDone_ = false;
+    recordsAcked_ = 0;
+    startMs_ = lastAckMs_ = millis();
+    active_ = true;
+    statusChar_->setValue("running");
+    Serial.printf("[BleHistory] Transfer from seq %lu, window %u, %u records/packet\n",
+                  (unsigned long)since, window_, (unsigned)recordsPerPacket());
+}
+
+// Releases every in-flight packet up to packetNo (16-bit wrap-safe)
+void BleHistoryService::acknowledge(uint16_t packetNo) {
+    while (inFlightCount_ > 0) {
+        InFlight& head = inFlight_[inFlightHead_];
+        if ((int16_t)(packetNo - head.packetNo) < 0) break;
+        ackedSeq_ = head.lastSeq;
+        ackedPacketNo_ = head.packetNo;
+        recordsAcked_ += head.count;
+        inFlightHead_ = (inFlightHead_ + 1) % MAX_WINDOW;
+        inFlightCount_--;
+        lastAckMs_ = millis();
+    }
+}
+
+// Go-back-N: resend everything after the last acknowledged packet
+void BleHistoryService::rewind(const char* reason) {
+    if (inFlightCount_ == 0 && !sourceDone_) return;
+    retransmits_.inc();
+    Serial.printf("[BleHistory] Rewind to seq %lu (%s)\n", (unsigned long)ackedSeq_, reason);
+    cursor_ = SyncCursor(ackedSeq_);
+    nextPacketNo_ = ackedPacketNo_ + 1;
+    inFlightCount_ = 0;
+    sourceDone_ = false;
+    lastAckMs_ = millis();
+}
+
+size_t BleHistoryService::recordsPerPacket() const {
+    uint16_t mtu = server_ ? server_->getPeerMTU(server_->getConnId()) : 23;
+    size_t payload = min((size_t)(mtu > 3 ? mtu - 3 : 0), (size_t)MAX_PACKET);
+    return payload > PACKET_HEADER ? (payload - PACKET_HEADER) / WireProtocol::ENV_RECORD_SIZE : 0;
+}
+
+// Sends the next packet of records. Returns false when nothing was sent.
+bool BleHistoryService::sendRecordsPacket() {
+    if (!connected_) {
+        active_ = false;
+        return false;
+    }
+    size_t perPacket = min(recordsPerPacket(), (size_t)255);
+    if (perPacket == 0) {
+        // Default 23-byte MTU cannot carry a record: end at once (status shows mtu=23);
+        // the client must request a larger MTU first
+        sourceDone_ = true;
+        return false;
+    }
+
+    EnvironmentData records[28]; // perPacket at MTU 517
+    size_t want = min(perPacket, sizeof(records) / sizeof(records[0]));
+    size_t n = dataManager_.readRecordsSince(cursor_, records, want);
+    if (n == 0) {
+        if (cursor_.phase == SyncCursor::PHASE_DONE) sourceDone_ = true;
+        return false; // More may follow on the next call (SD read is chunked)
+    }
+
+    uint16_t packetNo = nextPacketNo_++;
+    size_t len = PACKET_HEADER;
+    packet_[0] = PKT_RECORDS;
+    packet_[1] = (uint8_t)n;
+    WireProtocol::putU16(packet_ + 2, packetNo);
+    for (size_t i = 0; i < n; ++i) {
+        len += WireProtocol::encodeEnvRecord(packet_ + len, records[i]);
+    }
+    dataChar_->setValue(packet_, len);
+    dataChar_->notify();
+    recordsSent_.inc(n);
+
+    InFlight& slot = inFlight_[(inFlightHead_ + inFlightCount_) % MAX_WINDOW];
+    slot.packetNo = packetNo;
+    slot.lastSeq = records[n - 1].seq;
+    slot.count = (uint8_t)n;
+    inFlightCount_++;
+    return true;
+}
+
+void BleHistoryService::finishTransfer() {
+    unsigned long elapsedMs = max(millis() - startMs_, 1UL);
+    uint32_t rate = (uint32_t)((uint64_t)recordsAcked_ * 1000 / elapsedMs);
+
+    packet_[0] = PKT_END;
+    packet_[1] = 0;
+    WireProtocol::putU16(packet_ + 2, nextPacketNo_);
+    WireProtocol::putU32(packet_ + 4, ackedSeq_);
+    WireProtocol::putU32(packet_ + 8, recordsAcked_);
+    WireProtocol::putU32(packet_ + 12, rate);
+    dataChar_->setValue(packet_, 16);
+    dataChar_->notify();
+
+    char status[96];
+    snprintf(status, sizeof(status), "records=%lu ms=%lu rate=%lu/s mtu=%u last_seq=%lu",
+             (unsigned long)recordsAcked_, elapsedMs, (unsigned long)rate,
+             server_->getPeerMTU(server_->getConnId()), (unsigned long)ackedSeq_);
+    statusChar_->setValue(status);
+    lastRate_.set((float)rate);
+    Serial.printf("[BleHistory] Done: %s\n", status);
+    active_ = false;
+}
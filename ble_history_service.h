@@ -0,0 +1,115 @@
+#ifndef BLE_HISTORY_SERVICE_H
+#define BLE_HISTORY_SERVICE_H
+
+#include <Arduino.h>
+#include <BLEDevice.h>
+#include <BLEServer.h>
+#include <BLE2902.h>
+#include "freertos/FreeRTOS.h"
+#include "data_manager.h"
+#include "wire_protocol.h"
+#include "metrics.h"
+
+/**
+ * BLE 历史数据批量下载服务 (Bulk history download over BLE)
+ *
+ * 服务 HISTORY_SERVICE_UUID, 三个特征:
+ *   Control (WRITE)  客户端命令, 小端:
+ *     0x01 START  u32 sinceSeq, u8 window   从 sinceSeq 之后开始发送 (续传), window = 允许未确认的包数 (1..16)
+ *     0x02 ACK    u16 packetNo              确认到 packetNo 为止的所有包
+ *     0x03 NACK   u16 lastGoodPacketNo      发现包号缺口: 立即从 lastGoodPacketNo 之后重发 (go-back-N)
+ *     0x04 STOP
+ *   Data (NOTIFY)    设备 -> 客户端:
+ *     0x01 RECORDS  u8 count, u16 packetNo, count x SCHEMA_ENV_V2 记录 (18 bytes, seq 升序)
+ *     0x02 END      u8 0, u16 packetNo, u32 lastSeq, u32 records, u32 records/s
+ *   Status (READ)    最近一次传输的统计文本 (记录数, 耗时, records/s, MTU)
+ *
+ * 每包记录数按协商后的 ATT MTU 计算 (MTU 517 时 28 条/包); 连接时请求 DLE (251 字节链路层包)
+ * 和较短的连接间隔。超过 ACK_TIMEOUT_MS 未收到确认则从最后确认的位置重发。
+ * 断线后客户端用已保存的最大 seq 发送 START 即可续传。
+ *
+ * 记录读取和发送在主循环 (update) 中进行; BLE 回调只记录命令, 不访问 DataManager。
+ */
+class BleHistoryService {
+public:
+    explicit BleHistoryService(DataManager& dataMgr);
+
+    void begin(BLEServer* server);
+    void update(); // Called from BleManager::update()
+
+    // Connection events, forwarded from BleManager's server callbacks (BLE task)
+    void onConnect(BLEServer* server, esp_ble_gatts_cb_param_t* param);
+    void onDisconnect();
+
+private:
+    static const size_t MAX_WINDOW = 16;
+    static const size_t MAX_PACKET = 512;             // ATT MTU 517 - 3 (opcode + handle) - margin
+    static const size_t PACKET_HEADER = 4;
+    static const unsigned long ACK_TIMEOUT_MS = 2000;
+    static const int PACKETS_PER_UPDATE = 4;           // Bounds time spent per loop iteration
+
+    enum Opcode : uint8_t { OP_START = 0x01, OP_ACK = 0x02, OP_NACK = 0x03, OP_STOP = 0x04 };
+    enum PacketType : uint8_t { PKT_RECORDS = 0x01, PKT_END = 0x02 };
+
+    struct InFlight {
+        uint16_t packetNo;
+        uint32_t lastSeq;
+        uint8_t count;
+    };
+
+    DataManager& dataManager_;
+    BLEServer* server_;
+    BLECharacteristic* dataChar_;
+    BLECharacteristic* statusChar_;
+
+    // Commands from the BLE task, consumed by update()
+    portMUX_TYPE mux_;
+    bool startPending_;
+    uint32_t startSince_;
+    uint8_t startWindow_;
+    bool stopPending_;
+    bool ackPending_;
+    uint16_t ackPacketNo_;
+    bool nackPending_;
+    uint16_t nackPacketNo_;
+    volatile bool connected_;
+
+    // Transfer state (main loop only)
+    bool active_;
+    bool sourceDone_;
+    SyncCursor cursor_;
+    uint32_t ackedSeq_;
+    uint16_t ackedPacketNo_;
+    uint16_t nextPacketNo_;
+    uint8_t window_;
+    InFlight inFlight_[MAX_WINDOW];
+    size_t inFlightHead_;
+    size_t inFlightCount_;
+    unsigned long lastAckMs_;
+    unsigned long startMs_;
+    uint32_t recordsAcked_;
+    uint8_t packet_[MAX_PACKET];
+
+    MetricCounter recordsSent_;
+    MetricCounter retransmits_;
+    MetricGauge lastRate_;
+
+    void handleCommands();
+    void startTransfer(uint32_t since, uint8_t window);
+    void rewind(const char* reason);
+    void acknowledge(uint16_t packetNo);
+    bool sendRecordsPacket();
+    void finishTransfer();
+    size_t recordsPerPacket() const;
+
+    class ControlCallbacks : public BLECharacteristicCallbacks {
+    public:
+        explicit ControlCallbacks(BleHistoryService& owner) : owner_(owner) {}
+        void onWrite(BLECharacteristic* characteristic) override;
+    private:
+        BleHistoryService& owner_;
+    };
+    ControlCallbacks controlCallbacks_;
+};
+
+#endif // BLE_HISTORY_SERVICE_H
@@ -0,0 +1,59 @@
+#include "block_pool.h"
+#include "metrics.h"
+
+BlockPool::BlockPool(size_t blockSize, uint8_t count, HeapTag tag, MetricCounter* misses) :
+    buffer_(nullptr),
+    blockSize_((blockSize + 7) & ~(size_t)7),
+    count_(min(count, (uint8_t)MAX_BLOCKS)),
+    usedMask_(0),
+    tag_(tag),
+    misses_(misses)
+{
+    portMUX_INITIALIZE(&mux_);
+}
+
+bool BlockPool::begin() {
+    if (buffer_) return true;
+    buffer_ = (uint8_t*)heapAlloc(tag_, blockSize_ * count_, MALLOC_CAP_8BIT);
+    if (!buffer_) {
+        Serial.printf("[BlockPool] ERR: Could not allocate %u x %u bytes\n", (unsigned)count_, (unsigned)blockSize_);
+        return false;
+    }
+    return true;
+}
+
+void* BlockPool::acquire() {
+    void* block = nullptr;
+    portENTER_CRITICAL(&mux_);
+    for (uint8_t i = 0; buffer_ && i < count_; i++) {
+        if (!(usedMask_ & (1UL << i))) {
+            usedMask_ |= (1UL << i);
+            block = buffer_ + i * blockSize_;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&mux_);
+    if (!block && misses_) {
+        misses_->inc();
+    }
+    return block;
+}
+
+void BlockPool::release(void* block) {
+    if (!owns(block)) return;
+    size_t index = ((uint8_t*)block - buffer_) / blockSize_;
+    portENTER_CRITICAL(&mux_);
+    usedMask_ &= ~(1UL << index);
+    portEXIT_CRITICAL(&mux_);
+}
+
+bool BlockPool::owns(const void* block) const {
+    return buffer_ && block >= buffer_ && block < buffer_ + blockSize_ * count_;
+}
+
+uint8_t BlockPool::inUse() const {
+    portENTER_CRITICAL(&mux_);
+    uint8_t used = __builtin_popcount(usedMask_);
+    portEXIT_CRITICAL(&mux_);
+    return used;
+}
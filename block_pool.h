@@ -0,0 +1,42 @@
+#ifndef BLOCK_POOL_H
+#define BLOCK_POOL_H
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "heap_tracker.h"
+
+class MetricCounter;
+
+/**
+ * 固定大小内存块池 (Fixed-size block pool)
+ *
+ * begin() 时一次性分配 count 个 blockSize 字节的块, 之后 acquire()/release() 只是翻转
+ * 位图中的一位, 不再走堆分配器, 也就不会因为反复申请释放不同大小的缓冲区造成碎片。
+ * 池用完时 acquire() 返回 nullptr 并计数到 misses, 由调用者退回到原来的做法。
+ * 可在任意任务中使用 (portMUX 保护), 不能在 ISR 中使用。
+ */
+class BlockPool {
+public:
+    static const uint8_t MAX_BLOCKS = 32;
+
+    BlockPool(size_t blockSize, uint8_t count, HeapTag tag, MetricCounter* misses = nullptr);
+
+    bool begin();            // Allocates every block; call at boot / service start
+    void* acquire();         // nullptr when all blocks are in use
+    void release(void* block);
+    bool owns(const void* block) const;
+
+    size_t blockSize() const { return blockSize_; }
+    uint8_t inUse() const;
+
+private:
+    uint8_t* buffer_;
+    size_t blockSize_;
+    uint8_t count_;
+    uint32_t usedMask_;
+    HeapTag tag_;
+    MetricCounter* misses_;
+    mutable portMUX_TYPE mux_;
+};
+
+#endif // BLOCK_POOL_H
@@ -0,0 +1,92 @@
+#include "boot_timeline.h"
+#include "metrics.h"
+#include <esp_timer.h>
+
+BootTimeline bootTimeline;
+
+BootTimeline::BootTimeline() :
+    count_(0)
+{
+    portMUX_INITIALIZE(&mux_);
+    MetricsRegistry::instance().addCollector(collect, this);
+}
+
+void BootTimeline::mark(const char* name) {
+    int64_t now = esp_timer_get_time();
+    bool added = false;
+    portENTER_CRITICAL(&mux_);
+    bool seen = false;
+    for (size_t i = 0; i < count_ && !seen; i++) {
+        seen = strcmp(milestones_[i].name, name) == 0;
+    }
+    if (!seen && count_ < MAX_MILESTONES) {
+        milestones_[count_].name = name;
+        milestones_[count_].us = now;
+        count_++;
+        added = true;
+    }
+    portEXIT_CRITICAL(&mux_);
+    if (added) {
+        Serial.printf("[Boot] +%.1f ms %s\n", now / 1000.0f, name);
+    }
+}
+
+int64_t BootTimeline::elapsedUs(const char* name) const {
+    int64_t us = -1;
+    portENTER_CRITICAL(&mux_);
+    for (size_t i = 0; i < count_; i++) {
+        if (strcmp(milestones_[i].name, name) == 0) {
+            us = milestones_[i].us;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&mux_);
+    return us;
+}
+
+void BootTimeline::collect(MetricsWriter& w, void* context) {
+    BootTimeline* self = static_cast<BootTimeline*>(context);
+    Milestone copy[MAX_MILESTONES];
+    portENTER_CRITICAL(&self->mux_);
+    size_t count = self->count_;
+    memcpy(copy, self->milestones_, count * sizeof(Milestone));
+    portEXIT_CRITICAL(&self->mux_);
+
+    w.header("soundscape_boot_milestone_seconds", "Time from boot until each startup stage completed", "gauge");
+    char labels[48];
+    for (size_t i = 0; i < count; i++) {
+        snprintf(labels, sizeof(labels), "stage=\"%s\"", copy[i].name);
+        w.sample("soundscape_boot_milestone_seconds", labels, copy[i].us / 1e6f);
+    }
+    int64_t firstRecord = self->elapsedUs("first_record");
+    if (firstRecord >= 0) {
+        w.header("soundscape_boot_time_to_first_record_seconds", "Time from boot until the first record was stored", "gauge");
+        w.sample("soundscape_boot_time_to_first_record_seconds", nullptr, firstRecord / 1e6f);
+    }
+}
+
+BootStage::BootStage(const char* name, StageFn fn, uint32_t stackSize) :
+    name_(name),
+    fn_(fn),
+    stackSize_(stackSize),
+    done_(false)
+{}
+
+void BootStage::start() {
+    // Core 0 next to the WiFi stack; the loop keeps core 1 to itself
+    if (xTaskCreatePinnedToCore(taskEntry, name_, stackSize_, this, 1, nullptr, 0) != pdPASS) {
+        Serial.printf("[Boot] Could not start task for %s, running it inline\n", name_);
+        run();
+    }
+}
+
+void BootStage::taskEntry(void* param) {
+    static_cast<BootStage*>(param)->run();
+    vTaskDelete(nullptr);
+}
+
+void BootStage::run() {
+    fn_();
+    bootTimeline.mark(name_);
+    done_.store(true, std::memory_order_release);
+}
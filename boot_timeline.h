@@ -0,0 +1,69 @@
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <atomic>
+
+class MetricsWriter;
+
+/**
+ * 启动时间线 (Boot milestones)
+ *
+ * mark() 记录启动过程中各阶段完成的时刻 (esp_timer, 开机后微秒), 每个名字只记录第一次;
+ * 可从任意任务调用。每个里程碑在串口输出一行, 并在 /metrics 中导出为
+ * soundscape_boot_milestone_seconds{stage="..."}; 第一条记录写入缓冲区的时刻另外导出为
+ * soundscape_boot_time_to_first_record_seconds。
+ *
+ * BootStage 把一个一次性的慢初始化 (开机动画、BLE 协议栈) 放到独立任务中执行,
+ * 完成时记录同名里程碑; 主循环用 done() 判断是否可以开始使用对应模块。
+ */
+class BootTimeline {
+public:
+    static const size_t MAX_MILESTONES = 24;
+
+    BootTimeline();
+
+    // name must be a string literal. Later marks with the same name are ignored.
+    void mark(const char* name);
+    // Microseconds since boot of a milestone, or -1 if not reached yet
+    int64_t elapsedUs(const char* name) const;
+
+private:
+    struct Milestone {
+        const char* name;
+        int64_t us;
+    };
+
+    Milestone milestones_[MAX_MILESTONES];
+    size_t count_;
+    mutable portMUX_TYPE mux_;
+
+    static void collect(MetricsWriter& w, void* context);
+};
+
+extern BootTimeline bootTimeline;
+
+class BootStage {
+public:
+    typedef void (*StageFn)();
+
+    // name is also the milestone recorded when fn returns (string literal)
+    BootStage(const char* name, StageFn fn, uint32_t stackSize = 4096);
+
+    // Runs fn in its own task (core 0, low priority); inline if the task cannot be created
+    void start();
+    bool done() const { return done_.load(std::memory_order_acquire); }
+
+private:
+    const char* name_;
+    StageFn fn_;
+    uint32_t stackSize_;
+    std::atomic<bool> done_;
+
+    static void taskEntry(void* param);
+    void run();
+};
+
+#endif // BOOT_TIMELINE_H
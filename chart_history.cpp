@@ -0,0 +1,115 @@
+#include "chart_history.h"
+#include <cmath>
+
+// Column seconds are whole numbers: 5 s, 20 s, 2 min, 8 min per pixel
+static const uint32_t SPAN_SECONDS[ChartHistory::SPAN_COUNT] = {15 * 60, 3600, 6 * 3600, 24 * 3600};
+static const char* const SPAN_NAMES[ChartHistory::SPAN_COUNT] = {"15m", "1h", "6h", "24h"};
+// Fixed-point resolution per QueryField (db, temp, hum, lux)
+static const float FIELD_SCALE[QUERY_FIELD_COUNT] = {100.0f, 100.0f, 100.0f, 0.5f};
+
+ChartHistory::ChartHistory(DataManager& dataMgr) :
+    dataManager_(dataMgr),
+    lastSeq_(0)
+{
+    for (int s = 0; s < SPAN_COUNT; s++) {
+        clearSpan(s);
+        shifts_[s] = 0;
+    }
+}
+
+uint32_t ChartHistory::spanSeconds(int span) {
+    return (span >= 0 && span < SPAN_COUNT) ? SPAN_SECONDS[span] : SPAN_SECONDS[0];
+}
+
+const char* ChartHistory::spanName(int span) {
+    return (span >= 0 && span < SPAN_COUNT) ? SPAN_NAMES[span] : "?";
+}
+
+void ChartHistory::update() {
+    uint32_t seq = dataManager_.getLastSeq();
+    if (seq == 0 || seq == lastSeq_) {
+        return;
+    }
+    lastSeq_ = seq;
+    addRecord(dataManager_.getLatestData());
+}
+
+void ChartHistory::addRecord(const EnvironmentData& record) {
+    if (record.timestamp <= 0) return;
+
+    for (int s = 0; s < SPAN_COUNT; s++) {
+        int64_t col = (int64_t)record.timestamp / (SPAN_SECONDS[s] / COLUMNS);
+        int64_t& head = headColumn_[s];
+
+        if (head < 0) {
+            head = col;
+        } else if (col > head) {
+            // Entering a new column: the plot scrolls; clear the columns being reused
+            int64_t advance = col - head;
+            if (advance >= COLUMNS) {
+                clearSpan(s);
+            } else {
+                for (int64_t k = 1; k <= advance; k++) {
+                    clearColumn(s, (int)((head + k) % COLUMNS));
+                }
+            }
+            head = col;
+            shifts_[s]++;
+        } else if (col <= head - COLUMNS) {
+            // Time base moved backwards past the window (clock change): start over
+            clearSpan(s);
+            head = col;
+            shifts_[s]++;
+        }
+
+        int slot = (int)(col % COLUMNS);
+        for (int f = 0; f < QUERY_FIELD_COUNT; f++) {
+            float v = queryFieldValue(record, (QueryField)f);
+            if (isnan(v)) continue;
+            int16_t raw = encode((QueryField)f, v);
+            Envelope& e = env_[s][f];
+            if (raw < e.lo[slot]) e.lo[slot] = raw;
+            if (raw > e.hi[slot]) e.hi[slot] = raw;
+        }
+    }
+}
+
+bool ChartHistory::column(int span, QueryField field, int col, float& lo, float& hi) const {
+    if (span < 0 || span >= SPAN_COUNT || field >= QUERY_FIELD_COUNT || col < 0 || col >= COLUMNS) {
+        return false;
+    }
+    int64_t head = headColumn_[span];
+    if (head < 0) return false;
+    int64_t abs = head - (COLUMNS - 1) + col;
+    if (abs < 0) return false;
+    int slot = (int)(abs % COLUMNS);
+    const Envelope& e = env_[span][field];
+    if (e.hi[slot] < e.lo[slot]) return false; // Empty column
+    lo = decode(field, e.lo[slot]);
+    hi = decode(field, e.hi[slot]);
+    return true;
+}
+
+void ChartHistory::clearSpan(int span) {
+    headColumn_[span] = -1;
+    for (int slot = 0; slot < COLUMNS; slot++) {
+        clearColumn(span, slot);
+    }
+}
+
+void ChartHistory::clearColumn(int span, int slot) {
+    for (int f = 0; f < QUERY_FIELD_COUNT; f++) {
+        env_[span][f].lo[slot] = EMPTY_LO;
+        env_[span][f].hi[slot] = EMPTY_HI;
+    }
+}
+
+int16_t ChartHistory::encode(QueryField field, float value) {
+    float scaled = roundf(value * FIELD_SCALE[field]);
+    // Keep clear of the empty markers
+    return (int16_t)constrain(scaled, (float)(INT16_MIN + 1), (float)(INT16_MAX - 1));
+}
+
+float ChartHistory::decode(QueryField field, int16_t raw) {
+    return raw / FIELD_SCALE[field];
+}
@@ -0,0 +1,62 @@
+#ifndef CHART_HISTORY_H
+#define CHART_HISTORY_H
+
+#include <Arduino.h>
+#include "data_manager.h"
+#include "history_query.h"
+
+/**
+ * 历史曲线的逐像素列包络 (Per-pixel-column min/max envelopes for the chart screen)
+ *
+ * 每个时间跨度 (15 分钟 / 1 小时 / 6 小时 / 24 小时) 对应 COLUMNS 个像素列, 每列保存该
+ * 时间段内各字段的最小值和最大值。新记录到来时只更新它所在的那一列 (O(1)), 绘图时直接
+ * 读取列包络, 从不重新扫描原始数据。列以环形缓冲保存, 进入新的时间段时整体左移一列。
+ *
+ * 数据来源: 主循环中 update() 发现新的 seq 时读取 getLatestData(), 因此曲线从开机开始
+ * (DataManager 的内存缓冲区每分钟写入 SD 后即清空, 只有不到一分钟的数据; SD 上的历史不回填)。
+ * 记录时间戳从开机秒数切换为 NTP 时间 (首次同步) 时时间轴跳变, 包络会被清空重建。
+ *
+ * 数值以 int16 定点保存 (dB/温度/湿度 0.01, 光照 2 lx), 全部包络约 11.5 KB。
+ */
+class ChartHistory {
+public:
+    static const int COLUMNS = 180;  // Plot width in pixels
+    static const int SPAN_COUNT = 4;
+
+    explicit ChartHistory(DataManager& dataMgr);
+
+    void update(); // Called in loop; ingests the newest record when seq changes
+
+    static uint32_t spanSeconds(int span);
+    static const char* spanName(int span);   // "15m", "1h", ...
+
+    // Envelope of column col (0 = oldest, COLUMNS - 1 = newest). False if no samples.
+    bool column(int span, QueryField field, int col, float& lo, float& hi) const;
+    // Incremented whenever the span's columns shift left (the whole plot moves)
+    uint32_t shiftCount(int span) const { return shifts_[span]; }
+    uint32_t lastSeq() const { return lastSeq_; }
+
+private:
+    static const int16_t EMPTY_LO = INT16_MAX;
+    static const int16_t EMPTY_HI = INT16_MIN;
+
+    struct Envelope {
+        int16_t lo[COLUMNS];
+        int16_t hi[COLUMNS];
+    };
+
+    DataManager& dataManager_;
+    Envelope env_[SPAN_COUNT][QUERY_FIELD_COUNT]; // Ring of columns, indexed by absolute column % COLUMNS
+    int64_t headColumn_[SPAN_COUNT];  // Absolute column number (timestamp / column seconds) of the newest column
+    uint32_t shifts_[SPAN_COUNT];
+    uint32_t lastSeq_;
+
+    void addRecord(const EnvironmentData& record);
+    void clearSpan(int span);
+    void clearColumn(int span, int slot);
+
+    static int16_t encode(QueryField field, float value);
+    static float decode(QueryField field, int16_t raw);
+};
+
+#endif // CHART_HISTORY_H
@@ -0,0 +1,199 @@
+#include "chart_screen.h"
+#include "ui_manager.h" // forceRedraw after a span/field change
+#include "data_manager.h" // Include DataManager for getLatestData
+#include "ui_constants.h" // Include constants (e.g., TITLE_Y)
+#include <cmath>
+
+// Plot area; one pixel column per ChartHistory column
+const int PLOT_X = 50;
+const int PLOT_Y = 62;
+const int PLOT_W = ChartHistory::COLUMNS;
+const int PLOT_H = 190;
+
+// Per QueryField (db, temp, hum, lux)
+static const char* const FIELD_LABELS[QUERY_FIELD_COUNT] = {"Noise (dB)", "Temp (C)", "Humidity (%)", "Light (lx)"};
+static const uint8_t FIELD_DECIMALS[QUERY_FIELD_COUNT] = {1, 1, 1, 0};
+static const float FIELD_MIN_RANGE[QUERY_FIELD_COUNT] = {10.0f, 2.0f, 5.0f, 20.0f}; // Avoid magnifying noise
+static const uint16_t FIELD_COLORS[QUERY_FIELD_COUNT] = {TFT_YELLOW, TFT_ORANGE, TFT_CYAN, TFT_WHITE};
+
+ChartScreen::ChartScreen(TFT_eSPI& display, DataManager& dataMgr, ChartHistory& history) :
+    Screen(display, dataMgr),
+    history_(history),
+    span_(ChartHistory::SPAN_COUNT - 1), // 24h
+    field_(QUERY_FIELD_DB),
+    subtitle_(TC_DATUM, 2, TFT_WHITE, TFT_BLACK),
+    hiLabel_(TR_DATUM, 1, TFT_LIGHTGREY, TFT_BLACK),
+    loLabel_(BR_DATUM, 1, TFT_LIGHTGREY, TFT_BLACK),
+    current_(TL_DATUM, 2, TFT_WHITE, TFT_BLACK),
+    rangeValid_(false),
+    rangeLo_(0.0f),
+    rangeHi_(0.0f),
+    drawnShifts_(0),
+    drawnSeq_(0)
+{}
+
+void ChartScreen::draw(int yOffset /* = 0 */) {
+    TFT_eSPI& tft = canvas();
+    tft.setTextColor(TFT_WHITE, TFT_BLACK);
+
+    // Title - Centered, Size 2
+    tft.setTextDatum(TC_DATUM);
+    tft.setTextSize(2);
+    tft.drawString("History", tft.width() / 2, TITLE_Y + yOffset);
+
+    // Frame and time axis
+    tft.drawRect(PLOT_X - 1, PLOT_Y - 1 + yOffset, PLOT_W + 2, PLOT_H + 2, TFT_DARKGREY);
+    tft.setTextSize(1);
+    tft.setTextColor(TFT_LIGHTGREY, TFT_BLACK);
+    char spanLabel[8];
+    snprintf(spanLabel, sizeof(spanLabel), "-%s", ChartHistory::spanName(span_));
+    tft.setTextDatum(TL_DATUM);
+    tft.drawString(spanLabel, PLOT_X, PLOT_Y + PLOT_H + 4 + yOffset);
+    tft.setTextDatum(TR_DATUM);
+    tft.drawString("now", PLOT_X + PLOT_W, PLOT_Y + PLOT_H + 4 + yOffset);
+    tft.setTextDatum(TC_DATUM);
+    tft.drawString("Left: span  Center: field", tft.width() / 2, tft.height() - 12 + yOffset);
+
+    subtitle_.place(tft.width() / 2, TITLE_Y + LINE_HEIGHT);
+    hiLabel_.place(PLOT_X - 4, PLOT_Y);
+    loLabel_.place(PLOT_X - 4, PLOT_Y + PLOT_H);
+    current_.place(H_PADDING, PLOT_Y + PLOT_H + 18);
+
+    float lo, hi;
+    if (computeRange(lo, hi)) {
+        setRange(lo, hi);
+    } else {
+        rangeValid_ = false;
+    }
+    renderValues(yOffset, false);
+    drawPlot(tft, yOffset);
+    drawnShifts_ = history_.shiftCount(span_);
+    drawnSeq_ = history_.lastSeq();
+
+    tft.setTextDatum(TL_DATUM);
+    tft.setTextColor(TFT_WHITE, TFT_BLACK);
+}
+
+bool ChartScreen::updateValues() {
+    TFT_eSPI& tft = canvas();
+    uint32_t shifts = history_.shiftCount(span_);
+    uint32_t seq = history_.lastSeq();
+
+    // Axes: only the column envelopes are scanned, never the raw samples
+    float lo = 0.0f, hi = 0.0f;
+    bool haveData = computeRange(lo, hi);
+    bool replot = false;
+    if (haveData && (!rangeValid_ || shifts != drawnShifts_ || lo < rangeLo_ || hi > rangeHi_)) {
+        // Scrolled, or the new sample is outside the drawn range: rescale. A shrinking
+        // range is only applied when the plot scrolls anyway.
+        setRange(lo, hi);
+        replot = true;
+    } else if (shifts != drawnShifts_) {
+        replot = true;
+    }
+
+    if (!renderValues(0, true)) {
+        return false; // Not drawn in place yet
+    }
+    if (replot) {
+        drawPlot(tft, 0);
+    } else if (seq != drawnSeq_) {
+        drawColumn(tft, PLOT_W - 1, 0); // Only the newest column changed
+        ValueField::countRect(PLOT_X + PLOT_W - 1, PLOT_Y, 1, PLOT_H);
+    }
+    drawnShifts_ = shifts;
+    drawnSeq_ = seq;
+
+    tft.setTextDatum(TL_DATUM);
+    tft.setTextColor(TFT_WHITE, TFT_BLACK);
+    return true;
+}
+
+bool ChartScreen::handleInput(UIManager* uiManager, int buttonPin) {
+    if (buttonPin == BTN_LEFT_PIN) {
+        span_ = (span_ + 1) % ChartHistory::SPAN_COUNT;
+    } else if (buttonPin == BTN_CENTER_PIN) {
+        field_ = (QueryField)((field_ + 1) % QUERY_FIELD_COUNT);
+    } else {
+        return false;
+    }
+    Serial.printf("[ChartScreen] %s over %s\n", queryFieldName(field_), ChartHistory::spanName(span_));
+    uiManager->forceRedraw(); // Axes, labels and every column change
+    return true;
+}
+
+bool ChartScreen::computeRange(float& lo, float& hi) const {
+    bool any = false;
+    for (int col = 0; col < PLOT_W; col++) {
+        float cLo, cHi;
+        if (!history_.column(span_, field_, col, cLo, cHi)) continue;
+        if (!any || cLo < lo) lo = cLo;
+        if (!any || cHi > hi) hi = cHi;
+        any = true;
+    }
+    return any;
+}
+
+void ChartScreen::setRange(float lo, float hi) {
+    float minRange = FIELD_MIN_RANGE[field_];
+    if (hi - lo < minRange) {
+        float mid = (hi + lo) / 2.0f;
+        lo = mid - minRange / 2.0f;
+        hi = mid + minRange / 2.0f;
+    }
+    float pad = (hi - lo) * 0.05f;
+    rangeLo_ = lo - pad;
+    rangeHi_ = hi + pad;
+    rangeValid_ = true;
+}
+
+int ChartScreen::valueToY(float value) const {
+    float t = (value - rangeLo_) / (rangeHi_ - rangeLo_);
+    int y = PLOT_Y + PLOT_H - 1 - (int)lroundf(t * (PLOT_H - 1));
+    return constrain(y, PLOT_Y, PLOT_Y + PLOT_H - 1);
+}
+
+void ChartScreen::drawColumn(TFT_eSPI& tft, int col, int yOffset) {
+    int x = PLOT_X + col;
+    tft.drawFastVLine(x, PLOT_Y + yOffset, PLOT_H, TFT_BLACK);
+    float lo, hi;
+    if (!rangeValid_ || !history_.column(span_, field_, col, lo, hi)) {
+        return;
+    }
+    int yTop = valueToY(hi);
+    int yBottom = valueToY(lo);
+    tft.drawFastVLine(x, yTop + yOffset, yBottom - yTop + 1, FIELD_COLORS[field_]);
+}
+
+void ChartScreen::drawPlot(TFT_eSPI& tft, int yOffset) {
+    for (int col = 0; col < PLOT_W; col++) {
+        drawColumn(tft, col, yOffset);
+    }
+    ValueField::countRect(PLOT_X, PLOT_Y + yOffset, PLOT_W, PLOT_H);
+}
+
+bool ChartScreen::renderValues(int yOffset, bool inPlace) {
+    TFT_eSPI& tft = canvas();
+    char text[ValueField::MAX_TEXT];
+    bool ok = true;
+
+    snprintf(text, sizeof(text), "%s %s", FIELD_LABELS[field_], ChartHistory::spanName(span_));
+    ok &= subtitle_.show(tft, text, yOffset, inPlace);
+
+    uint8_t decimals = FIELD_DECIMALS[field_];
+    if (rangeValid_) {
+        formatValue(text, sizeof(text), rangeHi_, decimals);
+        ok &= hiLabel_.show(tft, text, yOffset, inPlace);
+        formatValue(text, sizeof(text), rangeLo_, decimals);
+        ok &= loLabel_.show(tft, text, yOffset, inPlace);
+    } else {
+        ok &= hiLabel_.show(tft, "", yOffset, inPlace);
+        ok &= loLabel_.show(tft, "", yOffset, inPlace);
+    }
+
+    char value[ValueField::MAX_TEXT];
+    formatValue(value, sizeof(value), queryFieldValue(getLatestData(), field_), decimals);
+    snprintf(text, sizeof(text), "Now: %s", value);
+    ok &= current_.show(tft, text, yOffset, inPlace);
+    return ok;
+}
@@ -0,0 +1,48 @@
+#ifndef CHART_SCREEN_H
+#define CHART_SCREEN_H
+
+#include "screen.h"
+#include "ui_widgets.h"
+#include "chart_history.h"
+
+// Forward declaration
+class DataManager;
+
+// History chart: min/max envelope per pixel column from ChartHistory.
+// BTN4 (Left) cycles the time span, BTN5 (Center) cycles the plotted field.
+// A data update repaints only the newest column unless the plot scrolled or the
+// value range grew, in which case the columns are redrawn from the envelopes.
+class ChartScreen : public Screen {
+public:
+    ChartScreen(TFT_eSPI& display, DataManager& dataMgr, ChartHistory& history);
+
+    void draw(int yOffset = 0) override;
+    bool updateValues() override;
+    bool handleInput(UIManager* uiManager, int buttonPin) override;
+
+private:
+    ChartHistory& history_;
+    uint8_t span_;
+    QueryField field_;
+
+    ValueField subtitle_;   // "Noise (dB)  24h"
+    ValueField hiLabel_;    // Y axis labels
+    ValueField loLabel_;
+    ValueField current_;    // Latest value
+
+    // Y axis range of the drawn plot and what it was drawn from
+    bool rangeValid_;
+    float rangeLo_;
+    float rangeHi_;
+    uint32_t drawnShifts_;
+    uint32_t drawnSeq_;
+
+    bool computeRange(float& lo, float& hi) const; // Over the visible columns' envelopes
+    void setRange(float lo, float hi);
+    int valueToY(float value) const;
+    void drawColumn(TFT_eSPI& tft, int col, int yOffset);
+    void drawPlot(TFT_eSPI& tft, int yOffset);
+    bool renderValues(int yOffset, bool inPlace);
+};
+
+#endif // CHART_SCREEN_H
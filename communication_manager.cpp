@@ -1,5 +1,13 @@
 #include "communication_manager.h"
 #include "ui_manager.h"
+#include "data_manager.h"
+#include "metrics.h"
+#include "web_assets.h"
+#include "time_keeper.h"
+#include "glyph_cache.h"
+#include "boot_timeline.h"
+#include "heap_tracker.h"
+#include <TFT_eSPI.h>
 #include <ArduinoJson.h>
 #include <ESPAsyncWebServer.h>
 #include <algorithm>
@@ -11,23 +19,42 @@ CommunicationManager* globalCommManagerPtr = nullptr;
 #error "Requires ArduinoJson 6 or higher"
 #endif
 
-CommunicationManager::CommunicationManager(I2SMicManager* micMgr, UIManager* uiMgr,
+CommunicationManager::CommunicationManager(I2SMicManager* micMgr, UIManager* uiMgr, DataManager* dataMgr,
                                          const char* ssid, const char* password,
                                          const char* ntpServer, long gmtOffset, int daylightOffset) :
     server(nullptr),
+    clientCount_(0),
+    commandArena_(COMMAND_ARENA_SIZE, HEAP_TAG_COMM, &systemMetrics.jsonArenaOverflows),
+    httpArena_(HTTP_ARENA_SIZE, HEAP_TAG_COMM, &systemMetrics.jsonArenaOverflows),
+    httpBodies_(HTTP_BODY_SIZE, HTTP_BODY_COUNT, HEAP_TAG_COMM, &systemMetrics.httpBodyPoolMisses),
     audioWs(nullptr),
+    maxAudioClients_(1),
     isRunning(false),
     micManagerPtr(micMgr),
     uiManagerPtr_(uiMgr),
+    dataManagerPtr_(dataMgr),
     audioClientsMutex(nullptr),
+    httpServer_(nullptr),
+    httpRunning_(false),
+    wifiState_(WIFI_STATE_IDLE),
+    wifiStateSinceMs_(0),
+    wifiNextAttemptMs_(0),
+    wifiBackoffMs_(WIFI_BACKOFF_INITIAL_MS),
+    wifiAttempts_(0),
+    wifiLinkUpPending_(false),
+    wifiLinkDownPending_(false),
+    wifiDisconnectReason_(0),
+    ntpPending_(false),
+    ntpLastCheckMs_(0),
     wifiSsid_(ssid),
     wifiPassword_(password),
     ntpServer_(ntpServer),
     gmtOffsetSec_(gmtOffset),
     daylightOffsetSec_(daylightOffset)
 {
-    clients.reserve(MAX_CLIENTS);
-    audioWsClients.reserve(MAX_AUDIO_WS_CLIENTS);
+    for (size_t i = 0; i < MAX_CLIENTS; ++i) {
+        clients[i].active = false;
+    }
     globalCommManagerPtr = this;
 
     // Create the mutex
@@ -39,6 +66,7 @@ CommunicationManager::CommunicationManager(I2SMicManager* micMgr, UIManager* uiM
     if (!uiManagerPtr_) {
          Serial.println("ERR: CommunicationManager created with null UIManager pointer!");
     }
+    MetricsRegistry::instance().addCollector(collectMetrics, this);
 }
 
 CommunicationManager::~CommunicationManager() {
@@ -74,17 +102,19 @@ void CommunicationManager::stop() {
     if (!isRunning) return;
     
     // 关闭所有客户端连接
-    for (auto& client : clients) {
-        if (client.connected()) {
-            client.stop();
+    for (auto& session : clients) {
+        if (!session.active) continue;
+        if (session.client.connected()) {
+            session.client.stop();
         }
+        releaseSession(session);
     }
-    clients.clear();
+    clientCount_ = 0;
     
     if (audioWs) {
         if (xSemaphoreTake(audioClientsMutex, portMAX_DELAY) == pdTRUE) {
-            for (auto* client : audioWsClients) {
-                if(client) client->close();
+            for (auto& ac : audioWsClients) {
+                if (ac.client) ac.client->close();
             }
             audioWsClients.clear();
             xSemaphoreGive(audioClientsMutex);
@@ -104,6 +134,9 @@ void CommunicationManager::stop() {
 }
 
 void CommunicationManager::update() {
+    HeapScope heapScope(HEAP_TAG_COMM);
+    updateWiFi();
+
     if (!isRunning || !server) return;
     
     static unsigned long lastUpdateTime = 0;
@@ -131,10 +164,26 @@ void CommunicationManager::handleNewConnections() {
     WiFiClient newClient = server->accept();
     if (!newClient) return;
     
-    if (clients.size() < MAX_CLIENTS) {
-        clients.push_back(newClient);
+    ClientSession* freeSlot = nullptr;
+    for (auto& slot : clients) {
+        if (!slot.active) {
+            freeSlot = &slot;
+            break;
+        }
+    }
+    if (freeSlot) {
+        ClientSession& session = *freeSlot;
+        session.active = true;
+        clientCount_++;
+        session.client = newClient;
+        session.binaryMode = false;
+        session.envSchema = WireProtocol::SCHEMA_ENV_V2;
+        session.rxLen = 0;
+        session.syncActive = false;
+        session.queryJob = 0;
         Serial.printf("新客户端连接: %s\n", newClient.remoteIP().toString().c_str());
-        newClient.println("CONNECTED");
+        // Advertise the supported protocols; the client may switch with "PROTO BIN1 [ENV3]"
+        newClient.println("CONNECTED PROTO=TEXT,BIN1 SCHEMA=ENV2,ENV3");
     } else {
         Serial.println("达到最大客户端数量限制，拒绝新连接");
         newClient.println("SERVER_FULL");
@@ -143,30 +192,110 @@ void CommunicationManager::handleNewConnections() {
 }
 
 void CommunicationManager::handleClientMessages() {
-    for (auto& client : clients) {
-        if (!client.connected() || !client.available()) continue;
-        
-        String command = client.readStringUntil('\n');
-        if (command.length() == 0) continue;
-        
-        command.trim();
-        processClientCommand(client, command);
+    char command[CLIENT_RX_BUFFER_SIZE];
+
+    for (auto& session : clients) {
+        WiFiClient& client = session.client;
+        if (!session.active || !client.connected()) continue;
+
+        // Non-blocking read of whatever has arrived (no readStringUntil timeout)
+        int available = client.available();
+        if (available > 0) {
+            if (session.rxLen >= sizeof(session.rxBuf)) {
+                // Request longer than the buffer: drop it and resynchronise
+                session.rxLen = 0;
+                sendStatus(session, 0, "REQUEST_TOO_LONG", true);
+            }
+            size_t space = sizeof(session.rxBuf) - session.rxLen;
+            int n = client.read(session.rxBuf + session.rxLen, min((size_t)available, space));
+            if (n > 0) session.rxLen += n;
+        }
+
+        // Drain every complete request already buffered (pipelining)
+        uint32_t requestSeq = 0;
+        for (int i = 0; i < MAX_COMMANDS_PER_UPDATE; ++i) {
+            if (!extractCommand(session, command, sizeof(command), requestSeq)) break;
+            if (command[0] == '\0') continue;
+            processClientCommand(session, command, requestSeq);
+        }
+
+        if (session.syncActive) {
+            pumpSync(session);
+        }
+        if (session.queryJob != 0) {
+            pumpQuery(session);
+        }
         yield(); // 让出CPU时间给其他任务
     }
 }
 
+// Pops one complete request from the session buffer into command (null-terminated).
+// Text mode: one '\n'-terminated line. Binary mode: one FRAME_REQUEST frame.
+bool CommunicationManager::extractCommand(ClientSession& session, char* command, size_t commandSize, uint32_t& requestSeq) {
+    size_t consumed = 0;
+    size_t cmdLen = 0;
+    const uint8_t* cmdStart = nullptr;
+    requestSeq = 0;
+
+    if (!session.binaryMode) {
+        uint8_t* newline = (uint8_t*)memchr(session.rxBuf, '\n', session.rxLen);
+        if (!newline) return false;
+        cmdStart = session.rxBuf;
+        cmdLen = newline - session.rxBuf;
+        consumed = cmdLen + 1;
+    } else {
+        if (session.rxLen < WireProtocol::HEADER_SIZE) return false;
+        WireProtocol::FrameHeader header;
+        if (!WireProtocol::decodeHeader(session.rxBuf, session.rxLen, header) ||
+            header.type != WireProtocol::FRAME_REQUEST ||
+            WireProtocol::HEADER_SIZE + header.length > sizeof(session.rxBuf)) {
+            // Framing lost: discard everything buffered so the client can resync
+            session.rxLen = 0;
+            sendStatus(session, 0, "BAD_FRAME", true);
+            return false;
+        }
+        if (session.rxLen < WireProtocol::HEADER_SIZE + header.length) return false;
+        cmdStart = session.rxBuf + WireProtocol::HEADER_SIZE;
+        cmdLen = header.length;
+        consumed = WireProtocol::HEADER_SIZE + header.length;
+        requestSeq = header.seq;
+    }
+
+    // Copy and trim (whitespace and CR)
+    while (cmdLen > 0 && isspace(cmdStart[cmdLen - 1])) cmdLen--;
+    while (cmdLen > 0 && isspace(*cmdStart)) { cmdStart++; cmdLen--; }
+    cmdLen = min(cmdLen, commandSize - 1);
+    memcpy(command, cmdStart, cmdLen);
+    command[cmdLen] = '\0';
+
+    // Shift remaining (pipelined) bytes to the front
+    session.rxLen -= consumed;
+    if (session.rxLen > 0) {
+        memmove(session.rxBuf, session.rxBuf + consumed, session.rxLen);
+    }
+    return true;
+}
+
 void CommunicationManager::removeDisconnectedClients() {
-    auto it = clients.begin();
-    while (it != clients.end()) {
-        if (!it->connected()) {
+    for (auto& session : clients) {
+        if (session.active && !session.client.connected()) {
             Serial.println("移除断开的客户端");
-            it = clients.erase(it);
-        } else {
-            ++it;
+            releaseSession(session);
+            clientCount_--;
         }
     }
 }
 
+// Frees a slot: drops the socket handle and abandons a query still running for it
+void CommunicationManager::releaseSession(ClientSession& session) {
+    if (session.queryJob != 0 && dataManagerPtr_) {
+        dataManagerPtr_->cancelQuery(session.queryJob);
+    }
+    session.queryJob = 0;
+    session.client = WiFiClient(); // The slot is reused as is
+    session.active = false;
+}
+
 void CommunicationManager::broadcastEnvironmentData(const EnvironmentData& data) {
     if (!isRunning) return;
     
@@ -175,11 +304,13 @@ void CommunicationManager::broadcastEnvironmentData(const EnvironmentData& data)
 }
 
 void CommunicationManager::sendHistoricalData(WiFiClient& client, const std::vector<EnvironmentData>& data) {
-    JsonDocument doc;
+    commandArena_.reset();
+    JsonDocument doc(&commandArena_); // Larger histories spill over to the heap
     JsonArray array = doc["data"].to<JsonArray>();
     
     for (const auto& record : data) {
         JsonObject obj = array.add<JsonObject>();
+        obj["seq"] = record.seq;
         obj["timestamp"] = record.timestamp;
         obj["decibels"] = record.decibels;
         obj["temperature"] = record.temperature;
@@ -187,378 +318,475 @@ void CommunicationManager::sendHistoricalData(WiFiClient& client, const std::vec
         obj["lux"] = record.lux;
     }
     
-    String jsonString;
-    serializeJson(doc, jsonString);
-    client.println(jsonString);
+    serializeJson(doc, client); // Streamed to the socket, no intermediate String
+    client.println();
 }
 
 void CommunicationManager::sendJsonData(WiFiClient& client, const EnvironmentData& data) {
     if (!client.connected()) return;
-    
-    JsonDocument doc;
+
+    char line[JSON_LINE_SIZE];
+    size_t length = formatRecordJson(data, line, sizeof(line));
+    client.write((const uint8_t*)line, length);
+    client.write((const uint8_t*)"\r\n", 2);
+}
+
+// One record as a JSON object in out (null-terminated); returns its length
+size_t CommunicationManager::formatRecordJson(const EnvironmentData& data, char* out, size_t outSize) {
+    commandArena_.reset();
+    JsonDocument doc(&commandArena_);
+    doc["seq"] = data.seq;
     doc["timestamp"] = data.timestamp;
+    if (data.flags & EnvironmentData::FLAG_TIME_UNSYNCED) {
+        doc["timeUnsynced"] = true; // timestamp is seconds since boot
+    }
     doc["decibels"] = data.decibels;
     doc["humidity"] = data.humidity;
     doc["temperature"] = data.temperature;
     doc["lux"] = data.lux;
-    
-    String jsonString;
-    serializeJson(doc, jsonString);
-    
-    client.println(jsonString);
+    return serializeJson(doc, out, outSize);
 }
 
-void CommunicationManager::processClientCommand(WiFiClient& client, const String& command) {
-    Serial.printf("收到客户端命令: %s\n", command.c_str());
-    
-    if (command == "GET_CURRENT") {
-        if (currentData.timestamp != 0) {
-            sendJsonData(client, currentData);
-        } else {
-            Serial.println("警告：没有可用的当前数据");
-            client.println("NO_DATA");
+void CommunicationManager::sendRecords(ClientSession& session, uint32_t requestSeq, const EnvironmentData* records, size_t count) {
+    if (!session.client.connected()) return;
+
+    if (!session.binaryMode) {
+        for (size_t i = 0; i < count; ++i) {
+            sendJsonData(session.client, records[i]);
         }
+        return;
     }
-    else if (command == "GET_HISTORY") {
-        Serial.println("处理GET_HISTORY命令 (未实现)");
-        client.println("HISTORY_NOT_IMPLEMENTED");
+
+    // Pack as many records per frame as the payload limit allows
+    uint8_t frame[WireProtocol::HEADER_SIZE + WireProtocol::MAX_PAYLOAD];
+    size_t recordsPerFrame = WireProtocol::MAX_PAYLOAD / WireProtocol::envRecordSize(session.envSchema);
+    size_t sent = 0;
+    do {
+        size_t batch = min(count - sent, recordsPerFrame);
+        size_t frameLen = WireProtocol::encodeEnvFrame(frame, sizeof(frame), requestSeq, records + sent, batch,
+                                                       session.envSchema);
+        if (frameLen == 0) break;
+        session.client.write(frame, frameLen);
+        sent += batch;
+    } while (sent < count);
+}
+
+void CommunicationManager::sendStatus(ClientSession& session, uint32_t requestSeq, const char* text, bool isError) {
+    if (!session.client.connected()) return;
+
+    if (!session.binaryMode) {
+        session.client.println(text);
+        return;
     }
-    else {
-        Serial.printf("未知命令: %s\n", command.c_str());
-        client.println("UNKNOWN_COMMAND");
+    uint8_t frame[WireProtocol::HEADER_SIZE + 160];
+    size_t frameLen = WireProtocol::encodeTextFrame(frame, sizeof(frame),
+                                                    isError ? WireProtocol::FRAME_ERROR : WireProtocol::FRAME_STATUS,
+                                                    requestSeq, text);
+    if (frameLen > 0) {
+        session.client.write(frame, frameLen);
     }
 }
 
-void CommunicationManager::setupHttpServer(AsyncWebServer* httpServer) {
-    if (!httpServer) return;
-
-    // 提供根路径的 HTML 页面
-    httpServer->on("/", HTTP_GET, [this](AsyncWebServerRequest *request){
-        // 发送包含 JavaScript WebSocket 客户端和 Web Audio API 播放器的 HTML
-        String html = R"(
-<!DOCTYPE html>
-<html>
-<head>
-    <title>ESP32 Audio Stream</title>
-    <meta name='viewport' content='width=device-width, initial-scale=1'>
-    <style>
-        body { font-family: sans-serif; text-align: center; padding: 20px; }
-        button { font-size: 1.2em; padding: 10px 20px; margin: 10px; cursor: pointer; }
-        #status { margin-top: 20px; font-weight: bold; }
-    </style>
-</head>
-<body>
-    <h1>ESP32 Live Audio Stream</h1>
-    <button id='playButton'>Play</button>
-    <button id='stopButton' disabled>Stop</button>
-    <div id='status'>Status: Disconnected</div>
-
-    <script>
-        let ws = null;
-        let audioContext = null;
-        let audioBufferQueue = [];
-        let isPlaying = false;
-        let isBuffering = true;
-        let nextStartTime = 0;
-        const sampleRate = 16000; // 与 ESP32 I2S 采样率匹配
-        const bufferSizeSeconds = 0.5; // 客户端缓冲秒数
-        const targetBufferSize = sampleRate * bufferSizeSeconds; // 目标缓冲区大小 (samples)
-
-        const statusDiv = document.getElementById('status');
-        const playButton = document.getElementById('playButton');
-        const stopButton = document.getElementById('stopButton');
-
-        function updateStatus(message) {
-            statusDiv.textContent = 'Status: ' + message;
-            console.log('Status:', message);
-        }
+// Text mode: one line. BIN1: the document split into SCHEMA_JSON status frames, each
+// carrying the number of frames still to follow in the count byte (0 = last).
+void CommunicationManager::sendJsonDocument(ClientSession& session, uint32_t requestSeq, const char* json, size_t length) {
+    if (!session.client.connected()) return;
 
-        function connectWebSocket() {
-            if (ws && ws.readyState === WebSocket.OPEN) {
-                updateStatus('Already connected');
-                return;
-            }
+    if (!session.binaryMode) {
+        session.client.write((const uint8_t*)json, length);
+        session.client.write((const uint8_t*)"\r\n", 2);
+        return;
+    }
+    uint8_t header[WireProtocol::HEADER_SIZE];
+    const size_t maxPayload = WireProtocol::MAX_PAYLOAD;
+    size_t total = length;
+    size_t chunks = (total + maxPayload - 1) / maxPayload;
+    if (chunks == 0) chunks = 1;
+    for (size_t i = 0; i < chunks; ++i) {
+        size_t offset = i * maxPayload;
+        size_t len = min(total - offset, maxPayload);
+        size_t remaining = min(chunks - 1 - i, (size_t)255);
+        WireProtocol::encodeHeader(header, WireProtocol::FRAME_STATUS, WireProtocol::SCHEMA_JSON,
+                                   (uint8_t)remaining, requestSeq, (uint16_t)len);
+        session.client.write(header, sizeof(header));
+        session.client.write((const uint8_t*)json + offset, len);
+    }
+}
 
-            const wsProtocol = window.location.protocol === 'https:' ? 'wss:' : 'ws:';
-            const wsUrl = `${wsProtocol}//${window.location.hostname}/audio`; // 使用相对路径 /audio
-            updateStatus(`Connecting to ${wsUrl}...`);
-
-            ws = new WebSocket(wsUrl);
-
-            ws.onopen = () => {
-                updateStatus('Connected');
-                playButton.disabled = false;
-                stopButton.disabled = true; // Stop is disabled until play starts
-                isBuffering = true; // Start buffering on connect
-                audioBufferQueue = []; // Clear queue on new connection
-                nextStartTime = 0; // Reset scheduling time on new connection
-            };
-
-            ws.onmessage = (event) => {
-                if (event.data instanceof Blob) {
-                    // Read the blob as an ArrayBuffer
-                    event.data.arrayBuffer().then(arrayBuffer => {
-                        // Assuming the data is 16-bit PCM samples
-                        const pcmData = new Int16Array(arrayBuffer);
-                        audioBufferQueue.push(pcmData); // Add Int16Array to queue
-
-                        // Check if we need to start playing after buffering
-                        if (isBuffering) {
-                            let currentBufferedSamples = audioBufferQueue.reduce((sum, arr) => sum + arr.length, 0);
-                            updateStatus(`Buffering... ${Math.round((currentBufferedSamples / targetBufferSize) * 100)}%`);
-                            if (currentBufferedSamples >= targetBufferSize) {
-                                isBuffering = false;
-                                updateStatus('Buffering complete. Ready to play.');
-                                if (isPlaying) { // If play was pressed during buffering
-                                    startPlayback();
-                                }
-                            }
-                        }
-                    });
-                } else {
-                    console.log('Received non-binary message:', event.data);
-                }
-            };
-
-            ws.onerror = (error) => {
-                updateStatus('WebSocket Error');
-                console.error('WebSocket Error:', error);
-                cleanupAudio();
-            };
-
-            ws.onclose = (event) => {
-                updateStatus(`Disconnected (Code: ${event.code}, Reason: ${event.reason || 'N/A'})`);
-                console.log('WebSocket closed:', event);
-                cleanupAudio();
-            };
+// QUERY <key=value ...>: aggregation over the stored history (see history_query.h).
+// The query runs in DataManager's query task; pumpQuery() sends the reply when it is done.
+void CommunicationManager::runQueryCommand(ClientSession& session, uint32_t requestSeq, const char* args) {
+    if (!dataManagerPtr_) {
+        sendStatus(session, requestSeq, "QUERY_UNAVAILABLE", true);
+        return;
+    }
+    TimeKeeper::Stamp now = timeKeeper.stamp();
+    QuerySpec query;
+    char err[96];
+    if (session.queryJob != 0) {
+        snprintf(err, sizeof(err), "BUSY"); // One query per connection at a time
+    } else if (query.parse(args, now.seconds, now.synced, err, sizeof(err)) &&
+               query.finalize(now.seconds, now.synced, err, sizeof(err))) {
+        session.queryJob = dataManagerPtr_->submitQuery(query);
+        if (session.queryJob != 0) {
+            session.queryRequestSeq = requestSeq;
+            return;
         }
+        snprintf(err, sizeof(err), "BUSY");
+    }
+    char reply[112];
+    snprintf(reply, sizeof(reply), "QUERY_ERROR %s", err);
+    sendStatus(session, requestSeq, reply, true);
+}
 
-        function scheduleBuffers() {
-            if (!isPlaying || !audioContext) { // Check audioContext as well
-                return;
-            }
+void CommunicationManager::pumpQuery(ClientSession& session) {
+    String json;
+    char err[96];
+    DataManager::QueryStatus status = dataManagerPtr_->takeQueryResult(session.queryJob, json, err, sizeof(err));
+    if (status == DataManager::QUERY_PENDING) return;
+    session.queryJob = 0;
+    if (status == DataManager::QUERY_OK) {
+        sendJsonDocument(session, session.queryRequestSeq, json.c_str(), json.length());
+        return;
+    }
+    char reply[112];
+    snprintf(reply, sizeof(reply), "QUERY_ERROR %s", err);
+    sendStatus(session, session.queryRequestSeq, reply, true);
+}
 
-            const now = audioContext.currentTime;
-            const lookaheadTime = 0.2; // Try to schedule ~200ms ahead
-            let scheduledDuration = 0; // Track duration scheduled in this call
+void CommunicationManager::processClientCommand(ClientSession& session, const char* command, uint32_t requestSeq) {
+    Serial.printf("收到客户端命令: %s\n", command);
+    
+    if (strcmp(command, "GET_CURRENT") == 0) {
+        const EnvironmentData& latest = dataManagerPtr_ ? dataManagerPtr_->getLatestData() : currentData;
+        if (latest.timestamp != 0) {
+            sendRecords(session, requestSeq, &latest, 1);
+        } else {
+            Serial.println("警告：没有可用的当前数据");
+            sendStatus(session, requestSeq, "NO_DATA");
+        }
+    }
+    else if (strcmp(command, "GET_HISTORY") == 0) {
+        Serial.println("处理GET_HISTORY命令 (未实现)");
+        sendStatus(session, requestSeq, "HISTORY_NOT_IMPLEMENTED");
+    }
+    else if (strncmp(command, "SYNC", 4) == 0 && (command[4] == ' ' || command[4] == '\0')) {
+        // SYNC <last_seq>: stream every stored record with seq > last_seq, SD first then RAM.
+        // Streaming continues over the following updates and ends with "SYNC_END <seq>".
+        if (!dataManagerPtr_) {
+            sendStatus(session, requestSeq, "SYNC_UNAVAILABLE", true);
+        } else {
+            char* end = nullptr;
+            unsigned long since = strtoul(command + 4, &end, 10);
+            session.syncCursor = SyncCursor((uint32_t)since);
+            session.syncRequestSeq = requestSeq;
+            session.syncActive = true;
+            Serial.printf("SYNC from seq %lu\n", since);
+        }
+    }
+    else if (strncmp(command, "PROTO ", 6) == 0) {
+        const char* proto = command + 6;
+        if (strcmp(proto, "BIN1") == 0) {
+            // Acknowledge in the current (text) protocol, then switch
+            sendStatus(session, requestSeq, "PROTO_OK BIN1");
+            session.binaryMode = true;
+            session.envSchema = WireProtocol::SCHEMA_ENV_V2;
+        } else if (strcmp(proto, "BIN1 ENV3") == 0) {
+            // Same framing, records carry their flags (unsynced timestamps stay distinguishable)
+            sendStatus(session, requestSeq, "PROTO_OK BIN1 ENV3");
+            session.binaryMode = true;
+            session.envSchema = WireProtocol::SCHEMA_ENV_V3;
+        } else if (strcmp(proto, "TEXT") == 0) {
+            sendStatus(session, requestSeq, "PROTO_OK TEXT");
+            session.binaryMode = false;
+        } else {
+            sendStatus(session, requestSeq, "PROTO_UNSUPPORTED", true);
+        }
+    }
+    else if (strncmp(command, "QUERY", 5) == 0 && (command[5] == ' ' || command[5] == '\0')) {
+        runQueryCommand(session, requestSeq, command + 5);
+    }
+    else if (strncmp(command, "BENCH WIRE", 10) == 0) {
+        int iterations = atoi(command + 10);
+        runWireBenchmark(session, requestSeq, iterations > 0 ? min(iterations, 5000) : 500);
+    }
+    else if (strncmp(command, "BENCH GLYPH", 11) == 0) {
+        int iterations = atoi(command + 11);
+        runGlyphBenchmark(session, requestSeq, iterations > 0 ? min(iterations, 2000) : 200);
+    }
+    else {
+        Serial.printf("未知命令: %s\n", command);
+        sendStatus(session, requestSeq, "UNKNOWN_COMMAND", true);
+    }
+}
 
-            // Check if we need to reset scheduling due to major lag or initial start
-            if (nextStartTime < now) {
-                 console.warn(`Scheduling lag detected: nextStartTime (${nextStartTime.toFixed(3)}) < now (${now.toFixed(3)}). Resetting.`);
-                 nextStartTime = now + 0.05; // Reset to start slightly ahead of now
-                 isBuffering = true; // Trigger buffering state again if we lagged badly
-            }
+// Sends the next chunk of an active SYNC. Called once per update so a large
+// backlog never stalls the loop; the client can reconnect and resume with the
+// last seq it received.
+void CommunicationManager::pumpSync(ClientSession& session) {
+    EnvironmentData batch[SYNC_RECORDS_PER_UPDATE];
+    size_t n = dataManagerPtr_->readRecordsSince(session.syncCursor, batch, SYNC_RECORDS_PER_UPDATE);
+    if (n > 0) {
+        sendRecords(session, session.syncRequestSeq, batch, n);
+    }
+    if (session.syncCursor.phase == SyncCursor::PHASE_DONE) {
+        char done[32];
+        snprintf(done, sizeof(done), "SYNC_END %lu", (unsigned long)session.syncCursor.lastSeq);
+        sendStatus(session, session.syncRequestSeq, done);
+        session.syncActive = false;
+    }
+}
 
-            // --- Refined Buffer Scheduling Logic ---
-            while (audioBufferQueue.length > 0 && nextStartTime < now + lookaheadTime + scheduledDuration) { // Schedule slightly ahead
-                const pcmData = audioBufferQueue.shift();
-                if (!pcmData || pcmData.length === 0) continue; // Skip empty buffers
+// Measures encode cost and size of one record on the JSON path (same work as
+// sendJsonData minus the socket write) versus the BIN1 frame encoder.
+void CommunicationManager::runWireBenchmark(ClientSession& session, uint32_t requestSeq, int iterations) {
+    EnvironmentData sample = currentData;
+    if (sample.timestamp == 0) {
+        sample.timestamp = 1700000000;
+        sample.seq = 123456;
+        sample.decibels = 48.3f;
+        sample.temperature = 23.45f;
+        sample.humidity = 41.2f;
+        sample.lux = 312.0f;
+    }
 
-                const float32Data = new Float32Array(pcmData.length);
-                const maxInt16Value = 32767.0; // 2^15 - 1 (for int16)
-                for (let i = 0; i < pcmData.length; i++) {
-                    float32Data[i] = pcmData[i] / maxInt16Value; // Normalize int16 to float -1.0 to 1.0
-                }
+    char line[JSON_LINE_SIZE];
+    size_t jsonBytes = 0;
+    uint32_t start = micros();
+    for (int i = 0; i < iterations; ++i) {
+        jsonBytes = formatRecordJson(sample, line, sizeof(line)) + 2; // CRLF
+    }
+    uint32_t jsonUs = micros() - start;
 
-                // Prevent creating zero-length buffers
-                if (float32Data.length === 0) {
-                    console.warn("Skipping zero-length audio buffer.");
-                    continue;
-                }
+    uint8_t frame[WireProtocol::HEADER_SIZE + WireProtocol::MAX_ENV_RECORD_SIZE];
+    size_t binBytes = 0;
+    start = micros();
+    for (int i = 0; i < iterations; ++i) {
+        binBytes = WireProtocol::encodeEnvFrame(frame, sizeof(frame), (uint32_t)i, &sample, 1, session.envSchema);
+    }
+    uint32_t binUs = micros() - start;
+
+    char result[160];
+    snprintf(result, sizeof(result),
+             "BENCH_WIRE n=%d json_bytes=%u json_us=%.2f bin_bytes=%u bin_us=%.2f batch_bytes_per_record=%u",
+             iterations, (unsigned)jsonBytes, (float)jsonUs / iterations,
+             (unsigned)binBytes, (float)binUs / iterations, (unsigned)WireProtocol::envRecordSize(session.envSchema));
+    Serial.println(result);
+    sendStatus(session, requestSeq, result);
+}
 
-                try {
-                    const audioBuffer = audioContext.createBuffer(1, float32Data.length, sampleRate);
-                    audioBuffer.copyToChannel(float32Data, 0);
-
-                    const sourceNode = audioContext.createBufferSource();
-                    sourceNode.buffer = audioBuffer;
-                    sourceNode.connect(audioContext.destination);
-
-                    // Log scheduling time only if significantly different
-                    // if (Math.abs(nextStartTime - audioContext.currentTime) > 0.1) {
-                    //      console.log(`Scheduling buffer of duration ${(audioBuffer.duration).toFixed(3)}s at ${nextStartTime.toFixed(3)} (now: ${now.toFixed(3)})`);
-                    // }
-                    sourceNode.start(nextStartTime);
-                    nextStartTime += audioBuffer.duration; // Schedule next buffer right after this one
-                    scheduledDuration += audioBuffer.duration;
-
-                } catch (e) {
-                    console.error("Error creating or scheduling audio buffer:", e);
-                    // Potentially stop playback or try to recover
-                    // For now, just log the error and continue trying
-                }
-            }
-            // --- End Refined Buffer Scheduling ---
-
-            // Check buffer levels after scheduling
-            let currentBufferedSamples = audioBufferQueue.reduce((sum, arr) => sum + (arr ? arr.length : 0), 0);
-            let currentBufferedSeconds = currentBufferedSamples / sampleRate;
-
-            if (isBuffering && currentBufferedSamples >= targetBufferSize) {
-                console.log("Buffering complete during playback scheduling.");
-                isBuffering = false;
-                updateStatus('Playing...'); // Update status if we just finished buffering
-                 // Ensure nextStartTime is reasonable after buffering
-                 if (nextStartTime < now) {
-                     nextStartTime = now + 0.05;
-                 }
-            } else if (!isBuffering && currentBufferedSeconds < bufferSizeSeconds * 0.3) { // If buffer runs low (e.g., < 30%)
-                 console.warn(`Buffer low (${currentBufferedSeconds.toFixed(2)}s). Attempting to re-buffer.`);
-                 isBuffering = true; // Enter buffering state
-                 updateStatus(`Re-buffering...`);
-                 // Stop requesting frames temporarily? The loop condition already handles empty queue.
-                 // We rely on the server sending more data.
-            } else if (isBuffering) {
-                 // Still buffering, update status
-                 updateStatus(`Buffering... ${Math.round((currentBufferedSamples / targetBufferSize) * 100)}%`);
-            }
+// Time per size-5 readout update: scaled GLCD rasterization (drawString) versus copying
+// cached glyph cells. Both loops draw into the same off-screen sprite, the same kind of
+// target as the display flusher's back buffer, so the panel and the UI are not disturbed.
+// Before timing, the cached path is checked to put the same pixels into the sprite.
+void CommunicationManager::runGlyphBenchmark(ClientSession& session, uint32_t requestSeq, int iterations) {
+    extern TFT_eSPI tft;
+    const uint8_t size = 5;
+    const uint16_t fg = TFT_WHITE;
+    const uint16_t bg = TFT_NAVY; // NoiseScreen's readout
+    static const char* const values[] = {"72.4", "48.9", "103.1", "---"};
+    const int valueCount = sizeof(values) / sizeof(values[0]);
+    const int32_t cellH = 8 * size;
+
+    // Two rows of cells: drawString() reference on top, cached glyphs below
+    TFT_eSprite canvas(&tft);
+    canvas.setColorDepth(16);
+    if (!canvas.createSprite(6 * size * 5, 2 * cellH)) {
+        sendStatus(session, requestSeq, "BENCH_GLYPH_NO_MEMORY", true);
+        return;
+    }
+    canvas.setTextDatum(TL_DATUM);
+    canvas.setTextSize(size);
+    canvas.setTextColor(fg, bg);
+
+    // First use builds the colour pair's glyphs (free if a screen already did)
+    GlyphCache& cache = GlyphCache::instance();
+    canvas.fillSprite(TFT_BLACK);
+    canvas.drawString(values[0], 0, 0);
+    uint32_t start = micros();
+    bool cached = cache.drawText(canvas, values[0], 0, cellH, size, fg, bg);
+    uint32_t firstUs = micros() - start;
+    const uint16_t* pixels = (const uint16_t*)canvas.getPointer();
+    size_t rowBytes = (size_t)canvas.width() * cellH * sizeof(uint16_t);
+    bool verified = cached && memcmp(pixels, pixels + rowBytes / sizeof(uint16_t), rowBytes) == 0;
+
+    start = micros();
+    for (int i = 0; i < iterations; ++i) {
+        canvas.drawString(values[i % valueCount], 0, 0);
+    }
+    uint32_t textUs = micros() - start;
 
+    start = micros();
+    for (int i = 0; verified && i < iterations; ++i) {
+        cache.drawText(canvas, values[i % valueCount], 0, 0, size, fg, bg);
+    }
+    uint32_t glyphUs = micros() - start;
+    canvas.deleteSprite();
 
-            // Keep scheduling if playing and not critically lagging
-            if (isPlaying) {
-                // Schedule the next check slightly before the last scheduled buffer ends,
-                // but not more frequent than requestAnimationFrame allows.
-                // Using requestAnimationFrame is generally fine.
-                requestAnimationFrame(scheduleBuffers);
-            }
-        }
+    if (!cached) {
+        sendStatus(session, requestSeq, "BENCH_GLYPH_NO_CACHE", true);
+        return;
+    }
+    if (!verified) {
+        Serial.println("[CommManager] ERR: Cached glyphs differ from drawString() in the sprite");
+        sendStatus(session, requestSeq, "BENCH_GLYPH_MISMATCH", true);
+        return;
+    }
+    char result[160];
+    snprintf(result, sizeof(result),
+             "BENCH_GLYPH n=%d size=%u text_us=%.1f glyph_us=%.1f speedup=%.1f first_use_us=%lu cache_bytes=%u",
+             iterations, size, (float)textUs / iterations, (float)glyphUs / iterations,
+             glyphUs > 0 ? (float)textUs / glyphUs : 0.0f, (unsigned long)firstUs, (unsigned)cache.bytesUsed());
+    Serial.println(result);
+    sendStatus(session, requestSeq, result);
+}
 
+void CommunicationManager::setupHttpServer(AsyncWebServer* httpServer) {
+    if (!httpServer) return;
 
-        function startPlayback() {
-            // Ensure AudioContext is ready (especially after user interaction)
-             if (!audioContext) {
-                 try {
-                    audioContext = new (window.AudioContext || window.webkitAudioContext)({ sampleRate: sampleRate });
-                    console.log(`AudioContext created. State: ${audioContext.state}, Sample Rate: ${audioContext.sampleRate}`);
-                 } catch (e) {
-                     updateStatus("Error creating AudioContext: " + e.message);
-                     console.error("AudioContext creation failed:", e);
-                     cleanupAudio(); // Clean up if context fails
-                     return;
-                 }
-            }
+    // 静态网页 (web/ 目录, 构建时 gzip 压缩后存放于 flash, 见 tools/build_web_assets.py)
+    for (size_t i = 0; i < WEB_ASSET_COUNT; ++i) {
+        const WebAsset* asset = &WEB_ASSETS[i];
+        httpServer->on(asset->path, HTTP_GET, [asset](AsyncWebServerRequest *request){
+            serveWebAsset(request, *asset);
+        });
+    }
 
-             // If context is suspended, try to resume it (requires user gesture)
-             if (audioContext.state === 'suspended') {
-                 audioContext.resume().then(() => {
-                     console.log("AudioContext resumed successfully.");
-                     // Proceed with playback logic only after successful resume
-                     initiatePlaybackSequence();
-                 }).catch(e => {
-                     updateStatus("AudioContext resume failed. Please click Play again.");
-                     console.error("AudioContext resume failed:", e);
-                     // Keep UI state indicating stopped/needs interaction
-                     isPlaying = false;
-                     playButton.disabled = false;
-                     stopButton.disabled = true;
-                 });
-             } else if (audioContext.state === 'running') {
-                 initiatePlaybackSequence(); // Context already running
-             } else {
-                  updateStatus(`AudioContext in unexpected state: ${audioContext.state}`);
-                  console.error(`AudioContext state is ${audioContext.state}`);
-             }
+    // 可以添加其他 HTTP 路由，例如用于发送控制命令或获取状态
+    httpServer->on("/status", HTTP_GET, [this](AsyncWebServerRequest *request){
+        char ipText[16] = "N/A"; // Same text as getIPAddress(), without the String
+        if (isWiFiConnected()) {
+            IPAddress ip = WiFi.localIP();
+            snprintf(ipText, sizeof(ipText), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
         }
 
-        function initiatePlaybackSequence() {
-            // This function contains the logic previously directly in startPlayback,
-            // called after ensuring AudioContext is running.
-             if (isBuffering && audioBufferQueue.length < targetBufferSize / sampleRate * 0.5) { // Require some buffer before starting
-                 updateStatus("Buffering, please wait...");
-                 // isPlaying should be true, scheduleBuffers will check buffering state
-                 // Start requesting frames if not already doing so
-                 if (isPlaying) requestAnimationFrame(scheduleBuffers);
-                 return;
-             }
-             if (!isBuffering && audioBufferQueue.length === 0) {
-                 updateStatus("Buffer empty, waiting for data...");
-                 isBuffering = true; // Go back to buffering state
-                 if (isPlaying) requestAnimationFrame(scheduleBuffers);
-                 return;
-             }
-
-             isPlaying = true;
-             playButton.disabled = true;
-             stopButton.disabled = false;
-             updateStatus('Playing...'); // Or Buffering if isBuffering is still true
-
-             // Reset scheduling time relative to current context time ONLY if it's lagging significantly
-             // or if starting fresh. The scheduleBuffers function handles minor lag.
-             if (nextStartTime < audioContext.currentTime - 0.1) { // If significantly behind
-                 nextStartTime = audioContext.currentTime + 0.1; // Add small delay before first buffer
-                 console.log("Resetting nextStartTime for playback start.");
-             } else if (nextStartTime === 0) { // Initial start
-                 nextStartTime = audioContext.currentTime + 0.1;
-             }
-
-
-             requestAnimationFrame(scheduleBuffers); // Start the scheduling loop
+        // The loop and the WS event handler change the client list under the mutex
+        int audioClients = -1;
+        if (audioClientsMutex != nullptr && xSemaphoreTake(audioClientsMutex, (TickType_t)10) == pdTRUE) {
+            audioClients = (int)audioWsClients.size();
+            xSemaphoreGive(audioClientsMutex);
         }
 
-
-        function stopPlayback() {
-            isPlaying = false; // Stop the scheduling loop
-            if (audioContext && audioContext.state === 'running') {
-                audioContext.suspend().then(() => console.log("AudioContext suspended.")); // Suspend context
-            }
-            // Keep the buffer queue for potential resume
-            playButton.disabled = false;
-            stopButton.disabled = true;
-            updateStatus('Stopped');
-            console.log("Playback stopped.");
-             // Do not reset nextStartTime here, allow resume from roughly where it left off
+        httpArena_.reset();
+        JsonDocument doc(&httpArena_);
+        doc["commandServer"] = isRunning;
+        doc["webSocketServer"] = (audioWs != nullptr);
+        if (audioClients >= 0) {
+            doc["audioClients"] = audioClients; // Left out when the list is busy
         }
+        doc["audioClientCap"] = maxAudioClients_;
+        doc["wifiState"] = getWiFiStateName();
+        doc["wifiStatus"] = isWiFiConnected();
+        doc["ipAddress"] = ipText;
+        sendJsonResponse(request, 200, doc);
+    });
 
-         function cleanupAudio() {
-            stopPlayback(); // Ensure playback is stopped
-            if (audioContext) {
-                audioContext.close().then(() => {
-                     console.log("AudioContext closed");
-                     audioContext = null;
-                });
-            }
-            audioBufferQueue = []; // Clear queue on disconnect/error
-            playButton.disabled = true; // Disable play until reconnected
-            stopButton.disabled = true;
-            if (ws && ws.readyState !== WebSocket.CLOSED) {
-                 ws.close();
+    // Aggregation over the stored history, e.g. /query?from=-3d&bucket=1h&fields=db&agg=leq,max
+    httpServer->on("/query", HTTP_GET, [this](AsyncWebServerRequest *request){
+        if (!dataManagerPtr_) {
+            request->send(503, "application/json", "{\"error\":\"QUERY_UNAVAILABLE\"}");
+            return;
+        }
+        static const char* QUERY_PARAMS[] = {"from", "to", "bucket", "fields", "agg"};
+        TimeKeeper::Stamp now = timeKeeper.stamp();
+        QuerySpec query;
+        char err[96];
+        bool ok = true;
+        for (size_t i = 0; i < sizeof(QUERY_PARAMS) / sizeof(QUERY_PARAMS[0]) && ok; ++i) {
+            if (request->hasParam(QUERY_PARAMS[i])) {
+                ok = query.setParam(QUERY_PARAMS[i], request->getParam(QUERY_PARAMS[i])->value().c_str(),
+                                    now.seconds, now.synced, err, sizeof(err));
             }
-            ws = null;
+        }
+        ok = ok && query.finalize(now.seconds, now.synced, err, sizeof(err));
+        uint32_t job = ok ? dataManagerPtr_->submitQuery(query) : 0;
+        if (job == 0) {
+            if (ok) snprintf(err, sizeof(err), "BUSY");
+            httpArena_.reset();
+            JsonDocument doc(&httpArena_);
+            doc["error"] = err;
+            sendJsonResponse(request, ok ? 503 : 400, doc);
+            return;
         }
 
+        // The query runs in DataManager's query task. The chunked body asks async_tcp to
+        // come back (RESPONSE_TRY_AGAIN) until it is done; errors found while running
+        // (e.g. RANGE_TOO_LARGE) arrive as {"error":...} in the 200 body.
+        DataManager* dataManager = dataManagerPtr_;
+        AsyncWebServerResponse* response = request->beginChunkedResponse("application/json",
+            [dataManager, job, json = String(), sent = (size_t)0, finished = false]
+            (uint8_t* buffer, size_t maxLen, size_t index) mutable -> size_t {
+                if (!finished) {
+                    char err[96];
+                    DataManager::QueryStatus status = dataManager->takeQueryResult(job, json, err, sizeof(err));
+                    if (status == DataManager::QUERY_PENDING) return RESPONSE_TRY_AGAIN;
+                    finished = true;
+                    if (status == DataManager::QUERY_FAILED) {
+                        json = "{\"error\":\"";
+                        json += err;
+                        json += "\"}";
+                    }
+                }
+                size_t len = min((size_t)json.length() - sent, maxLen);
+                memcpy(buffer, json.c_str() + sent, len);
+                sent += len;
+                return len;
+            });
+        request->onDisconnect([dataManager, job]() {
+            dataManager->cancelQuery(job); // No-op once the result was taken
+        });
+        request->send(response);
+    });
 
-        playButton.onclick = () => {
-             if (!ws || ws.readyState !== WebSocket.OPEN) {
-                connectWebSocket(); // Connect first if not connected
-             }
-             isPlaying = true; // Set flag immediately, actual playback starts after buffering
-             startPlayback();
-        };
-
-        stopButton.onclick = stopPlayback;
-
-        // Attempt to connect on page load
-        connectWebSocket();
-
-        // Cleanup on page unload
-        window.addEventListener('beforeunload', cleanupAudio);
-
-    </script>
-</body>
-</html>
-        )";
-        request->send(200, "text/html", html);
+    // Prometheus scrape endpoint. Rendered line by line straight into the
+    // response buffer, so a scrape does not build the document on the heap.
+    httpServer->on("/metrics", HTTP_GET, [](AsyncWebServerRequest *request){
+        size_t cursor = 0;
+        AsyncWebServerResponse* response = request->beginChunkedResponse("text/plain; version=0.0.4",
+            [cursor](uint8_t* buffer, size_t maxLen, size_t index) mutable -> size_t {
+                return MetricsRegistry::instance().render(buffer, maxLen, cursor);
+            });
+        request->send(response);
     });
 
-    // 可以添加其他 HTTP 路由，例如用于发送控制命令或获取状态
-    httpServer->on("/status", HTTP_GET, [this](AsyncWebServerRequest *request){
-        // Example: Send status as JSON
+    // Per-subsystem heap usage and the free / largest-block history (heap_tracker.h).
+    // Diagnostics only: the document is far larger than the request arena, so it stays on the heap.
+    httpServer->on("/heap", HTTP_GET, [](AsyncWebServerRequest *request){
+        HeapTracker::TagStats stats[HEAP_TAG_COUNT];
+        heapTracker.getStats(stats);
+        static HeapTracker::Sample history[HeapTracker::HISTORY_SIZE]; // Off the async_tcp stack
+        size_t count = heapTracker.getHistory(history, HeapTracker::HISTORY_SIZE);
+
         JsonDocument doc;
-        doc["commandServer"] = isRunning;
-        doc["webSocketServer"] = (audioWs != nullptr);
-        doc["audioClients"] = audioWsClients.size();
-        doc["wifiStatus"] = isWiFiConnected();
-        doc["ipAddress"] = getIPAddress();
+        doc["hooks"] = HeapTracker::hooksEnabled();
+        doc["approximate"] = !HeapTracker::hooksEnabled(); // growth* = net growth per scope, not allocations
+        doc["free"] = ESP.getFreeHeap();
+        doc["minFree"] = ESP.getMinFreeHeap();
+        doc["largestBlock"] = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+        JsonObject tags = doc["tags"].to<JsonObject>();
+        for (uint8_t t = 0; t < HEAP_TAG_COUNT; ++t) {
+            JsonObject tag = tags[HeapTracker::tagName(t)].to<JsonObject>();
+            tag["live"] = stats[t].liveBytes;
+            tag["peak"] = stats[t].peakBytes;
+            tag["allocs"] = stats[t].allocs;
+            tag["growthBytes"] = stats[t].growthBytes;
+            tag["growthRate"] = roundf(stats[t].growthRate);
+#if HEAP_AUDIT_STEADY_STATE
+            tag["steadyAllocs"] = stats[t].steadyAllocs;
+#endif
+        }
+        // One row per sample: uptime_s, free, largest_block, then live bytes per tag
+        doc["historyIntervalS"] = HeapTracker::HISTORY_INTERVAL_MS / 1000;
+        JsonArray rows = doc["history"].to<JsonArray>();
+        for (size_t i = 0; i < count; ++i) {
+            JsonArray row = rows.add<JsonArray>();
+            row.add(history[i].uptimeS);
+            row.add(history[i].freeBytes);
+            row.add(history[i].largestBlock);
+            for (uint8_t t = 0; t < HEAP_TAG_COUNT; ++t) {
+                row.add(history[i].liveBytes[t]);
+            }
+        }
         String output;
         serializeJson(doc, output);
         request->send(200, "application/json", output);
@@ -571,6 +799,45 @@ void CommunicationManager::setupHttpServer(AsyncWebServer* httpServer) {
     Serial.println("HTTP server routes configured.");
 }
 
+void CommunicationManager::sendJsonResponse(AsyncWebServerRequest* request, int code, const JsonDocument& doc) {
+    char* body = (char*)httpBodies_.acquire();
+    size_t length = body ? serializeJson(doc, body, httpBodies_.blockSize()) : 0;
+    if (body && length < httpBodies_.blockSize() - 1) {
+        // Body sent straight from the pooled block (same response type as the flash assets);
+        // the block goes back to the pool when the connection closes
+        request->onDisconnect([this, body]() {
+            httpBodies_.release(body);
+        });
+        request->send(request->beginResponse(code, "application/json", (const uint8_t*)body, length));
+        return;
+    }
+    if (body) {
+        httpBodies_.release(body); // Did not fit
+    }
+    String output;
+    serializeJson(doc, output);
+    request->send(code, "application/json", output);
+}
+
+void CommunicationManager::serveWebAsset(AsyncWebServerRequest* request, const WebAsset& asset) {
+    // 浏览器每次加载都会带 If-None-Match 重新验证; 内容未变时只回 304
+    const AsyncWebHeader* inm = request->getHeader("If-None-Match");
+    if (inm && strcmp(inm->value().c_str(), asset.etag) == 0) {
+        AsyncWebServerResponse* response = request->beginResponse(304);
+        response->addHeader("ETag", asset.etag);
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
+        return;
+    }
+
+    // Body is streamed straight from flash; nothing is copied to the heap
+    AsyncWebServerResponse* response = request->beginResponse(200, asset.contentType, asset.data, asset.length);
+    response->addHeader("Content-Encoding", "gzip");
+    response->addHeader("ETag", asset.etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+}
+
 void CommunicationManager::setupWebSocketServer(AsyncWebServer* httpServer) {
     if (!httpServer) return;
 
@@ -586,65 +853,183 @@ void CommunicationManager::setupWebSocketServer(AsyncWebServer* httpServer) {
     // 将 WebSocket 服务器附加到 HTTP 服务器
     httpServer->addHandler(audioWs);
 
-    Serial.println("WebSocket server configured on /audio");
+    // 根据当前可用堆内存确定音频客户端上限, 并预留 vector 容量避免运行时扩容
+    maxAudioClients_ = computeAudioClientCap();
+    if (xSemaphoreTake(audioClientsMutex, portMAX_DELAY) == pdTRUE) {
+        audioWsClients.reserve(maxAudioClients_);
+        xSemaphoreGive(audioClientsMutex);
+    }
+
+    Serial.printf("WebSocket server configured on /audio (max %u audio clients, free heap %u)\n",
+                  (unsigned)maxAudioClients_, (unsigned)ESP.getFreeHeap());
+}
+
+size_t CommunicationManager::computeAudioClientCap() const {
+    size_t freeHeap = ESP.getFreeHeap();
+    if (freeHeap <= AUDIO_HEAP_RESERVE + AUDIO_CLIENT_HEAP_COST) {
+        return 1;
+    }
+    size_t cap = (freeHeap - AUDIO_HEAP_RESERVE) / AUDIO_CLIENT_HEAP_COST;
+    return constrain(cap, (size_t)1, MAX_AUDIO_WS_CLIENTS_LIMIT);
 }
 
 void CommunicationManager::streamAudioViaWebSocket() {
+    HeapScope heapScope(HEAP_TAG_COMM);
     // Check if mutex exists before trying to use it
     if (!micManagerPtr || !audioWs || audioClientsMutex == nullptr) {
         return; 
     }
 
-    // Take the mutex to safely check and access audioWsClients
+    // Take the mutex only to check for clients; without the capture task the I2S read
+    // below can wait up to 15 ms and must not hold up connect/disconnect events in the
+    // async_tcp task.
     if (xSemaphoreTake(audioClientsMutex, (TickType_t)10) != pdTRUE) { // Use a small timeout
         Serial.println("WARN: Could not obtain audioClientsMutex in streamAudio");
         return; // Could not get mutex, skip this cycle
     }
+    bool hasClients = !audioWsClients.empty();
+    xSemaphoreGive(audioClientsMutex);
+    if (!hasClients) {
+        return;
+    }
 
-    if (audioWsClients.empty()) {
-        xSemaphoreGive(audioClientsMutex); // Release mutex before returning
-        return; // No clients, release mutex and return
+    AsyncWebSocketSharedBuffer frame;
+    if (micManagerPtr->isCapturing()) {
+        // The capture task fills the PCM ring; take a full frame when one is ready (never blocks)
+        if (micManagerPtr->pcmAvailable() >= WS_AUDIO_BUFFER_SAMPLES) {
+            frame = acquireAudioFrame(WS_AUDIO_FRAME_BYTES);
+            micManagerPtr->readPcmSamples(reinterpret_cast<int16_t*>(frame->data()), WS_AUDIO_BUFFER_SAMPLES);
+        }
+    } else {
+        // Temporary buffer to read 32-bit samples from I2S
+        int32_t tempReadBuffer[WS_AUDIO_BUFFER_SAMPLES];
+
+        // 从 I2S 读取原始样本 (read into temporary 32-bit buffer)
+        size_t samplesRead = micManagerPtr->readRawSamples(tempReadBuffer, WS_AUDIO_BUFFER_SAMPLES, 15); // 短超时
+
+        if (samplesRead > 0) {
+            // One buffer per frame, shared by every client (no per-client copy)
+            size_t bytesToSend = samplesRead * sizeof(int16_t);
+            frame = acquireAudioFrame(bytesToSend);
+            int16_t* out = reinterpret_cast<int16_t*>(frame->data());
+            for (size_t i = 0; i < samplesRead; ++i) {
+                // Correctly sign-extend 24-bit data from 32-bit slot, then take upper 16 bits
+                int32_t sample32 = tempReadBuffer[i] << 8; // Align MSB if data is in lower bits (check I2S config)
+                // Right shift to get upper 16 bits (sign bit preserved)
+                out[i] = (int16_t)(sample32 >> 16);
+            }
+        }
     }
 
-    // Temporary buffer to read 32-bit samples from I2S
-    int32_t tempReadBuffer[WS_AUDIO_BUFFER_SAMPLES];
+    if (xSemaphoreTake(audioClientsMutex, (TickType_t)10) != pdTRUE) {
+        return; // Frame is released with the last reference
+    }
+    // Queue the new frame for everyone, then let each client take what it can
+    for (AudioClient& ac : audioWsClients) {
+        if (frame) {
+            enqueueAudioFrame(ac, frame);
+        }
+        drainAudioQueue(ac);
+    }
+    xSemaphoreGive(audioClientsMutex);
 
-    // 从 I2S 读取原始样本 (read into temporary 32-bit buffer)
-    size_t samplesRead = micManagerPtr->readRawSamples(tempReadBuffer, WS_AUDIO_BUFFER_SAMPLES, 15); // 短超时
+    audioWs->cleanupClients();
+    yield(); // 发送后让出时间
+}
 
-    if (samplesRead > 0) {
-        // Convert 32-bit samples to 16-bit and store in wsAudioBuffer
-        for (size_t i = 0; i < samplesRead; ++i) {
-            // Correctly sign-extend 24-bit data from 32-bit slot, then take upper 16 bits
-            int32_t sample32 = tempReadBuffer[i] << 8; // Align MSB if data is in lower bits (check I2S config)
-            // Right shift to get upper 16 bits (sign bit preserved)
-            wsAudioBuffer[i] = (int16_t)(sample32 >> 16); 
+// A frame buffer of the given size (<= WS_AUDIO_FRAME_BYTES) from the pool. A pooled frame is
+// free again when the pool holds the only reference: no client queue or library message has it.
+AsyncWebSocketSharedBuffer CommunicationManager::acquireAudioFrame(size_t bytes) {
+    for (auto& pooled : audioFramePool_) {
+        if (!pooled) {
+            // Pool still filling up (first frames after a client connected)
+            pooled = std::make_shared<std::vector<uint8_t>>(WS_AUDIO_FRAME_BYTES);
+        } else if (pooled.use_count() != 1) {
+            continue;
         }
+        pooled->resize(bytes); // Within capacity: no reallocation
+        return pooled;
+    }
+    systemMetrics.audioFramePoolMisses.inc();
+    return std::make_shared<std::vector<uint8_t>>(bytes);
+}
 
-        size_t bytesToSend = samplesRead * sizeof(int16_t); // Calculate bytes for 16-bit data
-
-        // 将原始字节作为二进制消息发送给所有连接的 WebSocket 客户端
-        // Manual iteration remains safer within the mutex lock
-        for (AsyncWebSocketClient* client : audioWsClients) {
-             if (client && client->status() == WS_CONNECTED) {
-                 if (client->canSend()) { // 检查客户端是否可以接收数据
-                    client->binary((const uint8_t*)wsAudioBuffer, bytesToSend); // Send the 16-bit data buffer
-                 } else {
-                     // Serial.printf("WARN: WebSocket client %u cannot send data now.\\n\", client->id());
-                     // 客户端可能忙碌或缓冲区已满
-                 }
-             }
+void CommunicationManager::enqueueAudioFrame(AudioClient& ac, const AsyncWebSocketSharedBuffer& frame) {
+    if (ac.count == AUDIO_CLIENT_QUEUE_DEPTH) {
+        // Client fell behind: drop the oldest frame so it stays close to live audio
+        systemMetrics.wsBytesDropped.inc(ac.queue[ac.head]->size());
+        ac.queue[ac.head].reset();
+        ac.head = (ac.head + 1) % AUDIO_CLIENT_QUEUE_DEPTH;
+        ac.count--;
+        ac.framesDropped++;
+    }
+    ac.queue[(ac.head + ac.count) % AUDIO_CLIENT_QUEUE_DEPTH] = frame;
+    ac.count++;
+}
+
+void CommunicationManager::drainAudioQueue(AudioClient& ac) {
+    if (!ac.client || ac.client->status() != WS_CONNECTED) {
+        return;
+    }
+    // Keep the library's own queue short; backlog stays in our ring where the
+    // drop-oldest policy applies (the library would drop the newest instead).
+    while (ac.count > 0 && ac.client->queueLen() < AUDIO_CLIENT_INFLIGHT && ac.client->canSend()) {
+        AsyncWebSocketSharedBuffer& next = ac.queue[ac.head];
+        size_t bytes = next->size();
+        if (!ac.client->binary(next)) {
+            break;
         }
+        systemMetrics.wsBytesSent.inc(bytes);
+        next.reset();
+        ac.head = (ac.head + 1) % AUDIO_CLIENT_QUEUE_DEPTH;
+        ac.count--;
+        ac.framesSent++;
+    }
+}
 
-        audioWs->cleanupClients(); // It's generally safe to call cleanupClients outside the loop, 
-                                   // but the internal implementation should be thread-safe if possible.
-                                   // Keep it here for now, assuming library handles internal locking or queueing.
-                                   // Alternatively, iterate and mark clients for cleanup, then cleanup after releasing mutex.
-        yield(); // 发送后让出时间
+void CommunicationManager::removeAudioClient(uint32_t clientId, const char* reason) {
+    size_t oldSize = audioWsClients.size();
+    audioWsClients.erase(
+        std::remove_if(audioWsClients.begin(), audioWsClients.end(),
+                       [clientId](const AudioClient& ac) { return ac.id == clientId; }),
+        audioWsClients.end());
+    size_t newSize = audioWsClients.size();
+    if (newSize < oldSize) {
+        Serial.printf("Client #%lu removed (%s). Total audio clients: %d\n", (unsigned long)clientId, reason, newSize);
+    } else {
+        Serial.printf("Client #%lu not found for removal (%s)? Total audio clients: %d\n", (unsigned long)clientId, reason, newSize);
     }
+}
 
-    // Release the mutex
-    xSemaphoreGive(audioClientsMutex);
+// Scrape-time metrics for connected clients (registered with MetricsRegistry)
+void CommunicationManager::collectMetrics(MetricsWriter& w, void* context) {
+    CommunicationManager* self = (CommunicationManager*)context;
+
+    w.header("soundscape_tcp_clients", "Connected TCP command clients", "gauge");
+    w.sample("soundscape_tcp_clients", nullptr, (float)self->clientCount_);
+
+    if (self->audioClientsMutex == nullptr ||
+        xSemaphoreTake(self->audioClientsMutex, (TickType_t)10) != pdTRUE) {
+        return;
+    }
+    w.header("soundscape_ws_audio_clients", "Connected audio WebSocket clients", "gauge");
+    w.sample("soundscape_ws_audio_clients", nullptr, (float)self->audioWsClients.size());
+    w.header("soundscape_ws_audio_client_limit", "Audio WebSocket client cap derived from free heap", "gauge");
+    w.sample("soundscape_ws_audio_client_limit", nullptr, (float)self->maxAudioClients_);
+
+    char labels[24];
+    w.header("soundscape_ws_client_queue_depth", "Audio frames pending per client (own queue + library queue)", "gauge");
+    for (const AudioClient& ac : self->audioWsClients) {
+        snprintf(labels, sizeof(labels), "client=\"%lu\"", (unsigned long)ac.id);
+        size_t libQueued = ac.client ? ac.client->queueLen() : 0;
+        w.sample("soundscape_ws_client_queue_depth", labels, (float)(ac.count + libQueued));
+    }
+    w.header("soundscape_ws_client_dropped_frames_total", "Audio frames dropped (oldest first) per client", "counter");
+    for (const AudioClient& ac : self->audioWsClients) {
+        snprintf(labels, sizeof(labels), "client=\"%lu\"", (unsigned long)ac.id);
+        w.sampleU64("soundscape_ws_client_dropped_frames_total", labels, ac.framesDropped);
+    }
+    xSemaphoreGive(self->audioClientsMutex);
 }
 
 void CommunicationManager::staticOnAudioWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
@@ -665,11 +1050,17 @@ void CommunicationManager::onAudioWsEvent(AsyncWebSocket *server, AsyncWebSocket
             Serial.printf("WebSocket client #%lu connected from %s\n", client->id(), client->remoteIP().toString().c_str());
             // --- Lock Mutex ---
             if (xSemaphoreTake(audioClientsMutex, portMAX_DELAY) == pdTRUE) {
-                if (audioWsClients.size() < MAX_AUDIO_WS_CLIENTS) {
-                    audioWsClients.push_back(client);
+                // 上限按启动时的堆大小计算; 接入时再确认剩余堆仍够一个客户端的最坏开销
+                bool heapOk = ESP.getFreeHeap() > AUDIO_HEAP_RESERVE + AUDIO_CLIENT_HEAP_COST;
+                if (audioWsClients.size() < maxAudioClients_ && heapOk) {
+                    AudioClient ac = {};
+                    ac.client = client;
+                    ac.id = client->id();
+                    audioWsClients.push_back(ac);
                     Serial.printf("Client #%lu added. Total audio clients: %d\n", client->id(), audioWsClients.size());
                 } else {
-                    Serial.printf("Max WebSocket audio clients (%d) reached. Rejecting client #%lu.\n", MAX_AUDIO_WS_CLIENTS, client->id());
+                    Serial.printf("Audio client limit reached (%u clients, free heap %u). Rejecting client #%lu.\n",
+                                  (unsigned)maxAudioClients_, (unsigned)ESP.getFreeHeap(), client->id());
                     // Close client outside the lock if possible, or be quick
                     client->close(); 
                 }
@@ -685,19 +1076,9 @@ void CommunicationManager::onAudioWsEvent(AsyncWebSocket *server, AsyncWebSocket
             Serial.printf("WebSocket client #%lu disconnected\n", client->id());
             // --- Lock Mutex ---
             if (xSemaphoreTake(audioClientsMutex, portMAX_DELAY) == pdTRUE) {
-                size_t oldSize = audioWsClients.size();
-                audioWsClients.erase(
-                    std::remove_if(audioWsClients.begin(), audioWsClients.end(),
-                                [client](AsyncWebSocketClient* c) { return c->id() == client->id(); }),
-                    audioWsClients.end());
-                size_t newSize = audioWsClients.size();
+                removeAudioClient(client->id(), "disconnect");
                  // --- Unlock Mutex ---
                  xSemaphoreGive(audioClientsMutex);
-                 if (newSize < oldSize) {
-                    Serial.printf("Client #%lu removed. Total audio clients: %d\n", client->id(), newSize);
-                 } else {
-                    Serial.printf("Client #%lu not found for removal? Total audio clients: %d\n", client->id(), newSize);
-                 }
             } else {
                  Serial.println("ERR: Could not obtain audioClientsMutex for WS_EVT_DISCONNECT");
             }
@@ -712,19 +1093,9 @@ void CommunicationManager::onAudioWsEvent(AsyncWebSocket *server, AsyncWebSocket
              Serial.printf("WebSocket client #%lu error(%u): %s\n", client->id(), *((uint16_t*)arg), (char*)data);
              // --- Lock Mutex ---
              if (xSemaphoreTake(audioClientsMutex, portMAX_DELAY) == pdTRUE) {
-                 size_t oldSize = audioWsClients.size();
-                 audioWsClients.erase(
-                    std::remove_if(audioWsClients.begin(), audioWsClients.end(),
-                                [client](AsyncWebSocketClient* c) { return c->id() == client->id(); }),
-                    audioWsClients.end());
-                 size_t newSize = audioWsClients.size();
+                 removeAudioClient(client->id(), "error");
                  // --- Unlock Mutex ---
                  xSemaphoreGive(audioClientsMutex);
-                 if (newSize < oldSize) {
-                    Serial.printf("Client #%lu removed due to error. Total audio clients: %d\n", client->id(), newSize);
-                 } else {
-                    Serial.printf("Client #%lu not found for removal on error? Total audio clients: %d\n", client->id(), newSize);
-                 }
              } else {
                  Serial.println("ERR: Could not obtain audioClientsMutex for WS_EVT_ERROR");
              }
@@ -739,82 +1110,211 @@ void CommunicationManager::onAudioWsEvent(AsyncWebSocket *server, AsyncWebSocket
     }
 }
 
-bool CommunicationManager::connectWiFi() {
-  Serial.println("正在连接WiFi...");
-  WiFi.begin(wifiSsid_, wifiPassword_);
-
-  const int MAX_ATTEMPTS = 20;
-  for (int attempts = 0; attempts < MAX_ATTEMPTS && WiFi.status() != WL_CONNECTED; attempts++) {
-    delay(500);
-    Serial.print(".");
-  }
-  Serial.println();
-
-  bool connected = (WiFi.status() == WL_CONNECTED);
-  if (connected) {
-    Serial.println("WiFi已连接");
-    Serial.print("IP地址: ");
+void CommunicationManager::beginNetwork(AsyncWebServer* httpServer) {
+    HeapScope heapScope(HEAP_TAG_COMM);
+    httpServer_ = httpServer;
+    // JSON 回复用的内存区和响应缓冲池在启动时一次性分配, 之后每个请求复用
+    commandArena_.begin();
+    httpArena_.begin();
+    httpBodies_.begin();
+    // 路由只需注册一次; 服务器本身在链路建立后才启动
+    setupHttpServer(httpServer_);
+    setupWebSocketServer(httpServer_);
+
+    WiFi.persistent(false);
+    WiFi.setAutoReconnect(false); // Reconnection (with backoff) is owned by updateWiFi()
+    WiFi.onEvent(staticOnWiFiEvent);
+    WiFi.mode(WIFI_STA);
+
+    if (uiManagerPtr_) {
+        uiManagerPtr_->setWifiStatus(false);
+        uiManagerPtr_->setTimeStatus(false);
+    }
+    startWiFiAttempt(millis());
+}
+
+void CommunicationManager::staticOnWiFiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+    // Runs in the WiFi event task: record the event only, update() acts on it
+    CommunicationManager* self = globalCommManagerPtr;
+    if (!self) return;
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            self->wifiLinkUpPending_ = true;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+            self->wifiDisconnectReason_ = info.wifi_sta_disconnected.reason;
+            self->wifiLinkDownPending_ = true;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+            self->wifiLinkDownPending_ = true;
+            break;
+        default:
+            break;
+    }
+}
+
+void CommunicationManager::updateWiFi() {
+    if (wifiState_ == WIFI_STATE_IDLE) return;
+    unsigned long now = millis();
+
+    // Down first: if the link flapped up and down since the last update, the
+    // up event is only honoured when the driver still reports a connection.
+    if (wifiLinkDownPending_) {
+        wifiLinkDownPending_ = false;
+        onLinkDown();
+    }
+    if (wifiLinkUpPending_) {
+        wifiLinkUpPending_ = false;
+        if (WiFi.status() == WL_CONNECTED) {
+            onLinkUp();
+        }
+    }
+
+    switch (wifiState_) {
+        case WIFI_STATE_CONNECTING:
+            if (now - wifiStateSinceMs_ >= WIFI_CONNECT_TIMEOUT_MS) {
+                Serial.println("[CommManager] WiFi connect attempt timed out");
+                scheduleWiFiRetry(now);
+                WiFi.disconnect(); // The resulting DISCONNECTED event is ignored in BACKOFF
+            }
+            break;
+        case WIFI_STATE_BACKOFF:
+            if ((long)(now - wifiNextAttemptMs_) >= 0) {
+                startWiFiAttempt(now);
+            }
+            break;
+        case WIFI_STATE_CONNECTED:
+            checkNtpSync(now);
+            break;
+        default:
+            break;
+    }
+}
+
+void CommunicationManager::startWiFiAttempt(unsigned long now) {
+    wifiAttempts_++;
+    Serial.printf("[CommManager] Connecting to WiFi '%s' (attempt %lu)...\n", wifiSsid_, (unsigned long)wifiAttempts_);
+    WiFi.begin(wifiSsid_, wifiPassword_);
+    wifiState_ = WIFI_STATE_CONNECTING;
+    wifiStateSinceMs_ = now;
+}
+
+void CommunicationManager::scheduleWiFiRetry(unsigned long now) {
+    wifiNextAttemptMs_ = now + wifiBackoffMs_;
+    Serial.printf("[CommManager] WiFi retry in %lu ms\n", wifiBackoffMs_);
+    wifiBackoffMs_ = min(wifiBackoffMs_ * 2, WIFI_BACKOFF_MAX_MS);
+    wifiState_ = WIFI_STATE_BACKOFF;
+    wifiStateSinceMs_ = now;
+}
+
+void CommunicationManager::onLinkUp() {
+    if (wifiState_ == WIFI_STATE_CONNECTED) return;
+    Serial.print("[CommManager] WiFi已连接, IP地址: ");
     Serial.println(WiFi.localIP());
-  } else {
-    Serial.println("WiFi连接失败！");
-  }
-  if (uiManagerPtr_) {
-    uiManagerPtr_->setWifiStatus(connected);
-    uiManagerPtr_->forceRedraw();
-  }
-  return connected;
+    wifiState_ = WIFI_STATE_CONNECTED;
+    wifiStateSinceMs_ = millis();
+    wifiBackoffMs_ = WIFI_BACKOFF_INITIAL_MS;
+    wifiAttempts_ = 0;
+    bootTimeline.mark("wifi_connected");
+    if (uiManagerPtr_) {
+        uiManagerPtr_->setWifiStatus(true);
+    }
+
+    // Start network services now that there is an interface to bind to
+    begin();
+    if (httpServer_ && !httpRunning_) {
+        httpServer_->begin();
+        httpRunning_ = true;
+        Serial.println("HTTP 和 WebSocket 服务器已启动 (Port 80)");
+    }
+    syncNTPTime();
 }
 
-bool CommunicationManager::syncNTPTime() {
-  bool success = false;
-  if (isWiFiConnected()) {
-    Serial.println("正在同步NTP时间...");
-    configTime(gmtOffsetSec_, daylightOffsetSec_, ntpServer_);
+void CommunicationManager::onLinkDown() {
+    if (wifiState_ == WIFI_STATE_BACKOFF) return; // Retry already scheduled
+    bool wasConnected = (wifiState_ == WIFI_STATE_CONNECTED);
+    Serial.printf("[CommManager] WiFi %s (reason %u)\n",
+                  wasConnected ? "连接断开" : "连接失败", (unsigned)wifiDisconnectReason_);
+    if (wasConnected) {
+        stop();
+        if (httpServer_ && httpRunning_) {
+            httpServer_->end();
+            httpRunning_ = false;
+            Serial.println("HTTP server stopped.");
+        }
+        ntpPending_ = false;
+    }
+    if (uiManagerPtr_) {
+        uiManagerPtr_->setWifiStatus(false);
+    }
+    scheduleWiFiRetry(millis());
+}
+
+void CommunicationManager::checkNtpSync(unsigned long now) {
+    if (!ntpPending_ || now - ntpLastCheckMs_ < NTP_CHECK_INTERVAL_MS) return;
+    ntpLastCheckMs_ = now;
 
     struct tm timeinfo;
-    success = getLocalTime(&timeinfo);
-    if (!success) {
-      Serial.println("获取NTP时间失败");
-    } else {
-      Serial.println("NTP时间同步成功");
-      char timeString[50];
-      strftime(timeString, sizeof(timeString), "%Y-%m-%d %H:%M:%S", &timeinfo);
-      Serial.print("当前时间: ");
-      Serial.println(timeString);
-    }
-  } else {
-      Serial.println("WARN: WiFi未连接，跳过NTP同步。");
-      success = false;
-  }
-  if (uiManagerPtr_) {
-       uiManagerPtr_->setTimeStatus(success);
-       uiManagerPtr_->forceRedraw();
-  }
-  return success;
+    if (timeKeeper.isSynced() && getLocalTime(&timeinfo, 0)) { // Set by the SNTP callback, never waits
+        ntpPending_ = false;
+        char timeString[50];
+        strftime(timeString, sizeof(timeString), "%Y-%m-%d %H:%M:%S", &timeinfo);
+        Serial.printf("NTP时间同步成功, 当前时间: %s\n", timeString);
+        bootTimeline.mark("ntp_synced");
+        if (uiManagerPtr_) {
+            uiManagerPtr_->setTimeStatus(true);
+        }
+    }
+}
+
+bool CommunicationManager::connectWiFi() {
+    if (isWiFiConnected()) {
+        return true;
+    }
+    if (wifiState_ != WIFI_STATE_CONNECTING) {
+        startWiFiAttempt(millis());
+    }
+    return false;
+}
+
+bool CommunicationManager::syncNTPTime() {
+    if (!isWiFiConnected()) {
+        Serial.println("WARN: WiFi未连接，跳过NTP同步。");
+        return false;
+    }
+    Serial.println("正在同步NTP时间...");
+    timeKeeper.startSync(ntpServer_, gmtOffsetSec_, daylightOffsetSec_); // Background SNTP, does not wait
+    ntpPending_ = !timeKeeper.isSynced();
+    ntpLastCheckMs_ = 0;
+    return timeKeeper.isSynced();
 }
 
 bool CommunicationManager::reconnectWiFi() {
-    Serial.println("[CommManager] Attempting to reconnect WiFi...");
-    WiFi.disconnect(true);
-    delay(100);
-
-    bool wifiConnected = connectWiFi();
-    bool timeSynced = false;
-    if (wifiConnected) {
-        timeSynced = syncNTPTime();
+    Serial.println("[CommManager] Reconnect requested");
+    wifiBackoffMs_ = WIFI_BACKOFF_INITIAL_MS;
+    if (wifiState_ == WIFI_STATE_CONNECTED || wifiState_ == WIFI_STATE_CONNECTING) {
+        // DISCONNECTED event -> onLinkDown() stops the servers and retries after the initial backoff
+        WiFi.disconnect();
     } else {
-         if (uiManagerPtr_) {
-             uiManagerPtr_->setTimeStatus(false);
-             uiManagerPtr_->forceRedraw();
-         }
+        wifiNextAttemptMs_ = millis(); // Skip the remaining backoff
+        wifiState_ = WIFI_STATE_BACKOFF;
     }
-    return wifiConnected;
+    return isWiFiConnected();
 }
 
 bool CommunicationManager::isWiFiConnected() const {
     return (WiFi.status() == WL_CONNECTED);
 }
 
+const char* CommunicationManager::getWiFiStateName() const {
+    switch (wifiState_) {
+        case WIFI_STATE_CONNECTING: return "connecting";
+        case WIFI_STATE_CONNECTED:  return "connected";
+        case WIFI_STATE_BACKOFF:    return "backoff";
+        default:                    return "idle";
+    }
+}
+
 String CommunicationManager::getIPAddress() const {
     if (isWiFiConnected()) {
         return WiFi.localIP().toString();
@@ -3,39 +3,127 @@
 
 #include <WiFi.h>
 #include <vector>
+#include <memory>
 #include <time.h>
 #include "EnvironmentData.h"
 #include "i2s_mic_manager.h"
+#include "wire_protocol.h"
+#include "data_manager.h" // For SyncCursor
+#include "metrics.h"
+#include "json_arena.h"
+#include "block_pool.h"
 #include <ESPAsyncWebServer.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 
 class UIManager;
+struct WebAsset;
 
 class CommunicationManager {
 private:
     // Command Server
-    WiFiServer* server;
-    std::vector<WiFiClient> clients;
+    static const size_t CLIENT_RX_BUFFER_SIZE = WireProtocol::HEADER_SIZE + 128; // One full request frame / text line
+    static const int MAX_COMMANDS_PER_UPDATE = 8; // Pipelined requests drained per client per update
+    static const size_t SYNC_RECORDS_PER_UPDATE = 32; // SYNC chunk size per client per update
+
+    // Per-connection state: negotiated protocol and partially received request bytes
+    struct ClientSession {
+        bool active;          // Slot holds a connection
+        WiFiClient client;
+        bool binaryMode;      // true after "PROTO BIN1" negotiation
+        uint8_t envSchema;    // Record layout in BIN1: SCHEMA_ENV_V2, or SCHEMA_ENV_V3 after "PROTO BIN1 ENV3"
+        size_t rxLen;         // Bytes currently buffered in rxBuf
+        uint8_t rxBuf[CLIENT_RX_BUFFER_SIZE];
+        bool syncActive;      // A SYNC stream is in progress
+        uint32_t syncRequestSeq; // Request seq echoed on SYNC frames (BIN1)
+        SyncCursor syncCursor;
+        uint32_t queryJob;    // DataManager query handle of a QUERY in progress (0 = none)
+        uint32_t queryRequestSeq; // Request seq echoed on the QUERY reply (BIN1)
+    };
+
     static const uint16_t SERVER_PORT = 8266;
     static const size_t MAX_CLIENTS = 5;
+    WiFiServer* server;
+    ClientSession clients[MAX_CLIENTS]; // Fixed slots: connect/disconnect never moves or allocates sessions
+    size_t clientCount_;
+
+    // JSON replies are built in per-request arenas (json_arena.h) and serialized into fixed
+    // buffers instead of String; the main loop and the async_tcp task each have their own arena.
+    static const size_t COMMAND_ARENA_SIZE = 2048;  // TCP command replies (main loop)
+    static const size_t HTTP_ARENA_SIZE = 2048;     // HTTP handlers (async_tcp task)
+    static const size_t HTTP_BODY_SIZE = 512;       // Pooled response bodies, held until the request ends
+    static const uint8_t HTTP_BODY_COUNT = 4;
+    static const size_t JSON_LINE_SIZE = 256;       // One record as a text-mode JSON line
+    JsonArena commandArena_;
+    JsonArena httpArena_;
+    BlockPool httpBodies_;
 
     // WebSocket Audio Server
-    AsyncWebSocket* audioWs;
-    std::vector<AsyncWebSocketClient*> audioWsClients;
-    static const size_t MAX_AUDIO_WS_CLIENTS = 2;
+    // Each audio frame is converted once into a shared, reference-counted buffer and
+    // handed to every client; a client only holds references, never a copy.
     static const size_t WS_AUDIO_BUFFER_SAMPLES = 512; // Number of samples per WebSocket message (Adjust as needed)
-    int16_t wsAudioBuffer[WS_AUDIO_BUFFER_SAMPLES]; // New buffer (512 * 16-bit samples = 1024 bytes)
+    static const size_t WS_AUDIO_FRAME_BYTES = WS_AUDIO_BUFFER_SAMPLES * sizeof(int16_t);
+    static const size_t AUDIO_CLIENT_QUEUE_DEPTH = 4;   // Frames waiting per client before drop-oldest kicks in
+    static const size_t AUDIO_CLIENT_INFLIGHT = 2;      // Frames handed to the library queue per client
+    static const size_t MAX_AUDIO_WS_CLIENTS_LIMIT = 16; // Upper bound regardless of free heap
+    static const size_t AUDIO_HEAP_RESERVE = 48 * 1024;  // Heap kept free for everything else
+    // Worst-case heap per client: its own queued frames + library in-flight messages + TCP send buffer
+    static const size_t AUDIO_CLIENT_HEAP_COST = (AUDIO_CLIENT_QUEUE_DEPTH + AUDIO_CLIENT_INFLIGHT) * (WS_AUDIO_FRAME_BYTES + 64) + 8 * 1024;
+    // Frames are reused once every client and the library have let go of them. Enough for
+    // one client's queue and in-flight messages; more slow clients fall back to new frames.
+    static const size_t AUDIO_FRAME_POOL_SIZE = AUDIO_CLIENT_QUEUE_DEPTH + AUDIO_CLIENT_INFLIGHT + 2;
+
+    struct AudioClient {
+        AsyncWebSocketClient* client;
+        uint32_t id;
+        AsyncWebSocketSharedBuffer queue[AUDIO_CLIENT_QUEUE_DEPTH]; // Ring of pending frames
+        uint8_t head;           // Oldest pending frame
+        uint8_t count;          // Pending frames
+        uint32_t framesSent;
+        uint32_t framesDropped; // Oldest frames discarded because the client fell behind
+    };
+
+    AsyncWebSocket* audioWs;
+    std::vector<AudioClient> audioWsClients; // Capacity reserved for maxAudioClients_ at setup
+    AsyncWebSocketSharedBuffer audioFramePool_[AUDIO_FRAME_POOL_SIZE]; // Filled on first use, main loop only
+    size_t maxAudioClients_;   // Derived from free heap in setupWebSocketServer()
 
     bool isRunning;
     EnvironmentData currentData;
     I2SMicManager* micManagerPtr;
     UIManager* uiManagerPtr_;
+    DataManager* dataManagerPtr_; // Record source for GET_CURRENT / SYNC
 
     // Mutex for protecting audioWsClients vector
     SemaphoreHandle_t audioClientsMutex;
 
+    // WiFi connection state machine. WiFi.onEvent callbacks (WiFi event task) only
+    // set the pending flags; all transitions and server start/stop happen in update().
+    enum WifiState : uint8_t {
+        WIFI_STATE_IDLE,        // beginNetwork() not called yet
+        WIFI_STATE_CONNECTING,  // WiFi.begin() issued, waiting for GOT_IP
+        WIFI_STATE_CONNECTED,   // Link up, servers running
+        WIFI_STATE_BACKOFF      // Waiting for wifiNextAttemptMs_
+    };
+    static const unsigned long WIFI_CONNECT_TIMEOUT_MS = 15000;
+    static const unsigned long WIFI_BACKOFF_INITIAL_MS = 1000;
+    static const unsigned long WIFI_BACKOFF_MAX_MS = 60000;
+    static const unsigned long NTP_CHECK_INTERVAL_MS = 1000;
+
+    AsyncWebServer* httpServer_;
+    bool httpRunning_;
+    WifiState wifiState_;
+    unsigned long wifiStateSinceMs_;
+    unsigned long wifiNextAttemptMs_;
+    unsigned long wifiBackoffMs_;
+    uint32_t wifiAttempts_;
+    volatile bool wifiLinkUpPending_;
+    volatile bool wifiLinkDownPending_;
+    volatile uint8_t wifiDisconnectReason_;
+    bool ntpPending_;             // configTime() issued, waiting for the first SNTP reply
+    unsigned long ntpLastCheckMs_;
+
     // Network Configuration (Moved from .ino)
     const char* wifiSsid_;
     const char* wifiPassword_;
@@ -44,7 +132,7 @@ private:
     int daylightOffsetSec_;
 
 public:
-    CommunicationManager(I2SMicManager* micMgr, UIManager* uiMgr,
+    CommunicationManager(I2SMicManager* micMgr, UIManager* uiMgr, DataManager* dataMgr,
                          const char* ssid, const char* password,
                          const char* ntpServer = "pool.ntp.org",
                          long gmtOffset = 28800, int daylightOffset = 0);
@@ -53,7 +141,7 @@ public:
     // Command server methods
     bool begin();
     void stop();
-    void update(); // Handles command clients
+    void update(); // Drives the WiFi state machine and handles command clients
     bool isServerRunning() const { return isRunning; }
     void broadcastEnvironmentData(const EnvironmentData& data); // Still just updates internal data
     void sendHistoricalData(WiFiClient& client, const std::vector<EnvironmentData>& data);
@@ -66,10 +154,13 @@ public:
     void streamAudioViaWebSocket();
 
     // --- Network Management Methods ---
-    bool connectWiFi();         // Tries to connect to WiFi
-    bool syncNTPTime();       // Tries to sync NTP time
-    bool reconnectWiFi();     // Disconnects, connects, syncs time
+    // None of these block: they request a state change that update() carries out.
+    void beginNetwork(AsyncWebServer* httpServer); // Registers routes + WiFi events, starts connecting
+    bool connectWiFi();         // Starts a connection attempt now; returns current link state
+    bool syncNTPTime();       // Starts SNTP; returns true if the clock is already set
+    bool reconnectWiFi();     // Drops the link and retries with a fresh backoff
     bool isWiFiConnected() const; // Checks current WiFi status
+    const char* getWiFiStateName() const;
     String getIPAddress() const;  // Gets local IP address
     // --- End Network Management ---
 
@@ -79,10 +170,45 @@ private:
     void handleClientMessages();
     void removeDisconnectedClients();
     void sendJsonData(WiFiClient& client, const EnvironmentData& data);
-    void processClientCommand(WiFiClient& client, const String& command);
+    size_t formatRecordJson(const EnvironmentData& data, char* out, size_t outSize); // Uses commandArena_
+    bool extractCommand(ClientSession& session, char* command, size_t commandSize, uint32_t& requestSeq);
+    void processClientCommand(ClientSession& session, const char* command, uint32_t requestSeq);
+
+    // Protocol-aware reply helpers (text lines or BIN1 frames depending on the session)
+    void sendRecords(ClientSession& session, uint32_t requestSeq, const EnvironmentData* records, size_t count);
+    void sendStatus(ClientSession& session, uint32_t requestSeq, const char* text, bool isError = false);
+    void sendJsonDocument(ClientSession& session, uint32_t requestSeq, const char* json, size_t length);
+    void runQueryCommand(ClientSession& session, uint32_t requestSeq, const char* args);
+    void pumpQuery(ClientSession& session);
+    void releaseSession(ClientSession& session);
+    void pumpSync(ClientSession& session);
+    void runWireBenchmark(ClientSession& session, uint32_t requestSeq, int iterations);
+    void runGlyphBenchmark(ClientSession& session, uint32_t requestSeq, int iterations);
+
+    // Serves a pre-compressed web/ asset from flash with ETag revalidation
+    static void serveWebAsset(AsyncWebServerRequest* request, const WebAsset& asset);
+    // Sends doc from a pooled body buffer (String fallback when the pool is empty)
+    void sendJsonResponse(AsyncWebServerRequest* request, int code, const JsonDocument& doc);
+
+    // Audio fan-out helpers (called with audioClientsMutex held)
+    size_t computeAudioClientCap() const;
+    AsyncWebSocketSharedBuffer acquireAudioFrame(size_t bytes);
+    void enqueueAudioFrame(AudioClient& ac, const AsyncWebSocketSharedBuffer& frame);
+    void drainAudioQueue(AudioClient& ac);
+    void removeAudioClient(uint32_t clientId, const char* reason);
+
+    // WiFi state machine helpers (main loop only)
+    void updateWiFi();
+    void startWiFiAttempt(unsigned long now);
+    void scheduleWiFiRetry(unsigned long now);
+    void onLinkUp();
+    void onLinkDown();
+    void checkNtpSync(unsigned long now);
+    static void staticOnWiFiEvent(arduino_event_id_t event, arduino_event_info_t info);
 
     // WebSocket Event Handler
     void onAudioWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len);
+    static void collectMetrics(MetricsWriter& writer, void* context);
     static void staticOnAudioWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len);
 
 };
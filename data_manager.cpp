@@ -2,10 +2,35 @@
 #include <Arduino.h>
 #include <time.h>   // For time() and time formatting
 #include <SD_MMC.h> // Ensure SD MMC library is included
+#include <Preferences.h> // NVS storage for the record sequence reservation
+#include "metrics.h"
+#include "time_keeper.h"
+#include "boot_timeline.h"
+#include "heap_tracker.h"
+
+static const char* DATA_FILE_PATH = "/env_data.csv";
+static const char* CSV_HEADER = "seq,timestamp,datetime,decibels,humidity,temperature,lux,flags";
+static const char* SEQ_PREFS_NAMESPACE = "soundscape";
+static const char* SEQ_PREFS_KEY = "seq_next";
+static const char* ROLLUP_FILE_PATH = "/rollup_1h.bin";
+static const uint32_t SECONDS_PER_HOUR = 3600;
 
 // Constructor
 DataManager::DataManager(I2SMicManager& micMgr, TempHumSensor& thSensor, LightSensor& lSensor, UIManager& uiMgr) :
     dataIndex(0),
+    latestIndex_(-1),
+    nextSeq_(1),
+    seqReservedUntil_(1),
+    lastFlushedSeq_(0),
+    openRollupValid_(false),
+    rollupHourEnd_(0),
+    lateRecords_(0),
+    queryMutex_(nullptr),
+    nextQueryTicket_(1),
+    queryTask_(nullptr),
+    ramSnapshot_(nullptr),
+    ramSnapshotCount_(0),
+    queryCells_(nullptr),
     micManager_(micMgr),
     tempHumSensor_(thSensor),
     lightSensor_(lSensor),
@@ -19,10 +44,18 @@ DataManager::DataManager(I2SMicManager& micMgr, TempHumSensor& thSensor, LightSe
     for (int i = 0; i < DATA_BUFFER_MINUTES; ++i) {
         envData[i] = EnvironmentData(); // Uses default constructor (all NAN/0)
     }
+    queryMutex_ = xSemaphoreCreateMutex();
+    for (size_t i = 0; i < MAX_QUERY_JOBS; ++i) {
+        queryJobs_[i].handle = 0;
+        queryJobs_[i].state = QUERY_JOB_FREE;
+    }
+    portMUX_INITIALIZE(&queryJobMux_);
+    portMUX_INITIALIZE(&ringMux_);
 }
 
 // Initialization logic
 bool DataManager::begin() {
+    HeapScope heapScope(HEAP_TAG_DATA);
     sdCardOk_ = initSDCardInternal();
     if (sdCardOk_) {
         createHeaderIfNeededInternal();
@@ -30,13 +63,35 @@ bool DataManager::begin() {
     } else {
         Serial.println("[DataManager] WARN: SD Card Failed to Initialize.");
     }
-    lastSensorReadTime_ = millis(); // Initialize timers
+    initSequenceInternal(); // After SD init so the log can seed the sequence
+    initRollupsInternal();
+
+    // Query task, with room to snapshot the whole RAM ring and for the largest result
+    // (PSRAM when present)
+    size_t snapshotBytes = DATA_BUFFER_MINUTES * sizeof(EnvironmentData);
+    ramSnapshot_ = (EnvironmentData*)heapAlloc(HEAP_TAG_DATA, snapshotBytes, MALLOC_CAP_SPIRAM);
+    if (ramSnapshot_ == nullptr && !isLowMemory(snapshotBytes + 40000)) {
+        ramSnapshot_ = (EnvironmentData*)heapAlloc(HEAP_TAG_DATA, snapshotBytes, MALLOC_CAP_8BIT);
+    }
+    size_t cellBytes = QuerySpec::MAX_CELLS * sizeof(double);
+    queryCells_ = (double*)heapAlloc(HEAP_TAG_DATA, cellBytes, MALLOC_CAP_SPIRAM);
+    if (queryCells_ == nullptr && !isLowMemory(cellBytes + 40000)) {
+        queryCells_ = (double*)heapAlloc(HEAP_TAG_DATA, cellBytes, MALLOC_CAP_8BIT);
+    }
+    if (ramSnapshot_ == nullptr || queryCells_ == nullptr ||
+        xTaskCreate(queryTaskEntry, "query", QUERY_TASK_STACK_SIZE, this, 1, &queryTask_) != pdPASS) {
+        queryTask_ = nullptr;
+        Serial.println("[DataManager] ERR: Failed to start query task, history queries unavailable.");
+    }
+
+    lastSensorReadTime_ = millis() - SENSOR_READ_INTERVAL; // First record on the next update()
     lastSaveTime_ = millis();
     return true; // DataManager itself always "begins" successfully
 }
 
 // Update function called periodically in loop
 void DataManager::update() {
+    HeapScope heapScope(HEAP_TAG_DATA);
     unsigned long currentMillis = millis();
 
     // --- 1. Sensor Data Recording ---
@@ -49,16 +104,21 @@ void DataManager::update() {
 
     // --- 2. SD Card Saving Logic ---
     if (sdCardOk_) {
-        // Check if buffer is full OR save interval passed (and there's data to save)
+        // Check if buffer is full OR save interval passed (and there's data to save).
+        // Shortly after boot, wait for the first NTP sync so the records can be re-stamped.
+        bool holdForTimeSync = !timeKeeper.isSynced() && currentMillis < UNSYNCED_HOLD_MS;
         if (dataIndex >= DATA_BUFFER_MINUTES ||
-            (dataIndex > 0 && currentMillis - lastSaveTime_ >= SAVE_INTERVAL))
+            (dataIndex > 0 && !holdForTimeSync && currentMillis - lastSaveTime_ >= SAVE_INTERVAL))
         {
-            saveEnvironmentDataToSDInternal(); // This resets dataIndex
-            lastSaveTime_ = currentMillis;
+            // Resets dataIndex. Deferred while a query holds the log; retried on the next update.
+            if (saveEnvironmentDataToSDInternal()) {
+                lastSaveTime_ = currentMillis;
+            }
         } else if (dataIndex == 0) {
             // If index was reset by saving, update save timer
             lastSaveTime_ = currentMillis;
         }
+        updateRollupsInternal(); // Catch up on newly flushed log records
     } else {
         // No SD Card: Buffer full logic is handled inside recordEnvironmentDataInternal (wraps index)
         // We might still want to reset the save timer conceptually if the buffer fills
@@ -79,8 +139,11 @@ void DataManager::recordCurrentData() {
 void DataManager::saveDataToSd() {
     if (sdCardOk_) {
         Serial.println("[DataManager] Manual SD save triggered.");
-        saveEnvironmentDataToSDInternal();
-        lastSaveTime_ = millis(); // Reset save timer
+        if (saveEnvironmentDataToSDInternal()) {
+            lastSaveTime_ = millis(); // Reset save timer
+        } else {
+            Serial.println("[DataManager] Manual SD save deferred: a history query is reading the log.");
+        }
     } else {
         Serial.println("[DataManager] Manual SD save failed: SD card not available.");
     }
@@ -103,20 +166,42 @@ int DataManager::getDataBufferSize() const {
 
 // Helper to get the most recent valid entry
 const EnvironmentData& DataManager::getLatestData() const {
-    // Calculate the index of the last written element in the circular buffer
-    // If dataIndex is 0, it means the buffer either is empty or just wrapped around.
-    // If it wrapped, the last element is at the end. If empty, this still returns envData[size-1] which is default.
-    int latestIdx = (dataIndex == 0) ? (DATA_BUFFER_MINUTES - 1) : (dataIndex - 1);
+    // latestIndex_ tracks the last written slot; dataIndex alone is ambiguous after
+    // an SD save resets it to 0 while older records remain in the buffer.
+    if (latestIndex_ < 0 || latestIndex_ >= DATA_BUFFER_MINUTES) {
+         static EnvironmentData emptyData; // No record yet: timestamp 0 means "no data"
+         return emptyData;
+    }
+
+    return envData[latestIndex_];
+}
 
-    // Add bounds check just in case (should not happen with correct logic)
-    if (latestIdx < 0 || latestIdx >= DATA_BUFFER_MINUTES) {
-         Serial.printf("ERR: Invalid latestIdx %d calculated (dataIndex=%d). Returning dummy.\n", latestIdx, dataIndex);
-         static EnvironmentData dummyData; // Return a static dummy if index is invalid
-         dummyData = EnvironmentData(); // Reset dummy
-         return dummyData;
+uint32_t DataManager::getLastSeq() const {
+    return (latestIndex_ >= 0) ? envData[latestIndex_].seq : 0;
+}
+
+size_t DataManager::readRecordsSince(SyncCursor& cursor, EnvironmentData* out, size_t maxRecords) {
+    if (out == nullptr || maxRecords == 0) return 0;
+
+    if (cursor.phase == SyncCursor::PHASE_SD) {
+        if (!sdCardOk_) {
+            cursor.phase = SyncCursor::PHASE_RAM;
+        } else {
+            size_t n = readSdRecordsInternal(cursor, out, maxRecords);
+            if (n > 0 || cursor.phase == SyncCursor::PHASE_SD) {
+                return n; // More SD data may follow on the next call
+            }
+        }
     }
 
-    return envData[latestIdx];
+    if (cursor.phase == SyncCursor::PHASE_RAM) {
+        size_t n = readRamRecordsInternal(cursor, out, maxRecords);
+        if (n == 0) {
+            cursor.phase = SyncCursor::PHASE_DONE;
+        }
+        return n;
+    }
+    return 0;
 }
 
 // <<<<< ADDED Implementation for SD card status getter
@@ -152,10 +237,39 @@ bool DataManager::initSDCardInternal() {
 
 void DataManager::createHeaderIfNeededInternal() {
   // Logic moved from SoundScape.ino::createHeaderIfNeeded
-  if (sdCardOk_ && !SD_MMC.exists("/env_data.csv")) {
-    File dataFile = SD_MMC.open("/env_data.csv", FILE_WRITE);
+  if (!sdCardOk_) return;
+
+  // Logs written before records carried a seq column cannot be synced by seq;
+  // move them aside instead of mixing two layouts in one file.
+  if (SD_MMC.exists(DATA_FILE_PATH)) {
+    File existing = SD_MMC.open(DATA_FILE_PATH, FILE_READ);
+    char firstLine[8] = {0};
+    if (existing) {
+      existing.read((uint8_t*)firstLine, sizeof(firstLine) - 1);
+      existing.close();
+    }
+    if (strncmp(firstLine, "seq,", 4) != 0) {
+      char legacyPath[32];
+      bool haveName = false;
+      for (int i = 0; i < MAX_LEGACY_LOGS && !haveName; ++i) {
+        snprintf(legacyPath, sizeof(legacyPath), "/env_data_legacy%d.csv", i);
+        haveName = !SD_MMC.exists(legacyPath);
+      }
+      if (haveName && SD_MMC.rename(DATA_FILE_PATH, legacyPath)) {
+        Serial.printf("[DataManager] Moved pre-seq log to %s\n", legacyPath);
+      } else {
+        // Never append seq lines to the old layout: stop logging until the file is moved by hand
+        Serial.println("[DataManager] ERR: Failed to move pre-seq log aside, SD logging disabled.");
+        sdCardOk_ = false;
+        return;
+      }
+    }
+  }
+
+  if (!SD_MMC.exists(DATA_FILE_PATH)) {
+    File dataFile = SD_MMC.open(DATA_FILE_PATH, FILE_WRITE);
     if (dataFile) {
-      dataFile.println("timestamp,datetime,decibels,humidity,temperature,lux");
+      dataFile.println(CSV_HEADER);
       dataFile.close();
       Serial.println("[DataManager] Created CSV header file (/env_data.csv)");
     } else {
@@ -173,21 +287,19 @@ void DataManager::recordEnvironmentDataInternal() {
     isRecording_ = true;
 
     // Check memory (optional, but good practice)
-    if (isLowMemory(15000)) {
-        Serial.println("[DataManager] WARN: Low memory detected before recording, releasing emergency memory.");
-        releaseEmergencyMemory();
-        if (isLowMemory(10000)) {
-             Serial.println("[DataManager] ERR: Memory critically low even after releasing emergency pool! Skipping record.");
-             isRecording_ = false;
-             return;
-        }
+    if (isLowMemory(10000)) {
+        Serial.println("[DataManager] ERR: Memory critically low! Skipping record.");
+        isRecording_ = false;
+        return;
     }
 
     // --- 1. Prepare Data Structure ---
     EnvironmentData newData;
-    // Use UIManager to check if NTP time is synced
-    time_t now = uiManager_.isTimeInitialized() ? time(NULL) : millis() / 1000;
-    newData.timestamp = now;
+    // Monotonic time base; before the first NTP sync this is seconds since boot (flagged)
+    TimeKeeper::Stamp stamp = timeKeeper.stamp();
+    newData.timestamp = stamp.seconds;
+    newData.flags = stamp.synced ? 0 : EnvironmentData::FLAG_TIME_UNSYNCED;
+    newData.seq = allocateSeqInternal();
     // Initialize sensor readings to NAN
     newData.decibels = NAN;
     newData.humidity = NAN;
@@ -201,7 +313,9 @@ void DataManager::recordEnvironmentDataInternal() {
     // bool lightReadSuccess = false;
 
     // Noise Level
+    uint32_t readStartUs = micros();
     float db_reading = micManager_.readNoiseLevel(500); // Use the I2S Manager instance
+    systemMetrics.micReadUs.observe(micros() - readStartUs);
     if (!isnan(db_reading)) {
         newData.decibels = db_reading; // Already validated by micManager
         // micReadSuccess = true; // Removed
@@ -209,7 +323,10 @@ void DataManager::recordEnvironmentDataInternal() {
 
     // Temperature & Humidity
     float temp_reading, hum_reading;
-    if (tempHumSensor_.readData(temp_reading, hum_reading)) { // Use TempHumSensor instance
+    readStartUs = micros();
+    bool tempHumOk = tempHumSensor_.readData(temp_reading, hum_reading);
+    systemMetrics.tempHumReadUs.observe(micros() - readStartUs);
+    if (tempHumOk) { // Use TempHumSensor instance
         newData.temperature = temp_reading;
         newData.humidity = hum_reading;
         // tempHumReadSuccess = true; // Removed
@@ -217,7 +334,10 @@ void DataManager::recordEnvironmentDataInternal() {
 
     // Light Level
     float lux_reading;
-    if (lightSensor_.readData(lux_reading)) { // Use LightSensor instance
+    readStartUs = micros();
+    bool lightOk = lightSensor_.readData(lux_reading);
+    systemMetrics.lightReadUs.observe(micros() - readStartUs);
+    if (lightOk) { // Use LightSensor instance
         newData.lux = lux_reading;
         // lightReadSuccess = true; // Removed
     }
@@ -229,8 +349,13 @@ void DataManager::recordEnvironmentDataInternal() {
         dataIndex = 0;
     }
 
-    // Store the new data (valid or NAN) into the buffer
+    // Store the new data (valid or NAN) into the buffer. The query task copies slots
+    // concurrently (snapshotRamInternal), so the slot write is done as a unit.
+    portENTER_CRITICAL(&ringMux_);
     envData[dataIndex] = newData;
+    latestIndex_ = dataIndex;
+    portEXIT_CRITICAL(&ringMux_);
+    bootTimeline.mark("first_record"); // Only the first call after boot is recorded
 
     // --- 4. Log Data (Optional Debugging) ---
     // Serial.printf("\n==== DM Record [%d] @ %lld ====\n", dataIndex, (long long)now);
@@ -248,30 +373,40 @@ void DataManager::recordEnvironmentDataInternal() {
     isRecording_ = false;
 }
 
-void DataManager::saveEnvironmentDataToSDInternal() {
+bool DataManager::saveEnvironmentDataToSDInternal() {
     // Logic moved from SoundScape.ino::saveEnvironmentDataToSD
     if (!sdCardOk_) {
         Serial.println("[DataManager] ERR: Cannot save to SD, card not OK.");
         // If SD becomes unavailable, reset dataIndex to prevent buffer overflow if not handled elsewhere
         // dataIndex = 0; // Or just let it wrap around as per record logic
-        return;
+        return true;
     }
     if (dataIndex == 0) {
          // Serial.println("[DataManager] DBG: No new data to save to SD.");
-         return; // Nothing to save
+         return true; // Nothing to save
+    }
+
+    // The query task scans this file and the flushed/unflushed split, so the append and the
+    // dataIndex reset happen under queryMutex_. Only wait long when the buffer is full.
+    TickType_t lockWait = (dataIndex >= DATA_BUFFER_MINUTES) ? pdMS_TO_TICKS(2000) : pdMS_TO_TICKS(20);
+    if (xSemaphoreTake(queryMutex_, lockWait) != pdTRUE) {
+        return false;
     }
 
     // Attempt to open the file in append mode
     // Use a local File object, don't rely on a global one
-    File dataFile = SD_MMC.open("/env_data.csv", FILE_APPEND);
+    File dataFile = SD_MMC.open(DATA_FILE_PATH, FILE_APPEND);
     if (!dataFile) {
         Serial.println("[DataManager] ERR: Failed to open /env_data.csv for appending.");
         sdCardOk_ = false; // Assume SD card issue if file cannot be opened
         // Consider resetting dataIndex or implementing retry logic
-        return;
+        xSemaphoreGive(queryMutex_);
+        return true;
     }
 
     Serial.printf("[DataManager] Saving %d records to SD card...\n", dataIndex);
+    uint32_t flushStartUs = micros();
+    resolvePendingTimestampsInternal();
     int recordsSaved = 0;
 
     // Iterate through the data buffer up to the current dataIndex
@@ -282,16 +417,21 @@ void DataManager::saveEnvironmentDataToSDInternal() {
         localtime_r(&envData[i].timestamp, &timeinfo); // Use reentrant version
         strftime(timeString, sizeof(timeString), "%Y-%m-%d %H:%M:%S", &timeinfo);
 
-        // Prepare data line string
-        String dataLine = String(envData[i].timestamp) + "," +
-                          String(timeString) + "," +
-                          String(envData[i].decibels, 1) + "," + // Format float precision
-                          String(envData[i].humidity, 1) + "," +
-                          String(envData[i].temperature, 1) + "," +
-                          String(envData[i].lux, 0); // Lux usually whole number
+        // Prepare data line in a stack buffer (no String temporaries per field)
+        char dataLine[112];
+        int lineLen = snprintf(dataLine, sizeof(dataLine), "%lu,%lld,%s,%.1f,%.1f,%.1f,%.0f,%u\r\n",
+                               (unsigned long)envData[i].seq,
+                               (long long)envData[i].timestamp,
+                               timeString,
+                               envData[i].decibels,
+                               envData[i].humidity,
+                               envData[i].temperature,
+                               envData[i].lux, // Lux usually whole number
+                               (unsigned)envData[i].flags);
 
         // Write line to file
-        if (dataFile.println(dataLine)) {
+        if (lineLen > 0 && lineLen < (int)sizeof(dataLine) &&
+            dataFile.write((const uint8_t*)dataLine, lineLen) == (size_t)lineLen) {
             recordsSaved++;
         } else {
             Serial.println("[DataManager] ERR: Error writing data line to SD card!");
@@ -301,6 +441,10 @@ void DataManager::saveEnvironmentDataToSDInternal() {
     }
 
     dataFile.close(); // Close the file
+    systemMetrics.sdFlushUs.observe(micros() - flushStartUs);
+    if (recordsSaved > 0) {
+        lastFlushedSeq_ = envData[recordsSaved - 1].seq;
+    }
 
     Serial.printf("[DataManager] Successfully saved %d records.\n", recordsSaved);
 
@@ -308,9 +452,727 @@ void DataManager::saveEnvironmentDataToSDInternal() {
     // If recordsSaved < dataIndex, some data might be lost if we reset.
     // Safest: Reset index regardless to prevent re-saving old data on next attempt.
     dataIndex = 0;
+    xSemaphoreGive(queryMutex_);
 
     // Re-initialize buffer with default values after saving (optional)
     // for (int i = 0; i < DATA_BUFFER_MINUTES; ++i) {
     //     envData[i] = EnvironmentData();
     // }
+    return true;
+}
+
+
+// Re-stamps records taken before the first NTP sync. Their timestamp is seconds since
+// this boot on the monotonic clock, which TimeKeeper can now map to wall-clock time.
+void DataManager::resolvePendingTimestampsInternal() {
+    if (!timeKeeper.isSynced()) return;
+    int fixed = 0;
+    for (int i = 0; i < dataIndex; i++) {
+        EnvironmentData& record = envData[i];
+        if ((record.flags & EnvironmentData::FLAG_TIME_UNSYNCED) &&
+            timeKeeper.toWallClock(record.timestamp, record.timestamp)) {
+            record.flags &= ~EnvironmentData::FLAG_TIME_UNSYNCED;
+            fixed++;
+        }
+    }
+    if (fixed > 0) {
+        Serial.printf("[DataManager] Re-stamped %d pre-sync records with wall-clock time.\n", fixed);
+    }
+}
+
+
+// --- Record Sequence ---
+
+void DataManager::initSequenceInternal() {
+    uint32_t persisted = 1;
+    Preferences prefs;
+    if (prefs.begin(SEQ_PREFS_NAMESPACE, true)) { // Read-only
+        persisted = prefs.getUInt(SEQ_PREFS_KEY, 1);
+        prefs.end();
+    }
+
+    // The SD log is the source of truth if NVS was erased or lags behind
+    uint32_t sdLast = sdCardOk_ ? readLastSeqFromSdInternal() : 0;
+    nextSeq_ = max(persisted, sdLast + 1);
+    lastFlushedSeq_ = sdLast;
+    seqReservedUntil_ = nextSeq_; // First allocation reserves (and persists) a new block
+    Serial.printf("[DataManager] Record seq resumes at %lu (NVS=%lu, SD=%lu)\n",
+                  (unsigned long)nextSeq_, (unsigned long)persisted, (unsigned long)sdLast);
+}
+
+uint32_t DataManager::allocateSeqInternal() {
+    if (nextSeq_ >= seqReservedUntil_) {
+        // Persist the end of the next block before handing out any seq from it.
+        // After a reboot numbering resumes there, so seq never repeats (gaps are fine).
+        seqReservedUntil_ = nextSeq_ + SEQ_RESERVE_BLOCK;
+        Preferences prefs;
+        if (prefs.begin(SEQ_PREFS_NAMESPACE, false)) {
+            prefs.putUInt(SEQ_PREFS_KEY, seqReservedUntil_);
+            prefs.end();
+        } else {
+            Serial.println("[DataManager] WARN: Failed to persist seq reservation to NVS.");
+        }
+    }
+    return nextSeq_++;
+}
+
+uint32_t DataManager::readLastSeqFromSdInternal() {
+    File file = SD_MMC.open(DATA_FILE_PATH, FILE_READ);
+    if (!file) return 0;
+
+    // The last complete line fits comfortably in the file tail
+    char tail[160];
+    size_t fileSize = file.size();
+    size_t start = (fileSize > sizeof(tail) - 1) ? fileSize - (sizeof(tail) - 1) : 0;
+    file.seek(start);
+    int len = file.read((uint8_t*)tail, sizeof(tail) - 1);
+    file.close();
+    if (len <= 0) return 0;
+    tail[len] = '\0';
+
+    // Strip trailing line breaks, then find the start of the last line
+    while (len > 0 && (tail[len - 1] == '\n' || tail[len - 1] == '\r')) tail[--len] = '\0';
+    char* lastLine = strrchr(tail, '\n');
+    lastLine = lastLine ? lastLine + 1 : tail;
+
+    EnvironmentData record;
+    return parseCsvLine(lastLine, record) ? record.seq : 0;
+}
+
+// Parses "seq,timestamp,datetime,decibels,humidity,temperature,lux[,flags]". Returns false
+// for the header or malformed lines. Lines written before the flags column read as flags 0.
+bool DataManager::parseCsvLine(const char* line, EnvironmentData& record) {
+    char* end = nullptr;
+    unsigned long seq = strtoul(line, &end, 10);
+    if (end == line || *end != ',' || seq == 0) return false;
+    record.seq = (uint32_t)seq;
+
+    record.timestamp = (time_t)strtoll(end + 1, &end, 10);
+    if (*end != ',') return false;
+
+    const char* field = strchr(end + 1, ','); // Skip formatted datetime
+    if (!field) return false;
+    record.decibels = strtof(field + 1, &end);
+    if (*end != ',') return false;
+    record.humidity = strtof(end + 1, &end);
+    if (*end != ',') return false;
+    record.temperature = strtof(end + 1, &end);
+    if (*end != ',') return false;
+    record.lux = strtof(end + 1, &end);
+    record.flags = (*end == ',') ? (uint8_t)strtoul(end + 1, nullptr, 10) : 0;
+    return true;
+}
+
+static bool seqAtOrBefore(const EnvironmentData& record, uint32_t seq) {
+    return record.seq <= seq;
+}
+
+// Lines stamped before the first NTP sync carry seconds since boot; they are never
+// "before" a wall-clock time, which keeps the search conservative around them.
+static bool syncedBefore(const EnvironmentData& record, uint32_t timestamp) {
+    return !(record.flags & EnvironmentData::FLAG_TIME_UNSYNCED) && (uint32_t)record.timestamp < timestamp;
+}
+
+// Binary search over the log for a line start such that the lines before it satisfy
+// isBefore(line, key). Only needs the predicate to be monotonic over the file.
+size_t DataManager::findLineOffsetInternal(File& file, size_t fileSize,
+                                           bool (*isBefore)(const EnvironmentData&, uint32_t), uint32_t key) {
+    uint8_t chunk[128];
+    char line[128];
+    size_t lo = 0, hi = fileSize;
+    while (hi - lo > 512) {
+        size_t mid = lo + (hi - lo) / 2;
+        file.seek(mid);
+        int got = file.read(chunk, sizeof(chunk));
+        uint8_t* nl = (got > 0) ? (uint8_t*)memchr(chunk, '\n', got) : nullptr;
+        if (!nl) { hi = mid; continue; }
+        size_t lineStart = mid + (nl - chunk) + 1;
+        size_t avail = got - (nl - chunk) - 1;
+        size_t copyLen = min(avail, sizeof(line) - 1);
+        memcpy(line, nl + 1, copyLen);
+        line[copyLen] = '\0';
+        EnvironmentData probe;
+        if (parseCsvLine(line, probe) && isBefore(probe, key)) {
+            lo = lineStart;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+size_t DataManager::readSdRecordsInternal(SyncCursor& cursor, EnvironmentData* out, size_t maxRecords) {
+    File file = SD_MMC.open(DATA_FILE_PATH, FILE_READ);
+    if (!file) {
+        cursor.phase = SyncCursor::PHASE_RAM;
+        return 0;
+    }
+    size_t fileSize = file.size();
+    uint8_t chunk[512];
+    char line[128];
+
+    // First call: binary search for the first line with seq > lastSeq (the log is
+    // appended in seq order), so resuming a sync does not re-read the whole file.
+    if (cursor.fileOffset == 0) {
+        cursor.fileOffset = findLineOffsetInternal(file, fileSize, seqAtOrBefore, cursor.lastSeq);
+    }
+
+    size_t n = 0;
+    const int MAX_CHUNKS_PER_CALL = 16; // Bound the time spent per call
+    for (int c = 0; c < MAX_CHUNKS_PER_CALL && n < maxRecords; ++c) {
+        if (cursor.fileOffset >= fileSize || !file.seek(cursor.fileOffset)) {
+            cursor.phase = SyncCursor::PHASE_RAM;
+            break;
+        }
+        int got = file.read(chunk, sizeof(chunk));
+        if (got <= 0) {
+            cursor.phase = SyncCursor::PHASE_RAM;
+            break;
+        }
+
+        size_t pos = 0;
+        while (pos < (size_t)got && n < maxRecords) {
+            uint8_t* nl = (uint8_t*)memchr(chunk + pos, '\n', got - pos);
+            if (!nl) break; // Incomplete line, re-read it from its start next time
+            size_t lineLen = nl - (chunk + pos);
+            size_t copyLen = min(lineLen, sizeof(line) - 1);
+            memcpy(line, chunk + pos, copyLen);
+            line[copyLen] = '\0';
+
+            EnvironmentData record;
+            if (parseCsvLine(line, record) && record.seq > cursor.lastSeq) {
+                out[n++] = record;
+                cursor.lastSeq = record.seq;
+            }
+            pos += lineLen + 1;
+        }
+
+        if (pos == 0) {
+            // No line break in a whole chunk: a partial line at EOF, or a corrupt line to skip
+            if (cursor.fileOffset + got >= fileSize) {
+                cursor.phase = SyncCursor::PHASE_RAM;
+                break;
+            }
+            pos = got;
+        }
+        cursor.fileOffset += pos;
+    }
+    file.close();
+    return n;
+}
+
+size_t DataManager::readRamRecordsInternal(SyncCursor& cursor, EnvironmentData* out, size_t maxRecords) {
+    if (latestIndex_ < 0) return 0;
+
+    // dataIndex restarts at 0 after every SD save, so physical slot order is not seq
+    // order. Walk back from the newest record while seq keeps falling and is still
+    // newer than the cursor; that run, read forwards, is in ascending seq order.
+    int run = 0;
+    uint32_t prevSeq = UINT32_MAX;
+    for (int idx = latestIndex_; run < DATA_BUFFER_MINUTES; idx = (idx + DATA_BUFFER_MINUTES - 1) % DATA_BUFFER_MINUTES) {
+        uint32_t seq = envData[idx].seq;
+        if (seq == 0 || seq >= prevSeq || seq <= cursor.lastSeq) break;
+        prevSeq = seq;
+        run++;
+    }
+
+    int start = (latestIndex_ - run + 1 + DATA_BUFFER_MINUTES) % DATA_BUFFER_MINUTES;
+    size_t n = 0;
+    for (int i = 0; i < run && n < maxRecords; ++i) {
+        const EnvironmentData& record = envData[(start + i) % DATA_BUFFER_MINUTES];
+        out[n++] = record;
+        cursor.lastSeq = record.seq;
+    }
+    return n;
+}
+
+
+// --- Hourly Rollups ---
+
+static uint32_t floorHour(time_t t) {
+    return (uint32_t)t - (uint32_t)t % SECONDS_PER_HOUR;
+}
+
+static uint32_t ceilHour(time_t t) {
+    uint32_t h = floorHour(t);
+    return (h == (uint32_t)t) ? h : h + SECONDS_PER_HOUR;
+}
+
+void DataManager::initRollupsInternal() {
+    rollupCursor_ = SyncCursor(0);
+    rollupHourEnd_ = 0;
+    openRollupValid_ = false;
+    if (!sdCardOk_) return;
+
+    File file = SD_MMC.open(ROLLUP_FILE_PATH, FILE_READ);
+    if (!file) {
+        Serial.println("[DataManager] No rollup file yet, building it from the log.");
+        return;
+    }
+    size_t fileSize = file.size();
+    if (fileSize % HourRollup::RECORD_SIZE != 0) {
+        // Torn append (power loss): move it aside and rebuild from the log
+        file.close();
+        SD_MMC.remove("/rollup_1h.bad");
+        SD_MMC.rename(ROLLUP_FILE_PATH, "/rollup_1h.bad");
+        Serial.println("[DataManager] WARN: Rollup file damaged, rebuilding it from the log.");
+        return;
+    }
+    if (fileSize > 0) {
+        uint8_t buf[HourRollup::RECORD_SIZE];
+        HourRollup last;
+        file.seek(fileSize - HourRollup::RECORD_SIZE);
+        if (file.read(buf, sizeof(buf)) == (int)sizeof(buf)) {
+            last.decode(buf);
+            rollupHourEnd_ = last.hourStart + SECONDS_PER_HOUR;
+            rollupCursor_ = SyncCursor(last.lastSeq);
+        }
+    }
+    file.close();
+    Serial.printf("[DataManager] %u hourly rollups, resuming after seq %lu\n",
+                  (unsigned)(fileSize / HourRollup::RECORD_SIZE), (unsigned long)rollupCursor_.lastSeq);
+}
+
+// Consumes a small batch of newly flushed log records per call. An hour is finalised
+// (appended to the rollup file) when the first record of a later hour arrives.
+void DataManager::updateRollupsInternal() {
+    if (!sdCardOk_ || rollupCursor_.lastSeq >= lastFlushedSeq_) return;
+    if (xSemaphoreTake(queryMutex_, 0) != pdTRUE) return; // A query is running; catch up later
+
+    EnvironmentData batch[ROLLUP_BATCH];
+    rollupCursor_.phase = SyncCursor::PHASE_SD; // Only flushed records are rolled up
+    size_t n = readSdRecordsInternal(rollupCursor_, batch, ROLLUP_BATCH);
+    if (n == 0 && rollupCursor_.phase != SyncCursor::PHASE_SD) {
+        rollupCursor_.lastSeq = lastFlushedSeq_; // Nothing readable up to the flushed seq
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        const EnvironmentData& record = batch[i];
+        if (record.flags & EnvironmentData::FLAG_TIME_UNSYNCED) continue; // No wall-clock hour
+        uint32_t hour = floorHour(record.timestamp);
+        if (hour < rollupHourEnd_ || (openRollupValid_ && hour < openRollup_.hourStart)) {
+            lateRecords_++; // Hour already finalised; still visible to raw scans
+            continue;
+        }
+        if (openRollupValid_ && hour != openRollup_.hourStart) {
+            appendRollupInternal(openRollup_);
+            openRollupValid_ = false;
+        }
+        if (!openRollupValid_) {
+            openRollup_.reset(hour);
+            openRollupValid_ = true;
+        }
+        openRollup_.add(record);
+    }
+    xSemaphoreGive(queryMutex_);
+}
+
+bool DataManager::appendRollupInternal(const HourRollup& rollup) {
+    uint8_t buf[HourRollup::RECORD_SIZE];
+    rollup.encode(buf);
+    File file = SD_MMC.open(ROLLUP_FILE_PATH, FILE_APPEND);
+    if (!file) {
+        Serial.println("[DataManager] ERR: Failed to open rollup file for appending.");
+        return false;
+    }
+    bool ok = file.write(buf, sizeof(buf)) == sizeof(buf);
+    file.close();
+    // Advance even on a write error: the hour is gone from RAM and raw scans still cover it
+    rollupHourEnd_ = rollup.hourStart + SECONDS_PER_HOUR;
+    return ok;
+}
+
+// Merges the rollups with hourStart in [hour0, hour1) into acc. The file holds fixed-size
+// records in hourStart order, so the first one is found by binary search.
+uint32_t DataManager::mergeRollupsInternal(File& rollups, uint32_t hour0, uint32_t hour1, HourRollup& acc) {
+    uint8_t buf[HourRollup::RECORD_SIZE];
+    HourRollup rollup;
+    size_t lo = 0, hi = rollups.size() / HourRollup::RECORD_SIZE;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        rollups.seek(mid * HourRollup::RECORD_SIZE);
+        if (rollups.read(buf, sizeof(buf)) != (int)sizeof(buf)) return 0;
+        rollup.decode(buf);
+        if (rollup.hourStart < hour0) lo = mid + 1; else hi = mid;
+    }
+
+    uint32_t merged = 0;
+    rollups.seek(lo * HourRollup::RECORD_SIZE);
+    while (rollups.read(buf, sizeof(buf)) == (int)sizeof(buf)) {
+        rollup.decode(buf);
+        if (rollup.hourStart >= hour1) break;
+        for (int f = 0; f < QUERY_FIELD_COUNT; ++f) {
+            acc.fields[f].merge(rollup.fields[f]);
+        }
+        merged++;
+    }
+    return merged;
+}
+
+// Visits the records with a wall-clock timestamp in [t0, t1): flushed ones from the
+// SD log (seq <= flushedSeq), then the rest from the RAM snapshot taken when the query
+// started. Returns the number of log lines parsed, which stops at maxRecords.
+size_t DataManager::scanRawRangeInternal(time_t t0, time_t t1, uint32_t flushedSeq, size_t maxRecords,
+                                         RecordVisitorFn fn, void* context) {
+    size_t parsed = 0;
+    if (sdCardOk_) {
+        File file = SD_MMC.open(DATA_FILE_PATH, FILE_READ);
+        if (file) {
+            size_t fileSize = file.size();
+            size_t offset = findLineOffsetInternal(file, fileSize, syncedBefore, (uint32_t)t0);
+            uint8_t chunk[512];
+            char line[128];
+            bool done = false;
+            while (!done && offset < fileSize && parsed < maxRecords && file.seek(offset)) {
+                int got = file.read(chunk, sizeof(chunk));
+                if (got <= 0) break;
+                size_t pos = 0;
+                while (pos < (size_t)got) {
+                    uint8_t* nl = (uint8_t*)memchr(chunk + pos, '\n', got - pos);
+                    if (!nl) break;
+                    size_t lineLen = nl - (chunk + pos);
+                    size_t copyLen = min(lineLen, sizeof(line) - 1);
+                    memcpy(line, chunk + pos, copyLen);
+                    line[copyLen] = '\0';
+                    pos += lineLen + 1;
+
+                    EnvironmentData record;
+                    if (!parseCsvLine(line, record)) continue;
+                    if (record.seq > flushedSeq || ++parsed >= maxRecords) { done = true; break; }
+                    if (record.flags & EnvironmentData::FLAG_TIME_UNSYNCED) continue;
+                    if (record.timestamp >= t1) { done = true; break; }
+                    if (record.timestamp >= t0) fn(record, context);
+                }
+                if (pos == 0) break; // No complete line left
+                offset += pos;
+            }
+            file.close();
+        }
+    }
+
+    for (size_t i = 0; i < ramSnapshotCount_; ++i) {
+        const EnvironmentData& record = ramSnapshot_[i];
+        if (record.timestamp >= t0 && record.timestamp < t1) fn(record, context);
+    }
+    return parsed;
+}
+
+// Copies the unflushed RAM records (seq > flushedSeq) with a wall-clock timestamp in
+// [t0, t1) into ramSnapshot_. Called with queryMutex_ held, so no SD save re-stamps or
+// flushes the ring meanwhile; new records may still land in it (copied slot by slot).
+size_t DataManager::snapshotRamInternal(time_t t0, time_t t1, uint32_t flushedSeq) {
+    ramSnapshotCount_ = 0;
+    if (ramSnapshot_ == nullptr) return 0;
+    for (int i = 0; i < DATA_BUFFER_MINUTES; ++i) {
+        EnvironmentData record;
+        portENTER_CRITICAL(&ringMux_);
+        record = envData[i];
+        portEXIT_CRITICAL(&ringMux_);
+        if (record.seq <= flushedSeq || (record.flags & EnvironmentData::FLAG_TIME_UNSYNCED)) continue;
+        if (record.timestamp >= t0 && record.timestamp < t1) {
+            ramSnapshot_[ramSnapshotCount_++] = record;
+        }
+    }
+    return ramSnapshotCount_;
+}
+
+// --- Aggregation Queries ---
+
+struct QueryBucketContext {
+    HourRollup* acc;
+    PercentileHistogram* hist; // QUERY_FIELD_COUNT entries
+    bool histActive[QUERY_FIELD_COUNT];
+};
+
+static void accumulateQueryRecord(const EnvironmentData& record, void* context) {
+    QueryBucketContext* ctx = (QueryBucketContext*)context;
+    ctx->acc->add(record);
+    for (int f = 0; f < QUERY_FIELD_COUNT; ++f) {
+        if (ctx->histActive[f]) ctx->hist[f].add(queryFieldValue(record, (QueryField)f));
+    }
+}
+
+// Value of one result cell: the count for QUERY_AGG_COUNT, otherwise NAN when there is no data
+static double queryCellValue(const QueryColumn& column, const FieldStats& stats, const PercentileHistogram& hist) {
+    if (column.agg == QUERY_AGG_COUNT) {
+        return stats.count;
+    }
+    if (stats.count == 0) {
+        return NAN;
+    }
+    switch (column.agg) {
+        case QUERY_AGG_AVG:        return (float)(stats.sum / stats.count); // Same rounding as the float fields
+        case QUERY_AGG_MIN:        return stats.min;
+        case QUERY_AGG_MAX:        return stats.max;
+        case QUERY_AGG_LEQ:        return (float)(10.0 * log10(stats.energy / stats.count));
+        case QUERY_AGG_PERCENTILE: return hist.percentile(column.percentile);
+        default:                   return NAN;
+    }
+}
+
+// Runs in the query task. queryMutex_ is held only while the rollups, the raw log and the
+// RAM snapshot are reduced into queryCells_ (the raw scan limit bounds how long SD saves and
+// rollup updates are deferred); the JSON is formatted after the lock is released.
+// json is left open (no closing brace) so that the caller can add "cached", and it is
+// cached in that form: cached tells whether it came from queryCache_.
+bool DataManager::runQueryInternal(QuerySpec& query, String& json, bool& cached, char* err, size_t errLen) {
+    cached = false;
+    // Ranges that end before the newest finalised hour can no longer change. rollupHourEnd_
+    // only grows, so reading it without the lock at worst skips the cache once.
+    char key[QueryResultCache::MAX_KEY];
+    bool cacheable = query.to <= (time_t)rollupHourEnd_ && query.canonical(key, sizeof(key)) > 0;
+    if (cacheable && queryCache_.get(key, json)) {
+        systemMetrics.queryCacheHits.inc();
+        cached = true;
+        return true;
+    }
+
+    uint32_t startUs = micros();
+    PercentileHistogram hist[QUERY_FIELD_COUNT];
+    HourRollup acc;
+    QueryBucketContext ctx;
+    ctx.acc = &acc;
+    ctx.hist = hist;
+    for (int f = 0; f < QUERY_FIELD_COUNT; ++f) {
+        ctx.histActive[f] = query.fieldHasPercentile((QueryField)f);
+        if (ctx.histActive[f] && !hist[f].begin((QueryField)f)) {
+            snprintf(err, errLen, "OUT_OF_MEMORY");
+            return false;
+        }
+    }
+    uint32_t buckets = query.bucketCount();
+
+    if (xSemaphoreTake(queryMutex_, portMAX_DELAY) != pdTRUE) {
+        snprintf(err, errLen, "BUSY");
+        return false;
+    }
+    File rollups;
+    if (sdCardOk_ && !query.needsRawSamples()) {
+        rollups = SD_MMC.open(ROLLUP_FILE_PATH, FILE_READ);
+    }
+    uint32_t flushedSeq = lastFlushedSeq_;
+    snapshotRamInternal(query.from, query.to, flushedSeq);
+    uint32_t rollupHours = 0;
+    size_t rawRecords = 0;
+
+    bool ok = true;
+    for (uint32_t b = 0; b < buckets && ok; ++b) {
+        time_t bStart = query.from + (time_t)b * query.bucketSeconds;
+        time_t bEnd = min(bStart + (time_t)query.bucketSeconds, query.to);
+        acc.reset((uint32_t)bStart);
+        for (int f = 0; f < QUERY_FIELD_COUNT; ++f) {
+            if (ctx.histActive[f]) hist[f].reset();
+        }
+
+        // Whole finalised hours come from the rollups, the rest from the raw log
+        uint32_t h0 = ceilHour(bStart);
+        uint32_t h1 = min(floorHour(bEnd), rollupHourEnd_);
+        if (rollups && h0 < h1) {
+            rollupHours += mergeRollupsInternal(rollups, h0, h1, acc);
+            if (bStart < (time_t)h0) {
+                rawRecords += scanRawRangeInternal(bStart, h0, flushedSeq, MAX_RAW_RECORDS_PER_QUERY - rawRecords,
+                                                   accumulateQueryRecord, &ctx);
+            }
+            if ((time_t)h1 < bEnd && rawRecords < MAX_RAW_RECORDS_PER_QUERY) {
+                rawRecords += scanRawRangeInternal(h1, bEnd, flushedSeq, MAX_RAW_RECORDS_PER_QUERY - rawRecords,
+                                                   accumulateQueryRecord, &ctx);
+            }
+        } else {
+            rawRecords += scanRawRangeInternal(bStart, bEnd, flushedSeq, MAX_RAW_RECORDS_PER_QUERY - rawRecords,
+                                               accumulateQueryRecord, &ctx);
+        }
+        if (rawRecords >= MAX_RAW_RECORDS_PER_QUERY) {
+            snprintf(err, errLen, "RANGE_TOO_LARGE: over %u raw records, use a shorter range or no percentiles",
+                     (unsigned)MAX_RAW_RECORDS_PER_QUERY);
+            ok = false;
+            break;
+        }
+
+        double* row = queryCells_ + (size_t)b * query.columnCount;
+        for (uint8_t c = 0; c < query.columnCount; ++c) {
+            const QueryColumn& column = query.columns[c];
+            row[c] = queryCellValue(column, acc.fields[column.field], hist[column.field]);
+        }
+    }
+    if (rollups) rollups.close();
+    xSemaphoreGive(queryMutex_);
+    if (!ok) {
+        return false;
+    }
+
+    char buf[48];
+    json = "";
+    json.reserve(96 + buckets * (12 + query.columnCount * 8));
+    snprintf(buf, sizeof(buf), "{\"from\":%lu,\"to\":%lu,\"bucket\":%lu,\"columns\":[",
+             (unsigned long)query.from, (unsigned long)query.to, (unsigned long)query.bucketSeconds);
+    json += buf;
+    for (uint8_t c = 0; c < query.columnCount; ++c) {
+        const QueryColumn& column = query.columns[c];
+        static const char* AGG_NAMES[] = {"avg", "min", "max", "count", "leq", "p"};
+        json += (c ? ",\"" : "\"");
+        json += queryFieldName(column.field);
+        json += "_";
+        json += AGG_NAMES[column.agg];
+        if (column.agg == QUERY_AGG_PERCENTILE) {
+            snprintf(buf, sizeof(buf), "%u", (unsigned)column.percentile);
+            json += buf;
+        }
+        json += "\"";
+    }
+    json += "],\"rows\":[";
+    for (uint32_t b = 0; b < buckets; ++b) {
+        snprintf(buf, sizeof(buf), "%s[%lu", b ? "," : "", (unsigned long)(query.from + (time_t)b * query.bucketSeconds));
+        json += buf;
+        const double* row = queryCells_ + (size_t)b * query.columnCount;
+        for (uint8_t c = 0; c < query.columnCount; ++c) {
+            double value = row[c];
+            if (query.columns[c].agg == QUERY_AGG_COUNT) {
+                snprintf(buf, sizeof(buf), ",%lu", (unsigned long)value);
+            } else if (isnan(value) || isinf(value)) {
+                strlcpy(buf, ",null", sizeof(buf));
+            } else {
+                snprintf(buf, sizeof(buf), ",%.2f", value);
+            }
+            json += buf;
+        }
+        json += "]";
+    }
+    snprintf(buf, sizeof(buf), "],\"rollupHours\":%lu,\"rawRecords\":%lu",
+             (unsigned long)rollupHours, (unsigned long)rawRecords);
+    json += buf;
+    if (cacheable) queryCache_.put(key, json);
+    systemMetrics.queryUs.observe(micros() - startUs);
+    return true;
+}
+
+// --- Query Task ---
+
+uint32_t DataManager::submitQuery(const QuerySpec& query) {
+    if (queryTask_ == nullptr) return 0;
+
+    QueryJob* job = nullptr;
+    portENTER_CRITICAL(&queryJobMux_);
+    for (size_t i = 0; i < MAX_QUERY_JOBS; ++i) {
+        if (queryJobs_[i].state == QUERY_JOB_FREE) {
+            job = &queryJobs_[i];
+            job->handle = (nextQueryTicket_++ << 4) | (uint32_t)i;
+            job->state = QUERY_JOB_CLAIMED;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&queryJobMux_);
+    if (job == nullptr) return 0;
+
+    job->spec = query;
+    job->cancelled = false;
+    job->ok = false;
+    job->err[0] = '\0';
+    portENTER_CRITICAL(&queryJobMux_);
+    job->state = QUERY_JOB_QUEUED;
+    portEXIT_CRITICAL(&queryJobMux_);
+    xTaskNotifyGive(queryTask_);
+    return job->handle;
+}
+
+DataManager::QueryJob* DataManager::findQueryJobInternal(uint32_t handle) {
+    size_t slot = handle & 0x0F;
+    if (handle == 0 || slot >= MAX_QUERY_JOBS || queryJobs_[slot].handle != handle) return nullptr;
+    return &queryJobs_[slot];
+}
+
+DataManager::QueryStatus DataManager::takeQueryResult(uint32_t handle, String& json, char* err, size_t errLen) {
+    QueryJob* job = findQueryJobInternal(handle);
+    bool done = false;
+    portENTER_CRITICAL(&queryJobMux_);
+    if (job && job->handle == handle && job->state == QUERY_JOB_DONE) {
+        job->state = QUERY_JOB_CLAIMED; // Ours until freed below
+        done = true;
+    }
+    portEXIT_CRITICAL(&queryJobMux_);
+    if (job == nullptr) {
+        snprintf(err, errLen, "UNKNOWN_QUERY");
+        return QUERY_FAILED;
+    }
+    if (!done) return QUERY_PENDING;
+
+    bool ok = job->ok;
+    json = std::move(job->json);
+    job->json = String();
+    snprintf(err, errLen, "%s", job->err);
+    portENTER_CRITICAL(&queryJobMux_);
+    job->state = QUERY_JOB_FREE;
+    portEXIT_CRITICAL(&queryJobMux_);
+    return ok ? QUERY_OK : QUERY_FAILED;
+}
+
+void DataManager::cancelQuery(uint32_t handle) {
+    QueryJob* job = findQueryJobInternal(handle);
+    if (job == nullptr) return;
+    bool dropResult = false;
+    portENTER_CRITICAL(&queryJobMux_);
+    if (job->handle == handle) {
+        switch (job->state) {
+            case QUERY_JOB_QUEUED:  job->state = QUERY_JOB_FREE; break;
+            case QUERY_JOB_RUNNING: job->cancelled = true; break; // The task frees it
+            case QUERY_JOB_DONE:    job->state = QUERY_JOB_CLAIMED; dropResult = true; break;
+            default: break;
+        }
+    }
+    portEXIT_CRITICAL(&queryJobMux_);
+    if (dropResult) {
+        job->json = String();
+        portENTER_CRITICAL(&queryJobMux_);
+        job->state = QUERY_JOB_FREE;
+        portEXIT_CRITICAL(&queryJobMux_);
+    }
+}
+
+void DataManager::queryTaskEntry(void* param) {
+    static_cast<DataManager*>(param)->queryTaskLoop();
+}
+
+void DataManager::queryTaskLoop() {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Oldest queued job first, until none is left
+        for (;;) {
+            QueryJob* job = nullptr;
+            portENTER_CRITICAL(&queryJobMux_);
+            for (size_t i = 0; i < MAX_QUERY_JOBS; ++i) {
+                QueryJob& candidate = queryJobs_[i];
+                if (candidate.state == QUERY_JOB_QUEUED && (job == nullptr || candidate.handle < job->handle)) {
+                    job = &candidate;
+                }
+            }
+            if (job) job->state = QUERY_JOB_RUNNING;
+            portEXIT_CRITICAL(&queryJobMux_);
+            if (job == nullptr) break;
+
+            HeapScope heapScope(HEAP_TAG_DATA);
+            QuerySpec spec = job->spec;
+            String json;
+            char err[sizeof(job->err)] = "";
+            bool cached = false;
+            bool ok = runQueryInternal(spec, json, cached, err, sizeof(err));
+            if (ok) {
+                json += cached ? ",\"cached\":true}" : ",\"cached\":false}";
+            }
+
+            job->ok = ok;
+            job->json = std::move(json);
+            memcpy(job->err, err, sizeof(err));
+            bool abandoned;
+            portENTER_CRITICAL(&queryJobMux_);
+            abandoned = job->cancelled;
+            if (!abandoned) job->state = QUERY_JOB_DONE;
+            portEXIT_CRITICAL(&queryJobMux_);
+            if (abandoned) {
+                job->json = String();
+                portENTER_CRITICAL(&queryJobMux_);
+                job->state = QUERY_JOB_FREE;
+                portEXIT_CRITICAL(&queryJobMux_);
+            }
+        }
+    }
 }
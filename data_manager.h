@@ -11,6 +11,23 @@
 #include "SD_MMC.h"
 #include "memory_utils.h"
 #include "ui_manager.h" // For checking time status
+#include "history_query.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+// Resumable position of an incremental "records newer than seq" read (SYNC).
+// Records are delivered from the SD log first, then from the RAM buffer.
+struct SyncCursor {
+    enum Phase : uint8_t { PHASE_SD, PHASE_RAM, PHASE_DONE };
+
+    uint32_t lastSeq;    // Highest seq already delivered to the reader
+    uint32_t fileOffset; // Next byte to parse in the SD log (0 = not positioned yet)
+    Phase phase;
+
+    SyncCursor() : lastSeq(0), fileOffset(0), phase(PHASE_SD) {}
+    explicit SyncCursor(uint32_t since) : lastSeq(since), fileOffset(0), phase(PHASE_SD) {}
+};
 
 class DataManager {
 public:
@@ -32,11 +49,80 @@ public:
     int getDataBufferSize() const;   // Get the total size of the buffer
     const EnvironmentData& getLatestData() const; // Helper to get the most recent valid entry
     bool isSdCardInitialized() const; // Getter for SD card status
+    uint32_t getLastSeq() const;      // Seq of the most recent record (0 if none yet)
+    uint32_t getLastFlushedSeq() const { return lastFlushedSeq_; } // Highest seq written to the SD log
+
+    // Reads up to maxRecords records with seq > cursor.lastSeq, in ascending seq order,
+    // and advances the cursor. Returns the number of records written to out;
+    // cursor.phase becomes PHASE_DONE once both SD and RAM are exhausted.
+    size_t readRecordsSince(SyncCursor& cursor, EnvironmentData* out, size_t maxRecords);
+
+    // Aggregation queries (see history_query.h) run in the "query" task, so neither the main
+    // loop (TCP QUERY) nor async_tcp (HTTP /query) waits for SD scans. submitQuery() returns
+    // a job handle (0 = all job slots busy); poll it with takeQueryResult() until it stops
+    // returning QUERY_PENDING, which also frees the slot. cancelQuery() abandons a job whose
+    // requester went away (stale handles are ignored).
+    enum QueryStatus : uint8_t { QUERY_PENDING, QUERY_OK, QUERY_FAILED };
+    uint32_t submitQuery(const QuerySpec& query);
+    QueryStatus takeQueryResult(uint32_t handle, String& json, char* err, size_t errLen);
+    void cancelQuery(uint32_t handle);
 
 private:
     static const int DATA_BUFFER_MINUTES = 24 * 60; // 24 hours of data
     EnvironmentData envData[DATA_BUFFER_MINUTES];
     int dataIndex;
+    int latestIndex_;   // Index of the most recently written record (-1 = none)
+
+    // Record sequence numbers. Blocks of SEQ_RESERVE_BLOCK are reserved in NVS so
+    // seq stays monotonic across reboots without writing flash for every record.
+    uint32_t nextSeq_;
+    uint32_t seqReservedUntil_; // First seq NOT covered by the persisted reservation
+    static const uint32_t SEQ_RESERVE_BLOCK = 1000;
+    uint32_t lastFlushedSeq_;   // Highest seq already written to the SD log
+
+    // Hourly rollups, appended to the rollup file once an hour is complete. They are
+    // built incrementally from the SD log (rollupCursor_), so a reboot just resumes
+    // after the lastSeq of the newest rollup.
+    static const size_t ROLLUP_BATCH = 32;            // Log records consumed per update()
+    static const size_t MAX_RAW_RECORDS_PER_QUERY = 10000; // Log lines parsed per query (bounds how long it holds queryMutex_)
+    SyncCursor rollupCursor_;
+    HourRollup openRollup_;     // Hour currently being accumulated
+    bool openRollupValid_;
+    uint32_t rollupHourEnd_;    // End of the newest finalised hour; earlier hours are immutable
+    uint32_t lateRecords_;      // Log records older than the open hour (not rolled up)
+    SemaphoreHandle_t queryMutex_; // Serialises queries, rollup file access and SD log appends
+    QueryResultCache queryCache_;
+
+    // Query jobs: filled by submitQuery(), run one at a time by the query task
+    static const size_t MAX_QUERY_JOBS = 4;
+    static const uint32_t QUERY_TASK_STACK_SIZE = 8192;
+    enum QueryJobState : uint8_t {
+        QUERY_JOB_FREE,
+        QUERY_JOB_CLAIMED,  // Being filled in or emptied outside the lock
+        QUERY_JOB_QUEUED,
+        QUERY_JOB_RUNNING,
+        QUERY_JOB_DONE
+    };
+    struct QueryJob {
+        uint32_t handle;    // (ticket << 4) | slot, compared on every access
+        QueryJobState state;
+        bool cancelled;     // Requester gone while running; the task frees the slot
+        bool ok;
+        QuerySpec spec;
+        String json;
+        char err[96];
+    };
+    QueryJob queryJobs_[MAX_QUERY_JOBS];
+    uint32_t nextQueryTicket_;
+    portMUX_TYPE queryJobMux_;
+    TaskHandle_t queryTask_;
+
+    // Unflushed RAM records copied at the start of a query (the ring keeps being written
+    // by the main loop while the query runs). ringMux_ makes each slot copy consistent.
+    EnvironmentData* ramSnapshot_;
+    size_t ramSnapshotCount_;
+    double* queryCells_;      // buckets x columns values of the running query (QuerySpec::MAX_CELLS)
+    portMUX_TYPE ringMux_;
 
     I2SMicManager& micManager_;
     TempHumSensor& tempHumSensor_;
@@ -50,12 +136,39 @@ private:
 
     static const unsigned long SENSOR_READ_INTERVAL = 1000; // ms
     static const unsigned long SAVE_INTERVAL = 60000; // ms
+    static const int MAX_LEGACY_LOGS = 1000; // /env_data_legacyN.csv names tried for a pre-seq log
+    // Before the first NTP sync records are held in RAM (up to this long after boot)
+    // so they can be re-stamped with wall-clock time when they are flushed.
+    static const unsigned long UNSYNCED_HOLD_MS = 10UL * 60UL * 1000UL;
 
     // Internal helper methods
     bool initSDCardInternal();
     void createHeaderIfNeededInternal();
     void recordEnvironmentDataInternal();
-    void saveEnvironmentDataToSDInternal();
+    bool saveEnvironmentDataToSDInternal(); // false if deferred because a query holds the log
+    void resolvePendingTimestampsInternal();
+    void initSequenceInternal();
+    uint32_t allocateSeqInternal();
+    uint32_t readLastSeqFromSdInternal();
+    size_t readSdRecordsInternal(SyncCursor& cursor, EnvironmentData* out, size_t maxRecords);
+    size_t readRamRecordsInternal(SyncCursor& cursor, EnvironmentData* out, size_t maxRecords);
+    static bool parseCsvLine(const char* line, EnvironmentData& record);
+
+    // Rollups and queries
+    typedef void (*RecordVisitorFn)(const EnvironmentData& record, void* context);
+    void initRollupsInternal();
+    void updateRollupsInternal();
+    bool appendRollupInternal(const HourRollup& rollup);
+    uint32_t mergeRollupsInternal(File& rollups, uint32_t hour0, uint32_t hour1, HourRollup& acc);
+    size_t scanRawRangeInternal(time_t t0, time_t t1, uint32_t flushedSeq, size_t maxRecords,
+                                RecordVisitorFn fn, void* context);
+    size_t snapshotRamInternal(time_t t0, time_t t1, uint32_t flushedSeq);
+    bool runQueryInternal(QuerySpec& query, String& json, bool& cached, char* err, size_t errLen);
+    QueryJob* findQueryJobInternal(uint32_t handle);
+    static void queryTaskEntry(void* param);
+    void queryTaskLoop();
+    static size_t findLineOffsetInternal(File& file, size_t fileSize,
+                                         bool (*isBefore)(const EnvironmentData&, uint32_t), uint32_t key);
 };
 
 #endif // DATA_MANAGER_H 
\ No newline at end of file
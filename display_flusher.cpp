@@ -0,0 +1,238 @@
+#include "display_flusher.h"
+#include "ui_widgets.h"
+#include "metrics.h"
+#include "heap_tracker.h"
+#include "glyph_cache.h"
+#include <esp_heap_caps.h>
+
+DisplayFlusher::DisplayFlusher(TFT_eSPI& tft) :
+    tft_(tft),
+    width_(0),
+    height_(0),
+    buffers_{nullptr, nullptr},
+    bounce_{nullptr, nullptr},
+    dmaReady_(false),
+    task_(nullptr),
+    back_(0),
+    dirtySinceSubmit_(false),
+    framePending_(false),
+    pendingSinceUs_(0),
+    front_(1),
+    frontSubmitUs_(0),
+    busy_(false)
+{
+    backDamage_.bands = 0;
+    frontDamage_.bands = 0;
+}
+
+bool DisplayFlusher::begin() {
+    if (task_) {
+        return true;
+    }
+    HeapScope heapScope(HEAP_TAG_UI);
+    width_ = tft_.width();
+    height_ = tft_.height();
+    if (height_ > BAND_ROWS * MAX_BANDS) {
+        Serial.println("[DisplayFlusher] Screen taller than the damage map, drawing directly");
+        return false;
+    }
+
+    // 16-bit full-screen sprites (~150 KB each); TFT_eSprite puts them in PSRAM when present
+    for (int i = 0; i < 2; i++) {
+        buffers_[i] = new TFT_eSprite(&tft_);
+        buffers_[i]->setColorDepth(16);
+        if (!buffers_[i]->createSprite(width_, height_)) {
+            Serial.println("[DisplayFlusher] Back buffers unavailable, drawing directly");
+            releaseBuffers();
+            return false;
+        }
+        buffers_[i]->fillSprite(TFT_BLACK);
+        GlyphCache::instance().addSprite(buffers_[i]); // Readouts blit into the buffer, not the panel
+    }
+    size_t bounceBytes = (size_t)width_ * BAND_ROWS * sizeof(uint16_t);
+    for (int i = 0; i < 2; i++) {
+        bounce_[i] = (uint16_t*)heapAlloc(HEAP_TAG_UI, bounceBytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        if (!bounce_[i]) {
+            Serial.println("[DisplayFlusher] No DMA memory for bounce buffers, drawing directly");
+            releaseBuffers();
+            return false;
+        }
+    }
+    dmaReady_ = tft_.initDMA();
+
+    back_ = 0;
+    front_ = 1;
+    backDamage_.bands = 0;
+    dirtySinceSubmit_ = false;
+    framePending_ = false;
+    busy_.store(false);
+    // Core 0 below the capture task: flushing only ever waits for the SPI DMA
+    if (xTaskCreatePinnedToCore(taskEntry, "display_flush", TASK_STACK_SIZE, this, TASK_PRIORITY, &task_, TASK_CORE) != pdPASS) {
+        task_ = nullptr;
+        Serial.println("[DisplayFlusher] Failed to create flush task, drawing directly");
+        releaseBuffers();
+        return false;
+    }
+    Serial.printf("[DisplayFlusher] Started (%dx%d, %s)\n", width_, height_, dmaReady_ ? "DMA" : "blocking");
+    return true;
+}
+
+void DisplayFlusher::end() {
+    if (!task_) {
+        return;
+    }
+    // Put the last frame on the panel, then stop while the task is idle
+    while (busy_.load(std::memory_order_acquire)) {
+        vTaskDelay(1);
+    }
+    if (framePending_) {
+        handOver();
+        while (busy_.load(std::memory_order_acquire)) {
+            vTaskDelay(1);
+        }
+    }
+    vTaskDelete(task_);
+    task_ = nullptr;
+    releaseBuffers();
+}
+
+void DisplayFlusher::markDirty(int32_t x, int32_t y, int32_t w, int32_t h) {
+    // Clip to the screen
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    w = min(w, (int32_t)width_ - x);
+    h = min(h, (int32_t)height_ - y);
+    if (w <= 0 || h <= 0) return;
+
+    int16_t x0 = (int16_t)x;
+    int16_t x1 = (int16_t)(x + w);
+    for (int b = y / BAND_ROWS; b <= (y + h - 1) / BAND_ROWS; b++) {
+        uint32_t bit = 1UL << b;
+        if (backDamage_.bands & bit) {
+            backDamage_.x0[b] = min(backDamage_.x0[b], x0);
+            backDamage_.x1[b] = max(backDamage_.x1[b], x1);
+        } else {
+            backDamage_.bands |= bit;
+            backDamage_.x0[b] = x0;
+            backDamage_.x1[b] = x1;
+        }
+    }
+    dirtySinceSubmit_ = true;
+}
+
+void DisplayFlusher::markAll() {
+    markDirty(0, 0, width_, height_);
+}
+
+void DisplayFlusher::submit() {
+    if (!task_) return;
+    if (dirtySinceSubmit_) {
+        dirtySinceSubmit_ = false;
+        if (framePending_) {
+            // The task has not taken the previous frame yet: it is shown merged with this one
+            systemMetrics.displayFramesDropped.inc();
+        } else {
+            framePending_ = true;
+            pendingSinceUs_ = micros();
+        }
+    }
+    if (framePending_ && !busy_.load(std::memory_order_acquire)) {
+        handOver();
+    }
+}
+
+void DisplayFlusher::handOver() {
+    front_ = back_;
+    frontDamage_ = backDamage_;
+    frontSubmitUs_ = pendingSinceUs_;
+    framePending_ = false;
+    busy_.store(true, std::memory_order_release);
+    xTaskNotifyGive(task_);
+
+    // The other buffer is one frame behind: bring the changed areas over while the task
+    // pushes them (both only read the front buffer)
+    back_ ^= 1;
+    copyDamage((const uint16_t*)buffers_[front_]->getPointer(),
+               (uint16_t*)buffers_[back_]->getPointer(), frontDamage_);
+    backDamage_.bands = 0;
+}
+
+void DisplayFlusher::copyDamage(const uint16_t* src, uint16_t* dst, const Damage& damage) const {
+    for (int b = 0; b < MAX_BANDS; b++) {
+        if (!(damage.bands & (1UL << b))) continue;
+        int y = b * BAND_ROWS;
+        int rows = min((int)BAND_ROWS, height_ - y);
+        int x0 = damage.x0[b];
+        size_t bytes = (size_t)(damage.x1[b] - x0) * sizeof(uint16_t);
+        for (int r = y; r < y + rows; r++) {
+            size_t offset = (size_t)r * width_ + x0;
+            memcpy(dst + offset, src + offset, bytes);
+        }
+    }
+}
+
+void DisplayFlusher::taskEntry(void* param) {
+    static_cast<DisplayFlusher*>(param)->taskLoop();
+}
+
+void DisplayFlusher::taskLoop() {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        flushFront();
+        busy_.store(false, std::memory_order_release);
+    }
+}
+
+void DisplayFlusher::flushFront() {
+    const uint16_t* src = (const uint16_t*)buffers_[front_]->getPointer();
+    uint32_t bytes = 0;
+    uint8_t bounceIndex = 0;
+
+    tft_.setSwapBytes(false); // Sprite pixels are already in panel byte order
+    tft_.startWrite();
+    for (int b = 0; b < MAX_BANDS; b++) {
+        if (!(frontDamage_.bands & (1UL << b))) continue;
+        int y = b * BAND_ROWS;
+        int rows = min((int)BAND_ROWS, height_ - y);
+        int x0 = frontDamage_.x0[b];
+        int w = frontDamage_.x1[b] - x0;
+
+        // Gather the band's changed columns into one contiguous block. The transfer from
+        // the other bounce buffer may still be running; pushImageDMA waits for it before
+        // queueing this one.
+        uint16_t* block = bounce_[bounceIndex];
+        for (int r = 0; r < rows; r++) {
+            memcpy(block + r * w, src + (size_t)(y + r) * width_ + x0, w * sizeof(uint16_t));
+        }
+        if (dmaReady_) {
+            tft_.pushImageDMA(x0, y, w, rows, block);
+            bounceIndex ^= 1;
+        } else {
+            tft_.pushImage(x0, y, w, rows, block);
+        }
+        bytes += (uint32_t)w * rows * 2 + ValueField::WINDOW_OVERHEAD_BYTES;
+    }
+    if (dmaReady_) {
+        tft_.dmaWait(); // The frame is on the panel when this returns
+    }
+    tft_.endWrite();
+
+    systemMetrics.displaySpiBytes.inc(bytes);
+    systemMetrics.displayFramesFlushed.inc();
+    systemMetrics.displayFlushLatencyUs.observe(micros() - frontSubmitUs_);
+}
+
+void DisplayFlusher::releaseBuffers() {
+    for (int i = 0; i < 2; i++) {
+        if (buffers_[i]) {
+            GlyphCache::instance().removeSprite(buffers_[i]);
+            buffers_[i]->deleteSprite();
+            delete buffers_[i];
+            buffers_[i] = nullptr;
+        }
+        if (bounce_[i]) {
+            heapFree(bounce_[i]);
+            bounce_[i] = nullptr;
+        }
+    }
+}
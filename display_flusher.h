@@ -0,0 +1,89 @@
+#ifndef DISPLAY_FLUSHER_H
+#define DISPLAY_FLUSHER_H
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <atomic>
+
+/**
+ * 异步屏幕刷新 (Double-buffered display flush task)
+ *
+ * 两个全屏 16 位 sprite (PSRAM) 轮流作为后台缓冲: 主循环只在后台缓冲上绘制并记录
+ * 变化区域 (按 BAND_ROWS 行分段, 每段记录变化的列范围), submit() 提交一帧;
+ * 刷新任务把这些区域经内部 RAM 的两个 DMA 中转缓冲区用 pushImageDMA 推送到屏幕,
+ * 主循环不等待 SPI。
+ *
+ * 交接: 刷新任务空闲时, 后台缓冲变为前台交给任务, 另一个缓冲成为新的后台缓冲,
+ * 并从刚交出的缓冲复制这一帧变化的区域, 两个缓冲因此始终保持同一画面 (局部刷新的前提)。
+ * 任务仍在推送上一帧时提交的帧不会等待, 而是和之后的绘制合并为一帧, 计为丢帧;
+ * 延迟为从提交到该帧推送完成的时间。
+ *
+ * begin() 成功后 TFT 只能由刷新任务访问; 直接绘制屏幕前 (关机画面) 先调用 end()。
+ */
+class DisplayFlusher {
+public:
+    static const int BAND_ROWS = 10;   // Damage granularity and rows per DMA transfer
+    static const int MAX_BANDS = 32;   // 320 rows
+
+    explicit DisplayFlusher(TFT_eSPI& tft);
+
+    // Allocates the buffers and starts the task. False: keep drawing to the TFT directly.
+    bool begin();
+    // Waits for the current flush and stops the task; the TFT may be used directly again.
+    void end();
+    bool isActive() const { return task_ != nullptr; }
+
+    // Render target for the main loop. Changes after each handover.
+    TFT_eSprite& backBuffer() { return *buffers_[back_]; }
+
+    // Records a changed area of the back buffer (clipped to the screen)
+    void markDirty(int32_t x, int32_t y, int32_t w, int32_t h);
+    void markAll();
+
+    // Ends a frame. Hands it to the task now if it is idle, otherwise at a later
+    // submit(); a frame still waiting when the next one ends is merged into it (dropped).
+    void submit();
+
+private:
+    struct Damage {
+        uint32_t bands;            // Bit per band
+        int16_t x0[MAX_BANDS];     // Column range [x0, x1) per band
+        int16_t x1[MAX_BANDS];
+    };
+
+    static const uint32_t TASK_STACK_SIZE = 3072;
+    static const UBaseType_t TASK_PRIORITY = 1;
+    static const BaseType_t TASK_CORE = 0;
+
+    TFT_eSPI& tft_;
+    int width_;
+    int height_;
+    TFT_eSprite* buffers_[2];
+    uint16_t* bounce_[2];          // Internal DMA-capable memory; PSRAM cannot feed SPI DMA
+    bool dmaReady_;
+    TaskHandle_t task_;
+
+    // Main loop side
+    uint8_t back_;
+    Damage backDamage_;            // Changes in the back buffer since the last handover
+    bool dirtySinceSubmit_;
+    bool framePending_;            // Submitted, not yet handed over
+    uint32_t pendingSinceUs_;      // Submit time of the oldest merged frame
+
+    // Handed to the task; written by the main loop only while busy_ is false
+    uint8_t front_;
+    Damage frontDamage_;
+    uint32_t frontSubmitUs_;
+    std::atomic<bool> busy_;
+
+    void handOver();
+    void copyDamage(const uint16_t* src, uint16_t* dst, const Damage& damage) const;
+    static void taskEntry(void* param);
+    void taskLoop();
+    void flushFront();
+    void releaseBuffers();
+};
+
+#endif // DISPLAY_FLUSHER_H
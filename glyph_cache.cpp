@@ -0,0 +1,166 @@
+#include "glyph_cache.h"
+#include "memory_utils.h"
+#include "heap_tracker.h"
+#include <esp_heap_caps.h>
+
+// Everything a numeric readout can contain (formatValue, "---", padded values)
+const char GlyphCache::GLYPHS[] = "0123456789.- ";
+
+GlyphCache& GlyphCache::instance() {
+    static GlyphCache cache;
+    return cache;
+}
+
+GlyphCache::GlyphCache() :
+    setCount_(0),
+    warnedFull_(false),
+    panel_(nullptr),
+    sprites_{}
+{}
+
+void GlyphCache::addSprite(TFT_eSprite* sprite) {
+    for (uint8_t i = 0; i < MAX_SPRITES; i++) {
+        if (sprites_[i] == sprite) return;
+    }
+    for (uint8_t i = 0; i < MAX_SPRITES; i++) {
+        if (sprites_[i] == nullptr) {
+            sprites_[i] = sprite;
+            return;
+        }
+    }
+    // Not fatal: drawText() falls back to drawString() for this target
+    Serial.println("[GlyphCache] WARN: Too many sprite targets, extra ones draw text directly");
+}
+
+void GlyphCache::removeSprite(TFT_eSprite* sprite) {
+    for (uint8_t i = 0; i < MAX_SPRITES; i++) {
+        if (sprites_[i] == sprite) {
+            sprites_[i] = nullptr;
+        }
+    }
+}
+
+bool GlyphCache::covers(const char* text) {
+    for (const char* p = text; *p; p++) {
+        if (strchr(GLYPHS, *p) == nullptr) return false;
+    }
+    return true;
+}
+
+size_t GlyphCache::bytesUsed() const {
+    size_t bytes = 0;
+    for (uint8_t i = 0; i < setCount_; i++) {
+        bytes += cellPixels(sets_[i].size) * GLYPH_COUNT * sizeof(uint16_t);
+    }
+    return bytes;
+}
+
+bool GlyphCache::drawText(TFT_eSPI& tft, const char* text, int32_t x, int32_t y,
+                          uint8_t size, uint16_t fgColor, uint16_t bgColor) {
+    // pushImage() is not virtual: a sprite seen as TFT_eSPI& would blit to the panel
+    for (uint8_t i = 0; i < MAX_SPRITES; i++) {
+        if (sprites_[i] && static_cast<TFT_eSPI*>(sprites_[i]) == &tft) {
+            return drawText(*sprites_[i], text, x, y, size, fgColor, bgColor);
+        }
+    }
+    if (&tft != panel_ || size < MIN_SIZE || !covers(text)) {
+        return false;
+    }
+    const GlyphSet* set = findOrBuild(tft, size, fgColor, bgColor);
+    if (set == nullptr) {
+        return false;
+    }
+
+    int32_t w = 6 * size;
+    int32_t h = 8 * size;
+    size_t cell = cellPixels(size);
+    bool swap = tft.getSwapBytes();
+    tft.setSwapBytes(false); // Glyphs are stored in panel byte order, like sprite pixels
+    for (const char* p = text; *p; p++) {
+        size_t index = strchr(GLYPHS, *p) - GLYPHS;
+        tft.pushImage(x, y, w, h, set->pixels + index * cell);
+        x += w;
+    }
+    tft.setSwapBytes(swap);
+    return true;
+}
+
+bool GlyphCache::drawText(TFT_eSprite& sprite, const char* text, int32_t x, int32_t y,
+                          uint8_t size, uint16_t fgColor, uint16_t bgColor) {
+    uint16_t* dst = (uint16_t*)sprite.getPointer();
+    if (size < MIN_SIZE || !covers(text) || dst == nullptr ||
+        sprite.getColorDepth() != 16 || sprite.getRotation() != 0) {
+        return false; // Row copies assume an unrotated 16-bit buffer
+    }
+    const GlyphSet* set = findOrBuild(sprite, size, fgColor, bgColor);
+    if (set == nullptr) {
+        return false;
+    }
+
+    int32_t w = 6 * size;
+    int32_t h = 8 * size;
+    int32_t spriteW = sprite.width();
+    int32_t spriteH = sprite.height();
+    size_t cell = cellPixels(size);
+    // Cells and sprite pixels are both in panel byte order: plain row copies
+    int32_t row0 = max<int32_t>(0, -y);
+    int32_t row1 = min<int32_t>(h, spriteH - y);
+    for (const char* p = text; *p && x < spriteW; p++, x += w) {
+        int32_t col0 = max<int32_t>(0, -x);
+        int32_t col1 = min<int32_t>(w, spriteW - x);
+        if (col0 >= col1) continue;
+        const uint16_t* src = set->pixels + (strchr(GLYPHS, *p) - GLYPHS) * cell;
+        for (int32_t row = row0; row < row1; row++) {
+            memcpy(dst + (size_t)(y + row) * spriteW + x + col0, src + row * w + col0,
+                   (col1 - col0) * sizeof(uint16_t));
+        }
+    }
+    return true;
+}
+
+const GlyphCache::GlyphSet* GlyphCache::findOrBuild(TFT_eSPI& tft, uint8_t size, uint16_t fgColor, uint16_t bgColor) {
+    for (uint8_t i = 0; i < setCount_; i++) {
+        const GlyphSet& s = sets_[i];
+        if (s.size == size && s.fg == fgColor && s.bg == bgColor) return &s;
+    }
+    if (setCount_ >= MAX_SETS) {
+        if (!warnedFull_) {
+            Serial.println("[GlyphCache] Cache full, drawing further colour pairs directly");
+            warnedFull_ = true;
+        }
+        return nullptr;
+    }
+
+    size_t cell = cellPixels(size);
+    size_t bytes = cell * GLYPH_COUNT * sizeof(uint16_t);
+    uint16_t* pixels = (uint16_t*)heapAlloc(HEAP_TAG_UI, bytes, MALLOC_CAP_SPIRAM);
+    if (pixels == nullptr && !isLowMemory(bytes + 40000)) {
+        pixels = (uint16_t*)heapAlloc(HEAP_TAG_UI, bytes, MALLOC_CAP_8BIT); // No PSRAM: keep a margin
+    }
+    if (pixels == nullptr) {
+        return nullptr;
+    }
+
+    // Render each glyph once into a cell-sized sprite with the normal text path
+    TFT_eSprite cellSprite(&tft);
+    cellSprite.setColorDepth(16);
+    if (!cellSprite.createSprite(6 * size, 8 * size)) {
+        heapFree(pixels);
+        return nullptr;
+    }
+    cellSprite.setTextFont(1);
+    for (uint8_t g = 0; g < GLYPH_COUNT; g++) {
+        cellSprite.fillSprite(bgColor);
+        cellSprite.drawChar(0, 0, GLYPHS[g], fgColor, bgColor, size);
+        memcpy(pixels + g * cell, cellSprite.getPointer(), cell * sizeof(uint16_t));
+    }
+    cellSprite.deleteSprite();
+
+    GlyphSet& s = sets_[setCount_++];
+    s.size = size;
+    s.fg = fgColor;
+    s.bg = bgColor;
+    s.pixels = pixels;
+    Serial.printf("[GlyphCache] Built size %u 0x%04X/0x%04X (%u bytes)\n", size, fgColor, bgColor, (unsigned)bytes);
+    return &s;
+}
@@ -0,0 +1,70 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+
+/**
+ * 大字号数字的字形缓存 (Pre-rendered GLCD glyphs)
+ *
+ * TFT_eSPI 用放大的 GLCD 字体绘制带背景色的文字时, 每个字符要逐点填充 48 个
+ * size x size 的方块。这里在第一次使用某个 (字号, 前景色, 背景色) 组合时, 把数字、
+ * 小数点、负号和空格各渲染一次 (RGB565, 屏幕字节序), 之后每个字符只是一次块传输:
+ * 屏幕用 pushImage, sprite 直接按行复制到 getPointer() 的像素缓冲。
+ * pushImage() 不是虚函数, 通过 TFT_eSPI& 调用时 sprite 也会写到屏幕上, 所以
+ * drawText(TFT_eSPI&) 按地址查找真实目标: setPanel() 登记的屏幕, 或 addSprite() 登记的
+ * sprite (DisplayFlusher 的后台缓冲、过渡动画的 sprite); 未登记的目标返回 false。
+ *
+ * 只缓存 MIN_SIZE 及以上的字号 (大号数值读数); 文本中有其他字符、缓存已满或内存不足时
+ * drawText() 返回 false, 由调用者照常用 drawString() 绘制。
+ * 缓存优先放在 PSRAM, 字号 5 每组约 31 KB。只应在绘制屏幕的任务 (主循环) 中使用。
+ */
+class GlyphCache {
+public:
+    static const uint8_t MIN_SIZE = 4;
+    static const uint8_t MAX_SETS = 6;
+
+    static GlyphCache& instance();
+
+    // Draws text in GLCD character cells with the top-left corner at (x, y).
+    // tft must be the registered panel or a registered sprite, otherwise returns false.
+    bool drawText(TFT_eSPI& tft, const char* text, int32_t x, int32_t y,
+                  uint8_t size, uint16_t fgColor, uint16_t bgColor);
+    // Same into a 16-bit sprite (copies rows into its pixel buffer, clipped to the sprite)
+    bool drawText(TFT_eSprite& sprite, const char* text, int32_t x, int32_t y,
+                  uint8_t size, uint16_t fgColor, uint16_t bgColor);
+
+    // Targets drawText(TFT_eSPI&) can resolve (main loop only)
+    void setPanel(TFT_eSPI* panel) { panel_ = panel; }
+    void addSprite(TFT_eSprite* sprite);
+    void removeSprite(TFT_eSprite* sprite);
+    // True if every character of text has a glyph
+    static bool covers(const char* text);
+
+    size_t bytesUsed() const;
+    uint8_t setCount() const { return setCount_; }
+
+private:
+    static const char GLYPHS[];
+    static const uint8_t GLYPH_COUNT = 13;
+    static const uint8_t MAX_SPRITES = 4; // Flusher back buffers + transition sprites
+
+    struct GlyphSet {
+        uint8_t size;
+        uint16_t fg;
+        uint16_t bg;
+        uint16_t* pixels;   // GLYPH_COUNT cells of (6 * size) x (8 * size), row-major
+    };
+
+    GlyphSet sets_[MAX_SETS];
+    uint8_t setCount_;
+    bool warnedFull_;
+    TFT_eSPI* panel_;
+    TFT_eSprite* sprites_[MAX_SPRITES];
+
+    GlyphCache();
+    const GlyphSet* findOrBuild(TFT_eSPI& tft, uint8_t size, uint16_t fgColor, uint16_t bgColor);
+    static size_t cellPixels(uint8_t size) { return (size_t)(6 * size) * (8 * size); }
+};
+
+#endif // GLYPH_CACHE_H
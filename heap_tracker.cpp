@@ -0,0 +1,475 @@
+#include "heap_tracker.h"
+#include "metrics.h"
+#include <esp_heap_caps.h>
+
+HeapTracker heapTracker;
+
+// Guards stats_ and the task table (and the live-allocation table with hooks).
+// Statically initialised: the hooks can fire before any constructor has run.
+static portMUX_TYPE heapMux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char* const TAG_NAMES[HEAP_TAG_COUNT] = {"other", "comm", "data", "ui", "ble", "audio"};
+
+// Tags of tasks that never open a HeapScope, by task name prefix (used with hooks).
+// System tasks belong to the IDF / libraries: their own buffers are not audited.
+static const struct {
+    const char* prefix;
+    uint8_t tag;
+    bool system;
+} TASK_TAGS[] = {
+    {"async_tcp", HEAP_TAG_COMM, true},
+    {"tiT", HEAP_TAG_COMM, true},          // lwIP
+    {"wifi", HEAP_TAG_COMM, true},
+    {"arduino_events", HEAP_TAG_COMM, true},
+    {"uplink", HEAP_TAG_COMM, false},
+    {"query", HEAP_TAG_DATA, false},       // DataManager history queries
+    {"mic_capture", HEAP_TAG_AUDIO, false},
+    {"display_flush", HEAP_TAG_UI, false},
+    {"splash", HEAP_TAG_UI, false},
+    {"ble", HEAP_TAG_BLE, false},          // BootStage running the BLE init
+    {"btController", HEAP_TAG_BLE, true},
+    {"BTC", HEAP_TAG_BLE, true},
+    {"BTU", HEAP_TAG_BLE, true},
+    {"sys_evt", HEAP_TAG_OTHER, true},
+    {"esp_timer", HEAP_TAG_OTHER, true},
+    {"ipc", HEAP_TAG_OTHER, true},
+    {"Tmr Svc", HEAP_TAG_OTHER, true},
+    {"IDLE", HEAP_TAG_OTHER, true},
+};
+
+void HeapTracker::begin() {
+    MetricsRegistry::instance().addCollector(collect, this);
+    lastSampleMs_ = millis();
+    takeSample();
+    Serial.printf("[HeapTracker] Started (%s)\n", hooksEnabled() ? "heap hooks" : "scoped free-heap deltas");
+}
+
+void HeapTracker::update() {
+    if (millis() - lastSampleMs_ >= HISTORY_INTERVAL_MS) {
+        takeSample();
+    }
+#if HEAP_AUDIT_STEADY_STATE
+    printAudit();
+#endif
+}
+
+void HeapTracker::markSteadyState() {
+    if (steadyState_) return;
+#if HEAP_AUDIT_STEADY_STATE
+    Serial.printf("[HeapTracker] Steady state reached, auditing heap allocations (%s)\n",
+                  hooksEnabled() ? "every malloc" : "scope net growth only, approximate");
+#endif
+    steadyState_ = true;
+}
+
+const char* HeapTracker::tagName(uint8_t tag) {
+    return tag < HEAP_TAG_COUNT ? TAG_NAMES[tag] : "?";
+}
+
+bool HeapTracker::hooksEnabled() {
+#ifdef CONFIG_HEAP_USE_HOOKS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void HeapTracker::recordAlloc(uint8_t tag, size_t size) {
+    portENTER_CRITICAL_SAFE(&heapMux);
+    TagStats& s = stats_[tag];
+    s.liveBytes += size;
+    s.peakBytes = max(s.peakBytes, s.liveBytes);
+    s.allocs++;
+    s.growthBytes += size;
+    portEXIT_CRITICAL_SAFE(&heapMux);
+}
+
+void HeapTracker::recordFree(uint8_t tag, size_t size) {
+    portENTER_CRITICAL_SAFE(&heapMux);
+    stats_[tag].liveBytes -= size;
+    portEXIT_CRITICAL_SAFE(&heapMux);
+}
+
+void HeapTracker::recordNet(uint8_t tag, int32_t delta) {
+    portENTER_CRITICAL_SAFE(&heapMux);
+    TagStats& s = stats_[tag];
+    s.liveBytes += delta;
+    s.peakBytes = max(s.peakBytes, s.liveBytes);
+    if (delta > 0) {
+        s.growthBytes += delta;
+    }
+    portEXIT_CRITICAL_SAFE(&heapMux);
+}
+
+uint8_t HeapTracker::currentTag(bool* audited) {
+    TaskSlot* slot = slotForCurrentTask();
+    if (audited) {
+        *audited = slot && (slot->scope || !slot->system);
+    }
+    return slot ? slot->tag : HEAP_TAG_OTHER;
+}
+
+// An allocation on a steady-state path; no-op before markSteadyState() or without the audit
+void HeapTracker::audit(uint8_t tag, size_t size) {
+#if HEAP_AUDIT_STEADY_STATE
+    if (!steadyState_) return;
+    const char* task = pcTaskGetName(nullptr);
+    portENTER_CRITICAL_SAFE(&heapMux);
+    stats_[tag].steadyAllocs++;
+    stats_[tag].steadyBytes += size;
+    AuditEntry& entry = auditLog_[auditCount_ % AUDIT_LOG_SIZE];
+    entry.ms = millis();
+    entry.size = size;
+    entry.tag = tag;
+    entry.task = task;
+    auditCount_++;
+    portEXIT_CRITICAL_SAFE(&heapMux);
+#if HEAP_AUDIT_STEADY_STATE >= 2 && defined(CONFIG_HEAP_USE_HOOKS)
+    abort(); // Backtrace points at the allocating caller
+#endif
+#endif
+}
+
+// Main loop: logs the audit entries written since the last call.
+// Formatted on the stack: Serial.printf() mallocs for lines over 64 bytes, which would be audited again.
+void HeapTracker::printAudit() {
+    char line[112];
+    portENTER_CRITICAL(&heapMux);
+    uint32_t count = auditCount_;
+    portEXIT_CRITICAL(&heapMux);
+    if (count - auditPrinted_ > AUDIT_LOG_SIZE) {
+        snprintf(line, sizeof(line), "[HeapTracker] %lu steady-state allocations not shown",
+                 (unsigned long)(count - auditPrinted_ - AUDIT_LOG_SIZE));
+        Serial.println(line);
+        auditPrinted_ = count - AUDIT_LOG_SIZE;
+    }
+    while (auditPrinted_ != count) {
+        portENTER_CRITICAL(&heapMux);
+        AuditEntry entry = auditLog_[auditPrinted_ % AUDIT_LOG_SIZE];
+        portEXIT_CRITICAL(&heapMux);
+        snprintf(line, sizeof(line), "[HeapTracker] Steady-state allocation: %lu B, tag=%s, task=%s, t=%lu ms",
+                 (unsigned long)entry.size, tagName(entry.tag), entry.task ? entry.task : "?",
+                 (unsigned long)entry.ms);
+        Serial.println(line);
+        auditPrinted_++;
+    }
+}
+
+// Only the owning task changes its slot's tag / scope; the table itself is shared
+HeapTracker::TaskSlot* HeapTracker::slotForCurrentTask() {
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
+        return nullptr;
+    }
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    TaskSlot* slot = nullptr;
+    portENTER_CRITICAL_SAFE(&heapMux);
+    for (size_t i = 0; i < taskCount_ && !slot; i++) {
+        if (tasks_[i].task == self) slot = &tasks_[i];
+    }
+    if (!slot && taskCount_ < MAX_TASKS) {
+        slot = &tasks_[taskCount_++];
+        slot->task = self;
+        slot->tag = HEAP_TAG_OTHER;
+        slot->system = false;
+        slot->scope = nullptr;
+        const char* name = pcTaskGetName(nullptr);
+        for (size_t i = 0; i < sizeof(TASK_TAGS) / sizeof(TASK_TAGS[0]); i++) {
+            if (strncmp(name, TASK_TAGS[i].prefix, strlen(TASK_TAGS[i].prefix)) == 0) {
+                slot->tag = TASK_TAGS[i].tag;
+                slot->system = TASK_TAGS[i].system;
+                break;
+            }
+        }
+    }
+    portEXIT_CRITICAL_SAFE(&heapMux);
+    return slot;
+}
+
+void HeapTracker::takeSample() {
+    uint32_t now = millis();
+    float seconds = (now - lastSampleMs_) / 1000.0f;
+    lastSampleMs_ = now;
+
+    // Same figures as logMemoryStatus()
+    uint32_t freeBytes = ESP.getFreeHeap();
+    uint32_t largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    portENTER_CRITICAL(&heapMux);
+    Sample& sample = history_[historyHead_];
+    sample.uptimeS = now / 1000;
+    sample.freeBytes = freeBytes;
+    sample.largestBlock = largestBlock;
+    for (uint8_t t = 0; t < HEAP_TAG_COUNT; t++) {
+        TagStats& s = stats_[t];
+        sample.liveBytes[t] = s.liveBytes;
+        s.growthRate = seconds > 0.0f ? (s.growthBytes - lastGrowthBytes_[t]) / seconds : 0.0f;
+        lastGrowthBytes_[t] = s.growthBytes;
+    }
+    historyHead_ = (historyHead_ + 1) % HISTORY_SIZE;
+    historyCount_ = min(historyCount_ + 1, (size_t)HISTORY_SIZE);
+    portEXIT_CRITICAL(&heapMux);
+}
+
+void HeapTracker::getStats(TagStats* out) const {
+    portENTER_CRITICAL(&heapMux);
+    memcpy(out, stats_, sizeof(stats_));
+    portEXIT_CRITICAL(&heapMux);
+}
+
+// Callable from any task (the HTTP handler runs in async_tcp)
+size_t HeapTracker::getHistory(Sample* out, size_t maxSamples) const {
+    portENTER_CRITICAL(&heapMux);
+    size_t count = min(historyCount_, maxSamples);
+    size_t start = (historyHead_ + HISTORY_SIZE - count) % HISTORY_SIZE;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = history_[(start + i) % HISTORY_SIZE];
+    }
+    portEXIT_CRITICAL(&heapMux);
+    return count;
+}
+
+uint8_t HeapTracker::largestTag() const {
+    TagStats stats[HEAP_TAG_COUNT];
+    getStats(stats);
+    uint8_t largest = HEAP_TAG_OTHER;
+    int32_t bytes = 0;
+    for (uint8_t t = HEAP_TAG_OTHER + 1; t < HEAP_TAG_COUNT; t++) {
+        if (stats[t].liveBytes > bytes) {
+            bytes = stats[t].liveBytes;
+            largest = t;
+        }
+    }
+    return largest;
+}
+
+void HeapTracker::printReport() const {
+    TagStats stats[HEAP_TAG_COUNT];
+    getStats(stats);
+    Serial.printf("子系统    占用(B)   峰值(B)   %s  次数\n", hooksEnabled() ? "分配(B/s)" : "净增(B/s)");
+    for (uint8_t t = 0; t < HEAP_TAG_COUNT; t++) {
+        const TagStats& s = stats[t];
+        Serial.printf("%-8s %9ld %9ld %10.0f %6lu\n", tagName(t), (long)s.liveBytes, (long)s.peakBytes,
+                      s.growthRate, (unsigned long)s.allocs);
+    }
+    if (!hooksEnabled()) {
+        Serial.println("(无堆钩子: 按作用域净增长近似统计, 作用域内分配又释放的部分不计)");
+    }
+#if HEAP_AUDIT_STEADY_STATE
+    if (steadyState_) {
+        Serial.print("稳态分配次数:");
+        for (uint8_t t = 0; t < HEAP_TAG_COUNT; t++) {
+            Serial.printf(" %s=%lu", tagName(t), (unsigned long)stats[t].steadyAllocs);
+        }
+        Serial.println();
+    }
+#endif
+    if (historyCount_ > 1) {
+        const Sample& oldest = history_[(historyHead_ + HISTORY_SIZE - historyCount_) % HISTORY_SIZE];
+        const Sample& newest = history_[(historyHead_ + HISTORY_SIZE - 1) % HISTORY_SIZE];
+        Serial.printf("最大空闲块: %lu -> %lu 字节 (%lu 秒内)\n", (unsigned long)oldest.largestBlock,
+                      (unsigned long)newest.largestBlock, (unsigned long)(newest.uptimeS - oldest.uptimeS));
+    }
+}
+
+void HeapTracker::collect(MetricsWriter& w, void* context) {
+    HeapTracker* self = static_cast<HeapTracker*>(context);
+    TagStats stats[HEAP_TAG_COUNT];
+    self->getStats(stats);
+    char labels[HEAP_TAG_COUNT][16];
+    for (uint8_t t = 0; t < HEAP_TAG_COUNT; t++) {
+        snprintf(labels[t], sizeof(labels[t]), "tag=\"%s\"", TAG_NAMES[t]);
+    }
+
+    w.header("soundscape_heap_tag_live_bytes", "Heap bytes currently attributed to a subsystem", "gauge");
+    for (uint8_t t = 0; t < HEAP_TAG_COUNT; t++) {
+        w.sample("soundscape_heap_tag_live_bytes", labels[t], (float)stats[t].liveBytes);
+    }
+    w.header("soundscape_heap_tag_peak_bytes", "Highest heap bytes attributed to a subsystem", "gauge");
+    for (uint8_t t = 0; t < HEAP_TAG_COUNT; t++) {
+        w.sample("soundscape_heap_tag_peak_bytes", labels[t], (float)stats[t].peakBytes);
+    }
+    w.header("soundscape_heap_tag_growth_bytes_total",
+             hooksEnabled() ? "Heap bytes allocated by a subsystem since boot"
+                            : "Approximate heap growth of a subsystem since boot (net per scope, no heap hooks)",
+             "counter");
+    for (uint8_t t = 0; t < HEAP_TAG_COUNT; t++) {
+        w.sampleU64("soundscape_heap_tag_growth_bytes_total", labels[t], stats[t].growthBytes);
+    }
+    w.header("soundscape_heap_tag_allocations_total", "Counted heap allocations of a subsystem", "counter");
+    for (uint8_t t = 0; t < HEAP_TAG_COUNT; t++) {
+        w.sampleU64("soundscape_heap_tag_allocations_total", labels[t], stats[t].allocs);
+    }
+#if HEAP_AUDIT_STEADY_STATE
+    w.header("soundscape_heap_steady_state_allocations_total", "Audited heap allocations after boot completed", "counter");
+    for (uint8_t t = 0; t < HEAP_TAG_COUNT; t++) {
+        w.sampleU64("soundscape_heap_steady_state_allocations_total", labels[t], stats[t].steadyAllocs);
+    }
+    w.header("soundscape_heap_steady_state_allocated_bytes_total", "Bytes of audited heap allocations after boot completed", "counter");
+    for (uint8_t t = 0; t < HEAP_TAG_COUNT; t++) {
+        w.sampleU64("soundscape_heap_steady_state_allocated_bytes_total", labels[t], stats[t].steadyBytes);
+    }
+#endif
+}
+
+// --- HeapScope ---
+
+HeapScope::HeapScope(HeapTag tag) :
+    slot_(heapTracker.slotForCurrentTask()),
+    tag_(tag),
+    prevTag_(HEAP_TAG_OTHER),
+    parent_(nullptr),
+    freeBefore_(0),
+    childNet_(0)
+{
+    if (!slot_) return;
+    prevTag_ = slot_->tag;
+    parent_ = slot_->scope;
+    slot_->tag = tag;
+    slot_->scope = this;
+#ifndef CONFIG_HEAP_USE_HOOKS
+    freeBefore_ = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+#endif
+}
+
+HeapScope::~HeapScope() {
+    if (!slot_) return;
+#ifndef CONFIG_HEAP_USE_HOOKS
+    int32_t net = (int32_t)(freeBefore_ - heap_caps_get_free_size(MALLOC_CAP_8BIT));
+    if (net != childNet_) {
+        heapTracker.recordNet(tag_, net - childNet_);
+        if (net > childNet_) {
+            heapTracker.audit(tag_, net - childNet_);
+        }
+    }
+    if (parent_) {
+        parent_->childNet_ += net;
+    }
+#endif
+    slot_->tag = prevTag_;
+    slot_->scope = parent_;
+}
+
+// --- Tagged allocation ---
+
+#ifdef CONFIG_HEAP_USE_HOOKS
+
+// The hooks count every allocation, so the wrappers only need to set the tag
+void* heapAlloc(HeapTag tag, size_t size, uint32_t caps) {
+    HeapScope scope(tag);
+    return heap_caps_malloc(size, caps);
+}
+
+void heapFree(void* ptr) {
+    heap_caps_free(ptr);
+}
+
+// Live allocations -> size and tag, so each free is charged to the tag that allocated.
+// Open addressing with linear probing; allocations that do not fit are not tracked.
+static const size_t LIVE_SLOTS = 1024;
+static struct {
+    void* ptr;
+    uint32_t sizeTag;   // size << 8 | tag
+} liveSlots[LIVE_SLOTS];
+
+static inline size_t IRAM_ATTR liveHome(void* ptr) {
+    return (((uintptr_t)ptr >> 3) * 2654435761u) >> 22; // 10-bit Fibonacci hash
+}
+
+extern "C" void IRAM_ATTR esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps) {
+    if (!ptr) return;
+    bool audited = false;
+    uint8_t tag = heapTracker.currentTag(&audited);
+    bool stored = false;
+    portENTER_CRITICAL_SAFE(&heapMux);
+    size_t i = liveHome(ptr);
+    for (size_t n = 0; n < LIVE_SLOTS && !stored; n++, i = (i + 1) & (LIVE_SLOTS - 1)) {
+        if (!liveSlots[i].ptr) {
+            liveSlots[i].ptr = ptr;
+            liveSlots[i].sizeTag = (uint32_t)(size << 8) | tag;
+            stored = true;
+        }
+    }
+    portEXIT_CRITICAL_SAFE(&heapMux);
+    heapTracker.recordAlloc(tag, size);
+    if (!stored) {
+        heapTracker.recordFree(tag, size); // Counted, but not held against the tag
+    }
+    if (audited) {
+        heapTracker.audit(tag, size);
+    }
+}
+
+extern "C" void IRAM_ATTR esp_heap_trace_free_hook(void* ptr) {
+    if (!ptr) return;
+    uint32_t sizeTag = 0;
+    bool found = false;
+    portENTER_CRITICAL_SAFE(&heapMux);
+    size_t i = liveHome(ptr);
+    for (size_t n = 0; n < LIVE_SLOTS && liveSlots[i].ptr; n++, i = (i + 1) & (LIVE_SLOTS - 1)) {
+        if (liveSlots[i].ptr == ptr) {
+            found = true;
+            break;
+        }
+    }
+    if (found) {
+        sizeTag = liveSlots[i].sizeTag;
+        // Backward-shift deletion keeps every probe chain unbroken
+        size_t j = i;
+        for (;;) {
+            j = (j + 1) & (LIVE_SLOTS - 1);
+            if (!liveSlots[j].ptr) break;
+            size_t home = liveHome(liveSlots[j].ptr);
+            bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+            if (!stays) {
+                liveSlots[i] = liveSlots[j];
+                i = j;
+            }
+        }
+        liveSlots[i].ptr = nullptr;
+    }
+    portEXIT_CRITICAL_SAFE(&heapMux);
+    if (found) {
+        heapTracker.recordFree(sizeTag & 0xFF, sizeTag >> 8);
+    }
+}
+
+#else
+
+// Without hooks the size and tag travel in a header in front of the block.
+// 8 bytes keep the alignment heap_caps_malloc gives (DMA buffers need 4).
+struct AllocHeader {
+    uint32_t size;
+    uint8_t tag;
+    uint8_t reserved[3];
+};
+
+void* heapAlloc(HeapTag tag, size_t size, uint32_t caps) {
+    AllocHeader* header = (AllocHeader*)heap_caps_malloc(size + sizeof(AllocHeader), caps);
+    if (!header) {
+        return nullptr;
+    }
+    size_t bytes = size + sizeof(AllocHeader);
+    header->size = bytes;
+    header->tag = tag;
+    heapTracker.recordAlloc(tag, bytes);
+    heapTracker.audit(tag, bytes);
+    // Keep the enclosing scope from counting it a second time
+    HeapTracker::TaskSlot* slot = heapTracker.slotForCurrentTask();
+    if (slot && slot->scope) {
+        slot->scope->childNet_ += bytes;
+    }
+    return header + 1;
+}
+
+void heapFree(void* ptr) {
+    if (!ptr) return;
+    AllocHeader* header = (AllocHeader*)ptr - 1;
+    size_t bytes = header->size;
+    heapTracker.recordFree(header->tag, bytes);
+    heap_caps_free(header);
+    HeapTracker::TaskSlot* slot = heapTracker.slotForCurrentTask();
+    if (slot && slot->scope) {
+        slot->scope->childNet_ -= bytes;
+    }
+}
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef HEAP_TRACKER_H
+#define HEAP_TRACKER_H
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <esp_heap_caps.h>
+
+class MetricsWriter;
+class HeapScope;
+
+// Steady-state allocation audit (debug builds, e.g. -DHEAP_AUDIT_STEADY_STATE=1):
+// 0 = off, 1 = count and log allocations made after markSteadyState(),
+// 2 = as 1, and abort() on the first one when built with CONFIG_HEAP_USE_HOOKS (backtrace = caller)
+#ifndef HEAP_AUDIT_STEADY_STATE
+#define HEAP_AUDIT_STEADY_STATE 0
+#endif
+
+// Subsystems that heap usage is attributed to
+enum HeapTag : uint8_t {
+    HEAP_TAG_OTHER = 0,
+    HEAP_TAG_COMM,   // WiFi, TCP/HTTP/WebSocket, telemetry, uplink
+    HEAP_TAG_DATA,   // Sensors, record buffer, SD, queries
+    HEAP_TAG_UI,     // Screens, display buffers, glyph cache
+    HEAP_TAG_BLE,
+    HEAP_TAG_AUDIO,  // I2S capture, spectrum
+    HEAP_TAG_COUNT
+};
+
+/**
+ * 按子系统统计堆内存 (Per-subsystem heap accounting)
+ *
+ * 每个任务有一个"当前标签", 由 HeapScope (RAII) 在子系统入口处设置, 例如
+ * DataManager::update() 开头的 HeapScope heapScope(HEAP_TAG_DATA)。两种统计方式:
+ * - 默认 (Arduino 预编译 IDF 没有打开堆钩子): HeapScope 退出时用空闲堆的变化量计算该作用域
+ *   净分配的字节数, 嵌套作用域的部分只计入内层标签; heapAlloc()/heapFree() 分配的缓冲区
+ *   按实际大小精确计入。同一时刻其他任务的分配也会落入正在测量的作用域, 因此是近似值。
+ * - 以 CONFIG_HEAP_USE_HOOKS 编译 IDF 时, 每次 malloc/free 都经钩子按当前任务的标签精确计数;
+ *   没有 HeapScope 的任务按任务名归类 (async_tcp -> comm, mic_capture -> audio, ...)。
+ *
+ * 每个标签记录当前占用、峰值、累计增长字节数/分配次数和最近一个采样间隔的增长速率 (有钩子时
+ * 即为分配字节数; 没有钩子时只是各作用域的净增长, 作用域内分配又释放的部分看不到, 输出中标为近似);
+ * update() 每 10 秒记录一次空闲堆、最大空闲块和各标签占用, 保留最近 10 分钟, 用于把碎片化
+ * 的增长对应到具体子系统。数据在 /metrics (soundscape_heap_tag_*)、HTTP /heap、状态页和
+ * logMemoryStatus() 的串口报告中输出。
+ *
+ * 稳态分配审计 (HEAP_AUDIT_STEADY_STATE, 默认关闭): 启动完成后主循环调用 markSteadyState(),
+ * 此后的每次堆分配按标签计数, 最近几次在串口打印 (大小、标签、任务), 并导出为
+ * soundscape_heap_steady_state_allocations_total。计入审计的是 HeapScope 内的分配和本项目
+ * 任务 (loopTask、mic_capture、display_flush、input、uplink ...) 的分配; lwIP、WiFi、async_tcp、
+ * 蓝牙协议栈等系统任务自己的缓冲区不算。有堆钩子时逐次精确计数, 级别 2 在第一次分配处 abort();
+ * 没有钩子时只能看到 HeapScope 的净增长和 heapAlloc(), 短暂分配又释放的情况看不到, 只作参考。
+ * WiFi 重连、客户端接入等事件本身的分配也会出现在日志中, 按时间和标签区分。
+ */
+class HeapTracker {
+public:
+    static const size_t HISTORY_SIZE = 60;
+    static const uint32_t HISTORY_INTERVAL_MS = 10000;
+
+    struct TagStats {
+        int32_t liveBytes;   // Net bytes currently held
+        int32_t peakBytes;
+        uint32_t allocs;     // Counted allocations (hooks and heapAlloc() only)
+        // With heap hooks: bytes allocated. Without: only the net growth of each HeapScope plus
+        // heapAlloc() sizes, so memory allocated and freed inside one scope is not seen (approximate)
+        uint32_t growthBytes; // Since boot (wraps)
+        float growthRate;     // Bytes/s over the last history interval
+        uint32_t steadyAllocs; // Audited allocations after markSteadyState() (HEAP_AUDIT_STEADY_STATE)
+        uint32_t steadyBytes;
+    };
+
+    struct Sample {
+        uint32_t uptimeS;
+        uint32_t freeBytes;
+        uint32_t largestBlock;
+        int32_t liveBytes[HEAP_TAG_COUNT];
+    };
+
+    // Registers the metrics collector; call first thing in setup()
+    void begin();
+    // Main loop: takes a history sample every HISTORY_INTERVAL_MS (and prints new audit entries)
+    void update();
+    // Boot is complete: from now on allocations are audited (once; later calls are ignored)
+    void markSteadyState();
+    bool inSteadyState() const { return steadyState_; }
+
+    static const char* tagName(uint8_t tag);
+    static bool hooksEnabled();
+
+    void getStats(TagStats* out) const;               // HEAP_TAG_COUNT entries
+    size_t getHistory(Sample* out, size_t maxSamples) const; // Oldest first, returns the count
+    uint8_t largestTag() const;                       // Tag with the most live bytes
+    void printReport() const;
+
+    // Used by HeapScope, heapAlloc() and the heap hooks
+    void recordAlloc(uint8_t tag, size_t size);
+    void recordFree(uint8_t tag, size_t size);
+    void recordNet(uint8_t tag, int32_t delta);
+    void audit(uint8_t tag, size_t size);
+    uint8_t currentTag(bool* audited = nullptr); // audited: inside a HeapScope or on one of our tasks
+
+private:
+    friend class HeapScope;
+    friend void* heapAlloc(HeapTag tag, size_t size, uint32_t caps);
+    friend void heapFree(void* ptr);
+
+    struct TaskSlot {
+        TaskHandle_t task;
+        uint8_t tag;
+        bool system;        // Library / IDF task: not audited outside a HeapScope
+        HeapScope* scope;   // Innermost open scope of the task
+    };
+    static const size_t MAX_TASKS = 24;
+
+    struct AuditEntry {
+        uint32_t ms;
+        uint32_t size;
+        uint8_t tag;
+        const char* task;
+    };
+    static const size_t AUDIT_LOG_SIZE = 8;
+
+    // Zero-initialised global (no constructor), so the hooks can use it before setup()
+    TagStats stats_[HEAP_TAG_COUNT];
+    uint32_t lastGrowthBytes_[HEAP_TAG_COUNT];
+    TaskSlot tasks_[MAX_TASKS];
+    size_t taskCount_;
+    Sample history_[HISTORY_SIZE];
+    size_t historyCount_;
+    size_t historyHead_;
+    uint32_t lastSampleMs_;
+    volatile bool steadyState_;
+    AuditEntry auditLog_[AUDIT_LOG_SIZE];
+    uint32_t auditCount_;   // Entries written since markSteadyState()
+    uint32_t auditPrinted_;
+
+    TaskSlot* slotForCurrentTask();
+    void takeSample();
+    void printAudit();
+    static void collect(MetricsWriter& w, void* context);
+};
+
+extern HeapTracker heapTracker;
+
+// Attributes the heap used between construction and destruction to tag
+class HeapScope {
+public:
+    explicit HeapScope(HeapTag tag);
+    ~HeapScope();
+
+private:
+    friend void* heapAlloc(HeapTag tag, size_t size, uint32_t caps);
+    friend void heapFree(void* ptr);
+
+    HeapTracker::TaskSlot* slot_;
+    uint8_t tag_;
+    uint8_t prevTag_;
+    HeapScope* parent_;
+    uint32_t freeBefore_;
+    int32_t childNet_;      // Bytes already attributed by nested scopes / heapAlloc()
+
+    HeapScope(const HeapScope&) = delete;
+    HeapScope& operator=(const HeapScope&) = delete;
+};
+
+// heap_caps_malloc / heap_caps_free that are always counted under tag
+void* heapAlloc(HeapTag tag, size_t size, uint32_t caps);
+void heapFree(void* ptr);
+
+#endif // HEAP_TRACKER_H
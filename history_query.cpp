@@ -0,0 +1,446 @@
+#include "history_query.h"
+#include "heap_tracker.h"
+#include "wire_protocol.h" // Little-endian helpers
+#include <math.h>
+#include <string.h>
+
+static const char* FIELD_NAMES[QUERY_FIELD_COUNT] = {"db", "temp", "hum", "lux"};
+
+const char* queryFieldName(QueryField field) {
+    return field < QUERY_FIELD_COUNT ? FIELD_NAMES[field] : "?";
+}
+
+float queryFieldValue(const EnvironmentData& record, QueryField field) {
+    switch (field) {
+        case QUERY_FIELD_DB:   return record.decibels;
+        case QUERY_FIELD_TEMP: return record.temperature;
+        case QUERY_FIELD_HUM:  return record.humidity;
+        case QUERY_FIELD_LUX:  return record.lux;
+        default:               return NAN;
+    }
+}
+
+// --- FieldStats ---
+
+void FieldStats::reset() {
+    count = 0;
+    sum = 0.0;
+    energy = 0.0;
+    min = INFINITY;
+    max = -INFINITY;
+}
+
+void FieldStats::add(float value, bool trackEnergy) {
+    if (isnan(value)) return;
+    count++;
+    sum += value;
+    if (trackEnergy) {
+        energy += pow(10.0, value / 10.0);
+    }
+    if (value < min) min = value;
+    if (value > max) max = value;
+}
+
+void FieldStats::merge(const FieldStats& other) {
+    if (other.count == 0) return;
+    count += other.count;
+    sum += other.sum;
+    energy += other.energy;
+    if (other.min < min) min = other.min;
+    if (other.max > max) max = other.max;
+}
+
+// --- HourRollup ---
+
+void HourRollup::reset(uint32_t hour) {
+    hourStart = hour;
+    lastSeq = 0;
+    for (int f = 0; f < QUERY_FIELD_COUNT; ++f) {
+        fields[f].reset();
+    }
+}
+
+void HourRollup::add(const EnvironmentData& record) {
+    for (int f = 0; f < QUERY_FIELD_COUNT; ++f) {
+        fields[f].add(queryFieldValue(record, (QueryField)f), f == QUERY_FIELD_DB);
+    }
+    if (record.seq > lastSeq) lastSeq = record.seq;
+}
+
+static void putF64(uint8_t* p, double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    WireProtocol::putU32(p, (uint32_t)bits);
+    WireProtocol::putU32(p + 4, (uint32_t)(bits >> 32));
+}
+
+static double getF64(const uint8_t* p) {
+    uint64_t bits = (uint64_t)WireProtocol::getU32(p) | ((uint64_t)WireProtocol::getU32(p + 4) << 32);
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+static void putF32(uint8_t* p, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    WireProtocol::putU32(p, bits);
+}
+
+static float getF32(const uint8_t* p) {
+    uint32_t bits = WireProtocol::getU32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+void HourRollup::encode(uint8_t* out) const {
+    WireProtocol::putU32(out, hourStart);
+    WireProtocol::putU32(out + 4, lastSeq);
+    uint8_t* p = out + 8;
+    for (int f = 0; f < QUERY_FIELD_COUNT; ++f) {
+        WireProtocol::putU32(p, fields[f].count);
+        putF64(p + 4, fields[f].sum);
+        putF64(p + 12, fields[f].energy);
+        putF32(p + 20, fields[f].min);
+        putF32(p + 24, fields[f].max);
+        p += 28;
+    }
+}
+
+void HourRollup::decode(const uint8_t* in) {
+    hourStart = WireProtocol::getU32(in);
+    lastSeq = WireProtocol::getU32(in + 4);
+    const uint8_t* p = in + 8;
+    for (int f = 0; f < QUERY_FIELD_COUNT; ++f) {
+        fields[f].count = WireProtocol::getU32(p);
+        fields[f].sum = getF64(p + 4);
+        fields[f].energy = getF64(p + 12);
+        fields[f].min = getF32(p + 20);
+        fields[f].max = getF32(p + 24);
+        p += 28;
+    }
+}
+
+// --- QuerySpec ---
+
+QuerySpec::QuerySpec() :
+    from(0),
+    to(0),
+    bucketSeconds(3600),
+    fromRelative(false),
+    fieldMask(0),
+    aggCount(0),
+    columnCount(0)
+{}
+
+// "3600", "90s", "30m", "1h", "2d". Returns false on garbage.
+static bool parseDuration(const char* text, int64_t& seconds) {
+    char* end = nullptr;
+    long long v = strtoll(text, &end, 10);
+    if (end == text) return false;
+    switch (*end) {
+        case '\0':
+        case 's': break;
+        case 'm': v *= 60; break;
+        case 'h': v *= 3600; break;
+        case 'd': v *= 86400; break;
+        default: return false;
+    }
+    if (*end != '\0' && end[1] != '\0') return false;
+    seconds = v;
+    return true;
+}
+
+// Absolute epoch seconds, "now", or a negative duration relative to now ("-3d")
+static bool parseTime(const char* text, time_t now, bool nowValid, time_t& out, char* err, size_t errLen) {
+    if (strcmp(text, "now") == 0 || text[0] == '-') {
+        if (!nowValid) {
+            snprintf(err, errLen, "TIME_UNSYNCED: relative time needs NTP");
+            return false;
+        }
+        int64_t offset = 0;
+        if (text[0] == '-' && !parseDuration(text + 1, offset)) {
+            snprintf(err, errLen, "bad time '%s'", text);
+            return false;
+        }
+        out = now - (time_t)offset;
+        return true;
+    }
+    char* end = nullptr;
+    long long v = strtoll(text, &end, 10);
+    if (end == text || *end != '\0' || v < 0) {
+        snprintf(err, errLen, "bad time '%s'", text);
+        return false;
+    }
+    out = (time_t)v;
+    return true;
+}
+
+bool QuerySpec::setParam(const char* key, const char* value, time_t now, bool nowValid,
+                         char* err, size_t errLen) {
+    if (strcmp(key, "from") == 0) {
+        fromRelative = (strcmp(value, "now") == 0 || value[0] == '-');
+        return parseTime(value, now, nowValid, from, err, errLen);
+    }
+    if (strcmp(key, "to") == 0) {
+        return parseTime(value, now, nowValid, to, err, errLen);
+    }
+    if (strcmp(key, "bucket") == 0) {
+        int64_t seconds = 0;
+        if (!parseDuration(value, seconds) || seconds < (int64_t)MIN_BUCKET_SECONDS || seconds > 366LL * 86400) {
+            snprintf(err, errLen, "bad bucket '%s' (60s..366d)", value);
+            return false;
+        }
+        bucketSeconds = (uint32_t)seconds;
+        return true;
+    }
+
+    // Comma separated lists
+    char list[64];
+    strncpy(list, value, sizeof(list) - 1);
+    list[sizeof(list) - 1] = '\0';
+    char* save = nullptr;
+
+    if (strcmp(key, "fields") == 0) {
+        fieldMask = 0;
+        for (char* tok = strtok_r(list, ",", &save); tok; tok = strtok_r(nullptr, ",", &save)) {
+            int f = 0;
+            while (f < QUERY_FIELD_COUNT && strcmp(tok, FIELD_NAMES[f]) != 0) ++f;
+            if (f == QUERY_FIELD_COUNT) {
+                snprintf(err, errLen, "unknown field '%s' (db,temp,hum,lux)", tok);
+                return false;
+            }
+            fieldMask |= (1 << f);
+        }
+        return true;
+    }
+    if (strcmp(key, "agg") == 0) {
+        aggCount = 0;
+        for (char* tok = strtok_r(list, ",", &save); tok; tok = strtok_r(nullptr, ",", &save)) {
+            if (aggCount >= sizeof(aggs) / sizeof(aggs[0])) {
+                snprintf(err, errLen, "too many aggregates");
+                return false;
+            }
+            QueryAgg agg;
+            uint8_t pct = 0;
+            if (strcmp(tok, "avg") == 0) agg = QUERY_AGG_AVG;
+            else if (strcmp(tok, "min") == 0) agg = QUERY_AGG_MIN;
+            else if (strcmp(tok, "max") == 0) agg = QUERY_AGG_MAX;
+            else if (strcmp(tok, "count") == 0) agg = QUERY_AGG_COUNT;
+            else if (strcmp(tok, "leq") == 0) agg = QUERY_AGG_LEQ;
+            else if (strcmp(tok, "median") == 0) { agg = QUERY_AGG_PERCENTILE; pct = 50; }
+            else if (tok[0] == 'p') {
+                char* end = nullptr;
+                long p = strtol(tok + 1, &end, 10);
+                if (end == tok + 1 || *end != '\0' || p < 1 || p > 99) {
+                    snprintf(err, errLen, "bad percentile '%s' (p1..p99)", tok);
+                    return false;
+                }
+                agg = QUERY_AGG_PERCENTILE;
+                pct = (uint8_t)p;
+            } else {
+                snprintf(err, errLen, "unknown agg '%s'", tok);
+                return false;
+            }
+            aggs[aggCount] = agg;
+            percentiles[aggCount] = pct;
+            aggCount++;
+        }
+        return true;
+    }
+    snprintf(err, errLen, "unknown parameter '%s'", key);
+    return false;
+}
+
+bool QuerySpec::parse(const char* args, time_t now, bool nowValid, char* err, size_t errLen) {
+    char buf[160];
+    strncpy(buf, args, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    char* save = nullptr;
+    for (char* tok = strtok_r(buf, " ", &save); tok; tok = strtok_r(nullptr, " ", &save)) {
+        char* eq = strchr(tok, '=');
+        if (!eq) {
+            snprintf(err, errLen, "expected key=value, got '%s'", tok);
+            return false;
+        }
+        *eq = '\0';
+        if (!setParam(tok, eq + 1, now, nowValid, err, errLen)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool QuerySpec::finalize(time_t now, bool nowValid, char* err, size_t errLen) {
+    if (from == 0) {
+        snprintf(err, errLen, "missing 'from'");
+        return false;
+    }
+    if (to == 0) {
+        if (!nowValid) {
+            snprintf(err, errLen, "TIME_UNSYNCED: missing 'to' needs NTP");
+            return false;
+        }
+        to = now;
+    }
+    if (fromRelative) {
+        // "-3d" is taken as "the last 3 days of buckets": snap to a bucket (whole hour for
+        // hour-multiple buckets) so bucket edges fall on rollup boundaries.
+        uint32_t align = (bucketSeconds % 3600 == 0) ? 3600 : bucketSeconds;
+        from -= from % align;
+    }
+    if (from >= to) {
+        snprintf(err, errLen, "empty range (from must be < to)");
+        return false;
+    }
+    if (fieldMask == 0) fieldMask = 1 << QUERY_FIELD_DB;
+    if (aggCount == 0) {
+        aggs[0] = QUERY_AGG_AVG;
+        percentiles[0] = 0;
+        aggCount = 1;
+    }
+
+    columnCount = 0;
+    for (int f = 0; f < QUERY_FIELD_COUNT; ++f) {
+        if (!(fieldMask & (1 << f))) continue;
+        for (uint8_t a = 0; a < aggCount; ++a) {
+            if (aggs[a] == QUERY_AGG_LEQ && f != QUERY_FIELD_DB) {
+                snprintf(err, errLen, "leq is only defined for db");
+                return false;
+            }
+            if (columnCount >= MAX_COLUMNS) {
+                snprintf(err, errLen, "too many columns (max %u)", (unsigned)MAX_COLUMNS);
+                return false;
+            }
+            columns[columnCount++] = QueryColumn{(QueryField)f, aggs[a], percentiles[a]};
+        }
+    }
+    if ((size_t)bucketCount() * columnCount > MAX_CELLS) {
+        snprintf(err, errLen, "result too large (%lu buckets x %u columns)",
+                 (unsigned long)bucketCount(), (unsigned)columnCount);
+        return false;
+    }
+    return true;
+}
+
+uint32_t QuerySpec::bucketCount() const {
+    if (to <= from || bucketSeconds == 0) return 0;
+    return (uint32_t)(((int64_t)to - from + bucketSeconds - 1) / bucketSeconds);
+}
+
+bool QuerySpec::needsRawSamples() const {
+    for (uint8_t c = 0; c < columnCount; ++c) {
+        if (columns[c].agg == QUERY_AGG_PERCENTILE) return true;
+    }
+    return false;
+}
+
+bool QuerySpec::fieldHasPercentile(QueryField f) const {
+    for (uint8_t c = 0; c < columnCount; ++c) {
+        if (columns[c].field == f && columns[c].agg == QUERY_AGG_PERCENTILE) return true;
+    }
+    return false;
+}
+
+size_t QuerySpec::canonical(char* out, size_t outLen) const {
+    int len = snprintf(out, outLen, "%lld-%lld/%lu:", (long long)from, (long long)to, (unsigned long)bucketSeconds);
+    for (uint8_t c = 0; c < columnCount && len > 0 && (size_t)len < outLen; ++c) {
+        len += snprintf(out + len, outLen - len, "%u.%u.%u,",
+                        (unsigned)columns[c].field, (unsigned)columns[c].agg, (unsigned)columns[c].percentile);
+    }
+    return (len > 0 && (size_t)len < outLen) ? (size_t)len : 0; // 0 = did not fit, not cacheable
+}
+
+// --- PercentileHistogram ---
+
+static const float HIST_RANGE[QUERY_FIELD_COUNT][2] = {
+    {0.0f, 140.0f},   // dB
+    {-40.0f, 125.0f}, // C (Si7021 range)
+    {0.0f, 100.0f},   // %RH
+    {0.0f, 5.2f}      // log10(lux + 1), up to ~160k lx
+};
+
+PercentileHistogram::PercentileHistogram() : field_(QUERY_FIELD_DB), bins_(nullptr), total_(0) {}
+
+PercentileHistogram::~PercentileHistogram() {
+    heapFree(bins_);
+}
+
+bool PercentileHistogram::begin(QueryField field) {
+    field_ = field;
+    if (!bins_) {
+        bins_ = (uint32_t*)heapAlloc(HEAP_TAG_DATA, BINS * sizeof(uint32_t), MALLOC_CAP_8BIT);
+    }
+    reset();
+    return bins_ != nullptr;
+}
+
+void PercentileHistogram::reset() {
+    if (bins_) memset(bins_, 0, BINS * sizeof(uint32_t));
+    total_ = 0;
+}
+
+int PercentileHistogram::binFor(float value) const {
+    float v = (field_ == QUERY_FIELD_LUX) ? log10f(max(value, 0.0f) + 1.0f) : value;
+    float lo = HIST_RANGE[field_][0], hi = HIST_RANGE[field_][1];
+    int bin = (int)((v - lo) / (hi - lo) * BINS);
+    return constrain(bin, 0, (int)BINS - 1);
+}
+
+float PercentileHistogram::valueFor(int bin) const {
+    float lo = HIST_RANGE[field_][0], hi = HIST_RANGE[field_][1];
+    float v = lo + (bin + 0.5f) * (hi - lo) / BINS; // Bin centre
+    return (field_ == QUERY_FIELD_LUX) ? powf(10.0f, v) - 1.0f : v;
+}
+
+void PercentileHistogram::add(float value) {
+    if (!bins_ || isnan(value)) return;
+    bins_[binFor(value)]++;
+    total_++;
+}
+
+float PercentileHistogram::percentile(uint8_t p) const {
+    if (!bins_ || total_ == 0) return NAN;
+    // Nearest-rank: smallest bin whose cumulative count reaches p% of the samples
+    uint64_t rank = ((uint64_t)total_ * p + 99) / 100;
+    if (rank == 0) rank = 1;
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < BINS; ++i) {
+        cumulative += bins_[i];
+        if (cumulative >= rank) return valueFor(i);
+    }
+    return valueFor(BINS - 1);
+}
+
+// --- QueryResultCache ---
+
+QueryResultCache::QueryResultCache() : tick_(0) {
+    for (size_t i = 0; i < ENTRIES; ++i) {
+        entries_[i].key[0] = '\0';
+        entries_[i].lastUse = 0;
+    }
+}
+
+bool QueryResultCache::get(const char* key, String& result) {
+    for (size_t i = 0; i < ENTRIES; ++i) {
+        if (entries_[i].lastUse != 0 && strcmp(entries_[i].key, key) == 0) {
+            entries_[i].lastUse = ++tick_;
+            result = entries_[i].result;
+            return true;
+        }
+    }
+    return false;
+}
+
+void QueryResultCache::put(const char* key, const String& result) {
+    if (strlen(key) >= MAX_KEY || result.length() > MAX_RESULT_BYTES) return;
+    size_t victim = 0;
+    for (size_t i = 0; i < ENTRIES; ++i) {
+        if (entries_[i].lastUse == 0) { victim = i; break; }
+        if (entries_[i].lastUse < entries_[victim].lastUse) victim = i;
+    }
+    strcpy(entries_[victim].key, key);
+    entries_[victim].result = result;
+    entries_[victim].lastUse = ++tick_;
+}
@@ -0,0 +1,156 @@
+#ifndef HISTORY_QUERY_H
+#define HISTORY_QUERY_H
+
+#include <Arduino.h>
+#include <time.h>
+#include "EnvironmentData.h"
+
+/**
+ * 历史数据聚合查询 (History aggregation queries)
+ *
+ * 查询 = 时间范围 [from, to) + 桶宽 + 字段 + 聚合函数, 例如
+ *   "from=-3d bucket=1h fields=db agg=leq,max"     最近 3 天每小时的 LAeq 和最大值
+ *   "from=1717171200 to=1717776000 bucket=1d fields=temp agg=max"
+ * 桶从 from 开始对齐 (按本地日统计时请传入本地零点)。
+ *
+ * 执行 (DataManager::runQuery): 对齐到整点且已封存的小时直接读取小时汇总 (HourRollup),
+ * 只有桶边缘的非整点部分、尚未封存的当前小时以及百分位数才扫描原始记录。
+ * 本文件只包含与存储无关的部分: 查询解析、可合并的统计量、汇总记录编码、百分位直方图和结果缓存。
+ */
+
+enum QueryField : uint8_t {
+    QUERY_FIELD_DB = 0,
+    QUERY_FIELD_TEMP,
+    QUERY_FIELD_HUM,
+    QUERY_FIELD_LUX,
+    QUERY_FIELD_COUNT
+};
+
+enum QueryAgg : uint8_t {
+    QUERY_AGG_AVG = 0,
+    QUERY_AGG_MIN,
+    QUERY_AGG_MAX,
+    QUERY_AGG_COUNT,
+    QUERY_AGG_LEQ,        // Energy average, 10*log10(mean(10^(L/10))); dB only
+    QUERY_AGG_PERCENTILE  // Needs raw samples (QueryColumn::percentile)
+};
+
+// Mergeable per-field statistics: what an hourly rollup stores, and what a bucket accumulates.
+struct FieldStats {
+    uint32_t count;
+    double sum;
+    double energy;  // Sum of 10^(x/10), only maintained for dB
+    float min;
+    float max;
+
+    FieldStats() { reset(); }
+    void reset();
+    void add(float value, bool trackEnergy);
+    void merge(const FieldStats& other);
+};
+
+// Summary of one clock hour, appended to the rollup file when the hour is complete.
+struct HourRollup {
+    uint32_t hourStart; // Epoch seconds, multiple of 3600
+    uint32_t lastSeq;   // Highest raw record seq included (rebuild resumes after it)
+    FieldStats fields[QUERY_FIELD_COUNT];
+
+    void reset(uint32_t hour);
+    void add(const EnvironmentData& record);
+
+    // Fixed-size little-endian on-disk layout, so the file can be binary searched
+    static const size_t RECORD_SIZE = 8 + QUERY_FIELD_COUNT * (4 + 8 + 8 + 4 + 4);
+    void encode(uint8_t* out) const;
+    void decode(const uint8_t* in);
+};
+
+struct QueryColumn {
+    QueryField field;
+    QueryAgg agg;
+    uint8_t percentile; // 1..99 for QUERY_AGG_PERCENTILE
+};
+
+struct QuerySpec {
+    static const size_t MAX_COLUMNS = 12;
+    static const size_t MAX_CELLS = 4096;        // buckets * columns, bounds the response size
+    static const uint32_t MIN_BUCKET_SECONDS = 60;
+
+    time_t from;
+    time_t to;
+    uint32_t bucketSeconds;
+    bool fromRelative;      // 'from' was given relative to now; finalize() snaps it to a bucket
+    uint8_t fieldMask;      // Bit per QueryField
+    uint8_t aggCount;
+    QueryAgg aggs[6];
+    uint8_t percentiles[6]; // Parallel to aggs
+    QueryColumn columns[MAX_COLUMNS];
+    uint8_t columnCount;
+
+    QuerySpec();
+
+    // Applies one "key=value" parameter (from, to, bucket, fields, agg). Relative times
+    // ("-3d", "now") are resolved against 'now'. Returns false with a message on error.
+    bool setParam(const char* key, const char* value, time_t now, bool nowValid,
+                  char* err, size_t errLen);
+    // Parses "key=value key=value ..." (the TCP QUERY arguments).
+    bool parse(const char* args, time_t now, bool nowValid, char* err, size_t errLen);
+    // Validates and expands fields x aggs into columns. Call after all parameters are set;
+    // a missing 'to' means now. Defaults: fields=db, agg=avg, bucket=1h.
+    // A relative 'from' is rounded down to the bucket (or hour) boundary.
+    bool finalize(time_t now, bool nowValid, char* err, size_t errLen);
+
+    uint32_t bucketCount() const;
+    bool needsRawSamples() const;       // Any percentile column
+    bool fieldHasPercentile(QueryField f) const;
+    // Canonical text form of the query (absolute times); used as cache key.
+    size_t canonical(char* out, size_t outLen) const;
+};
+
+// Fixed-resolution histogram for percentiles. dB/temperature/humidity use linear bins
+// over the sensor range (~0.1-0.16 unit resolution), lux uses log-spaced bins.
+class PercentileHistogram {
+public:
+    static const size_t BINS = 1024;
+
+    PercentileHistogram();
+    ~PercentileHistogram();
+    bool begin(QueryField field); // Allocates the bins; false if out of memory
+    void reset();
+    void add(float value);
+    float percentile(uint8_t p) const; // NAN if empty
+
+private:
+    QueryField field_;
+    uint32_t* bins_;
+    uint32_t total_;
+
+    int binFor(float value) const;
+    float valueFor(int bin) const;
+};
+
+// Small LRU cache of rendered results for queries whose range is entirely in the past
+// (immutable: every hour in it is already rolled up).
+class QueryResultCache {
+public:
+    static const size_t ENTRIES = 4;
+    static const size_t MAX_KEY = 112;
+    static const size_t MAX_RESULT_BYTES = 8192; // Larger results are not cached
+
+    QueryResultCache();
+    bool get(const char* key, String& result);
+    void put(const char* key, const String& result);
+
+private:
+    struct Entry {
+        char key[MAX_KEY];
+        String result;
+        uint32_t lastUse; // 0 = empty
+    };
+    Entry entries_[ENTRIES];
+    uint32_t tick_;
+};
+
+const char* queryFieldName(QueryField field);
+float queryFieldValue(const EnvironmentData& record, QueryField field);
+
+#endif // HISTORY_QUERY_H
@@ -1,6 +1,15 @@
 #include "i2s_mic_manager.h"
 #include <math.h>
 #include <cmath> // Include for isnan
+#include "metrics.h"
+#include "heap_tracker.h"
+
+// Called from the I2S ISR when the DMA receive queue overflows (samples lost
+// because nobody read the channel in time).
+static bool IRAM_ATTR onI2SRecvOverflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* userCtx) {
+    systemMetrics.i2sOverruns.inc();
+    return false; // No higher-priority task woken
+}
 
 I2SMicManager::I2SMicManager(uint32_t sample_rate, uint8_t ws_pin, uint8_t sd_pin, uint8_t sck_pin, i2s_port_t port_num) :
     sample_rate_(sample_rate),
@@ -8,11 +17,22 @@ I2SMicManager::I2SMicManager(uint32_t sample_rate, uint8_t ws_pin, uint8_t sd_pi
     sd_pin_(sd_pin),
     sck_pin_(sck_pin),
     port_num_(port_num),
-    initialized_(false)
+    initialized_(false),
+    captureTask_(nullptr),
+    spectrum_(sample_rate),
+    fastMs_(0.0f),
+    blockCount_(0),
+    levelSumSq_(0.0),
+    levelSamples_(0),
+    pcmHead_(0),
+    pcmTail_(0)
 {
+    portMUX_INITIALIZE(&mux_);
+    memset(&snapshot_, 0, sizeof(snapshot_));
 }
 
 bool I2SMicManager::begin() {
+    HeapScope heapScope(HEAP_TAG_AUDIO);
     if (initialized_) {
         return true;
     }
@@ -63,6 +83,14 @@ bool I2SMicManager::begin() {
         return false;
     }
     
+    // Overflow callback must be registered before the channel is enabled
+    i2s_event_callbacks_t callbacks = {};
+    callbacks.on_recv_q_ovf = onI2SRecvOverflow;
+    err = i2s_channel_register_event_callback(rx_handle_, &callbacks, this);
+    if (err != ESP_OK) {
+        Serial.printf("WARN: I2S溢出回调注册失败: %s\n", esp_err_to_name(err));
+    }
+
     err = i2s_channel_enable(rx_handle_);
     if (err != ESP_OK) {
         Serial.printf("I2S通道启用失败: %s\n", esp_err_to_name(err));
@@ -82,6 +110,20 @@ float I2SMicManager::readNoiseLevel(int timeout_ms) {
         return NAN;
     }
 
+    if (captureTask_) {
+        // Energy average of everything captured since the previous call; never blocks
+        portENTER_CRITICAL(&mux_);
+        double sumSq = levelSumSq_;
+        uint32_t count = levelSamples_;
+        levelSumSq_ = 0.0;
+        levelSamples_ = 0;
+        portEXIT_CRITICAL(&mux_);
+        if (count == 0) {
+            return NAN;
+        }
+        return DataValidator::validateDecibels(rmsToDb(sqrt(sumSq / count)));
+    }
+
     size_t bytes_read = 0;
     esp_err_t result = i2s_channel_read(rx_handle_, samples_, sizeof(samples_), &bytes_read, timeout_ms);
 
@@ -105,12 +147,19 @@ float I2SMicManager::readNoiseLevel(int timeout_ms) {
     validSamples = min(validSamples, BUFFER_SIZE);
 
     double rms = calculateRMS(samples_, validSamples);
-
-    if (rms <= 0 || isnan(rms)) { // 也检查rms是否为NaN
-        // Serial.println("DBG: Calculated RMS is zero or invalid.");
+    float db = rmsToDb(rms);
+    if (isnan(db)) { // rms 为 0 或无效
         return NAN;
     }
 
+    // processNoiseLevel 现在也能处理 NaN 输入，但这里我们已经保证了 db 不是 NaN
+    return DataValidator::validateDecibels(db);
+}
+
+float I2SMicManager::rmsToDb(double rms) {
+    if (rms <= 0 || isnan(rms)) {
+        return NAN;
+    }
     // 计算分贝值 (rms > 0 and not NaN here)
     float db = 20.0f * log10f(rms);
 
@@ -118,10 +167,7 @@ float I2SMicManager::readNoiseLevel(int timeout_ms) {
     if (db < NOISE_FLOOR) {
         db = NOISE_FLOOR;
     }
-    db = (db - NOISE_FLOOR) * CALIBRATION_FACTOR + OFFSET_DB;
-
-    // processNoiseLevel 现在也能处理 NaN 输入，但这里我们已经保证了 db 不是 NaN
-    return DataValidator::validateDecibels(db);
+    return (db - NOISE_FLOOR) * CALIBRATION_FACTOR + OFFSET_DB;
 }
 
 double I2SMicManager::calculateRMS(const int32_t* samples, size_t count) {
@@ -158,6 +204,10 @@ double I2SMicManager::calculateRMS(const int32_t* samples, size_t count) {
 }
 
 void I2SMicManager::end() {
+    if (captureTask_) {
+        vTaskDelete(captureTask_);
+        captureTask_ = nullptr;
+    }
     if (initialized_) {
         i2s_channel_disable(rx_handle_);
         i2s_del_channel(rx_handle_);
@@ -184,4 +234,124 @@ size_t I2SMicManager::readRawSamples(int32_t* buffer, size_t maxSamples, int tim
 
     // Return number of samples read
     return bytes_read / sizeof(int32_t);
-} 
\ No newline at end of file
+} 
+// --- Background capture ---
+
+bool I2SMicManager::startCapture() {
+    HeapScope heapScope(HEAP_TAG_AUDIO);
+    static_assert(BUFFER_SIZE == SpectrumAnalyzer::N, "one capture block feeds one FFT");
+    if (!initialized_) {
+        return false;
+    }
+    if (captureTask_) {
+        return true;
+    }
+    // Core 0, above the loop task: DMA holds ~90 ms of audio, so WiFi preempting us is harmless
+    if (xTaskCreatePinnedToCore(captureTaskEntry, "mic_capture", CAPTURE_STACK_SIZE, this, 5, &captureTask_, 0) != pdPASS) {
+        captureTask_ = nullptr;
+        Serial.println("[I2SMicManager] Failed to create capture task");
+        return false;
+    }
+    Serial.println("[I2SMicManager] Capture task started");
+    return true;
+}
+
+void I2SMicManager::captureTaskEntry(void* param) {
+    static_cast<I2SMicManager*>(param)->captureLoop();
+}
+
+void I2SMicManager::captureLoop() {
+    for (;;) {
+        size_t bytes_read = 0;
+        esp_err_t result = i2s_channel_read(rx_handle_, samples_, sizeof(samples_), &bytes_read, 100);
+        if (result != ESP_OK || bytes_read == 0) {
+            if (result != ESP_ERR_TIMEOUT) {
+                Serial.printf("ERR: I2S capture read failed: %s\n", esp_err_to_name(result));
+                vTaskDelay(pdMS_TO_TICKS(100));
+            }
+            continue;
+        }
+        processBlock(min(bytes_read / sizeof(int32_t), BUFFER_SIZE));
+    }
+}
+
+void I2SMicManager::processBlock(size_t count) {
+    // Same conversion as calculateRMS: sign-extend the 24-bit sample, remove the block DC
+    int64_t dc_sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        int32_t sample = samples_[i] << 8;
+        sample >>= 8;
+        dc_sum += sample;
+    }
+    float dc_offset = (float)dc_sum / count;
+
+    uint32_t head = pcmHead_.load(std::memory_order_relaxed);
+    float sumSq = 0.0f;
+    float peak = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        int32_t sample = samples_[i] << 8;
+        pcmRing_[(head + i) % PCM_RING_SAMPLES] = (int16_t)(sample >> 16); // Upper 16 bits, as streamed before
+        sample >>= 8;
+        float v = ((float)sample - dc_offset) / 8388608.0f;
+        block_[i] = v;
+        sumSq += v * v;
+        peak = max(peak, fabsf(v));
+    }
+    pcmHead_.store(head + count, std::memory_order_release);
+
+    // Fast time weighting: one-pole smoothing of the mean square, block by block
+    float blockSeconds = (float)count / sample_rate_;
+    fastMs_ += (sumSq / count - fastMs_) * (1.0f - expf(-blockSeconds / FAST_TAU_S));
+    float fastDb = rmsToDb(sqrtf(fastMs_));
+    float peakDb = rmsToDb(peak);
+
+    // Spectrum every other block (~31 Hz at 16 kHz), only for full blocks
+    bool spectrumDue = (++blockCount_ & 1) == 0 && count == SpectrumAnalyzer::N;
+    float bandDb[SpectrumAnalyzer::BANDS];
+    if (spectrumDue) {
+        float bandPower[SpectrumAnalyzer::BANDS];
+        spectrum_.compute(block_, bandPower);
+        for (size_t b = 0; b < SpectrumAnalyzer::BANDS; b++) {
+            bandDb[b] = rmsToDb(sqrtf(bandPower[b]));
+        }
+    }
+
+    portENTER_CRITICAL(&mux_);
+    levelSumSq_ += sumSq;
+    levelSamples_ += count;
+    snapshot_.fastDb = fastDb;
+    snapshot_.peakDb = peakDb;
+    if (spectrumDue) {
+        memcpy(snapshot_.bandDb, bandDb, sizeof(bandDb));
+        snapshot_.frame++;
+    }
+    portEXIT_CRITICAL(&mux_);
+}
+
+void I2SMicManager::getLevelSnapshot(LevelSnapshot& out) const {
+    portENTER_CRITICAL(&mux_);
+    out = snapshot_;
+    portEXIT_CRITICAL(&mux_);
+}
+
+size_t I2SMicManager::pcmAvailable() const {
+    uint32_t avail = pcmHead_.load(std::memory_order_acquire) - pcmTail_;
+    return min((size_t)avail, PCM_RING_SAMPLES - BUFFER_SIZE);
+}
+
+size_t I2SMicManager::readPcmSamples(int16_t* out, size_t count) {
+    uint32_t head = pcmHead_.load(std::memory_order_acquire);
+    // Keep one block of distance from the writer: older audio has been (or is being) overwritten
+    const uint32_t keep = PCM_RING_SAMPLES - BUFFER_SIZE;
+    if (head - pcmTail_ > keep) {
+        pcmTail_ = head - keep;
+    }
+    if (out == nullptr || head - pcmTail_ < count) {
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        out[i] = pcmRing_[(pcmTail_ + i) % PCM_RING_SAMPLES];
+    }
+    pcmTail_ += count;
+    return count;
+}
@@ -4,9 +4,32 @@
 #include <Arduino.h>
 #include "driver/i2s_std.h"
 #include "driver/i2s_common.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <atomic>
 #include "data_validator.h"
+#include "spectrum_analyzer.h"
 
+/**
+ * I2S 麦克风 (INMP441)
+ *
+ * begin() 之后可调用 startCapture() 启动后台采集任务: 任务持续读取 I2S (每块 256 个样本,
+ * 16 ms), 在一处完成所有音频处理, 其他模块只读取结果, 不再直接读 I2S:
+ * - Fast 时间计权声级 (τ = 125 ms) 和当前块的峰值, 以及每两块一次的 16 频带频谱 (~31 Hz),
+ *   通过 getLevelSnapshot() 读取 (实时声级屏);
+ * - readNoiseLevel() 返回自上次调用以来所有样本的能量平均声级, 立即返回不再阻塞;
+ * - 16 位 PCM 写入环形缓冲区, 由 readPcmSamples() 取走 (WebSocket 音频流)。
+ * 未启动采集任务时 readNoiseLevel()/readRawSamples() 保持原来的阻塞读取行为。
+ */
 class I2SMicManager {
+public:
+    struct LevelSnapshot {
+        float fastDb;   // Fast (125 ms) time-weighted level, same calibration as readNoiseLevel()
+        float peakDb;   // Sample peak of the latest block
+        float bandDb[SpectrumAnalyzer::BANDS];
+        uint32_t frame; // Increments with every spectrum update (0 = none yet)
+    };
+
 private:
     // Match initialization order in constructor
     uint32_t sample_rate_;
@@ -26,6 +49,23 @@ private:
     static constexpr double CALIBRATION_FACTOR = 0.70;  // 继续降低增益
     static constexpr double OFFSET_DB = 31.0;  // 继续提高偏移值以降低整体读数
     static constexpr double NOISE_FLOOR = -75.0;  // 保持噪声基准不变
+
+    // Background capture (startCapture)
+    static constexpr float FAST_TAU_S = 0.125f;      // IEC 61672 "Fast" time constant
+    static const size_t PCM_RING_SAMPLES = 4096;     // 256 ms of 16-bit audio for the WebSocket
+    static const uint32_t CAPTURE_STACK_SIZE = 4096;
+    TaskHandle_t captureTask_;
+    mutable portMUX_TYPE mux_;
+    SpectrumAnalyzer spectrum_;
+    float block_[BUFFER_SIZE];      // DC-free normalised samples of the current block (task only)
+    float fastMs_;                  // Fast-weighted mean square (task only)
+    uint32_t blockCount_;           // Task only
+    LevelSnapshot snapshot_;        // Guarded by mux_
+    double levelSumSq_;             // Since the last readNoiseLevel(), guarded by mux_
+    uint32_t levelSamples_;
+    int16_t pcmRing_[PCM_RING_SAMPLES];
+    std::atomic<uint32_t> pcmHead_; // Total samples written (task)
+    uint32_t pcmTail_;              // Total samples consumed (reader)
     
 public:
     I2SMicManager(uint32_t sample_rate = 16000, 
@@ -43,10 +83,25 @@ public:
     // Returns the number of samples read (not bytes).
     // Returns 0 on failure or timeout.
     size_t readRawSamples(int32_t* buffer, size_t maxSamples, int timeout_ms);
-    
+
+    // Starts the capture task (call after begin()). Returns false if it could not be created.
+    bool startCapture();
+    bool isCapturing() const { return captureTask_ != nullptr; }
+    void getLevelSnapshot(LevelSnapshot& out) const;
+    const SpectrumAnalyzer& spectrum() const { return spectrum_; }
+    // PCM ring (single reader): samples waiting, and a non-blocking read of exactly
+    // count samples (returns 0 if fewer are buffered). Audio older than the ring is dropped.
+    size_t pcmAvailable() const;
+    size_t readPcmSamples(int16_t* out, size_t count);
+
 private:
     // 私有辅助函数
     double calculateRMS(const int32_t* samples, size_t count);
+    static float rmsToDb(double rms);   // Calibrated dB; NAN for rms <= 0
+
+    static void captureTaskEntry(void* param);
+    void captureLoop();
+    void processBlock(size_t count);
 };
 
 #endif // I2S_MIC_MANAGER_H 
\ No newline at end of file
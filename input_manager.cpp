@@ -2,114 +2,234 @@
 #include "ui_manager.h"
 #include "data_manager.h"
 #include "communication_manager.h" // Include full header for CommManager methods
-#include <WiFi.h> // Needed for WiFi.status() - Can be removed now
-#include <time.h> // Needed for initTime() simulation - Can be removed now
+#include "metrics.h"
+#include "driver/gpio.h"
+#include <esp_timer.h>
 
 // Constructor
 InputManager::InputManager(UIManager& uiMgr, DataManager& dataMgr, CommunicationManager& commMgr) :
+    edgeHead_(0),
+    edgeTail_(0),
+    task_(nullptr),
+    events_(nullptr),
     uiManager_(uiMgr),
     dataManager_(dataMgr),
     commManager_(commMgr) // Store reference
 {
     // Initialize button states
-    for (int i = 0; i < 5; ++i) {
-        lastBtnState[i] = HIGH; // Assume buttons are pull-up
-        btnPressTime[i] = 0;
-        btnLongPressTriggered[i] = false;
+    for (int i = 0; i < BUTTON_COUNT; ++i) {
+        buttons_[i] = ButtonState();
     }
 }
 
-// Initialize button pins
+// Initialize button pins, the decoder task and the edge interrupts
 void InputManager::begin() {
-    pinMode(BTN1_PIN, INPUT_PULLUP);
-    pinMode(BTN2_PIN, INPUT_PULLUP);
-    pinMode(BTN3_PIN, INPUT_PULLUP);
-    pinMode(BTN4_PIN, INPUT_PULLUP);
-    pinMode(BTN5_PIN, INPUT_PULLUP);
-    Serial.println("[InputManager] Button pins initialized.");
+    const uint8_t pins[BUTTON_COUNT] = {BTN1_PIN, BTN2_PIN, BTN3_PIN, BTN4_PIN, BTN5_PIN};
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    for (int i = 0; i < BUTTON_COUNT; ++i) {
+        pinMode(pins[i], INPUT_PULLUP);
+        pinContext_[i] = {this, (uint8_t)i, pins[i]};
+        ButtonState& b = buttons_[i];
+        b.pressed = digitalRead(pins[i]) == LOW;
+        // A button held through boot does nothing until it has been released
+        b.pressUs = now;
+        b.longFired = b.pressed;
+        b.repeated = b.pressed;
+        b.bootHeld = b.pressed;
+    }
+
+    events_ = xQueueCreate(EVENT_QUEUE_LENGTH, sizeof(Event));
+    // Core 1 above loop(): decoding preempts a busy loop instead of waiting for it
+    if (!events_ || xTaskCreatePinnedToCore(taskEntry, "input", TASK_STACK_SIZE, this, 4, &task_, 1) != pdPASS) {
+        task_ = nullptr;
+        Serial.println("[InputManager] Failed to start the decoder task, buttons disabled");
+        return;
+    }
+    for (int i = 0; i < BUTTON_COUNT; ++i) {
+        attachInterruptArg(pins[i], onEdge, &pinContext_[i], CHANGE);
+    }
+    Serial.println("[InputManager] Button interrupts initialized.");
 }
 
-// Update function - checks button states and handles events
+// Runs the actions of the events decoded since the last call
 void InputManager::update() {
-    unsigned long currentTime = millis();
-    int btnPins[5] = {BTN1_PIN, BTN2_PIN, BTN3_PIN, BTN4_PIN, BTN5_PIN};
+    if (!events_) return;
+    Event event;
+    while (xQueueReceive(events_, &event, 0) == pdTRUE) {
+        systemMetrics.inputLatencyUs.observe((uint32_t)esp_timer_get_time() - event.us);
+        dispatch(event);
+    }
+}
 
-    for (int i = 0; i < 5; ++i) {
-        bool currentState = digitalRead(btnPins[i]);
+// GPIO interrupt (any edge): timestamp the new level and wake the decoder
+void IRAM_ATTR InputManager::onEdge(void* arg) {
+    PinContext* ctx = static_cast<PinContext*>(arg);
+    InputManager* self = ctx->self;
+    uint32_t head = self->edgeHead_.load(std::memory_order_relaxed);
+    if (head - self->edgeTail_.load(std::memory_order_acquire) < EDGE_RING_SIZE) {
+        Edge& edge = self->edges_[head & (EDGE_RING_SIZE - 1)];
+        edge.us = (uint32_t)esp_timer_get_time();
+        edge.button = ctx->button;
+        edge.level = gpio_get_level((gpio_num_t)ctx->pin);
+        self->edgeHead_.store(head + 1, std::memory_order_release);
+    } else {
+        // Ring full: the debounce window end re-reads the pin, so only timing is lost
+        systemMetrics.inputEventsDropped.inc();
+    }
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(self->task_, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
 
-        // --- Edge Detection and Action --- //
+void InputManager::taskEntry(void* param) {
+    static_cast<InputManager*>(param)->decodeLoop();
+}
 
-        // Button Pressed (Falling Edge: HIGH -> LOW)
-        if (currentState == LOW && lastBtnState[i] == HIGH) {
-            btnPressTime[i] = currentTime;
-            btnLongPressTriggered[i] = false;
-            // Serial.printf("[InputManager] Button %d Down\n", i + 1);
+void InputManager::decodeLoop() {
+    TickType_t wait = portMAX_DELAY;
+    for (;;) {
+        // Woken by an edge, or by the nearest debounce / long-press / repeat deadline
+        ulTaskNotifyTake(pdTRUE, wait);
+        uint32_t tail = edgeTail_.load(std::memory_order_relaxed);
+        uint32_t head = edgeHead_.load(std::memory_order_acquire);
+        while (tail != head) {
+            handleEdge(edges_[tail & (EDGE_RING_SIZE - 1)]);
+            edgeTail_.store(++tail, std::memory_order_release);
         }
-        // Button Released (Rising Edge: LOW -> HIGH)
-        else if (currentState == HIGH && lastBtnState[i] == LOW) {
-            // Check if it was a short press (long press didn't trigger)
-            if (!btnLongPressTriggered[i]) {
-                // --- Short Press Actions --- //
-                // Serial.printf("[InputManager] Button %d Short Press\n", i + 1);
-                switch (i) {
-                    case 0: // BTN1 (Up)
-                        uiManager_.handleInput(BTN1_PIN); // Pass original pin ID to UIManager
-                        break;
-                    case 1: // BTN2 (Right - LED Mode)
-                        {
-                            uint8_t nextMode = (uiManager_.getCurrentLedMode() + 1) % 4;
-                            uiManager_.setLedMode(nextMode);
-                            // updateLEDs(); // LED update should happen elsewhere based on UIManager state
-                            Serial.printf("[InputManager] Button 2: Set LED Mode to %d\n", nextMode);
-                        }
-                        break;
-                    case 2: // BTN3 (Down)
-                        uiManager_.handleInput(BTN3_PIN); // Pass original pin ID to UIManager
-                        break;
-                    case 3: // BTN4 (Left - Save Data)
-                        dataManager_.saveDataToSd(); // Call DataManager method
-                        // uiManager_.forceRedraw(); // Let DataManager/UIManager handle redraw if needed
-                        break;
-                    case 4: // BTN5 (Center - Manual Refresh)
-                        dataManager_.recordCurrentData(); // Call DataManager method
-                        // uiManager_.forceRedraw(); // Let DataManager/UIManager handle redraw if needed
-                        break;
-                }
+        wait = runTimers((uint32_t)esp_timer_get_time());
+    }
+}
+
+void InputManager::handleEdge(const Edge& edge) {
+    ButtonState& b = buttons_[edge.button];
+    if (b.lockout && edge.us - b.lockoutUs < DEBOUNCE_US) {
+        return; // Contact bounce; the end of the window re-reads the pin
+    }
+    b.lockout = false;
+    bool pressed = edge.level == LOW;
+    if (pressed != b.pressed) {
+        setPressed(edge.button, pressed, edge.us);
+    }
+}
+
+// Accepts a debounced change (the first edge of a burst) and opens the debounce window
+void InputManager::setPressed(uint8_t button, bool pressed, uint32_t us) {
+    ButtonState& b = buttons_[button];
+    b.pressed = pressed;
+    b.lockout = true;
+    b.lockoutUs = us;
+    if (pressed) {
+        b.pressUs = us;
+        b.longFired = false;
+        b.repeated = false;
+        b.nextRepeatUs = us + REPEAT_DELAY_MS * 1000;
+    } else if (b.bootHeld) {
+        b.bootHeld = false; // Released at last; the next press counts
+    } else if (!b.longFired && !b.repeated) {
+        emit(button, EVENT_PRESS, us);
+    }
+}
+
+TickType_t InputManager::runTimers(uint32_t now) {
+    uint32_t nextUs = UINT32_MAX;
+    for (uint8_t i = 0; i < BUTTON_COUNT; ++i) {
+        ButtonState& b = buttons_[i];
+        if (b.lockout && now - b.lockoutUs >= DEBOUNCE_US) {
+            b.lockout = false;
+            // Settled: pick up a change whose edge fell inside the window
+            bool pressed = gpio_get_level((gpio_num_t)pinContext_[i].pin) == LOW;
+            if (pressed != b.pressed) {
+                setPressed(i, pressed, now);
             }
-            btnPressTime[i] = 0; // Reset press time
-            // Serial.printf("[InputManager] Button %d Up\n", i + 1);
         }
-        // Button Held Down (LOW -> LOW)
-        else if (currentState == LOW && lastBtnState[i] == LOW) {
-            // Check for long press trigger
-            if (!btnLongPressTriggered[i] && btnPressTime[i] != 0 && (currentTime - btnPressTime[i] >= LONG_PRESS_MS)) {
-                 // --- Long Press Actions --- //
-                 Serial.printf("[InputManager] Button %d Long Press\n", i + 1);
-                 btnLongPressTriggered[i] = true; // Mark as triggered
-
-                 switch (i) {
-                     case 0: // BTN1 (Up) - No long press action defined
-                         break;
-                     case 1: // BTN2 (Right) - No long press action defined
-                         break;
-                     case 2: // BTN3 (Down) - No long press action defined
-                         break;
-                     case 3: // BTN4 (Left - Reconnect WiFi)
-                         // Call CommunicationManager method
-                         commManager_.reconnectWiFi();
-                         break;
-                     case 4: // BTN5 (Center - Restart)
-                         Serial.println("[InputManager] Restarting via Button 5 long press...");
-                         Serial.flush();
-                         delay(100);
-                         ESP.restart();
-                         break;
-                 }
+        if (b.lockout) {
+            nextUs = min(nextUs, DEBOUNCE_US - (now - b.lockoutUs));
+        }
+        if (!b.pressed || b.bootHeld) continue;
+
+        if ((LONG_PRESS_BUTTONS >> i) & 1 && !b.longFired) {
+            uint32_t held = now - b.pressUs;
+            if (held >= LONG_PRESS_MS * 1000) {
+                b.longFired = true;
+                emit(i, EVENT_LONG, now);
+            } else {
+                nextUs = min(nextUs, (uint32_t)(LONG_PRESS_MS * 1000 - held));
             }
         }
+        if ((REPEAT_BUTTONS >> i) & 1) {
+            if ((int32_t)(b.nextRepeatUs - now) <= 0) {
+                b.repeated = true;
+                b.nextRepeatUs = now + REPEAT_MS * 1000; // No catching up after a stall
+                emit(i, EVENT_REPEAT, now);
+            }
+            nextUs = min(nextUs, b.nextRepeatUs - now);
+        }
+    }
+    if (nextUs == UINT32_MAX) {
+        return portMAX_DELAY;
+    }
+    return pdMS_TO_TICKS(nextUs / 1000) + 1; // Round up: never wake before the deadline
+}
+
+void InputManager::emit(uint8_t button, EventType type, uint32_t us) {
+    if (button == 4 && type == EVENT_LONG) {
+        // BTN5 long press restarts from here, so it works even when loop() is stuck
+        Serial.println("[InputManager] Restarting via Button 5 long press...");
+        Serial.flush();
+        delay(100);
+        ESP.restart();
+    }
+    Event event = {us, button, type};
+    if (xQueueSend(events_, &event, 0) != pdTRUE) {
+        systemMetrics.inputEventsDropped.inc(); // loop() has not drained the queue for a while
+    }
+}
+
+// Button actions, run on the main loop
+void InputManager::dispatch(const Event& event) {
+    switch (event.type) {
+        case EVENT_PRESS:
+        case EVENT_REPEAT:
+            // --- Short Press Actions (Up / Down also repeat while held) --- //
+            // Serial.printf("[InputManager] Button %d Short Press\n", event.button + 1);
+            switch (event.button) {
+                case 0: // BTN1 (Up)
+                    uiManager_.handleInput(BTN1_PIN); // Pass original pin ID to UIManager
+                    break;
+                case 1: // BTN2 (Right - LED Mode)
+                    {
+                        uint8_t nextMode = (uiManager_.getCurrentLedMode() + 1) % LED_MODE_COUNT;
+                        uiManager_.setLedMode(nextMode);
+                        Serial.printf("[InputManager] Button 2: Set LED Mode to %d\n", nextMode);
+                    }
+                    break;
+                case 2: // BTN3 (Down)
+                    uiManager_.handleInput(BTN3_PIN); // Pass original pin ID to UIManager
+                    break;
+                case 3: // BTN4 (Left - Save Data, unless the active screen uses it)
+                    if (uiManager_.handleInput(BTN4_PIN)) break;
+                    dataManager_.saveDataToSd(); // Call DataManager method
+                    break;
+                case 4: // BTN5 (Center - Manual Refresh, unless the active screen uses it)
+                    if (uiManager_.handleInput(BTN5_PIN)) break;
+                    dataManager_.recordCurrentData(); // Call DataManager method
+                    break;
+            }
+            break;
 
-        // Update last state
-        lastBtnState[i] = currentState;
+        case EVENT_LONG:
+            // --- Long Press Actions --- //
+            Serial.printf("[InputManager] Button %d Long Press\n", event.button + 1);
+            switch (event.button) {
+                case 3: // BTN4 (Left - Reconnect WiFi)
+                    // Call CommunicationManager method
+                    commManager_.reconnectWiFi();
+                    break;
+                // BTN5 (Center - Restart) is handled by the decoder task
+            }
+            break;
     }
 }
 
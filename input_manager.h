@@ -2,39 +2,113 @@
 #define INPUT_MANAGER_H
 
 #include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <atomic>
 
 // Forward declarations to avoid circular includes
 class UIManager;
 class DataManager;
 class CommunicationManager; // Forward declare if needed for WiFi reconnect
 
+/**
+ * 按键输入 (5 个按键, 低电平有效)
+ *
+ * 每个按键引脚的电平变化触发 GPIO 中断, 中断只把 (按键, 电平, 时间戳) 写入无锁单生产者/
+ * 单消费者环形队列并唤醒解码任务, 不再在主循环中轮询 digitalRead。
+ * 解码任务按时间戳去抖 (第一个边沿立即生效, 随后 DEBOUNCE_US 内的抖动忽略, 窗口结束时
+ * 读一次引脚校正), 并在任务中计时长按和自动重复, 生成的事件放入 FreeRTOS 队列;
+ * 主循环的 update() 只取出事件并执行动作。主循环被 SD 保存或 WiFi 重连阻塞时按键不会丢失,
+ * 事件在主循环恢复后按顺序处理; BTN5 长按重启直接在解码任务中执行。
+ */
 class InputManager {
 public:
     // Constructor takes pointers/references to other managers it needs to interact with
     InputManager(UIManager& uiMgr, DataManager& dataMgr, CommunicationManager& commMgr);
 
-    void begin(); // Initialize button pins
-    void update(); // Call this in the main loop to check buttons
+    void begin(); // Initialize button pins, interrupts and the decoder task
+    void update(); // Call this in the main loop to run the decoded button events
 
 private:
+    enum EventType : uint8_t {
+        EVENT_PRESS,  // Released before a long press / repeat
+        EVENT_LONG,   // Held for LONG_PRESS_MS (buttons with a long-press action)
+        EVENT_REPEAT  // Held past REPEAT_DELAY_MS, then every REPEAT_MS (buttons without one)
+    };
+
+    struct Edge {
+        uint32_t us;
+        uint8_t button;
+        uint8_t level;
+    };
+
+    struct Event {
+        uint32_t us;        // Edge (or timer) time the event was decoded from
+        uint8_t button;
+        EventType type;
+    };
+
+    // Decoder state of one button (task only)
+    struct ButtonState {
+        bool pressed;       // Debounced state
+        bool lockout;       // Inside the debounce window after an accepted edge
+        uint32_t lockoutUs; // Start of the debounce window
+        uint32_t pressUs;
+        bool longFired;
+        bool repeated;
+        uint32_t nextRepeatUs;
+        bool bootHeld;      // Held since begin(): no events or timers until released
+    };
+
+    struct PinContext {
+        InputManager* self;
+        uint8_t button;
+        uint8_t pin;
+    };
+
     // Define button pins internally
     static const uint8_t BTN1_PIN = 2;  // Up
     static const uint8_t BTN2_PIN = 1;  // Right (LED Mode)
     static const uint8_t BTN3_PIN = 41; // Down
     static const uint8_t BTN4_PIN = 40; // Left (Save / WiFi Reconnect)
     static const uint8_t BTN5_PIN = 42; // Center (Manual Refresh / Restart)
-
-    // Button states
-    bool lastBtnState[5]; // Store last state for edge detection (0-4 corresponds to BTN1-5)
-    unsigned long btnPressTime[5]; // Store press start time for long press detection
-    bool btnLongPressTriggered[5]; // Flag to prevent multiple triggers
+    static const uint8_t BUTTON_COUNT = 5;
+    static const uint8_t LONG_PRESS_BUTTONS = 0x18; // BTN4, BTN5 (bit = button index)
+    static const uint8_t REPEAT_BUTTONS = 0x05;     // BTN1, BTN3 (Up / Down); BTN2 only has short presses
 
     static const unsigned long LONG_PRESS_MS = 1000; // 1 second
+    static const unsigned long REPEAT_DELAY_MS = 500;
+    static const unsigned long REPEAT_MS = 150;
+    static const uint32_t DEBOUNCE_US = 20000;
+    static const size_t EDGE_RING_SIZE = 32;        // Power of two
+    static const size_t EVENT_QUEUE_LENGTH = 16;
+    static const uint32_t TASK_STACK_SIZE = 3072;
+
+    // ISR -> decoder task
+    Edge edges_[EDGE_RING_SIZE];
+    std::atomic<uint32_t> edgeHead_; // Written by the ISRs (same core, same level: never nested)
+    std::atomic<uint32_t> edgeTail_; // Written by the decoder task
+    PinContext pinContext_[BUTTON_COUNT];
+    TaskHandle_t task_;
+
+    // Decoder task -> update()
+    QueueHandle_t events_;
+    ButtonState buttons_[BUTTON_COUNT];
 
     // References to other managers
     UIManager& uiManager_;
     DataManager& dataManager_;
     CommunicationManager& commManager_; // Store reference to CommManager
+
+    static void IRAM_ATTR onEdge(void* arg);
+    static void taskEntry(void* param);
+    void decodeLoop();
+    void handleEdge(const Edge& edge);
+    void setPressed(uint8_t button, bool pressed, uint32_t us);
+    TickType_t runTimers(uint32_t now); // Returns ticks until the next deadline
+    void emit(uint8_t button, EventType type, uint32_t us);
+    void dispatch(const Event& event);
 };
 
-#endif // INPUT_MANAGER_H 
\ No newline at end of file
+#endif // INPUT_MANAGER_H
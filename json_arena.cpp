@@ -0,0 +1,87 @@
+#include "json_arena.h"
+#include "metrics.h"
+
+JsonArena::JsonArena(size_t capacity, HeapTag tag, MetricCounter* overflows) :
+    buffer_(nullptr),
+    capacity_(roundUp(capacity)),
+    offset_(0),
+    highWater_(0),
+    tag_(tag),
+    overflows_(overflows)
+{
+}
+
+bool JsonArena::begin() {
+    if (buffer_) return true;
+    buffer_ = (uint8_t*)heapAlloc(tag_, capacity_, MALLOC_CAP_8BIT);
+    if (!buffer_) {
+        Serial.printf("[JsonArena] ERR: Could not allocate %u bytes, documents use the heap\n", (unsigned)capacity_);
+        return false;
+    }
+    offset_ = 0;
+    return true;
+}
+
+bool JsonArena::isLast(const BlockHeader* header) const {
+    return (const uint8_t*)(header + 1) + roundUp(header->size) == buffer_ + offset_;
+}
+
+void* JsonArena::allocate(size_t size) {
+    size_t need = sizeof(BlockHeader) + roundUp(size);
+    if (buffer_ && capacity_ - offset_ >= need) {
+        BlockHeader* header = (BlockHeader*)(buffer_ + offset_);
+        header->size = size;
+        offset_ += need;
+        highWater_ = max(highWater_, offset_);
+        return header + 1;
+    }
+
+    // Arena full: the document still works, from the heap
+    BlockHeader* header = (BlockHeader*)heapAlloc(tag_, sizeof(BlockHeader) + size, MALLOC_CAP_8BIT);
+    if (!header) {
+        return nullptr;
+    }
+    header->size = size;
+    if (overflows_) {
+        overflows_->inc();
+    }
+    return header + 1;
+}
+
+void JsonArena::deallocate(void* ptr) {
+    if (!ptr) return;
+    BlockHeader* header = (BlockHeader*)ptr - 1;
+    if (!owns(header)) {
+        heapFree(header);
+        return;
+    }
+    // Freed last block gives its space back; any other waits for reset()
+    if (isLast(header)) {
+        offset_ = (uint8_t*)header - buffer_;
+    }
+}
+
+void* JsonArena::reallocate(void* ptr, size_t newSize) {
+    if (!ptr) return allocate(newSize);
+    BlockHeader* header = (BlockHeader*)ptr - 1;
+    size_t start = (uint8_t*)ptr - buffer_;
+    if (owns(header) && isLast(header) && capacity_ - start >= roundUp(newSize)) {
+        // Last block grows or shrinks in place (string builders, shrinkToFit)
+        header->size = newSize;
+        offset_ = start + roundUp(newSize);
+        highWater_ = max(highWater_, offset_);
+        return ptr;
+    }
+    if (newSize <= header->size) {
+        header->size = newSize; // Shrinking anywhere else keeps the block
+        return ptr;
+    }
+
+    void* moved = allocate(newSize);
+    if (!moved) {
+        return nullptr; // ArduinoJson keeps the old block
+    }
+    memcpy(moved, ptr, min((size_t)header->size, newSize));
+    deallocate(ptr);
+    return moved;
+}
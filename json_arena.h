@@ -0,0 +1,59 @@
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "heap_tracker.h"
+
+#if ARDUINOJSON_VERSION_MAJOR < 7
+#error "JsonArena requires the ArduinoJson 7 allocator interface"
+#endif
+
+class MetricCounter;
+
+/**
+ * JsonDocument 的按请求内存区 (Per-request arena for ArduinoJson)
+ *
+ * begin() 时一次性分配固定大小的缓冲区, 之后文档的内存池和字符串都从缓冲区中顺序分配
+ * (bump allocation), 释放最后一块时归还空间, 其余的在下一个请求开始 reset() 时整体回收。
+ * 用法: 每个请求开头 reset(), 再构造 JsonDocument doc(&arena), 序列化到调用者的固定缓冲区。
+ * 缓冲区不够时退回到堆上分配 (heapAlloc, 计入 tag), 同时计数到 overflows, 结果仍然正确。
+ *
+ * 不加锁: 每个内存区只能由一个任务使用 (主循环的命令处理, 或 async_tcp 中的 HTTP 回调),
+ * 且同一时刻只有一个文档。
+ */
+class JsonArena : public ArduinoJson::Allocator {
+public:
+    JsonArena(size_t capacity, HeapTag tag, MetricCounter* overflows = nullptr);
+
+    bool begin();       // Allocates the buffer; call at boot / service start
+    // Starts a new request. Every document built on the arena before must be destroyed.
+    void reset() { offset_ = 0; }
+
+    size_t capacity() const { return capacity_; }
+    size_t highWater() const { return highWater_; }
+
+    void* allocate(size_t size) override;
+    void deallocate(void* ptr) override;
+    void* reallocate(void* ptr, size_t newSize) override;
+
+private:
+    // In front of every block, arena or heap; 8 bytes keep the alignment
+    struct BlockHeader {
+        uint32_t size;
+        uint32_t reserved;
+    };
+
+    uint8_t* buffer_;
+    size_t capacity_;
+    size_t offset_;
+    size_t highWater_;
+    HeapTag tag_;
+    MetricCounter* overflows_;
+
+    bool owns(const void* ptr) const { return buffer_ && ptr >= buffer_ && ptr < buffer_ + capacity_; }
+    bool isLast(const BlockHeader* header) const;
+    static size_t roundUp(size_t size) { return (size + 7) & ~(size_t)7; }
+};
+
+#endif // JSON_ARENA_H
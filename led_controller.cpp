@@ -1,125 +1,335 @@
 #include "led_controller.h"
 #include "ui_manager.h"    // Need access to getLedMode
 #include "data_manager.h"  // Need access to getLatestData
+#include "i2s_mic_manager.h" // Fast level for the VU mode
+#include "metrics.h"
 #include <Arduino.h>      // For Serial
 
 // Constructor
-LedController::LedController(UIManager& uiMgr, DataManager& dataMgr) :
-    pixels_(NUM_LEDS, LED_PIN, NEO_GRB + NEO_KHZ800),
+LedController::LedController(UIManager& uiMgr, DataManager& dataMgr, I2SMicManager& micMgr) :
     uiManager_(uiMgr),
-    dataManager_(dataMgr)
-{}
+    dataManager_(dataMgr),
+    micManager_(micMgr),
+    channel_(nullptr),
+    encoder_(nullptr),
+    timer_(nullptr),
+    dma_(false),
+    fadeStartUs_(0),
+    brightness_(50), // Default brightness
+    vuActive_(false),
+    frameValid_(false),
+    vuPeakDb_(NAN),
+    vuPeakUs_(0),
+    vuLastUs_(0),
+    lastMode_(0xFF),
+    lastSeq_(0)
+{
+    portMUX_INITIALIZE(&mux_);
+    for (int i = 0; i < NUM_LEDS; i++) {
+        from_[i] = target_[i] = {0.0f, 0.0f, 0.0f};
+    }
+    memset(frame_, 0, sizeof(frame_));
+}
 
-// Initialize NeoPixel library
+// Set up the RMT channel (DMA when available) and start the animation timer
 void LedController::begin() {
-    pixels_.begin();
-    pixels_.setBrightness(50); // Default brightness
-    pixels_.clear();
-    pixels_.show();
-    Serial.println("[LedController] Initialized.");
+    rmt_tx_channel_config_t channelConfig = {};
+    channelConfig.gpio_num = (gpio_num_t)LED_PIN;
+    channelConfig.clk_src = RMT_CLK_SRC_DEFAULT;
+    channelConfig.resolution_hz = RMT_RESOLUTION_HZ;
+    channelConfig.mem_block_symbols = 64;  // With DMA: size of the DMA buffer
+    channelConfig.trans_queue_depth = 2;
+    channelConfig.flags.with_dma = true;
+    dma_ = rmt_new_tx_channel(&channelConfig, &channel_) == ESP_OK;
+    if (!dma_) {
+        // Plain RMT memory, refilled from the RMT interrupt: still non-blocking
+        channelConfig.mem_block_symbols = 48;
+        channelConfig.flags.with_dma = false;
+        if (rmt_new_tx_channel(&channelConfig, &channel_) != ESP_OK) {
+            channel_ = nullptr;
+            Serial.println("[LedController] No RMT channel available, LEDs disabled");
+            return;
+        }
+    }
+
+    // WS2812B bit timings (0.3 / 0.9 us), MSB first
+    rmt_bytes_encoder_config_t encoderConfig = {};
+    encoderConfig.bit0.level0 = 1;
+    encoderConfig.bit0.duration0 = 3;
+    encoderConfig.bit0.level1 = 0;
+    encoderConfig.bit0.duration1 = 9;
+    encoderConfig.bit1.level0 = 1;
+    encoderConfig.bit1.duration0 = 9;
+    encoderConfig.bit1.level1 = 0;
+    encoderConfig.bit1.duration1 = 3;
+    encoderConfig.flags.msb_first = 1;
+    if (rmt_new_bytes_encoder(&encoderConfig, &encoder_) != ESP_OK || rmt_enable(channel_) != ESP_OK) {
+        Serial.println("[LedController] RMT setup failed, LEDs disabled");
+        rmt_del_channel(channel_);
+        channel_ = nullptr;
+        return;
+    }
+
+    // Start dark; the frames are far enough apart that no reset code needs to be sent
+    transmit(frame_);
+
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = timerCallback;
+    timerArgs.arg = this;
+    timerArgs.name = "led_anim";
+    if (esp_timer_create(&timerArgs, &timer_) != ESP_OK ||
+        esp_timer_start_periodic(timer_, FRAME_INTERVAL_US) != ESP_OK) {
+        Serial.println("[LedController] Failed to start animation timer");
+        return;
+    }
+    Serial.printf("[LedController] Initialized (RMT%s, %u Hz).\n", dma_ ? " + DMA" : "",
+                  (unsigned)(1000000 / FRAME_INTERVAL_US));
 }
 
-// Update LEDs based on mode and data
+// Stop the animation and turn the LEDs off
+void LedController::end() {
+    if (timer_) {
+        esp_timer_stop(timer_);
+        esp_timer_delete(timer_);
+        timer_ = nullptr;
+    }
+    if (!channel_) {
+        return;
+    }
+    rmt_tx_wait_all_done(channel_, 100);
+    uint8_t black[NUM_LEDS * 3] = {0};
+    transmit(black);
+    rmt_tx_wait_all_done(channel_, 100);
+}
+
+// Pick a new target colour; the timer fades towards it
 void LedController::update() {
     uint8_t currentMode = uiManager_.getCurrentLedMode();
     const EnvironmentData& latestData = dataManager_.getLatestData();
+    if (currentMode == lastMode_ && latestData.seq == lastSeq_) {
+        return;
+    }
+    lastMode_ = currentMode;
+    lastSeq_ = latestData.seq;
+    if (currentMode == LED_MODE_VU) {
+        vuActive_.store(true, std::memory_order_release);
+        return;
+    }
+    // Stop the VU frames first so they cannot overwrite the new target; the fade starts
+    // from the last VU frame
+    vuActive_.store(false, std::memory_order_release);
+    setTarget(calculateColor(currentMode, latestData));
+}
+
+// Set LED brightness
+void LedController::setBrightness(uint8_t brightness) {
+    brightness_ = brightness;
+}
+
+void LedController::setTarget(const LedColor& color) {
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&mux_);
+    // Fade from wherever the previous fade has got to
+    float t = fadeProgress(now);
+    for (int i = 0; i < NUM_LEDS; i++) {
+        from_[i] = mix(from_[i], target_[i], t);
+        target_[i] = color;
+    }
+    fadeStartUs_ = now;
+    portEXIT_CRITICAL(&mux_);
+}
+
+float LedController::fadeProgress(int64_t nowUs) const {
+    float t = (nowUs - fadeStartUs_) / (FADE_MS * 1000.0f);
+    if (t >= 1.0f) return 1.0f;
+    if (t <= 0.0f) return 0.0f;
+    return t * t * (3.0f - 2.0f * t); // Smoothstep: no visible jump at either end
+}
 
-    // Get the calculated color based on mode and data
-    uint32_t color = calculateColor(currentMode, latestData);
+void LedController::timerCallback(void* arg) {
+    static_cast<LedController*>(arg)->renderFrame();
+}
 
-    // Apply the color to all LEDs
-    // Check if mode is OFF separately, as calculateColor might return black
-    if (currentMode == LED_MODE_OFF) {
-        if (pixels_.getPixelColor(0) != 0) { // Only clear if not already off
-            pixels_.clear();
-            pixels_.show();
+// Runs in the esp_timer task at FRAME_INTERVAL_US
+void LedController::renderFrame() {
+    LedColor colors[NUM_LEDS];
+    int64_t now = esp_timer_get_time();
+    if (vuActive_.load(std::memory_order_acquire)) {
+        renderVu(colors, now);
+        // Park the fade state on this frame so leaving the mode fades out from it
+        portENTER_CRITICAL(&mux_);
+        for (int i = 0; i < NUM_LEDS; i++) {
+            from_[i] = target_[i] = colors[i];
         }
+        portEXIT_CRITICAL(&mux_);
     } else {
-        // Check if the color needs updating to avoid redundant writes
-        if (pixels_.getPixelColor(0) != color) {
-             for (int i = 0; i < NUM_LEDS; i++) {
-                pixels_.setPixelColor(i, color);
-            }
-            pixels_.show();
+        vuPeakDb_ = NAN;
+        portENTER_CRITICAL(&mux_);
+        float t = fadeProgress(now);
+        for (int i = 0; i < NUM_LEDS; i++) {
+            colors[i] = mix(from_[i], target_[i], t);
+        }
+        portEXIT_CRITICAL(&mux_);
+    }
+
+    // The LEDs are linear in PWM duty, so linear light maps straight onto the wire values
+    float scale = brightness_;
+    uint8_t grb[NUM_LEDS * 3];
+    for (int i = 0; i < NUM_LEDS; i++) {
+        grb[i * 3 + 0] = (uint8_t)lroundf(colors[i].g * scale);
+        grb[i * 3 + 1] = (uint8_t)lroundf(colors[i].r * scale);
+        grb[i * 3 + 2] = (uint8_t)lroundf(colors[i].b * scale);
+    }
+    if (frameValid_ && memcmp(grb, frame_, sizeof(grb)) == 0) {
+        return; // Nothing changed on the strip
+    }
+    transmit(grb);
+}
+
+// VU meter from the capture task's Fast level: each LED covers VU_STEP_DB above
+// VU_FLOOR_DB and the top one is lit in proportion; the LED holding the peak stays full.
+void LedController::renderVu(LedColor* colors, int64_t nowUs) {
+    static const uint32_t VU_COLORS[NUM_LEDS] = { 0x00FF00, 0x00FF00, 0xFFFF00, 0xFF0000 };
+
+    I2SMicManager::LevelSnapshot snap;
+    micManager_.getLevelSnapshot(snap);
+    if (!micManager_.isCapturing() || snap.frame == 0) {
+        for (int i = 0; i < NUM_LEDS; i++) {
+            colors[i] = fromRgb(0x000060); // Dim blue for 'no data'
         }
+        return;
+    }
+
+    float level = snap.fastDb;
+    float dt = min((nowUs - vuLastUs_) / 1e6f, 0.25f);
+    vuLastUs_ = nowUs;
+    if (!isnan(level) && (isnan(vuPeakDb_) || level >= vuPeakDb_)) {
+        vuPeakDb_ = level;
+        vuPeakUs_ = nowUs;
+    } else if (!isnan(vuPeakDb_) && nowUs - vuPeakUs_ > VU_PEAK_HOLD_US) {
+        vuPeakDb_ -= VU_PEAK_DECAY_DB_PER_S * dt;
+        if (vuPeakDb_ < VU_FLOOR_DB) {
+            vuPeakDb_ = NAN;
+        }
+    }
+    int peakLed = -1;
+    if (!isnan(vuPeakDb_) && vuPeakDb_ >= VU_FLOOR_DB) {
+        peakLed = min((int)((vuPeakDb_ - VU_FLOOR_DB) / VU_STEP_DB), NUM_LEDS - 1);
+    }
+
+    for (int i = 0; i < NUM_LEDS; i++) {
+        float fill = isnan(level) ? 0.0f : (level - (VU_FLOOR_DB + i * VU_STEP_DB)) / VU_STEP_DB;
+        fill = constrain(fill, 0.0f, 1.0f);
+        if (i == peakLed) {
+            fill = 1.0f;
+        }
+        colors[i] = mix({0.0f, 0.0f, 0.0f}, fromRgb(VU_COLORS[i]), fill);
     }
 }
 
-// Set LED brightness
-void LedController::setBrightness(uint8_t brightness) {
-    pixels_.setBrightness(brightness);
-    // Re-show the pixels with the new brightness if they are not off
-    if (uiManager_.getCurrentLedMode() != LED_MODE_OFF) {
-        pixels_.show();
+// Queues grb on the RMT channel. Returns false (and keeps the previous frame) while the
+// last transfer is still going out; the next tick retries.
+bool LedController::transmit(const uint8_t* grb) {
+    if (!channel_) {
+        return false;
     }
+    if (rmt_tx_wait_all_done(channel_, 0) != ESP_OK) {
+        systemMetrics.ledFramesSkipped.inc();
+        return false;
+    }
+    memmove(frame_, grb, sizeof(frame_));
+    rmt_transmit_config_t txConfig = {};
+    txConfig.loop_count = 0;
+    if (rmt_transmit(channel_, encoder_, frame_, sizeof(frame_), &txConfig) != ESP_OK) {
+        frameValid_ = false;
+        return false;
+    }
+    frameValid_ = true;
+    systemMetrics.ledFramesSent.inc();
+    return true;
+}
+
+// sRGB 0xRRGGBB to linear light
+LedController::LedColor LedController::fromRgb(uint32_t rgb) {
+    LedColor c;
+    c.r = powf(((rgb >> 16) & 0xFF) / 255.0f, GAMMA);
+    c.g = powf(((rgb >> 8) & 0xFF) / 255.0f, GAMMA);
+    c.b = powf((rgb & 0xFF) / 255.0f, GAMMA);
+    return c;
+}
+
+LedController::LedColor LedController::mix(const LedColor& a, const LedColor& b, float t) {
+    return { a.r + (b.r - a.r) * t, a.g + (b.g - a.g) * t, a.b + (b.b - a.b) * t };
+}
+
+// colors[i] covers the values between thresholds[i - 1] and thresholds[i] (count colours,
+// count - 1 ascending thresholds). Within +/- blend of a threshold the two neighbouring
+// colours are mixed in linear light.
+LedController::LedColor LedController::ramp(float value, const float* thresholds, const uint32_t* colors,
+                                            int count, float blend) {
+    for (int i = 0; i < count - 1; i++) {
+        if (value < thresholds[i] - blend) {
+            return fromRgb(colors[i]);
+        }
+        if (value < thresholds[i] + blend) {
+            float t = (value - (thresholds[i] - blend)) / (2.0f * blend);
+            return mix(fromRgb(colors[i]), fromRgb(colors[i + 1]), t);
+        }
+    }
+    return fromRgb(colors[count - 1]);
 }
 
 // Internal helper to calculate color based on mode and data
 // Logic moved from SoundScape.ino::updateLEDs
-uint32_t LedController::calculateColor(uint8_t mode, const EnvironmentData& data) {
-    uint32_t color = 0; // Default Black/Off
+LedController::LedColor LedController::calculateColor(uint8_t mode, const EnvironmentData& data) {
+    static const uint32_t INVALID = 0x800080; // Purple
 
+    if (mode == LED_MODE_OFF) {
+        return fromRgb(0x000000);
+    }
     // Handle case where no valid data is available yet (timestamp is 0)
     if (data.timestamp == 0) {
-        return pixels_.Color(0, 0, 32); // Dim blue for 'no data'
+        return fromRgb(0x000060); // Dim blue for 'no data'
     }
 
     switch (mode) {
-        case LED_MODE_OFF:
-            color = 0; // Black
-            break;
-
         case LED_MODE_NOISE:
             {
+                // Quiet blue, low green, medium yellow, high red
+                static const float thresholds[] = { NOISE_THRESHOLD_LOW, NOISE_THRESHOLD_MEDIUM, NOISE_THRESHOLD_HIGH };
+                static const uint32_t colors[] = { 0x0000FF, 0x00FF00, 0xFFFF00, 0xFF0000 };
                 float db = data.decibels;
-                // Use constants from ui_constants.h included via led_controller.h
-                if (isnan(db) || db < NOISE_THRESHOLD_LOW) {
-                    color = pixels_.Color(0, 0, 255);   // Blue - Quiet or Invalid
-                } else if (db < NOISE_THRESHOLD_MEDIUM) {
-                    color = pixels_.Color(0, 255, 0);   // Green - Low
-                } else if (db < NOISE_THRESHOLD_HIGH) {
-                    color = pixels_.Color(255, 255, 0); // Yellow - Medium
-                } else { // db >= NOISE_THRESHOLD_HIGH
-                    color = pixels_.Color(255, 0, 0);  // Red - High
+                if (isnan(db)) {
+                    return fromRgb(colors[0]); // Blue - Invalid
                 }
+                return ramp(db, thresholds, colors, 4, 2.0f);
             }
-            break;
 
         case LED_MODE_TEMP:
             {
+                // Cold blue, comfortable green, hot red
+                static const float thresholds[] = { 16.0f, 28.0f };
+                static const uint32_t colors[] = { 0x0000FF, 0x00FF00, 0xFF0000 };
                 float temp = data.temperature;
-                // Use constants from ui_constants.h
-                 if (isnan(temp) || temp < TEMP_MIN || temp > TEMP_MAX) {
-                    color = pixels_.Color(128, 0, 128); // Purple for invalid
-                } else if (temp < 16.0f) { // Example thresholds
-                    color = pixels_.Color(0, 0, 255);  // Blue - Cold
-                } else if (temp > 28.0f) {
-                    color = pixels_.Color(255, 0, 0);  // Red - Hot
-                } else {
-                    color = pixels_.Color(0, 255, 0);  // Green - Comfortable
+                if (isnan(temp) || temp < TEMP_MIN || temp > TEMP_MAX) {
+                    return fromRgb(INVALID);
                 }
+                return ramp(temp, thresholds, colors, 3, 1.0f);
             }
-            break;
 
         case LED_MODE_HUMIDITY:
             {
+                // Dry orange, comfortable green, humid blue
+                static const float thresholds[] = { 30.0f, 70.0f };
+                static const uint32_t colors[] = { 0xFFA500, 0x00FF00, 0x0000FF };
                 float humidity = data.humidity;
-                 // Use constants from ui_constants.h
-                 if (isnan(humidity) || humidity < HUM_MIN || humidity > HUM_MAX) {
-                    color = pixels_.Color(128, 0, 128); // Purple for invalid
-                } else if (humidity < 30.0f) { // Example thresholds
-                    color = pixels_.Color(255, 165, 0); // Orange - Dry (changed from red)
-                } else if (humidity > 70.0f) {
-                    color = pixels_.Color(0, 0, 255);  // Blue - Humid
-                } else {
-                    color = pixels_.Color(0, 255, 0);  // Green - Comfortable
+                if (isnan(humidity) || humidity < HUM_MIN || humidity > HUM_MAX) {
+                    return fromRgb(INVALID);
                 }
+                return ramp(humidity, thresholds, colors, 3, 3.0f);
             }
-            break;
 
         default:
-            color = pixels_.Color(32, 32, 32); // Dim white for unknown mode
-            break;
+            return fromRgb(0x606060); // Dim white for unknown mode
     }
-    return color;
-} 
\ No newline at end of file
+}
@@ -1,34 +1,105 @@
 #ifndef LED_CONTROLLER_H
 #define LED_CONTROLLER_H
 
-#include <Adafruit_NeoPixel.h>
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "driver/rmt_tx.h"
+#include "esp_timer.h"
 #include "EnvironmentData.h" // Need data structure
 #include "ui_constants.h"    // Need LED modes and noise thresholds
 #include <cmath>              // For isnan
+#include <atomic>
 
 // Forward declarations
 class UIManager;
 class DataManager;
+class I2SMicManager;
 
+/**
+ * WS2812B 灯带 (4 颗)
+ *
+ * 数据由 RMT 外设输出 (ESP32-S3 上优先使用 DMA), rmt_transmit() 排队后立即返回,
+ * 不再像 Adafruit_NeoPixel::show() 那样关中断逐位输出, 不影响 I2S 和 WiFi 中断。
+ *
+ * 动画由 esp_timer 以固定 60 Hz 驱动: 每一帧把当前颜色向目标颜色渐变 (FADE_MS),
+ * 只在输出字节变化时才发送。主循环中的 update() 只在模式或数据变化时计算新的目标颜色。
+ * 颜色在线性光空间中混合: 阈值颜色按 sRGB 定义, 先做 gamma 解码再插值,
+ * 阈值附近 (±BLEND) 的数值得到相邻两种颜色的过渡色, 避免跨阈值时跳变。
+ *
+ * LED_MODE_VU: 定时器每帧直接读取麦克风采集任务的 Fast 计权声级, 4 颗 LED 各占 15 dB
+ * (40-100 dB, 绿/绿/黄/红, 与 NOISE_THRESHOLD_MEDIUM/HIGH 对齐), 最上面一颗按比例点亮;
+ * 峰值所在的 LED 保持全亮 1 秒后以 20 dB/s 回落。主循环不参与 VU 显示。
+ */
 class LedController {
 public:
     // Constructor takes references to managers for state/data
-    LedController(UIManager& uiMgr, DataManager& dataMgr);
+    LedController(UIManager& uiMgr, DataManager& dataMgr, I2SMicManager& micMgr);
 
-    void begin(); // Initialize NeoPixel library
-    void update(); // Update LEDs based on mode and data
-    void setBrightness(uint8_t brightness); // Control brightness
+    void begin(); // Set up the RMT channel and start the animation timer
+    void end();   // Stop the animation and turn the LEDs off (blocking)
+    void update(); // Pick a new target colour when the mode or data changed
+    void setBrightness(uint8_t brightness); // Control brightness, applied by the next frame
 
 private:
+    // Colour in linear light, 0..1 per channel
+    struct LedColor {
+        float r, g, b;
+    };
+
     // LED configuration
     static const uint8_t LED_PIN = 18;
     static const uint8_t NUM_LEDS = 4;
+    static const uint32_t RMT_RESOLUTION_HZ = 10000000; // 0.1 us per tick
+    static const uint32_t FRAME_INTERVAL_US = 16667;    // 60 Hz
+    static const uint32_t FADE_MS = 300;
+    static constexpr float GAMMA = 2.2f;
+    // VU mode
+    static constexpr float VU_FLOOR_DB = NOISE_THRESHOLD_MEDIUM - 30.0f;
+    static constexpr float VU_STEP_DB = 15.0f;            // Per LED
+    static const uint32_t VU_PEAK_HOLD_US = 1000000;
+    static constexpr float VU_PEAK_DECAY_DB_PER_S = 20.0f;
 
-    Adafruit_NeoPixel pixels_;
     UIManager& uiManager_;
     DataManager& dataManager_;
+    I2SMicManager& micManager_;
+
+    rmt_channel_handle_t channel_;
+    rmt_encoder_handle_t encoder_;
+    esp_timer_handle_t timer_;
+    bool dma_;
+
+    // Shared with the timer callback, guarded by mux_
+    portMUX_TYPE mux_;
+    LedColor from_[NUM_LEDS];
+    LedColor target_[NUM_LEDS];
+    int64_t fadeStartUs_;
+    volatile uint8_t brightness_;
+    std::atomic<bool> vuActive_;  // Set by update(); the timer renders the VU meter itself
+
+    // Timer callback only
+    uint8_t frame_[NUM_LEDS * 3]; // GRB wire order; owned by the RMT until the transfer is done
+    bool frameValid_;
+    float vuPeakDb_;              // Held peak (NAN = none)
+    int64_t vuPeakUs_;            // When vuPeakDb_ was last raised
+    int64_t vuLastUs_;            // Previous VU frame, for the decay step
+
+    // update() only
+    uint8_t lastMode_;
+    uint32_t lastSeq_;
+
+    LedColor calculateColor(uint8_t mode, const EnvironmentData& data);
+    void setTarget(const LedColor& color);
+
+    float fadeProgress(int64_t nowUs) const; // 0..1, eased; caller holds mux_
+
+    static void timerCallback(void* arg);
+    void renderFrame();
+    void renderVu(LedColor* colors, int64_t nowUs);
+    bool transmit(const uint8_t* grb);
 
-    uint32_t calculateColor(uint8_t mode, const EnvironmentData& data);
+    static LedColor fromRgb(uint32_t rgb);
+    static LedColor mix(const LedColor& a, const LedColor& b, float t);
+    static LedColor ramp(float value, const float* thresholds, const uint32_t* colors, int count, float blend);
 };
 
-#endif // LED_CONTROLLER_H 
\ No newline at end of file
+#endif // LED_CONTROLLER_H
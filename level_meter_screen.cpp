@@ -0,0 +1,325 @@
+#include "level_meter_screen.h"
+#include "data_manager.h"
+#include "ui_constants.h" // Include constants (e.g., TITLE_Y, NOISE_THRESHOLD_*)
+#include "metrics.h"
+#include <cmath>
+
+// Level bar (Fast dB) and the peak-hold strip underneath
+const float METER_DB_MIN = 30.0f;
+const float METER_DB_MAX = 110.0f;
+const int BAR_Y = 96;
+const int BAR_H = 24;
+const int PEAK_Y = BAR_Y + BAR_H + 2;
+const int PEAK_H = 4;
+const int PEAK_W = 3;
+const int SCALE_Y = PEAK_Y + PEAK_H + 4;
+
+// Spectrum bars
+const float SPEC_DB_MIN = 20.0f;
+const float SPEC_DB_MAX = 100.0f;
+const int SPEC_Y = 150;
+const int SPEC_H = 120;
+const int BAND_GAP = 2;
+
+const uint16_t TRACK_COLOR = 0x18E3; // Unlit part of the level bar
+const uint16_t BAND_COLOR = TFT_CYAN;
+
+const uint32_t PEAK_HOLD_US = 1500000;
+const float PEAK_DECAY_DB_PER_S = 20.0f;
+const float BAND_FALL_DB_PER_S = 60.0f;
+const uint32_t VALUE_EVERY_FRAMES = 6;   // Text fields at ~5 Hz, bars every frame
+
+// Adaptive frame rate: 30/20/15/10 fps. A frame may use a third of its interval.
+static const uint32_t FRAME_INTERVALS_US[] = {33333, 50000, 66667, 100000};
+const float RATE_EWMA_ALPHA = 0.1f;
+const uint32_t RATE_HOLD_US = 2000000;   // Minimum time between rate changes
+
+LevelMeterScreen::LevelMeterScreen(TFT_eSPI& display, DataManager& dataMgr, I2SMicManager& mic) :
+    Screen(display, dataMgr),
+    mic_(mic),
+    level_(TR_DATUM, 4, TFT_WHITE, TFT_BLACK),
+    peak_(TC_DATUM, 2, TFT_LIGHTGREY, TFT_BLACK),
+    rate_(BR_DATUM, 1, TFT_DARKGREY, TFT_BLACK),
+    drawn_(false),
+    levelPx_(0),
+    peakPx_(-1),
+    nextBand_(0),
+    peakHoldDb_(NAN),
+    peakHeldUs_(0),
+    lastFrameUs_(0),
+    frameCount_(0),
+    rateLevel_(0),
+    costEwmaUs_(0.0f),
+    periodEwmaUs_((float)FRAME_INTERVALS_US[0]),
+    rateChangedUs_(0)
+{
+    for (size_t b = 0; b < BANDS; b++) {
+        bandPx_[b] = 0;
+        bandShownDb_[b] = NAN;
+    }
+}
+
+void LevelMeterScreen::draw(int yOffset /* = 0 */) {
+    TFT_eSPI& tft = canvas();
+    int barX = H_PADDING;
+    int barW = barWidth();
+    tft.setTextColor(TFT_WHITE, TFT_BLACK);
+
+    // Title - Centered, Size 2
+    tft.setTextDatum(TC_DATUM);
+    tft.setTextSize(2);
+    tft.drawString("Live Level", tft.width() / 2, TITLE_Y + yOffset);
+    tft.setTextDatum(TL_DATUM);
+    tft.drawString("dB", tft.width() / 2 + 36, 50 + yOffset);
+
+    // Level bar track and scale
+    tft.fillRect(barX, BAR_Y + yOffset, barW, BAR_H, TRACK_COLOR);
+    tft.setTextSize(1);
+    tft.setTextColor(TFT_LIGHTGREY, TFT_BLACK);
+    tft.drawString("30", barX, SCALE_Y + yOffset);
+    tft.setTextDatum(TC_DATUM);
+    tft.drawNumber(NOISE_THRESHOLD_MEDIUM, barX + levelToPx(NOISE_THRESHOLD_MEDIUM), SCALE_Y + yOffset);
+    tft.drawNumber(NOISE_THRESHOLD_HIGH, barX + levelToPx(NOISE_THRESHOLD_HIGH), SCALE_Y + yOffset);
+    tft.setTextDatum(TR_DATUM);
+    tft.drawString("110", barX + barW, SCALE_Y + yOffset);
+
+    // Spectrum frequency axis
+    char edge[8];
+    const SpectrumAnalyzer& spectrum = mic_.spectrum();
+    snprintf(edge, sizeof(edge), "%d", (int)spectrum.bandEdgeHz(0));
+    tft.setTextDatum(TL_DATUM);
+    tft.drawString(edge, barX, SPEC_Y + SPEC_H + 4 + yOffset);
+    snprintf(edge, sizeof(edge), "%dk", (int)lroundf(spectrum.bandEdgeHz(BANDS) / 1000.0f));
+    tft.setTextDatum(TR_DATUM);
+    tft.drawString(edge, barX + barW, SPEC_Y + SPEC_H + 4 + yOffset);
+    tft.drawFastHLine(barX, SPEC_Y + SPEC_H + yOffset, barW, TFT_DARKGREY);
+
+    // Current state, drawn from empty bars
+    I2SMicManager::LevelSnapshot snap;
+    mic_.getLevelSnapshot(snap);
+    level_.place(tft.width() / 2 + 30, 36);
+    peak_.place(tft.width() / 2, 72);
+    rate_.place(tft.width() - H_PADDING, tft.height() - 4);
+    renderValues(snap, yOffset, false);
+
+    levelPx_ = 0;
+    drawLevel(tft, levelToPx(snap.fastDb), yOffset);
+    peakPx_ = -1;
+    drawPeakMarker(tft, isnan(peakHoldDb_) ? -1 : levelToPx(peakHoldDb_), yOffset);
+    for (size_t b = 0; b < BANDS; b++) {
+        bandPx_[b] = 0;
+        drawBand(tft, b, bandToPx(bandShownDb_[b]), yOffset);
+    }
+
+    // Bars are only tracked for a draw at the final position
+    drawn_ = (yOffset == 0);
+    frameCount_ = 0; // Do not measure a period across the time the screen was hidden
+
+    tft.setTextDatum(TL_DATUM);
+    tft.setTextColor(TFT_WHITE, TFT_BLACK);
+}
+
+bool LevelMeterScreen::updateValues() {
+    // Nothing here depends on the 1 Hz records; renderFrame() keeps the screen current
+    return drawn_;
+}
+
+uint32_t LevelMeterScreen::frameIntervalUs() const {
+    return mic_.isCapturing() ? FRAME_INTERVALS_US[rateLevel_] : 0;
+}
+
+void LevelMeterScreen::renderFrame(uint32_t budgetUs) {
+    if (!drawn_) return;
+    TFT_eSPI& tft = canvas();
+    uint32_t startUs = micros();
+    float dt = frameCount_ > 0 ? (startUs - lastFrameUs_) / 1e6f : 0.0f;
+    dt = min(dt, 0.25f);
+
+    I2SMicManager::LevelSnapshot snap;
+    mic_.getLevelSnapshot(snap);
+
+    // Level bar and peak hold
+    drawLevel(tft, levelToPx(snap.fastDb), 0);
+    if (!isnan(snap.peakDb) && (isnan(peakHoldDb_) || snap.peakDb >= peakHoldDb_)) {
+        peakHoldDb_ = snap.peakDb;
+        peakHeldUs_ = startUs;
+    } else if (!isnan(peakHoldDb_) && startUs - peakHeldUs_ > PEAK_HOLD_US) {
+        peakHoldDb_ -= PEAK_DECAY_DB_PER_S * dt;
+        if (peakHoldDb_ < METER_DB_MIN) {
+            peakHoldDb_ = NAN;
+        }
+    }
+    drawPeakMarker(tft, isnan(peakHoldDb_) ? -1 : levelToPx(peakHoldDb_), 0);
+
+    if (frameCount_ % VALUE_EVERY_FRAMES == 0) {
+        renderValues(snap, 0, true);
+    }
+
+    // Spectrum: bars jump up and fall back at a limited rate
+    for (size_t b = 0; b < BANDS; b++) {
+        float target = snap.frame > 0 ? snap.bandDb[b] : NAN;
+        float& shown = bandShownDb_[b];
+        if (isnan(shown) || (!isnan(target) && target >= shown)) {
+            shown = target;
+        } else {
+            shown = isnan(target) ? shown - BAND_FALL_DB_PER_S * dt
+                                  : max(target, shown - BAND_FALL_DB_PER_S * dt);
+            if (shown < SPEC_DB_MIN) shown = NAN;
+        }
+    }
+    // Draw in round-robin order until the budget is spent; the rest wait a frame
+    size_t drawnBands = 0;
+    for (; drawnBands < BANDS; drawnBands++) {
+        if (drawnBands > 0 && micros() - startUs >= budgetUs) break;
+        size_t b = (nextBand_ + drawnBands) % BANDS;
+        drawBand(tft, b, bandToPx(bandShownDb_[b]), 0);
+    }
+    nextBand_ = (nextBand_ + drawnBands) % BANDS;
+    if (drawnBands < BANDS) {
+        systemMetrics.meterDeferredBands.inc(BANDS - drawnBands);
+    }
+
+    uint32_t costUs = micros() - startUs;
+    systemMetrics.meterFrameUs.observe(costUs);
+    if (frameCount_ > 0) {
+        periodEwmaUs_ += ((float)(startUs - lastFrameUs_) - periodEwmaUs_) * RATE_EWMA_ALPHA;
+        systemMetrics.meterFps.set(1e6f / periodEwmaUs_);
+    }
+    costEwmaUs_ += ((float)costUs - costEwmaUs_) * RATE_EWMA_ALPHA;
+    adaptRate(startUs);
+    lastFrameUs_ = startUs;
+    frameCount_++;
+}
+
+void LevelMeterScreen::adaptRate(uint32_t nowUs) {
+    if (frameCount_ < 10 || nowUs - rateChangedUs_ < RATE_HOLD_US) {
+        return; // Let the averages settle first
+    }
+    const uint8_t slowest = sizeof(FRAME_INTERVALS_US) / sizeof(FRAME_INTERVALS_US[0]) - 1;
+    uint32_t interval = FRAME_INTERVALS_US[rateLevel_];
+    uint8_t level = rateLevel_;
+    if (rateLevel_ < slowest &&
+        (costEwmaUs_ > interval / 3 || periodEwmaUs_ > interval * 1.5f)) {
+        level++; // Frames too expensive, or the loop cannot call us often enough
+    } else if (rateLevel_ > 0) {
+        uint32_t faster = FRAME_INTERVALS_US[rateLevel_ - 1];
+        if (costEwmaUs_ < faster / 6 && periodEwmaUs_ < interval * 1.1f) {
+            level--; // Comfortably within half the faster rate's budget
+        }
+    }
+    if (level == rateLevel_) return;
+
+    Serial.printf("[LevelMeterScreen] %lu -> %lu fps (frame %.1f ms, period %.1f ms)\n",
+                  1000000UL / interval, 1000000UL / FRAME_INTERVALS_US[level],
+                  costEwmaUs_ / 1000.0f, periodEwmaUs_ / 1000.0f);
+    rateLevel_ = level;
+    rateChangedUs_ = nowUs;
+    periodEwmaUs_ = (float)FRAME_INTERVALS_US[level];
+}
+
+int LevelMeterScreen::barWidth() const {
+    return display_.width() - 2 * H_PADDING; // Sprites used for transitions have the same size
+}
+
+int LevelMeterScreen::levelToPx(float db) const {
+    if (isnan(db)) return 0;
+    float t = (db - METER_DB_MIN) / (METER_DB_MAX - METER_DB_MIN);
+    return constrain((int)lroundf(t * barWidth()), 0, barWidth());
+}
+
+int LevelMeterScreen::bandToPx(float db) const {
+    if (isnan(db)) return 0;
+    float t = (db - SPEC_DB_MIN) / (SPEC_DB_MAX - SPEC_DB_MIN);
+    return constrain((int)lroundf(t * SPEC_H), 0, SPEC_H);
+}
+
+// Fills [from, to) of the level bar, split into green / yellow / red at the thresholds
+void LevelMeterScreen::drawLevelSpan(TFT_eSPI& tft, int from, int to, int yOffset) {
+    const int edges[] = {levelToPx(NOISE_THRESHOLD_MEDIUM), levelToPx(NOISE_THRESHOLD_HIGH), barWidth()};
+    const uint16_t colors[] = {TFT_GREEN, TFT_YELLOW, TFT_RED};
+    int start = 0;
+    for (int i = 0; i < 3; i++) {
+        int a = max(from, start);
+        int b = min(to, edges[i]);
+        if (b > a) {
+            tft.fillRect(H_PADDING + a, BAR_Y + yOffset, b - a, BAR_H, colors[i]);
+            ValueField::countRect(H_PADDING + a, BAR_Y + yOffset, b - a, BAR_H);
+        }
+        start = edges[i];
+    }
+}
+
+void LevelMeterScreen::drawLevel(TFT_eSPI& tft, int px, int yOffset) {
+    if (px > levelPx_) {
+        drawLevelSpan(tft, levelPx_, px, yOffset);
+    } else if (px < levelPx_) {
+        tft.fillRect(H_PADDING + px, BAR_Y + yOffset, levelPx_ - px, BAR_H, TRACK_COLOR);
+        ValueField::countRect(H_PADDING + px, BAR_Y + yOffset, levelPx_ - px, BAR_H);
+    }
+    levelPx_ = px;
+}
+
+void LevelMeterScreen::drawPeakMarker(TFT_eSPI& tft, int px, int yOffset) {
+    if (px == peakPx_) return;
+    int maxX = barWidth() - PEAK_W;
+    if (peakPx_ >= 0) {
+        int x = H_PADDING + constrain(peakPx_ - PEAK_W / 2, 0, maxX);
+        tft.fillRect(x, PEAK_Y + yOffset, PEAK_W, PEAK_H, TFT_BLACK);
+        ValueField::countRect(x, PEAK_Y + yOffset, PEAK_W, PEAK_H);
+    }
+    if (px >= 0) {
+        int x = H_PADDING + constrain(px - PEAK_W / 2, 0, maxX);
+        tft.fillRect(x, PEAK_Y + yOffset, PEAK_W, PEAK_H, TFT_WHITE);
+        ValueField::countRect(x, PEAK_Y + yOffset, PEAK_W, PEAK_H);
+    }
+    peakPx_ = px;
+}
+
+void LevelMeterScreen::drawBand(TFT_eSPI& tft, size_t band, int px, int yOffset) {
+    int old = bandPx_[band];
+    if (px == old) return;
+    int slot = barWidth() / (int)BANDS;
+    int x = H_PADDING + (int)band * slot;
+    int w = slot - BAND_GAP;
+    int bottom = SPEC_Y + SPEC_H + yOffset;
+    if (px > old) {
+        tft.fillRect(x, bottom - px, w, px - old, BAND_COLOR);
+        ValueField::countRect(x, bottom - px, w, px - old);
+    } else {
+        tft.fillRect(x, bottom - old, w, old - px, TFT_BLACK);
+        ValueField::countRect(x, bottom - old, w, old - px);
+    }
+    bandPx_[band] = px;
+}
+
+bool LevelMeterScreen::renderValues(const I2SMicManager::LevelSnapshot& snap, int yOffset, bool inPlace) {
+    TFT_eSPI& tft = canvas();
+    char text[ValueField::MAX_TEXT];
+    bool ok = true;
+
+    if (!mic_.isCapturing()) {
+        ok &= level_.show(tft, "---", yOffset, inPlace);
+        ok &= peak_.show(tft, "Mic off", yOffset, inPlace);
+        ok &= rate_.show(tft, "", yOffset, inPlace);
+        return ok;
+    }
+
+    if (isnan(snap.fastDb) || snap.fastDb < NOISE_THRESHOLD_MEDIUM) {
+        level_.setColor(TFT_GREEN);
+    } else if (snap.fastDb < NOISE_THRESHOLD_HIGH) {
+        level_.setColor(TFT_YELLOW);
+    } else {
+        level_.setColor(TFT_RED);
+    }
+    formatValue(text, sizeof(text), snap.fastDb, 1);
+    ok &= level_.show(tft, text, yOffset, inPlace);
+
+    char value[ValueField::MAX_TEXT];
+    formatValue(value, sizeof(value), peakHoldDb_, 1);
+    snprintf(text, sizeof(text), "Peak %s", value);
+    ok &= peak_.show(tft, text, yOffset, inPlace);
+
+    snprintf(text, sizeof(text), "%lu fps", 1000000UL / FRAME_INTERVALS_US[rateLevel_]);
+    ok &= rate_.show(tft, text, yOffset, inPlace);
+    return ok;
+}
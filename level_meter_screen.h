@@ -0,0 +1,63 @@
+#ifndef LEVEL_METER_SCREEN_H
+#define LEVEL_METER_SCREEN_H
+
+#include "screen.h"
+#include "ui_widgets.h"
+#include "i2s_mic_manager.h"
+
+// Forward declaration
+class DataManager;
+
+// Real-time level meter: Fast-weighted level bar with peak hold and a 16-band spectrum,
+// animated from I2SMicManager::getLevelSnapshot() at up to 30 fps.
+// Each frame only draws the strips of bars that moved. Bands that do not fit in the
+// frame budget are deferred to the next frame (round robin), and the frame rate steps
+// down (30/20/15/10 fps) when frames cost too much or the main loop cannot keep up.
+class LevelMeterScreen : public Screen {
+public:
+    LevelMeterScreen(TFT_eSPI& display, DataManager& dataMgr, I2SMicManager& mic);
+
+    void draw(int yOffset = 0) override;
+    bool updateValues() override;
+    void onExit(UIManager* uiManager) override { drawn_ = false; }
+    uint32_t frameIntervalUs() const override;
+    void renderFrame(uint32_t budgetUs) override;
+
+private:
+    static const size_t BANDS = SpectrumAnalyzer::BANDS;
+
+    I2SMicManager& mic_;
+    ValueField level_;      // Fast dB
+    ValueField peak_;       // Held peak
+    ValueField rate_;       // Current frame rate
+
+    bool drawn_;            // Bars below reflect the screen contents
+    int16_t levelPx_;       // Drawn width of the level bar
+    int16_t peakPx_;        // Drawn x of the peak marker (-1 = none)
+    int16_t bandPx_[BANDS]; // Drawn height of each spectrum bar
+    float bandShownDb_[BANDS]; // Displayed band levels (instant rise, limited fall)
+    uint8_t nextBand_;      // Round-robin start for the next frame
+
+    float peakHoldDb_;
+    uint32_t peakHeldUs_;   // When peakHoldDb_ was last raised
+    uint32_t lastFrameUs_;
+    uint32_t frameCount_;
+
+    // Adaptive frame rate
+    uint8_t rateLevel_;     // Index into the interval table, 0 = fastest
+    float costEwmaUs_;      // Render time per frame
+    float periodEwmaUs_;    // Measured time between frames
+    uint32_t rateChangedUs_;
+
+    int barWidth() const;
+    int levelToPx(float db) const;
+    int bandToPx(float db) const;
+    void drawLevelSpan(TFT_eSPI& tft, int from, int to, int yOffset);
+    void drawLevel(TFT_eSPI& tft, int px, int yOffset);
+    void drawPeakMarker(TFT_eSPI& tft, int px, int yOffset);
+    void drawBand(TFT_eSPI& tft, size_t band, int px, int yOffset);
+    bool renderValues(const I2SMicManager::LevelSnapshot& snap, int yOffset, bool inPlace);
+    void adaptRate(uint32_t nowUs);
+};
+
+#endif // LEVEL_METER_SCREEN_H
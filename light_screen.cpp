@@ -4,11 +4,13 @@
 
 // Constructor implementation - Pass DataManager reference to base class
 LightScreen::LightScreen(TFT_eSPI& display, DataManager& dataMgr) :
-    Screen(display, dataMgr) // Call base class constructor with DataManager
+    Screen(display, dataMgr), // Call base class constructor with DataManager
+    value_(TC_DATUM, 5, TFT_BLACK, TFT_ORANGE)
 {}
 
 // draw() method implementation
 void LightScreen::draw(int yOffset /* = 0 */) {
+    TFT_eSPI& tft = canvas();
     tft.setTextColor(TFT_BLACK, TFT_ORANGE); // Set color
 
     // Title - Centered, Size 3
@@ -17,22 +19,29 @@ void LightScreen::draw(int yOffset /* = 0 */) {
     // Use TITLE_Y from ui_constants.h
     tft.drawString("Light Intensity", tft.width() / 2, TITLE_Y + 10 + yOffset);
 
+    // Unit - Below value, Size 3
+    int valueY = tft.height() / 2 - 20;
+    tft.drawString("lx", tft.width() / 2, valueY + 50 + yOffset);
+
     // Value - Centered, Large Size 5
-    tft.setTextSize(5);
-    int valueY = tft.height() / 2 - 20 + yOffset;
-    // Use getLatestData() helper from base class (which now uses DataManager)
-    const EnvironmentData& latestData = getLatestData();
+    value_.place(tft.width() / 2, valueY);
+    renderValues(yOffset, false);
 
-    // Check lux value
-    if (!isnan(latestData.lux)) {
-       tft.drawFloat(latestData.lux, 0, tft.width() / 2, valueY);
-    } else {
-       tft.drawString("---", tft.width() / 2, valueY);
-    }
+    tft.setTextDatum(TL_DATUM); // Reset datum
+}
 
-    // Unit - Below value, Size 3
-    tft.setTextSize(3);
-    tft.drawString("lx", tft.width() / 2, valueY + 50);
+bool LightScreen::updateValues() {
+    TFT_eSPI& tft = canvas();
+    bool ok = renderValues(0, true);
+    tft.setTextDatum(TL_DATUM);
+    return ok;
+}
 
-    tft.setTextDatum(TL_DATUM); // Reset datum
+bool LightScreen::renderValues(int yOffset, bool inPlace) {
+    TFT_eSPI& tft = canvas();
+    // Use getLatestData() helper from base class (which now uses DataManager)
+    const EnvironmentData& latestData = getLatestData();
+    char text[ValueField::MAX_TEXT];
+    formatValue(text, sizeof(text), latestData.lux, 0);
+    return value_.show(tft, text, yOffset, inPlace);
 }
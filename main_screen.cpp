@@ -13,11 +13,21 @@ const int STATUS_Y_MAIN = 280;
 
 // Constructor implementation - Pass DataManager reference to base class
 MainScreen::MainScreen(TFT_eSPI& display, DataManager& dataMgr) :
-    Screen(display, dataMgr) // Call base class constructor with DataManager
+    Screen(display, dataMgr), // Call base class constructor with DataManager
+    temp_(TL_DATUM, 2, TFT_WHITE, TFT_BLACK),
+    hum_(TL_DATUM, 2, TFT_WHITE, TFT_BLACK),
+    lux_(TL_DATUM, 2, TFT_WHITE, TFT_BLACK),
+    db_(TL_DATUM, 2, TFT_WHITE, TFT_BLACK),
+    date_(TL_DATUM, 2, TFT_WHITE, TFT_BLACK),
+    clock_(TL_DATUM, 2, TFT_WHITE, TFT_BLACK),
+    sd_(TR_DATUM, 1, TFT_GREEN, TFT_BLACK),
+    wifi_(TR_DATUM, 1, TFT_GREEN, TFT_BLACK),
+    drawnSdStatus_(false)
 {}
 
 // draw() method implementation
 void MainScreen::draw(int yOffset /* = 0 */) {
+    TFT_eSPI& tft = canvas();
     tft.setTextColor(TFT_WHITE, TFT_BLACK);
 
     // Title
@@ -26,106 +36,104 @@ void MainScreen::draw(int yOffset /* = 0 */) {
     tft.drawString("Environment Monitor", tft.width() / 2, TITLE_Y_MAIN + yOffset);
     tft.setTextDatum(TL_DATUM); // Reset datum
 
-    // Data Section
-    int currentY = TITLE_Y_MAIN + LINE_HEIGHT_MAIN + V_PADDING_MAIN + yOffset;
+    // Data Section: static labels and units, values are widgets
+    int currentY = TITLE_Y_MAIN + LINE_HEIGHT_MAIN + V_PADDING_MAIN;
     int labelX = H_PADDING_MAIN;
     int valueX = H_PADDING_MAIN + 110;
 
     tft.setTextSize(2);
-    // Use getLatestData() helper from base class (which now uses DataManager)
-    const EnvironmentData& latestData = getLatestData();
+    int unitX = valueX + tft.textWidth("00.0") + 5;
 
-    // Temperature
-    tft.drawString("Temp:", labelX, currentY);
-    if (!isnan(latestData.temperature)) {
-        tft.drawFloat(latestData.temperature, 1, valueX, currentY);
-        tft.drawString(" C", valueX + tft.textWidth("00.0") + 5, currentY);
-    } else {
-        tft.drawString("---", valueX, currentY);
-    }
+    tft.drawString("Temp:", labelX, currentY + yOffset);
+    tft.drawString(" C", unitX, currentY + yOffset);
+    temp_.place(valueX, currentY);
     currentY += LINE_HEIGHT_MAIN - 5;
 
-    // Humidity
-    tft.drawString("Humidity:", labelX, currentY);
-    if (!isnan(latestData.humidity)) {
-        tft.drawFloat(latestData.humidity, 1, valueX, currentY);
-        tft.drawString(" %", valueX + tft.textWidth("00.0") + 5, currentY);
-    } else {
-        tft.drawString("---", valueX, currentY);
-    }
+    tft.drawString("Humidity:", labelX, currentY + yOffset);
+    tft.drawString(" %", unitX, currentY + yOffset);
+    hum_.place(valueX, currentY);
     currentY += LINE_HEIGHT_MAIN - 5;
 
-    // Light
-    tft.drawString("Light:", labelX, currentY);
-    if (!isnan(latestData.lux)) {
-        tft.drawFloat(latestData.lux, 0, valueX, currentY);
-        tft.drawString(" lx", valueX + tft.textWidth("00000") + 5, currentY);
-    } else {
-        tft.drawString("---", valueX, currentY);
-    }
+    tft.drawString("Light:", labelX, currentY + yOffset);
+    tft.drawString(" lx", valueX + tft.textWidth("00000") + 5, currentY + yOffset);
+    lux_.place(valueX, currentY);
     currentY += LINE_HEIGHT_MAIN - 5;
 
-    // Noise
-    tft.drawString("Noise:", labelX, currentY);
-    if (!isnan(latestData.decibels)) {
-        tft.drawFloat(latestData.decibels, 1, valueX, currentY);
-        tft.drawString(" dB", valueX + tft.textWidth("00.0") + 5, currentY);
-    } else {
-        tft.drawString("---", valueX, currentY);
-    }
+    tft.drawString("Noise:", labelX, currentY + yOffset);
+    tft.drawString(" dB", unitX, currentY + yOffset);
+    db_.place(valueX, currentY);
     currentY += LINE_HEIGHT_MAIN - 5;
 
     // Separator Line
-    tft.drawFastHLine(H_PADDING_MAIN, currentY, tft.width() - 2 * H_PADDING_MAIN, TFT_DARKGREY);
+    tft.drawFastHLine(H_PADDING_MAIN, currentY + yOffset, tft.width() - 2 * H_PADDING_MAIN, TFT_DARKGREY);
     currentY += V_PADDING_MAIN;
 
+    date_.place(labelX, currentY);
+    clock_.place(labelX, currentY + LINE_HEIGHT_MAIN - 10);
+
+    // Status labels, right aligned; WiFi sits left of the SD label
+    int statusX = tft.width() - H_PADDING_MAIN;
+    drawnSdStatus_ = uiManagerPtr_ && uiManagerPtr_->isSdCardInitialized();
+    sd_.place(statusX, STATUS_Y_MAIN);
+    tft.setTextSize(1);
+    statusX -= (tft.textWidth(drawnSdStatus_ ? "SD" : "SD!") + 10);
+    wifi_.place(statusX, STATUS_Y_MAIN);
+
+    renderValues(yOffset, false);
+
+    tft.setTextDatum(TL_DATUM); // Reset datum
+    tft.setTextColor(TFT_WHITE, TFT_BLACK); // Reset color
+}
+
+bool MainScreen::updateValues() {
+    TFT_eSPI& tft = canvas();
+    if (uiManagerPtr_ && uiManagerPtr_->isSdCardInitialized() != drawnSdStatus_) {
+        return false; // WiFi label position depends on the SD label
+    }
+    bool ok = renderValues(0, true);
+    tft.setTextDatum(TL_DATUM);
+    tft.setTextColor(TFT_WHITE, TFT_BLACK);
+    return ok;
+}
+
+bool MainScreen::renderValues(int yOffset, bool inPlace) {
+    TFT_eSPI& tft = canvas();
+    const EnvironmentData& latestData = getLatestData();
+    char text[ValueField::MAX_TEXT];
+    bool ok = true;
+
+    formatValue(text, sizeof(text), latestData.temperature, 1);
+    ok &= temp_.show(tft, text, yOffset, inPlace);
+    formatValue(text, sizeof(text), latestData.humidity, 1);
+    ok &= hum_.show(tft, text, yOffset, inPlace);
+    formatValue(text, sizeof(text), latestData.lux, 0);
+    ok &= lux_.show(tft, text, yOffset, inPlace);
+    formatValue(text, sizeof(text), latestData.decibels, 1);
+    ok &= db_.show(tft, text, yOffset, inPlace);
+
     // Time (Access timeInitialized via UIManager pointer)
     if (uiManagerPtr_ && uiManagerPtr_->isTimeInitialized()) {
-      struct tm timeinfo;
-      time_t now;
-      time(&now);
-      localtime_r(&now, &timeinfo);
-      char timeString[20];
-      strftime(timeString, sizeof(timeString), "%Y-%m-%d", &timeinfo);
-      tft.drawString(timeString, labelX, currentY);
-      currentY += LINE_HEIGHT_MAIN - 10;
-      strftime(timeString, sizeof(timeString), "%H:%M:%S", &timeinfo);
-      tft.drawString(timeString, labelX, currentY);
+        struct tm timeinfo;
+        time_t now;
+        time(&now);
+        localtime_r(&now, &timeinfo);
+        strftime(text, sizeof(text), "%Y-%m-%d", &timeinfo);
+        ok &= date_.show(tft, text, yOffset, inPlace);
+        strftime(text, sizeof(text), "%H:%M:%S", &timeinfo);
+        ok &= clock_.show(tft, text, yOffset, inPlace);
     } else {
-      tft.drawString("Time not synced", labelX, currentY);
+        ok &= date_.show(tft, "Time not synced", yOffset, inPlace);
+        ok &= clock_.show(tft, "", yOffset, inPlace);
     }
 
     // Status Icons (Access status flags via UIManager pointer)
     if (uiManagerPtr_) {
         bool sdStatus = uiManagerPtr_->isSdCardInitialized();
         bool wifiStatus = uiManagerPtr_->isWifiConnected();
-
-        tft.setTextSize(1);
-        tft.setTextColor(TFT_GREEN, TFT_BLACK);
-        int statusX = tft.width() - H_PADDING_MAIN;
-
-        // SD Status
-        tft.setTextDatum(TR_DATUM);
-        if (sdStatus) {
-            tft.drawString("SD", statusX, STATUS_Y_MAIN + yOffset);
-        } else {
-            tft.setTextColor(TFT_RED, TFT_BLACK);
-            tft.drawString("SD!", statusX, STATUS_Y_MAIN + yOffset);
-            tft.setTextColor(TFT_GREEN, TFT_BLACK);
-        }
-        statusX -= (tft.textWidth(sdStatus ? "SD" : "SD!") + 10);
-
-        // WiFi Status
-        tft.setTextDatum(TR_DATUM);
-        if (wifiStatus) {
-             tft.drawString("WiFi", statusX, STATUS_Y_MAIN + yOffset);
-        } else {
-            tft.setTextColor(TFT_RED, TFT_BLACK);
-            tft.drawString("WiFi!", statusX, STATUS_Y_MAIN + yOffset);
-            tft.setTextColor(TFT_GREEN, TFT_BLACK);
-        }
+        sd_.setColor(sdStatus ? TFT_GREEN : TFT_RED);
+        ok &= sd_.show(tft, sdStatus ? "SD" : "SD!", yOffset, inPlace);
+        wifi_.setColor(wifiStatus ? TFT_GREEN : TFT_RED);
+        ok &= wifi_.show(tft, wifiStatus ? "WiFi" : "WiFi!", yOffset, inPlace);
     }
-
-    tft.setTextDatum(TL_DATUM); // Reset datum
-    tft.setTextColor(TFT_WHITE, TFT_BLACK); // Reset color
+    return ok;
 }
@@ -2,6 +2,7 @@
 #define MAIN_SCREEN_H
 
 #include "screen.h"
+#include "ui_widgets.h"
 
 // Forward declaration
 class DataManager;
@@ -12,6 +13,21 @@ public:
     MainScreen(TFT_eSPI& display, DataManager& dataMgr);
 
     void draw(int yOffset = 0) override;
+    bool updateValues() override;
+
+private:
+    // Value widgets; labels, units and the separator are static and only drawn by draw()
+    ValueField temp_;
+    ValueField hum_;
+    ValueField lux_;
+    ValueField db_;
+    ValueField date_;   // Date, or "Time not synced"
+    ValueField clock_;  // Time of day, empty while not synced
+    ValueField sd_;
+    ValueField wifi_;
+    bool drawnSdStatus_; // The WiFi label is placed relative to the SD label's width
+
+    bool renderValues(int yOffset, bool inPlace);
 };
 
 #endif // MAIN_SCREEN_H
@@ -0,0 +1,240 @@
+#include "metrics.h"
+#include <esp_heap_caps.h>
+
+// --- Histogram ---
+
+MetricHistogram::MetricHistogram(const uint32_t* bounds, size_t boundCount, float scale) :
+    bounds_(bounds),
+    boundCount_(min(boundCount, MAX_BUCKETS)),
+    scale_(scale)
+{
+    for (size_t i = 0; i <= MAX_BUCKETS; ++i) {
+        counts_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void MetricHistogram::observe(uint32_t value) {
+    // Per-bucket (non-cumulative) counts; render() accumulates them
+    size_t i = 0;
+    while (i < boundCount_ && value > bounds_[i]) {
+        ++i;
+    }
+    counts_[i].fetch_add(1, std::memory_order_relaxed);
+    count_.inc();
+    sum_.inc(value);
+}
+
+// --- Writer ---
+
+MetricsWriter::MetricsWriter(uint8_t* buf, size_t maxLen, size_t unitsToSkip) :
+    buf_(buf),
+    maxLen_(maxLen),
+    skip_(unitsToSkip),
+    written_(0),
+    unitsWritten_(0),
+    full_(false)
+{}
+
+bool MetricsWriter::beginUnit() {
+    if (full_) return false;
+    if (skip_ > 0) {
+        skip_--; // Already sent in an earlier chunk, don't even format it
+        return false;
+    }
+    return true;
+}
+
+void MetricsWriter::commitUnit(const char* text, int len) {
+    if (len <= 0) return;
+    size_t n = (size_t)len;
+    if (written_ + n > maxLen_) {
+        if (written_ > 0) {
+            full_ = true; // Retry this unit at the start of the next chunk
+            return;
+        }
+        n = maxLen_; // A single line larger than the whole chunk: truncate rather than stall
+    }
+    memcpy(buf_ + written_, text, n);
+    written_ += n;
+    unitsWritten_++;
+}
+
+void MetricsWriter::header(const char* name, const char* help, const char* type) {
+    if (!beginUnit()) return;
+    char line[192];
+    int len = snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    commitUnit(line, min(len, (int)sizeof(line) - 1));
+}
+
+void MetricsWriter::sample(const char* name, const char* labels, float value) {
+    if (!beginUnit()) return;
+    char line[160];
+    int len = (labels && labels[0])
+        ? snprintf(line, sizeof(line), "%s{%s} %.6g\n", name, labels, value)
+        : snprintf(line, sizeof(line), "%s %.6g\n", name, value);
+    commitUnit(line, min(len, (int)sizeof(line) - 1));
+}
+
+void MetricsWriter::sampleU64(const char* name, const char* labels, uint64_t value) {
+    if (!beginUnit()) return;
+    char line[160];
+    int len = (labels && labels[0])
+        ? snprintf(line, sizeof(line), "%s{%s} %llu\n", name, labels, (unsigned long long)value)
+        : snprintf(line, sizeof(line), "%s %llu\n", name, (unsigned long long)value);
+    commitUnit(line, min(len, (int)sizeof(line) - 1));
+}
+
+// --- Registry ---
+
+MetricsRegistry& MetricsRegistry::instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+void MetricsRegistry::addEntry(const char* name, const char* help, const char* labels, EntryType type, void* metric) {
+    if (entryCount_ >= MAX_ENTRIES) {
+        Serial.printf("[Metrics] ERR: Registry full, dropping %s\n", name);
+        return;
+    }
+    entries_[entryCount_++] = Entry{name, help, labels, type, metric};
+}
+
+void MetricsRegistry::addCounter(const char* name, const char* help, MetricCounter* counter, const char* labels) {
+    addEntry(name, help, labels, ENTRY_COUNTER, counter);
+}
+
+void MetricsRegistry::addGauge(const char* name, const char* help, MetricGauge* gauge, const char* labels) {
+    addEntry(name, help, labels, ENTRY_GAUGE, gauge);
+}
+
+void MetricsRegistry::addHistogram(const char* name, const char* help, MetricHistogram* histogram, const char* labels) {
+    addEntry(name, help, labels, ENTRY_HISTOGRAM, histogram);
+}
+
+void MetricsRegistry::addCollector(MetricsCollectorFn fn, void* context) {
+    if (collectorCount_ >= MAX_COLLECTORS) {
+        Serial.println("[Metrics] ERR: Too many collectors");
+        return;
+    }
+    collectors_[collectorCount_++] = Collector{fn, context};
+}
+
+void MetricsRegistry::renderHistogram(MetricsWriter& w, const Entry& e) {
+    const MetricHistogram* h = (const MetricHistogram*)e.metric;
+    char name[96];
+    char labels[96];
+    const char* sep = (e.labels && e.labels[0]) ? "," : "";
+    const char* base = e.labels ? e.labels : "";
+
+    snprintf(name, sizeof(name), "%s_bucket", e.name);
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i <= h->bucketCount(); ++i) {
+        cumulative += h->bucketValue(i);
+        if (i < h->bucketCount()) {
+            snprintf(labels, sizeof(labels), "%s%sle=\"%.6g\"", base, sep, h->bound(i) * h->scale());
+        } else {
+            snprintf(labels, sizeof(labels), "%s%sle=\"+Inf\"", base, sep);
+        }
+        w.sampleU64(name, labels, cumulative);
+    }
+    snprintf(name, sizeof(name), "%s_sum", e.name);
+    w.sample(name, e.labels, (float)((double)h->sum() * h->scale()));
+    snprintf(name, sizeof(name), "%s_count", e.name);
+    w.sampleU64(name, e.labels, h->count());
+}
+
+size_t MetricsRegistry::render(uint8_t* buf, size_t maxLen, size_t& cursor) {
+    MetricsWriter w(buf, maxLen, cursor);
+
+    for (size_t i = 0; i < entryCount_ && !w.full(); ++i) {
+        const Entry& e = entries_[i];
+        // Entries sharing a name (different labels) share one HELP/TYPE header
+        bool firstOfFamily = (i == 0) || strcmp(entries_[i - 1].name, e.name) != 0;
+        switch (e.type) {
+            case ENTRY_COUNTER:
+                if (firstOfFamily) w.header(e.name, e.help, "counter");
+                w.sampleU64(e.name, e.labels, ((MetricCounter*)e.metric)->value());
+                break;
+            case ENTRY_GAUGE:
+                if (firstOfFamily) w.header(e.name, e.help, "gauge");
+                w.sample(e.name, e.labels, ((MetricGauge*)e.metric)->value());
+                break;
+            case ENTRY_HISTOGRAM:
+                if (firstOfFamily) w.header(e.name, e.help, "histogram");
+                renderHistogram(w, e);
+                break;
+        }
+    }
+
+    // Collectors last: their line count may change between chunks (clients come
+    // and go), which would otherwise shift every line after them.
+    for (size_t i = 0; i < collectorCount_ && !w.full(); ++i) {
+        collectors_[i].fn(w, collectors_[i].context);
+    }
+    cursor += w.unitsWritten();
+    return w.written();
+}
+
+// --- System metrics ---
+
+// Bucket bounds in microseconds
+static const uint32_t LOOP_US_BUCKETS[] = {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 500000, 1000000};
+static const uint32_t SD_FLUSH_US_BUCKETS[] = {5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000};
+static const uint32_t SENSOR_US_BUCKETS[] = {500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000};
+static const uint32_t FRAME_US_BUCKETS[] = {2500, 5000, 10000, 16667, 25000, 33333, 50000, 100000};
+static const uint32_t FLUSH_LATENCY_US_BUCKETS[] = {5000, 10000, 16667, 33333, 50000, 100000, 250000};
+
+static void collectHeap(MetricsWriter& w, void* context) {
+    w.header("soundscape_heap_free_bytes", "Free heap", "gauge");
+    w.sample("soundscape_heap_free_bytes", nullptr, (float)ESP.getFreeHeap());
+    w.header("soundscape_heap_largest_free_block_bytes", "Largest allocatable heap block", "gauge");
+    w.sample("soundscape_heap_largest_free_block_bytes", nullptr, (float)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    w.header("soundscape_heap_min_free_bytes", "Lowest free heap since boot", "gauge");
+    w.sample("soundscape_heap_min_free_bytes", nullptr, (float)ESP.getMinFreeHeap());
+}
+
+SystemMetrics::SystemMetrics() :
+    loopTimeUs(LOOP_US_BUCKETS, sizeof(LOOP_US_BUCKETS) / sizeof(LOOP_US_BUCKETS[0]), 1e-6f),
+    sdFlushUs(SD_FLUSH_US_BUCKETS, sizeof(SD_FLUSH_US_BUCKETS) / sizeof(SD_FLUSH_US_BUCKETS[0]), 1e-6f),
+    micReadUs(SENSOR_US_BUCKETS, sizeof(SENSOR_US_BUCKETS) / sizeof(SENSOR_US_BUCKETS[0]), 1e-6f),
+    tempHumReadUs(SENSOR_US_BUCKETS, sizeof(SENSOR_US_BUCKETS) / sizeof(SENSOR_US_BUCKETS[0]), 1e-6f),
+    lightReadUs(SENSOR_US_BUCKETS, sizeof(SENSOR_US_BUCKETS) / sizeof(SENSOR_US_BUCKETS[0]), 1e-6f),
+    queryUs(SD_FLUSH_US_BUCKETS, sizeof(SD_FLUSH_US_BUCKETS) / sizeof(SD_FLUSH_US_BUCKETS[0]), 1e-6f),
+    displayFrameUs(FRAME_US_BUCKETS, sizeof(FRAME_US_BUCKETS) / sizeof(FRAME_US_BUCKETS[0]), 1e-6f),
+    displayFlushLatencyUs(FLUSH_LATENCY_US_BUCKETS, sizeof(FLUSH_LATENCY_US_BUCKETS) / sizeof(FLUSH_LATENCY_US_BUCKETS[0]), 1e-6f),
+    meterFrameUs(FRAME_US_BUCKETS, sizeof(FRAME_US_BUCKETS) / sizeof(FRAME_US_BUCKETS[0]), 1e-6f),
+    inputLatencyUs(LOOP_US_BUCKETS, sizeof(LOOP_US_BUCKETS) / sizeof(LOOP_US_BUCKETS[0]), 1e-6f)
+{
+    MetricsRegistry& r = MetricsRegistry::instance();
+    r.addCollector(collectHeap, nullptr);
+    r.addHistogram("soundscape_loop_duration_seconds", "Main loop iteration time", &loopTimeUs);
+    r.addCounter("soundscape_i2s_overruns_total", "I2S DMA receive queue overflows", &i2sOverruns);
+    r.addHistogram("soundscape_sd_flush_duration_seconds", "Time to append buffered records to the SD log", &sdFlushUs);
+    r.addCounter("soundscape_ws_audio_bytes_sent_total", "Audio WebSocket payload bytes queued to clients", &wsBytesSent);
+    r.addCounter("soundscape_ws_audio_bytes_dropped_total", "Audio WebSocket payload bytes dropped for slow clients", &wsBytesDropped);
+    r.addHistogram("soundscape_sensor_read_duration_seconds", "Sensor read time", &micReadUs, "sensor=\"mic\"");
+    r.addHistogram("soundscape_sensor_read_duration_seconds", "Sensor read time", &tempHumReadUs, "sensor=\"temp_hum\"");
+    r.addHistogram("soundscape_sensor_read_duration_seconds", "Sensor read time", &lightReadUs, "sensor=\"light\"");
+    r.addHistogram("soundscape_query_duration_seconds", "History aggregation query time (cache misses)", &queryUs);
+    r.addCounter("soundscape_query_cache_hits_total", "History queries answered from the result cache", &queryCacheHits);
+    r.addCounter("soundscape_display_spi_bytes_total", "Estimated bytes sent to the TFT over SPI", &displaySpiBytes);
+    r.addCounter("soundscape_display_full_redraws_total", "Full-screen clears and redraws", &displayFullRedraws);
+    r.addCounter("soundscape_display_partial_updates_total", "Data updates drawn by repainting changed fields only", &displayPartialUpdates);
+    r.addGauge("soundscape_display_update_bytes", "Estimated SPI bytes of the last partial update", &displayUpdateBytes);
+    r.addHistogram("soundscape_display_frame_duration_seconds", "Screen transition frame time (composite and push)", &displayFrameUs);
+    r.addCounter("soundscape_display_frames_flushed_total", "Frames pushed to the panel by the display flush task", &displayFramesFlushed);
+    r.addCounter("soundscape_display_frames_dropped_total", "Frames merged into the next one because the flush task was busy", &displayFramesDropped);
+    r.addHistogram("soundscape_display_flush_latency_seconds", "Time from frame submit until it is on the panel", &displayFlushLatencyUs);
+    r.addGauge("soundscape_meter_fps", "Level meter screen frame rate", &meterFps);
+    r.addCounter("soundscape_meter_deferred_bands_total", "Spectrum bars deferred to the next frame by the frame budget", &meterDeferredBands);
+    r.addHistogram("soundscape_meter_frame_duration_seconds", "Level meter frame render time", &meterFrameUs);
+    r.addCounter("soundscape_led_frames_total", "LED strip frames sent through the RMT peripheral", &ledFramesSent);
+    r.addCounter("soundscape_led_frames_skipped_total", "LED strip frames deferred because the previous transfer was still running", &ledFramesSkipped);
+    r.addCounter("soundscape_input_events_dropped_total", "Button edges or events lost because the main loop fell behind", &inputEventsDropped);
+    r.addHistogram("soundscape_input_latency_seconds", "Time from a button edge until its action runs", &inputLatencyUs);
+    r.addCounter("soundscape_mem_pool_misses_total", "Steady-state buffers that fell back to the heap", &jsonArenaOverflows, "pool=\"json_arena\"");
+    r.addCounter("soundscape_mem_pool_misses_total", "Steady-state buffers that fell back to the heap", &httpBodyPoolMisses, "pool=\"http_body\"");
+    r.addCounter("soundscape_mem_pool_misses_total", "Steady-state buffers that fell back to the heap", &audioFramePoolMisses, "pool=\"audio_frame\"");
+}
+
+SystemMetrics systemMetrics;
@@ -0,0 +1,201 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <atomic>
+
+/**
+ * 轻量级指标注册表 (Prometheus text exposition format)
+ *
+ * - Counter / Gauge / Histogram 只使用 32 位原子操作，可在任意任务或 ISR 中更新，无锁。
+ * - 64 位计数通过低 32 位溢出时进位到高 32 位实现，读取时做一致性重试。
+ * - render() 直接写入调用者提供的缓冲区 (无堆分配)，按整行分段输出，
+ *   适配 AsyncWebServer 的 chunked response。
+ */
+
+// Monotonic 64-bit counter built from two lock-free 32-bit atomics.
+class MetricCounter {
+public:
+    MetricCounter() : low_(0), high_(0) {}
+
+    void inc(uint32_t n = 1) {
+        uint32_t old = low_.fetch_add(n, std::memory_order_relaxed);
+        if ((uint32_t)(old + n) < old) {
+            high_.fetch_add(1, std::memory_order_relaxed); // Carry
+        }
+    }
+
+    uint64_t value() const {
+        uint32_t hi, lo;
+        do {
+            hi = high_.load(std::memory_order_relaxed);
+            lo = low_.load(std::memory_order_relaxed);
+        } while (hi != high_.load(std::memory_order_relaxed));
+        return ((uint64_t)hi << 32) | lo;
+    }
+
+private:
+    std::atomic<uint32_t> low_;
+    std::atomic<uint32_t> high_;
+};
+
+// Last-value gauge. Stored as float bits so set() is a single atomic store.
+class MetricGauge {
+public:
+    MetricGauge() : bits_(0) {}
+
+    void set(float v) {
+        uint32_t b;
+        memcpy(&b, &v, sizeof(b));
+        bits_.store(b, std::memory_order_relaxed);
+    }
+
+    float value() const {
+        uint32_t b = bits_.load(std::memory_order_relaxed);
+        float v;
+        memcpy(&v, &b, sizeof(v));
+        return v;
+    }
+
+private:
+    std::atomic<uint32_t> bits_;
+};
+
+// Fixed-bucket histogram over integer observations (e.g. microseconds).
+// Bucket bounds are inclusive upper limits in observation units; 'scale' converts
+// units to the exported base unit (1e-6 renders microseconds as seconds).
+class MetricHistogram {
+public:
+    static const size_t MAX_BUCKETS = 12;
+
+    MetricHistogram(const uint32_t* bounds, size_t boundCount, float scale = 1.0f);
+
+    void observe(uint32_t value);
+
+    size_t bucketCount() const { return boundCount_; }
+    uint32_t bound(size_t i) const { return bounds_[i]; }
+    uint32_t bucketValue(size_t i) const { return counts_[i].load(std::memory_order_relaxed); } // i == bucketCount() is +Inf
+    uint64_t count() const { return count_.value(); }
+    uint64_t sum() const { return sum_.value(); }
+    float scale() const { return scale_; }
+
+private:
+    const uint32_t* bounds_;
+    size_t boundCount_;
+    float scale_;
+    std::atomic<uint32_t> counts_[MAX_BUCKETS + 1];
+    MetricCounter count_;
+    MetricCounter sum_;
+};
+
+// Sink used by render() and by collectors. Output is produced in whole lines
+// ("units"); a render call skips the units already sent in earlier chunks and
+// stops at the first unit that does not fit, so no line is ever split.
+class MetricsWriter {
+public:
+    MetricsWriter(uint8_t* buf, size_t maxLen, size_t unitsToSkip);
+
+    void header(const char* name, const char* help, const char* type);
+    void sample(const char* name, const char* labels, float value);
+    void sampleU64(const char* name, const char* labels, uint64_t value);
+
+    size_t written() const { return written_; }
+    size_t unitsWritten() const { return unitsWritten_; }
+    bool full() const { return full_; }
+
+private:
+    uint8_t* buf_;
+    size_t maxLen_;
+    size_t skip_;        // Units still to skip (sent in previous chunks)
+    size_t written_;
+    size_t unitsWritten_;
+    bool full_;
+
+    bool beginUnit();    // false if this unit is skipped or the buffer is full
+    void commitUnit(const char* text, int len);
+};
+
+typedef void (*MetricsCollectorFn)(MetricsWriter& writer, void* context);
+
+class MetricsRegistry {
+public:
+    static MetricsRegistry& instance();
+
+    // name / help / labels must be string literals (or otherwise outlive the registry).
+    // labels is either nullptr or a Prometheus label set without braces, e.g. "sensor=\"mic\"".
+    void addCounter(const char* name, const char* help, MetricCounter* counter, const char* labels = nullptr);
+    void addGauge(const char* name, const char* help, MetricGauge* gauge, const char* labels = nullptr);
+    void addHistogram(const char* name, const char* help, MetricHistogram* histogram, const char* labels = nullptr);
+    // Collectors emit samples computed at scrape time (heap, per-client values).
+    // They are rendered after all registered entries.
+    void addCollector(MetricsCollectorFn fn, void* context);
+
+    // Renders the next part of the exposition text into buf. 'cursor' counts lines
+    // already produced and must start at 0 for each scrape.
+    // Returns bytes written; 0 once the whole document has been produced.
+    size_t render(uint8_t* buf, size_t maxLen, size_t& cursor);
+
+private:
+    MetricsRegistry() : entryCount_(0), collectorCount_(0) {}
+
+    enum EntryType : uint8_t { ENTRY_COUNTER, ENTRY_GAUGE, ENTRY_HISTOGRAM };
+    struct Entry {
+        const char* name;
+        const char* help;
+        const char* labels;
+        EntryType type;
+        void* metric;
+    };
+    struct Collector {
+        MetricsCollectorFn fn;
+        void* context;
+    };
+
+    static const size_t MAX_ENTRIES = 48;
+    static const size_t MAX_COLLECTORS = 8;
+    Entry entries_[MAX_ENTRIES];
+    size_t entryCount_;
+    Collector collectors_[MAX_COLLECTORS];
+    size_t collectorCount_;
+
+    void addEntry(const char* name, const char* help, const char* labels, EntryType type, void* metric);
+    void renderHistogram(MetricsWriter& w, const Entry& e);
+};
+
+// Firmware-wide hot-path metrics, registered on construction.
+struct SystemMetrics {
+    SystemMetrics();
+
+    MetricHistogram loopTimeUs;       // loop() iteration time
+    MetricCounter i2sOverruns;        // I2S DMA receive queue overflows (ISR)
+    MetricHistogram sdFlushUs;        // saveEnvironmentDataToSDInternal duration
+    MetricCounter wsBytesSent;        // /audio WebSocket payload bytes queued
+    MetricCounter wsBytesDropped;     // /audio payload bytes dropped for slow clients
+    MetricHistogram micReadUs;        // Sensor read durations
+    MetricHistogram tempHumReadUs;
+    MetricHistogram lightReadUs;
+    MetricHistogram queryUs;          // DataManager::runQuery (cache misses)
+    MetricCounter queryCacheHits;
+    MetricCounter displaySpiBytes;    // Estimated TFT SPI traffic (pixels * 2 + window commands)
+    MetricCounter displayFullRedraws; // fillScreen + draw()
+    MetricCounter displayPartialUpdates; // In-place widget refreshes
+    MetricGauge displayUpdateBytes;   // SPI bytes of the last partial update
+    MetricHistogram displayFrameUs;   // Transition frame: composite + push to the panel
+    MetricCounter displayFramesFlushed; // Frames pushed by the DisplayFlusher task
+    MetricCounter displayFramesDropped; // Frames merged into the next one (flush still busy)
+    MetricHistogram displayFlushLatencyUs; // submit() to the frame being on the panel
+    MetricGauge meterFps;             // Level meter screen: measured frame rate
+    MetricCounter meterDeferredBands; // Spectrum bars left for the next frame (over budget)
+    MetricHistogram meterFrameUs;     // Level meter frame render time
+    MetricCounter ledFramesSent;      // LED frames queued on the RMT channel
+    MetricCounter ledFramesSkipped;   // LED frames deferred because the last transfer was still running
+    MetricCounter inputEventsDropped; // Button edges / events lost to a full ring or queue
+    MetricHistogram inputLatencyUs;   // Button edge to its action running in loop()
+    MetricCounter jsonArenaOverflows; // JSON document blocks that did not fit the request arena (heap fallback)
+    MetricCounter httpBodyPoolMisses; // HTTP JSON responses built on the heap because the body pool was empty
+    MetricCounter audioFramePoolMisses; // Audio WebSocket frames allocated because every pooled frame was in flight
+};
+
+extern SystemMetrics systemMetrics;
+
+#endif // METRICS_H
@@ -5,11 +5,13 @@
 
 // Constructor implementation - Pass DataManager reference to base class
 NoiseScreen::NoiseScreen(TFT_eSPI& display, DataManager& dataMgr) :
-    Screen(display, dataMgr) // Call base class constructor with DataManager
+    Screen(display, dataMgr), // Call base class constructor with DataManager
+    value_(TC_DATUM, 5, TFT_WHITE, TFT_NAVY)
 {}
 
 // draw() method implementation
 void NoiseScreen::draw(int yOffset /* = 0 */) {
+    TFT_eSPI& tft = canvas();
     tft.setTextColor(TFT_WHITE, TFT_NAVY); // Set color
 
     // Title - Centered, Size 3
@@ -18,23 +20,36 @@ void NoiseScreen::draw(int yOffset /* = 0 */) {
     // Use TITLE_Y from ui_constants.h
     tft.drawString("Noise Level", tft.width() / 2, TITLE_Y + 10 + yOffset);
 
+    // Unit - Below value, Size 3
+    int valueY = tft.height() / 2 - 20;
+    tft.drawString("dB", tft.width() / 2, valueY + 50 + yOffset);
+
     // Value - Centered, Large Size 5
-    tft.setTextSize(5);
-    int valueY = tft.height() / 2 - 20 + yOffset;
+    value_.place(tft.width() / 2, valueY);
+    renderValues(yOffset, false);
+
+    tft.setTextDatum(TL_DATUM); // Reset datum
+}
+
+bool NoiseScreen::updateValues() {
+    TFT_eSPI& tft = canvas();
+    bool ok = renderValues(0, true);
+    tft.setTextDatum(TL_DATUM);
+    return ok;
+}
+
+bool NoiseScreen::renderValues(int yOffset, bool inPlace) {
+    TFT_eSPI& tft = canvas();
     // Use getLatestData() helper from base class (which now uses DataManager)
     const EnvironmentData& latestData = getLatestData();
+    char text[ValueField::MAX_TEXT];
 
     // Check decibels value
     // Use DB_MIN from ui_constants.h
     if (!isnan(latestData.decibels) && latestData.decibels >= DB_MIN) {
-        tft.drawFloat(latestData.decibels, 1, tft.width() / 2, valueY);
+        formatValue(text, sizeof(text), latestData.decibels, 1);
     } else {
-        tft.drawString("---", tft.width() / 2, valueY);
+        strlcpy(text, "---", sizeof(text));
     }
-
-    // Unit - Below value, Size 3
-    tft.setTextSize(3);
-    tft.drawString("dB", tft.width() / 2, valueY + 50); // Apply offset (relative to valueY)
-
-    tft.setTextDatum(TL_DATUM); // Reset datum
+    return value_.show(tft, text, yOffset, inPlace);
 }
@@ -2,6 +2,7 @@
 #define NOISE_SCREEN_H
 
 #include "screen.h"
+#include "ui_widgets.h"
 
 // Forward declaration
 class DataManager;
@@ -12,6 +13,12 @@ public:
     NoiseScreen(TFT_eSPI& display, DataManager& dataMgr);
 
     void draw(int yOffset = 0) override;
+    bool updateValues() override;
+
+private:
+    ValueField value_;
+
+    bool renderValues(int yOffset, bool inPlace);
 };
 
 #endif // NOISE_SCREEN_H
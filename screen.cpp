@@ -3,11 +3,19 @@
 
 // Constructor Implementation
 Screen::Screen(TFT_eSPI& display, DataManager& dataMgr) :
-    tft(display),
+    display_(display),
+    output_(&display),
+    canvas_(&display),
     dataManager_(dataMgr),
     uiManagerPtr_(nullptr) // Initialize uiManagerPtr_ to nullptr
 {}
 
+void Screen::renderTo(TFT_eSPI& target) {
+    canvas_ = &target;
+    draw(0);
+    canvas_ = output_;
+}
+
 // getLatestData Implementation
 const EnvironmentData& Screen::getLatestData() const {
     // Now we have the full definition of DataManager, so we can call its methods
@@ -26,14 +26,39 @@ public:
     // Draw the screen content
     virtual void draw(int yOffset = 0) = 0; // Pure virtual
 
+    // Repaint only the value widgets that changed since the last draw (dirty regions).
+    // Returns false if the screen cannot be updated in place (not drawn yet, layout
+    // changed, or no widgets) and UIManager must clear the screen and call draw().
+    virtual bool updateValues() { return false; }
+
+    // Animated screens return their current frame interval (0 = static screen). While
+    // the screen is active and drawn, UIManager calls renderFrame() at most that often;
+    // a frame should stop and defer remaining work once it has used budgetUs.
+    virtual uint32_t frameIntervalUs() const { return 0; }
+    virtual void renderFrame(uint32_t budgetUs) {}
+
     // Handle input events
     virtual bool handleInput(UIManager* uiManager, int buttonPin) { return false; }
 
+    // Draw the complete screen into an off-screen target (a sprite for transitions)
+    // instead of the display. Widgets remember screen coordinates, so once the
+    // target has been pushed at offset 0 updateValues() can repaint in place.
+    void renderTo(TFT_eSPI& target);
+
+    // Where draw()/updateValues()/renderFrame() render: the display, or the back
+    // buffer of the DisplayFlusher (set by UIManager before each use)
+    void setOutput(TFT_eSPI& target) { output_ = &target; canvas_ = &target; }
+
 protected:
-    TFT_eSPI& tft;           // Reference to the display object
+    TFT_eSPI& display_;      // Reference to the display object
+    TFT_eSPI* output_;       // Normal drawing target (see setOutput)
+    TFT_eSPI* canvas_;       // Where draw() renders: output_, or a sprite during renderTo()
     DataManager& dataManager_; // Reference to the Data Manager
     UIManager* uiManagerPtr_;  // Pointer to the UI Manager (set in onEnter)
 
+    // Drawing target for draw()/updateValues()
+    TFT_eSPI& canvas() { return *canvas_; }
+
     // Helper function Declaration (Implementation moved to .cpp)
     const EnvironmentData& getLatestData() const;
 }; 
@@ -0,0 +1,81 @@
+#include "spectrum_analyzer.h"
+#include <math.h>
+
+SpectrumAnalyzer::SpectrumAnalyzer(uint32_t sampleRate) :
+    sampleRate_(sampleRate)
+{
+    float windowPower = 0.0f;
+    for (size_t i = 0; i < N; i++) {
+        window_[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / N);
+        windowPower += window_[i] * window_[i];
+    }
+    for (size_t i = 0; i < N / 2; i++) {
+        cos_[i] = cosf(2.0f * (float)M_PI * i / N);
+        sin_[i] = -sinf(2.0f * (float)M_PI * i / N);
+    }
+    // One-sided spectrum: each bin k in 1..N/2-1 stands for +k and -k
+    powerScale_ = 2.0f / (N * windowPower);
+
+    // Log-spaced band edges over bins 1..N/2, at least one bin per band
+    const float lastBin = N / 2;
+    bandStart_[0] = 1;
+    for (size_t b = 1; b <= BANDS; b++) {
+        uint16_t edge = (uint16_t)lroundf(powf(lastBin, (float)b / BANDS));
+        bandStart_[b] = max<uint16_t>(edge, bandStart_[b - 1] + 1);
+    }
+    bandStart_[BANDS] = N / 2 + 1; // Include the Nyquist bin in the last band
+}
+
+float SpectrumAnalyzer::bandEdgeHz(size_t i) const {
+    i = min(i, (size_t)BANDS);
+    return (float)bandStart_[i] * sampleRate_ / N;
+}
+
+void SpectrumAnalyzer::compute(const float* samples, float* bandPower) {
+    for (size_t i = 0; i < N; i++) {
+        re_[i] = samples[i] * window_[i];
+        im_[i] = 0.0f;
+    }
+    fft();
+    for (size_t b = 0; b < BANDS; b++) {
+        float sum = 0.0f;
+        for (uint16_t k = bandStart_[b]; k < bandStart_[b + 1] && k <= N / 2; k++) {
+            sum += re_[k] * re_[k] + im_[k] * im_[k];
+        }
+        bandPower[b] = sum * powerScale_;
+    }
+}
+
+// In-place iterative radix-2 decimation-in-time FFT on re_/im_
+void SpectrumAnalyzer::fft() {
+    // Bit-reversal permutation
+    for (size_t i = 1, j = 0; i < N; i++) {
+        size_t bit = N >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            float t = re_[i]; re_[i] = re_[j]; re_[j] = t;
+            t = im_[i]; im_[i] = im_[j]; im_[j] = t;
+        }
+    }
+    for (size_t len = 2; len <= N; len <<= 1) {
+        size_t half = len >> 1;
+        size_t step = N / len; // Twiddle index stride
+        for (size_t start = 0; start < N; start += len) {
+            for (size_t k = 0; k < half; k++) {
+                float wr = cos_[k * step];
+                float wi = sin_[k * step];
+                size_t a = start + k;
+                size_t b = a + half;
+                float tr = re_[b] * wr - im_[b] * wi;
+                float ti = re_[b] * wi + im_[b] * wr;
+                re_[b] = re_[a] - tr;
+                im_[b] = im_[a] - ti;
+                re_[a] += tr;
+                im_[a] += ti;
+            }
+        }
+    }
+}
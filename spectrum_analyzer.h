@@ -0,0 +1,42 @@
+#ifndef SPECTRUM_ANALYZER_H
+#define SPECTRUM_ANALYZER_H
+
+#include <Arduino.h>
+
+/**
+ * 小型频谱分析 (Band spectrum from a 256-point FFT)
+ *
+ * 对一块 N 个样本加 Hann 窗后做基 2 复数 FFT (虚部为 0), 再把 1..N/2 号频点按对数间隔
+ * 合并为 BANDS 个频带, 输出每个频带的均方值 (与时域均方同一量纲, 可直接换算为 dB)。
+ * 16 kHz 采样时频点间隔 62.5 Hz, 频带覆盖 62.5 Hz - 8 kHz。
+ *
+ * 所有表 (窗函数、旋转因子、频带边界) 在构造时计算; compute() 不分配内存,
+ * 在 ESP32-S3 上约 0.2 ms, 供采集任务调用 (非线程安全, 每个实例只能由一个任务使用)。
+ */
+class SpectrumAnalyzer {
+public:
+    static const size_t N = 256;
+    static const size_t BANDS = 16;
+
+    explicit SpectrumAnalyzer(uint32_t sampleRate);
+
+    // samples: N values (DC already removed). bandPower: BANDS mean-square values.
+    void compute(const float* samples, float* bandPower);
+
+    // Lower edge of band i in Hz (i == BANDS gives the upper edge of the last band)
+    float bandEdgeHz(size_t i) const;
+
+private:
+    uint32_t sampleRate_;
+    float window_[N];
+    float cos_[N / 2];
+    float sin_[N / 2];
+    uint16_t bandStart_[BANDS + 1]; // FFT bin index; band i is [bandStart_[i], bandStart_[i + 1])
+    float re_[N];
+    float im_[N];
+    float powerScale_;              // Converts |X[k]|^2 to mean-square contribution
+
+    void fft();
+};
+
+#endif // SPECTRUM_ANALYZER_H
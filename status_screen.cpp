@@ -3,15 +3,26 @@
 #include "data_manager.h" // Include DataManager (though not directly used for data here)
 #include "ui.h" // Include for LED_MODE definitions
 #include "ui_constants.h" // Include constants
+#include "heap_tracker.h"
+#include <esp_heap_caps.h>
 #include <WiFi.h> // Still needed for WiFi.localIP()
 
 // Constructor implementation - Pass DataManager reference to base class
 StatusScreen::StatusScreen(TFT_eSPI& display, DataManager& dataMgr) :
-    Screen(display, dataMgr) // Call base class constructor with DataManager
+    Screen(display, dataMgr), // Call base class constructor with DataManager
+    wifi_(TL_DATUM, 2, TFT_WHITE, TFT_DARKCYAN),
+    ip_(TL_DATUM, 2, TFT_WHITE, TFT_DARKCYAN),
+    sd_(TL_DATUM, 2, TFT_WHITE, TFT_DARKCYAN),
+    time_(TL_DATUM, 2, TFT_WHITE, TFT_DARKCYAN),
+    ledMode_(TL_DATUM, 2, TFT_WHITE, TFT_DARKCYAN),
+    heap_(TL_DATUM, 2, TFT_WHITE, TFT_DARKCYAN),
+    heapTop_(TL_DATUM, 2, TFT_WHITE, TFT_DARKCYAN),
+    drawnWifiStatus_(false)
 {}
 
 // draw() method implementation
 void StatusScreen::draw(int yOffset /* = 0 */) {
+    TFT_eSPI& tft = canvas();
     tft.setTextColor(TFT_WHITE, TFT_DARKCYAN); // Set color
 
     // Title - Centered, Size 2
@@ -24,70 +35,115 @@ void StatusScreen::draw(int yOffset /* = 0 */) {
     // Status Info - Size 2, Aligned
     tft.setTextSize(2);
     // Use TITLE_Y, LINE_HEIGHT, H_PADDING from ui_constants.h
-    int currentY = TITLE_Y + LINE_HEIGHT + yOffset;
+    int currentY = TITLE_Y + LINE_HEIGHT;
     int labelX = H_PADDING;
     int statusX = H_PADDING + 120;
 
     // Access status flags via UIManager pointer (available via base Screen class)
     if (!uiManagerPtr_) {
-        tft.drawString("Error: UIManager N/A", labelX, currentY);
+        tft.drawString("Error: UIManager N/A", labelX, currentY + yOffset);
         return;
     }
 
-    bool wifiStatus = uiManagerPtr_->isWifiConnected();
-    bool sdStatus = uiManagerPtr_->isSdCardInitialized();
-    bool timeStatus = uiManagerPtr_->isTimeInitialized();
-    uint8_t ledMode = uiManagerPtr_->getCurrentLedMode();
-
-    // WiFi Status
-    tft.drawString("WiFi:", labelX, currentY);
-    if (wifiStatus) {
-        tft.setTextColor(TFT_GREEN, TFT_DARKCYAN);
-        tft.drawString("Connected", statusX, currentY);
-        tft.setTextColor(TFT_WHITE, TFT_DARKCYAN);
+    // Labels are static; the status words are widgets
+    drawnWifiStatus_ = uiManagerPtr_->isWifiConnected();
+    tft.drawString("WiFi:", labelX, currentY + yOffset);
+    wifi_.place(statusX, currentY);
+    if (drawnWifiStatus_) {
         currentY += LINE_HEIGHT - 5;
-        tft.drawString("IP:", labelX + 10, currentY);
-        tft.drawString(WiFi.localIP().toString(), statusX, currentY);
-    } else {
-        tft.setTextColor(TFT_RED, TFT_DARKCYAN);
-        tft.drawString("Not Connected", statusX, currentY);
-        tft.setTextColor(TFT_WHITE, TFT_DARKCYAN);
+        tft.drawString("IP:", labelX + 10, currentY + yOffset);
+        ip_.place(statusX, currentY);
     }
     currentY += LINE_HEIGHT;
 
-    // SD Card Status
-    tft.drawString("SD Card:", labelX, currentY);
-    if (sdStatus) {
-        tft.setTextColor(TFT_GREEN, TFT_DARKCYAN);
-        tft.drawString("Mounted", statusX, currentY);
-        tft.setTextColor(TFT_WHITE, TFT_DARKCYAN);
-    } else {
-        tft.setTextColor(TFT_RED, TFT_DARKCYAN);
-        tft.drawString("Failed/Missing", statusX, currentY);
-        tft.setTextColor(TFT_WHITE, TFT_DARKCYAN);
-    }
+    tft.drawString("SD Card:", labelX, currentY + yOffset);
+    sd_.place(statusX, currentY);
     currentY += LINE_HEIGHT;
 
-    // NTP Time Status
-    tft.drawString("NTP Time:", labelX, currentY);
-    if (timeStatus) {
-        tft.setTextColor(TFT_GREEN, TFT_DARKCYAN);
-        tft.drawString("Synced", statusX, currentY);
-        tft.setTextColor(TFT_WHITE, TFT_DARKCYAN);
+    tft.drawString("NTP Time:", labelX, currentY + yOffset);
+    time_.place(statusX, currentY);
+    currentY += LINE_HEIGHT;
+
+    tft.drawString("LED Mode:", labelX, currentY + yOffset);
+    ledMode_.place(statusX, currentY);
+    currentY += LINE_HEIGHT;
+
+    tft.drawString("Heap:", labelX, currentY + yOffset);
+    heap_.place(statusX, currentY);
+    currentY += LINE_HEIGHT;
+
+    tft.drawString("Heap Top:", labelX, currentY + yOffset);
+    heapTop_.place(statusX, currentY);
+
+    renderValues(yOffset, false);
+    tft.setTextColor(TFT_WHITE, TFT_DARKCYAN);
+    tft.setTextDatum(TL_DATUM);
+}
+
+bool StatusScreen::updateValues() {
+    TFT_eSPI& tft = canvas();
+    if (!uiManagerPtr_ || uiManagerPtr_->isWifiConnected() != drawnWifiStatus_) {
+        return false; // Rows move when the IP line appears or disappears
+    }
+    bool ok = renderValues(0, true);
+    tft.setTextColor(TFT_WHITE, TFT_DARKCYAN);
+    tft.setTextDatum(TL_DATUM);
+    return ok;
+}
+
+bool StatusScreen::renderValues(int yOffset, bool inPlace) {
+    TFT_eSPI& tft = canvas();
+    bool ok = true;
+
+    // WiFi Status
+    if (drawnWifiStatus_) {
+        wifi_.setColor(TFT_GREEN);
+        ok &= wifi_.show(tft, "Connected", yOffset, inPlace);
+        char ip[ValueField::MAX_TEXT];
+        strlcpy(ip, WiFi.localIP().toString().c_str(), sizeof(ip));
+        ok &= ip_.show(tft, ip, yOffset, inPlace);
     } else {
-        tft.setTextColor(TFT_YELLOW, TFT_DARKCYAN);
-        tft.drawString("Not Synced", statusX, currentY);
-        tft.setTextColor(TFT_WHITE, TFT_DARKCYAN);
+        wifi_.setColor(TFT_RED);
+        ok &= wifi_.show(tft, "Not Connected", yOffset, inPlace);
     }
-    currentY += LINE_HEIGHT;
+
+    // SD Card Status
+    bool sdStatus = uiManagerPtr_->isSdCardInitialized();
+    sd_.setColor(sdStatus ? TFT_GREEN : TFT_RED);
+    ok &= sd_.show(tft, sdStatus ? "Mounted" : "Failed/Missing", yOffset, inPlace);
+
+    // NTP Time Status
+    bool timeStatus = uiManagerPtr_->isTimeInitialized();
+    time_.setColor(timeStatus ? TFT_GREEN : TFT_YELLOW);
+    ok &= time_.show(tft, timeStatus ? "Synced" : "Not Synced", yOffset, inPlace);
 
     // LED Mode Status
-    tft.drawString("LED Mode:", labelX, currentY);
-    switch(ledMode) {
-        case LED_MODE_OFF: tft.drawString("Off", statusX, currentY); break;
-        case LED_MODE_NOISE: tft.drawString("Noise", statusX, currentY); break;
-        case LED_MODE_TEMP: tft.drawString("Temp", statusX, currentY); break;
-        case LED_MODE_HUMIDITY: tft.drawString("Humidity", statusX, currentY); break;
-        default: tft.drawString("Unknown", statusX, currentY); break;
+    const char* mode;
+    switch (uiManagerPtr_->getCurrentLedMode()) {
+        case LED_MODE_OFF: mode = "Off"; break;
+        case LED_MODE_NOISE: mode = "Noise"; break;
+        case LED_MODE_TEMP: mode = "Temp"; break;
+        case LED_MODE_HUMIDITY: mode = "Humidity"; break;
+        case LED_MODE_VU: mode = "VU Meter"; break;
+        default: mode = "Unknown"; break;
     }
+    ok &= ledMode_.show(tft, mode, yOffset, inPlace);
+
+    // Heap: free / largest block in KB, yellow when fragmented like logMemoryStatus() warns
+    uint32_t freeHeap = ESP.getFreeHeap();
+    uint32_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    char heap[ValueField::MAX_TEXT];
+    snprintf(heap, sizeof(heap), "%luK/%luK", (unsigned long)(freeHeap / 1024), (unsigned long)(largest / 1024));
+    heap_.setColor(largest * 2 < freeHeap ? TFT_YELLOW : TFT_WHITE);
+    ok &= heap_.show(tft, heap, yOffset, inPlace);
+
+    HeapTracker::TagStats stats[HEAP_TAG_COUNT];
+    heapTracker.getStats(stats);
+    uint8_t top = heapTracker.largestTag();
+    char heapTop[ValueField::MAX_TEXT];
+    // "~": scope net growth only (no heap hooks), see heap_tracker.h
+    snprintf(heapTop, sizeof(heapTop), "%s %s%ldK", HeapTracker::tagName(top),
+             HeapTracker::hooksEnabled() ? "" : "~", (long)(stats[top].liveBytes / 1024));
+    ok &= heapTop_.show(tft, heapTop, yOffset, inPlace);
+    return ok;
 }
@@ -2,6 +2,7 @@
 #define STATUS_SCREEN_H
 
 #include "screen.h"
+#include "ui_widgets.h"
 
 // Forward declaration
 class DataManager;
@@ -12,6 +13,19 @@ public:
     StatusScreen(TFT_eSPI& display, DataManager& dataMgr);
 
     void draw(int yOffset = 0) override;
+    bool updateValues() override;
+
+private:
+    ValueField wifi_;
+    ValueField ip_;
+    ValueField sd_;
+    ValueField time_;
+    ValueField ledMode_;
+    ValueField heap_;       // Free / largest free block
+    ValueField heapTop_;    // Subsystem holding the most heap
+    bool drawnWifiStatus_; // The IP row only exists while connected, shifting the rows below
+
+    bool renderValues(int yOffset, bool inPlace);
 };
 
 #endif // STATUS_SCREEN_H
@@ -0,0 +1,74 @@
+#include "telemetry_beacon.h"
+#include "heap_tracker.h"
+#include <esp_random.h>
+
+TelemetryBeacon::TelemetryBeacon(DataManager& dataMgr, const char* group, uint16_t port, bool enabled) :
+    dataManager_(dataMgr),
+    port_(port),
+    enabled_(enabled),
+    bootId_(0),
+    beaconSeq_(0),
+    lastRecordSeq_(0)
+{
+    if (!group_.fromString(group) || !group_.isMulticast()) {
+        enabled_ = false;
+    }
+    memset(deviceId_, 0, sizeof(deviceId_));
+    MetricsRegistry& r = MetricsRegistry::instance();
+    r.addCounter("soundscape_beacon_sent_total", "Telemetry beacons sent", &sent_);
+    r.addCounter("soundscape_beacon_send_errors_total", "Telemetry beacons that failed to send", &sendErrors_);
+}
+
+void TelemetryBeacon::begin() {
+    if (!enabled_) {
+        Serial.println("[TelemetryBeacon] Disabled.");
+        return;
+    }
+    WiFi.macAddress(deviceId_);
+    bootId_ = (uint16_t)esp_random();
+    // Start after the current record so a reboot does not resend an old one
+    lastRecordSeq_ = dataManager_.getLastSeq();
+    Serial.printf("[TelemetryBeacon] Sending to %s:%u (boot id %04x)\n",
+                  group_.toString().c_str(), port_, bootId_);
+}
+
+void TelemetryBeacon::update() {
+    HeapScope heapScope(HEAP_TAG_COMM);
+    if (!enabled_) return;
+    uint32_t recordSeq = dataManager_.getLastSeq();
+    if (recordSeq == lastRecordSeq_) return;
+    if (!WiFi.isConnected()) {
+        lastRecordSeq_ = recordSeq; // Not buffered; SYNC recovers the records
+        return;
+    }
+
+    // Every record since the last beacon, oldest first, from the RAM ring (no SD access):
+    // a slow loop iteration must not skip records behind a single beacon seq step
+    SyncCursor cursor(lastRecordSeq_);
+    cursor.phase = SyncCursor::PHASE_RAM;
+    EnvironmentData records[MAX_RECORDS_PER_UPDATE];
+    size_t count = dataManager_.readRecordsSince(cursor, records, MAX_RECORDS_PER_UPDATE);
+    lastRecordSeq_ = count > 0 ? cursor.lastSeq : recordSeq;
+
+    uint8_t datagram[BEACON_SIZE];
+    for (size_t i = 0; i < count; ++i) {
+        size_t len = encode(datagram, records[i]);
+        if (udp_.beginPacket(group_, port_) && udp_.write(datagram, len) == len && udp_.endPacket()) {
+            sent_.inc();
+        } else {
+            sendErrors_.inc();
+        }
+    }
+}
+
+size_t TelemetryBeacon::encode(uint8_t* out, const EnvironmentData& record) {
+    out[0] = 'S';
+    out[1] = 'B';
+    out[2] = BEACON_VERSION;
+    out[3] = record.flags;
+    memcpy(out + 4, deviceId_, sizeof(deviceId_));
+    WireProtocol::putU16(out + 10, bootId_);
+    WireProtocol::putU32(out + 12, ++beaconSeq_);
+    WireProtocol::encodeEnvRecord(out + 16, record);
+    return BEACON_SIZE;
+}
@@ -0,0 +1,62 @@
+#ifndef TELEMETRY_BEACON_H
+#define TELEMETRY_BEACON_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include "data_manager.h"
+#include "wire_protocol.h"
+#include "metrics.h"
+
+/**
+ * UDP 组播遥测信标 (Multicast telemetry beacons for fleet collection)
+ *
+ * 每产生一条新记录就向配置的组播组发送一个定长小端数据报, 采集端用一个 socket
+ * 即可接收整个局域网内所有设备的数据 (见 tools/beacon_receiver.py)。
+ * 两次 update() 之间产生了多条记录时逐条发送 (从 RAM 环形缓冲读取, 每次最多
+ * MAX_RECORDS_PER_UPDATE 条, 剩下的下一次发送), 因此每条记录对应一个信标序号。
+ *
+ * 数据报布局 (BEACON_SIZE = 34 bytes):
+ *   off  size
+ *   0    2    magic "SB"
+ *   2    1    version (BEACON_VERSION)
+ *   3    1    record flags (EnvironmentData::Flags)
+ *   4    6    device id (WiFi STA MAC)
+ *   10   2    boot id (random per boot; a change resets the sequence)
+ *   12   4    beacon seq (per boot, starts at 1, +1 per datagram) - gaps = lost datagrams
+ *   16   18   record in SCHEMA_ENV_V2 layout (record seq, timestamp, packed fields)
+ *
+ * 发送是 fire-and-forget: 链路断开时不缓存, 直接跳过 (记录仍在 SD 上, 可用 SYNC 补齐)。
+ */
+class TelemetryBeacon {
+public:
+    static const uint8_t BEACON_VERSION = 1;
+    static const size_t BEACON_SIZE = 16 + WireProtocol::ENV_RECORD_SIZE;
+    static const size_t MAX_RECORDS_PER_UPDATE = 8; // Datagrams per update(); the rest follow next time
+
+    // group/port: multicast destination. enabled=false keeps the beacon off.
+    TelemetryBeacon(DataManager& dataMgr, const char* group, uint16_t port, bool enabled);
+
+    void begin();
+    void update(); // Called in loop; sends when a new record is available
+
+    bool isEnabled() const { return enabled_; }
+
+private:
+    DataManager& dataManager_;
+    IPAddress group_;
+    uint16_t port_;
+    bool enabled_;
+    WiFiUDP udp_;
+    uint8_t deviceId_[6];
+    uint16_t bootId_;
+    uint32_t beaconSeq_;
+    uint32_t lastRecordSeq_; // Record seq of the last beacon (0 = none)
+
+    MetricCounter sent_;
+    MetricCounter sendErrors_;
+
+    size_t encode(uint8_t* out, const EnvironmentData& record);
+};
+
+#endif // TELEMETRY_BEACON_H
@@ -4,11 +4,16 @@
 
 // Constructor implementation - Pass DataManager reference to base class
 TempHumScreen::TempHumScreen(TFT_eSPI& display, DataManager& dataMgr) :
-    Screen(display, dataMgr) // Call base class constructor with DataManager
+    Screen(display, dataMgr), // Call base class constructor with DataManager
+    temp_(TR_DATUM, 3, TFT_WHITE, TFT_DARKGREEN),
+    tempUnit_(TR_DATUM, 3, TFT_WHITE, TFT_DARKGREEN),
+    hum_(TR_DATUM, 3, TFT_WHITE, TFT_DARKGREEN),
+    humUnit_(TR_DATUM, 3, TFT_WHITE, TFT_DARKGREEN)
 {}
 
 // draw() method implementation
 void TempHumScreen::draw(int yOffset /* = 0 */) {
+    TFT_eSPI& tft = canvas();
     tft.setTextColor(TFT_WHITE, TFT_DARKGREEN); // Set color
 
     // Title - Centered, Size 2
@@ -20,34 +25,45 @@ void TempHumScreen::draw(int yOffset /* = 0 */) {
 
     // Layout values
     // Use TITLE_Y, H_PADDING from ui_constants.h
-    int valueY = TITLE_Y + 40 + yOffset;
+    int valueY = TITLE_Y + 40;
     int labelX = H_PADDING + 10;
     int valueX = tft.width() - H_PADDING - 50;
 
-    // Use getLatestData() helper from base class (which now uses DataManager)
-    const EnvironmentData& latestData = getLatestData();
-
-    // Temperature - Size 3
+    // Labels - Size 3; values and units are widgets
     tft.setTextSize(3);
-    tft.drawString("Temp:", labelX, valueY + 5);
-    tft.setTextDatum(TR_DATUM);
-    if (!isnan(latestData.temperature)) {
-        tft.drawFloat(latestData.temperature, 1, valueX, valueY);
-        tft.drawString("C", valueX + 25, valueY + 5);
-    } else {
-        tft.drawString("---", valueX, valueY);
-    }
-    tft.setTextDatum(TL_DATUM);
+    tft.drawString("Temp:", labelX, valueY + 5 + yOffset);
+    temp_.place(valueX, valueY);
+    tempUnit_.place(valueX + 25, valueY + 5);
     valueY += 70;
 
-    // Humidity - Size 3
-    tft.drawString("Humidity:", labelX, valueY + 5);
-    tft.setTextDatum(TR_DATUM);
-    if (!isnan(latestData.humidity)) {
-        tft.drawFloat(latestData.humidity, 1, valueX, valueY);
-        tft.drawString("%", valueX + 25, valueY + 5);
-    } else {
-        tft.drawString("---", valueX, valueY);
-    }
+    tft.drawString("Humidity:", labelX, valueY + 5 + yOffset);
+    hum_.place(valueX, valueY);
+    humUnit_.place(valueX + 25, valueY + 5);
+
+    renderValues(yOffset, false);
+    tft.setTextDatum(TL_DATUM);
+}
+
+bool TempHumScreen::updateValues() {
+    TFT_eSPI& tft = canvas();
+    bool ok = renderValues(0, true);
     tft.setTextDatum(TL_DATUM);
+    return ok;
+}
+
+bool TempHumScreen::renderValues(int yOffset, bool inPlace) {
+    TFT_eSPI& tft = canvas();
+    // Use getLatestData() helper from base class (which now uses DataManager)
+    const EnvironmentData& latestData = getLatestData();
+    char text[ValueField::MAX_TEXT];
+    bool ok = true;
+
+    formatValue(text, sizeof(text), latestData.temperature, 1);
+    ok &= temp_.show(tft, text, yOffset, inPlace);
+    ok &= tempUnit_.show(tft, isnan(latestData.temperature) ? "" : "C", yOffset, inPlace);
+
+    formatValue(text, sizeof(text), latestData.humidity, 1);
+    ok &= hum_.show(tft, text, yOffset, inPlace);
+    ok &= humUnit_.show(tft, isnan(latestData.humidity) ? "" : "%", yOffset, inPlace);
+    return ok;
 }
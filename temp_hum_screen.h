@@ -2,6 +2,7 @@
 #define TEMP_HUM_SCREEN_H
 
 #include "screen.h"
+#include "ui_widgets.h"
 
 // Forward declaration
 class DataManager;
@@ -12,6 +13,15 @@ public:
     TempHumScreen(TFT_eSPI& display, DataManager& dataMgr);
 
     void draw(int yOffset = 0) override;
+    bool updateValues() override;
+
+private:
+    ValueField temp_;
+    ValueField tempUnit_; // Units are hidden while the value is missing
+    ValueField hum_;
+    ValueField humUnit_;
+
+    bool renderValues(int yOffset, bool inPlace);
 };
 
 #endif // TEMP_HUM_SCREEN_H
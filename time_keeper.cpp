@@ -0,0 +1,131 @@
+#include "time_keeper.h"
+#include <esp_timer.h>
+#include <esp_sntp.h>
+#include <sys/time.h>
+
+TimeKeeper::TimeKeeper() :
+    synced_(false),
+    baseMonoUs_(0),
+    baseWallUs_(0),
+    slewUs_(0),
+    driftPpm_(0.0f),
+    lastSyncMonoUs_(0),
+    lastSyncWallUs_(0)
+{
+    portMUX_INITIALIZE(&mux_);
+    MetricsRegistry& r = MetricsRegistry::instance();
+    r.addGauge("soundscape_time_synced", "1 once the wall clock has been set from NTP", &syncedGauge_);
+    r.addCounter("soundscape_time_syncs_total", "SNTP sync results applied", &syncCount_);
+    r.addGauge("soundscape_time_drift_ppm", "Estimated local clock drift", &driftPpmGauge_);
+    r.addGauge("soundscape_time_last_offset_seconds", "Clock error measured at the last sync", &lastOffsetGauge_);
+}
+
+void TimeKeeper::startSync(const char* ntpServer, long gmtOffsetSec, int daylightOffsetSec) {
+    // Smooth mode: lwIP adjusts the system clock with adjtime() instead of stepping
+    // it, so time() users (screen clock) do not see backward jumps either.
+    sntp_set_sync_mode(SNTP_SYNC_MODE_SMOOTH);
+    sntp_set_sync_interval(RESYNC_INTERVAL_MS);
+    sntp_set_time_sync_notification_cb(sntpSyncCallback);
+    configTime(gmtOffsetSec, daylightOffsetSec, ntpServer); // Starts SNTP and returns immediately
+    Serial.printf("[TimeKeeper] SNTP started (%s, resync every %lu s)\n",
+                  ntpServer, (unsigned long)(RESYNC_INTERVAL_MS / 1000));
+}
+
+void TimeKeeper::sntpSyncCallback(struct timeval* tv) {
+    // Called from the lwIP task with the NTP time (before any smoothing)
+    if (tv) {
+        timeKeeper.onSync((int64_t)tv->tv_sec * 1000000LL + tv->tv_usec);
+    }
+}
+
+void TimeKeeper::onSync(int64_t ntpWallUs) {
+    int64_t monoUs = monotonicUs();
+    int64_t errorUs = 0;
+    bool first = false;
+
+    portENTER_CRITICAL(&mux_);
+    if (!synced_) {
+        first = true;
+        baseMonoUs_ = monoUs;
+        baseWallUs_ = ntpWallUs;
+        slewUs_ = 0;
+        synced_ = true;
+    } else {
+        int64_t predicted = wallAtLocked(monoUs);
+        errorUs = ntpWallUs - predicted;
+
+        // Drift from the NTP-vs-local elapsed time over a long enough interval
+        int64_t interval = monoUs - lastSyncMonoUs_;
+        if (interval >= MIN_DRIFT_INTERVAL_US) {
+            float measured = (float)((double)((ntpWallUs - lastSyncWallUs_) - interval) * 1e6 / (double)interval);
+            float smoothed = (driftPpm_ == 0.0f) ? measured : 0.75f * driftPpm_ + 0.25f * measured;
+            driftPpm_ = constrain(smoothed, -MAX_DRIFT_PPM, MAX_DRIFT_PPM);
+        }
+
+        // Re-base at the current (continuous) reading; the error is slewed out
+        // from here unless it is a large forward error, which is safe to step.
+        baseMonoUs_ = monoUs;
+        if (errorUs > STEP_THRESHOLD_US) {
+            baseWallUs_ = ntpWallUs;
+            slewUs_ = 0;
+        } else {
+            baseWallUs_ = predicted;
+            slewUs_ = errorUs;
+        }
+    }
+    lastSyncMonoUs_ = monoUs;
+    lastSyncWallUs_ = ntpWallUs;
+    float driftPpm = driftPpm_;
+    portEXIT_CRITICAL(&mux_);
+
+    syncCount_.inc();
+    syncedGauge_.set(1.0f);
+    driftPpmGauge_.set(driftPpm);
+    lastOffsetGauge_.set((float)errorUs / 1e6f);
+    // Serial from the lwIP task is fine at this rate (once per resync interval)
+    Serial.printf("[TimeKeeper] %s: offset %lld ms, drift %.1f ppm\n",
+                  first ? "First sync" : "Resync", (long long)(errorUs / 1000), driftPpm);
+}
+
+int64_t TimeKeeper::wallAtLocked(int64_t monoUs) const {
+    int64_t dt = monoUs - baseMonoUs_;
+    int64_t wall = baseWallUs_ + dt + (int64_t)((double)dt * driftPpm_ / 1e6);
+    if (dt > 0 && slewUs_ != 0) {
+        // Apply at most SLEW_PPM of the elapsed time: the rate never drops below
+        // (1 - drift - slew) > 0, so readings stay monotonic.
+        int64_t maxSlew = dt * SLEW_PPM / 1000000;
+        wall += constrain(slewUs_, -maxSlew, maxSlew);
+    }
+    return wall;
+}
+
+int64_t TimeKeeper::monotonicUs() const {
+    return esp_timer_get_time();
+}
+
+int64_t TimeKeeper::nowWallUs() const {
+    if (!synced_) return 0;
+    int64_t monoUs = monotonicUs();
+    portENTER_CRITICAL(&mux_);
+    int64_t wall = wallAtLocked(monoUs);
+    portEXIT_CRITICAL(&mux_);
+    return wall;
+}
+
+TimeKeeper::Stamp TimeKeeper::stamp() const {
+    Stamp s;
+    s.synced = synced_;
+    s.seconds = s.synced ? (time_t)(nowWallUs() / 1000000LL) : (time_t)(monotonicUs() / 1000000LL);
+    return s;
+}
+
+bool TimeKeeper::toWallClock(time_t monoSeconds, time_t& wallSeconds) const {
+    if (!synced_) return false;
+    portENTER_CRITICAL(&mux_);
+    int64_t wall = wallAtLocked((int64_t)monoSeconds * 1000000LL);
+    portEXIT_CRITICAL(&mux_);
+    wallSeconds = (time_t)(wall / 1000000LL);
+    return true;
+}
+
+TimeKeeper timeKeeper;
@@ -0,0 +1,78 @@
+#ifndef TIME_KEEPER_H
+#define TIME_KEEPER_H
+
+#include <Arduino.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "metrics.h"
+
+/**
+ * 时间基准服务 (Monotonic time base mapped to wall-clock time)
+ *
+ * 所有采样都用 esp_timer 单调时钟打时间戳, 再通过偏移 + 漂移模型换算为墙上时间:
+ *
+ *   wall(mono) = baseWall + (mono - baseMono) * (1 + drift) + slew
+ *
+ * - SNTP 在后台运行 (lwIP 任务), 每 RESYNC_INTERVAL_MS 自动重新同步; 同步结果通过
+ *   回调送入本模型, 调用方从不等待网络。
+ * - 每次同步测得的误差不直接跳变, 而是以不超过 SLEW_PPM 的速率逐步修正 (类似 adjtime),
+ *   因此 now() 永不倒退; 只有超过 STEP_THRESHOLD_US 的正向误差才会直接前跳。
+ * - 两次同步之间的时间差用于估计晶振漂移 (ppm, 指数平滑)。
+ * - 首次同步前的记录只能用开机后的单调秒数打戳 (stamp().synced == false),
+ *   同步后可用 toWallClock() 追溯换算。
+ */
+class TimeKeeper {
+public:
+    struct Stamp {
+        time_t seconds; // Wall-clock epoch seconds, or seconds since boot if !synced
+        bool synced;
+    };
+
+    TimeKeeper();
+
+    // Configures the timezone and starts background SNTP. Non-blocking; safe to call again
+    // after a reconnect.
+    void startSync(const char* ntpServer, long gmtOffsetSec, int daylightOffsetSec);
+
+    bool isSynced() const { return synced_; }
+    int64_t monotonicUs() const;           // esp_timer, microseconds since boot
+    Stamp stamp() const;                   // Current time for a new sample
+    int64_t nowWallUs() const;             // Wall-clock microseconds (0 if not synced)
+
+    // Converts a pre-sync stamp (seconds since boot, this boot only) to wall-clock seconds.
+    // Returns false if no sync has happened yet.
+    bool toWallClock(time_t monoSeconds, time_t& wallSeconds) const;
+
+    float driftPpm() const { return driftPpmGauge_.value(); }
+    uint32_t syncCount() const { return (uint32_t)syncCount_.value(); }
+
+private:
+    static const uint32_t RESYNC_INTERVAL_MS = 3600000;      // SNTP poll interval (1 h)
+    static const int64_t SLEW_PPM = 500;                     // Max correction rate
+    static const int64_t STEP_THRESHOLD_US = 1000000;        // Forward errors above this are stepped
+    static const int64_t MIN_DRIFT_INTERVAL_US = 600000000;  // Need >= 10 min between syncs to estimate drift
+    static constexpr float MAX_DRIFT_PPM = 500.0f;
+
+    mutable portMUX_TYPE mux_;
+    volatile bool synced_;
+    int64_t baseMonoUs_;     // Model origin (monotonic)
+    int64_t baseWallUs_;     // Wall time at baseMonoUs_
+    int64_t slewUs_;         // Error still being slewed out from baseMonoUs_
+    float driftPpm_;         // Rate error of the local clock vs NTP
+    int64_t lastSyncMonoUs_;
+    int64_t lastSyncWallUs_;
+
+    MetricCounter syncCount_;
+    MetricGauge syncedGauge_;
+    MetricGauge driftPpmGauge_;
+    MetricGauge lastOffsetGauge_;  // Error measured at the last sync (seconds)
+
+    int64_t wallAtLocked(int64_t monoUs) const; // Requires mux_ held and synced_
+    void onSync(int64_t ntpWallUs);
+
+    static void sntpSyncCallback(struct timeval* tv);
+};
+
+extern TimeKeeper timeKeeper;
+
+#endif // TIME_KEEPER_H
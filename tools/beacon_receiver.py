@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""
+SoundScape 组播遥测信标接收/汇总工具 (Fleet collector for TelemetryBeacon datagrams).
+
+加入组播组后用一个 socket 接收局域网内所有设备的信标 (格式见 telemetry_beacon.h),
+按设备统计接收数、丢失数 (信标序号的空洞)、重复/乱序数, 并可把记录追加到 CSV。
+
+设备重启后 boot id 改变, 序号从 1 重新开始, 不计为丢失。
+
+用法:
+    python3 tools/beacon_receiver.py
+    python3 tools/beacon_receiver.py --group 239.255.83.66 --port 8267 --csv fleet.csv
+    python3 tools/beacon_receiver.py --quiet --report 30
+"""
+
+import argparse
+import csv
+import math
+import socket
+import struct
+import sys
+import time
+
+MAGIC = b"SB"
+BEACON_VERSION = 1
+# magic, version, flags, device id, boot id, beacon seq, record seq, timestamp, dB*100, temp*100, hum*100, lux*100
+BEACON = struct.Struct("<2sBB6sHIIIHhHI")
+FLAG_TIME_UNSYNCED = 0x01
+
+
+def decode_beacon(data):
+    """Returns a dict for a valid beacon datagram, or None."""
+    if len(data) < BEACON.size:
+        return None
+    (magic, version, flags, device, boot_id, beacon_seq, record_seq,
+     ts, db, temp, hum, lux) = BEACON.unpack_from(data)
+    if magic != MAGIC or version != BEACON_VERSION:
+        return None
+    return {
+        "device": device.hex(":"),
+        "boot_id": boot_id,
+        "beacon_seq": beacon_seq,
+        "seq": record_seq,
+        "timestamp": ts,
+        "time_unsynced": bool(flags & FLAG_TIME_UNSYNCED),
+        "decibels": math.nan if db == 0xFFFF else db / 100.0,
+        "temperature": math.nan if temp == -32768 else temp / 100.0,
+        "humidity": math.nan if hum == 0xFFFF else hum / 100.0,
+        "lux": math.nan if lux == 0xFFFFFFFF else lux / 100.0,
+    }
+
+
+class DeviceStats:
+    """Loss accounting for one device from its beacon sequence numbers."""
+
+    def __init__(self, boot_id):
+        self.boot_id = boot_id
+        self.expected = None  # Next beacon seq we expect
+        self.received = 0
+        self.lost = 0
+        self.late = 0         # Duplicates or reordered datagrams
+        self.reboots = 0
+        self.last = None
+        self.last_seen = 0.0
+
+    def observe(self, beacon):
+        if beacon["boot_id"] != self.boot_id:
+            self.boot_id = beacon["boot_id"]
+            self.expected = None
+            self.reboots += 1
+        seq = beacon["beacon_seq"]
+        self.received += 1
+        self.last_seen = time.time()
+        if self.expected is None:
+            self.expected = seq + 1
+        elif seq >= self.expected:
+            gap = seq - self.expected
+            self.lost += gap
+            self.expected = seq + 1
+            if gap:
+                return gap
+        else:
+            # Arrived after a later one: it was counted as lost when the gap opened
+            self.late += 1
+            self.lost = max(0, self.lost - 1)
+        self.last = beacon
+        return 0
+
+    def loss_ratio(self):
+        total = self.received + self.lost
+        return self.lost / total if total else 0.0
+
+
+def open_socket(group, port, iface):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    if hasattr(socket, "SO_REUSEPORT"):
+        try:
+            sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEPORT, 1)
+        except OSError:
+            pass
+    sock.bind(("", port))
+    mreq = struct.pack("4s4s", socket.inet_aton(group), socket.inet_aton(iface))
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+    sock.settimeout(1.0)
+    return sock
+
+
+def print_report(devices):
+    print("\n%-17s %6s %8s %6s %6s %7s %8s %7s" %
+          ("device", "boot", "recv", "lost", "late", "loss%", "reboots", "dB"))
+    for device, st in sorted(devices.items()):
+        db = st.last["decibels"] if st.last else math.nan
+        print("%-17s %6s %8d %6d %6d %6.2f%% %8d %7.1f" %
+              (device, "%04x" % st.boot_id, st.received, st.lost, st.late, st.loss_ratio() * 100, st.reboots, db))
+    sys.stdout.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--group", default="239.255.83.66", help="multicast group (TELEMETRY_GROUP)")
+    parser.add_argument("--port", type=int, default=8267, help="UDP port (TELEMETRY_PORT)")
+    parser.add_argument("--iface", default="0.0.0.0", help="local interface address to join on")
+    parser.add_argument("--csv", help="append every record to this CSV file")
+    parser.add_argument("--report", type=float, default=10.0, help="seconds between summary tables")
+    parser.add_argument("--quiet", action="store_true", help="do not print each beacon")
+    args = parser.parse_args()
+
+    sock = open_socket(args.group, args.port, args.iface)
+    devices = {}
+    writer = None
+    csv_file = None
+    if args.csv:
+        csv_file = open(args.csv, "a", newline="")
+        writer = csv.writer(csv_file)
+        if csv_file.tell() == 0:
+            writer.writerow(["received_at", "device", "boot_id", "beacon_seq", "seq", "timestamp",
+                             "decibels", "temperature", "humidity", "lux", "time_unsynced"])
+
+    print("listening on %s:%d" % (args.group, args.port))
+    next_report = time.time() + args.report
+    invalid = 0
+    try:
+        while True:
+            try:
+                data, addr = sock.recvfrom(1500)
+            except socket.timeout:
+                data = None
+            now = time.time()
+            if data is not None:
+                beacon = decode_beacon(data)
+                if beacon is None:
+                    invalid += 1
+                else:
+                    st = devices.get(beacon["device"])
+                    if st is None:
+                        st = devices[beacon["device"]] = DeviceStats(beacon["boot_id"])
+                    gap = st.observe(beacon)
+                    if gap:
+                        print("%s: %d beacon(s) lost before #%d" % (beacon["device"], gap, beacon["beacon_seq"]))
+                    if not args.quiet:
+                        print("%s %s #%d seq=%d %.1f dB %.1f C %.1f %% %.0f lx" %
+                              (beacon["device"], addr[0], beacon["beacon_seq"], beacon["seq"],
+                               beacon["decibels"], beacon["temperature"], beacon["humidity"], beacon["lux"]))
+                    if writer:
+                        writer.writerow([round(now, 3), beacon["device"], beacon["boot_id"], beacon["beacon_seq"],
+                                         beacon["seq"], beacon["timestamp"], beacon["decibels"],
+                                         beacon["temperature"], beacon["humidity"], beacon["lux"],
+                                         int(beacon["time_unsynced"])])
+            if now >= next_report:
+                next_report = now + args.report
+                print_report(devices)
+                if invalid:
+                    print("invalid datagrams: %d" % invalid)
+                if csv_file:
+                    csv_file.flush()
+    except KeyboardInterrupt:
+        print_report(devices)
+    finally:
+        if csv_file:
+            csv_file.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""
+把 web/ 目录下的静态网页资源预压缩为 gzip, 生成 web_assets.h (PROGMEM 数组)。
+
+输出是可复现的: 文件按路径排序, gzip 头中的 mtime 固定为 0 且不写入文件名,
+压缩级别固定为 9。同样的输入在任何 Linux 机器上都生成逐字节相同的 web_assets.h,
+因此生成的头文件随源码一起提交, Arduino 构建不需要运行本脚本。
+
+ETag 取压缩后内容 SHA-256 的前 16 个十六进制字符, 资源不变则 ETag 不变。
+
+用法 (修改 web/ 下的文件后):
+    python3 tools/build_web_assets.py
+    python3 tools/build_web_assets.py --check   # 仅检查 web_assets.h 是否为最新
+"""
+
+import argparse
+import gzip
+import hashlib
+import io
+import os
+import sys
+
+REPO_ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+WEB_DIR = os.path.join(REPO_ROOT, "web")
+OUTPUT = os.path.join(REPO_ROOT, "web_assets.h")
+
+CONTENT_TYPES = {
+    ".html": "text/html; charset=utf-8",
+    ".js": "application/javascript",
+    ".css": "text/css",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+    ".png": "image/png",
+}
+
+
+def gzip_bytes(data):
+    buf = io.BytesIO()
+    # filename="" and mtime=0 keep the gzip header free of build-machine state
+    with gzip.GzipFile(filename="", mode="wb", compresslevel=9, fileobj=buf, mtime=0) as gz:
+        gz.write(data)
+    return buf.getvalue()
+
+
+def collect_assets():
+    assets = []
+    for root, dirs, files in os.walk(WEB_DIR):
+        dirs.sort()
+        for name in sorted(files):
+            full = os.path.join(root, name)
+            rel = os.path.relpath(full, WEB_DIR).replace(os.sep, "/")
+            ext = os.path.splitext(name)[1].lower()
+            if ext not in CONTENT_TYPES:
+                print("skip (unknown type): %s" % rel, file=sys.stderr)
+                continue
+            with open(full, "rb") as f:
+                raw = f.read()
+            url = "/" if rel == "index.html" else "/" + rel
+            assets.append((url, CONTENT_TYPES[ext], raw, gzip_bytes(raw)))
+    assets.sort(key=lambda a: a[0])
+    return assets
+
+
+def symbol_for(url):
+    name = "root" if url == "/" else url.strip("/")
+    return "WEB_ASSET_" + "".join(c.upper() if c.isalnum() else "_" for c in name)
+
+
+def render_header(assets):
+    out = []
+    out.append("// Generated by tools/build_web_assets.py from web/ - do not edit.")
+    out.append("#ifndef WEB_ASSETS_H")
+    out.append("#define WEB_ASSETS_H")
+    out.append("")
+    out.append("#include <Arduino.h>")
+    out.append("")
+    out.append("struct WebAsset {")
+    out.append("    const char* path;         // Request path")
+    out.append("    const char* contentType;")
+    out.append("    const char* etag;         // Quoted strong ETag")
+    out.append("    const uint8_t* data;      // gzip-compressed body in flash")
+    out.append("    size_t length;")
+    out.append("};")
+    out.append("")
+    for url, _, raw, gz in assets:
+        sym = symbol_for(url)
+        out.append("// %s: %d bytes, %d gzipped" % (url, len(raw), len(gz)))
+        out.append("static const uint8_t %s[] PROGMEM = {" % sym)
+        for i in range(0, len(gz), 16):
+            out.append("    " + ", ".join("0x%02x" % b for b in gz[i:i + 16]) + ",")
+        out.append("};")
+        out.append("")
+    out.append("static const WebAsset WEB_ASSETS[] = {")
+    for url, ctype, _, gz in assets:
+        etag = hashlib.sha256(gz).hexdigest()[:16]
+        out.append('    {"%s", "%s", "\\"%s\\"", %s, sizeof(%s)},' % (url, ctype, etag, symbol_for(url), symbol_for(url)))
+    out.append("};")
+    out.append("static const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);")
+    out.append("")
+    out.append("#endif // WEB_ASSETS_H")
+    out.append("")
+    return "\n".join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--check", action="store_true", help="exit 1 if web_assets.h is out of date")
+    args = parser.parse_args()
+
+    header = render_header(collect_assets())
+    if args.check:
+        try:
+            with open(OUTPUT, "r", encoding="utf-8") as f:
+                current = f.read()
+        except FileNotFoundError:
+            current = ""
+        if current != header:
+            print("web_assets.h is out of date; run tools/build_web_assets.py", file=sys.stderr)
+            sys.exit(1)
+        print("web_assets.h is up to date")
+        return
+
+    with open(OUTPUT, "w", encoding="utf-8", newline="\n") as f:
+        f.write(header)
+    print("wrote %s" % os.path.relpath(OUTPUT, REPO_ROOT))
+
+
+if __name__ == "__main__":
+    main()
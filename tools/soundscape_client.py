@@ -0,0 +1,305 @@
+#!/usr/bin/env python3
+"""
+SoundScape 主机端客户端库 (Host-side client for the TCP command port, default 8266).
+
+支持两种协议:
+  * TEXT - 每行一条命令, 响应为 JSON 行或状态文本 (原有协议)
+  * BIN1 - 连接后发送 "PROTO BIN1" 协商, 之后使用定长小端帧 (见 wire_protocol.h)。
+           设备支持时 (问候行含 ENV3) 协商 "PROTO BIN1 ENV3", 记录带 flags (SCHEMA_ENV_V3)
+
+BIN1 下请求可以流水线发送 (pipelining): request() 立即返回 seq, 之后用
+responses() / wait() 按 seq 取回响应。
+
+用法:
+    python3 soundscape_client.py <device-ip> GET_CURRENT
+    python3 soundscape_client.py <device-ip> --sync state.txt
+    python3 soundscape_client.py <device-ip> --bench 200
+"""
+
+import argparse
+import json
+import math
+import socket
+import struct
+import time
+
+FRAME_MAGIC = 0xA5
+HEADER = struct.Struct("<BBBBIH")  # magic, type, schema, count, seq, length
+HEADER_SIZE = HEADER.size          # 10
+
+FRAME_REQUEST = 0x01
+FRAME_RECORDS = 0x02
+FRAME_STATUS = 0x03
+FRAME_ERROR = 0x04
+
+SCHEMA_TEXT = 0x00
+SCHEMA_ENV_V1 = 0x01
+SCHEMA_ENV_V2 = 0x02
+SCHEMA_ENV_V3 = 0x04
+
+FLAG_TIME_UNSYNCED = 0x01
+
+ENV_V1 = struct.Struct("<IHhHI")   # timestamp, dB*100, temp*100, hum*100, lux*100
+ENV_V2 = struct.Struct("<IIHhHI")  # seq + ENV_V1
+ENV_V3 = struct.Struct("<IIHhHIB") # ENV_V2 + flags
+
+
+def _env_fields(ts, db, temp, hum, lux):
+    return {
+        "timestamp": ts,
+        "decibels": math.nan if db == 0xFFFF else db / 100.0,
+        "temperature": math.nan if temp == -32768 else temp / 100.0,
+        "humidity": math.nan if hum == 0xFFFF else hum / 100.0,
+        "lux": math.nan if lux == 0xFFFFFFFF else lux / 100.0,
+    }
+
+
+def decode_env_v1(payload, count):
+    """Decodes SCHEMA_ENV_V1 records into dicts (NAN sentinels -> float('nan'))."""
+    return [_env_fields(*ENV_V1.unpack_from(payload, i * ENV_V1.size)) for i in range(count)]
+
+
+def decode_env_v2(payload, count):
+    """Decodes SCHEMA_ENV_V2 records (ENV_V1 prefixed with the record seq)."""
+    records = []
+    for i in range(count):
+        seq, *fields = ENV_V2.unpack_from(payload, i * ENV_V2.size)
+        record = _env_fields(*fields)
+        record["seq"] = seq
+        records.append(record)
+    return records
+
+
+def decode_env_v3(payload, count):
+    """Decodes SCHEMA_ENV_V3 records (ENV_V2 followed by the record flags).
+
+    Records with FLAG_TIME_UNSYNCED carry seconds since boot in "timestamp",
+    not wall-clock time; "timeUnsynced" is set on them.
+    """
+    records = []
+    for i in range(count):
+        seq, *fields, flags = ENV_V3.unpack_from(payload, i * ENV_V3.size)
+        record = _env_fields(*fields)
+        record["seq"] = seq
+        record["flags"] = flags
+        if flags & FLAG_TIME_UNSYNCED:
+            record["timeUnsynced"] = True
+        records.append(record)
+    return records
+
+
+SCHEMA_DECODERS = {
+    SCHEMA_ENV_V1: decode_env_v1,
+    SCHEMA_ENV_V2: decode_env_v2,
+    SCHEMA_ENV_V3: decode_env_v3,
+}
+
+
+class Frame:
+    def __init__(self, ftype, schema, count, seq, payload):
+        self.type = ftype
+        self.schema = schema
+        self.count = count
+        self.seq = seq
+        self.payload = payload
+
+    @property
+    def text(self):
+        return self.payload.decode("utf-8", "replace")
+
+    @property
+    def records(self):
+        decoder = SCHEMA_DECODERS.get(self.schema)
+        if self.type != FRAME_RECORDS or decoder is None:
+            return []
+        return decoder(self.payload, self.count)
+
+
+class SoundScapeClient:
+    def __init__(self, host, port=8266, timeout=5.0):
+        self.sock = socket.create_connection((host, port), timeout=timeout)
+        self.rx = b""
+        self.binary = False
+        self.next_seq = 1
+        self.bytes_received = 0
+        self.greeting = self._read_line()
+
+    def close(self):
+        self.sock.close()
+
+    # --- low level ---
+    def _fill(self):
+        chunk = self.sock.recv(4096)
+        if not chunk:
+            raise ConnectionError("device closed the connection")
+        self.bytes_received += len(chunk)
+        self.rx += chunk
+
+    def _read_line(self):
+        while b"\n" not in self.rx:
+            self._fill()
+        line, self.rx = self.rx.split(b"\n", 1)
+        return line.decode("utf-8", "replace").strip()
+
+    def _read_frame(self):
+        while len(self.rx) < HEADER_SIZE:
+            self._fill()
+        magic, ftype, schema, count, seq, length = HEADER.unpack_from(self.rx)
+        if magic != FRAME_MAGIC:
+            raise ValueError("lost frame sync (magic 0x%02X)" % magic)
+        while len(self.rx) < HEADER_SIZE + length:
+            self._fill()
+        payload = self.rx[HEADER_SIZE:HEADER_SIZE + length]
+        self.rx = self.rx[HEADER_SIZE + length:]
+        return Frame(ftype, schema, count, seq, payload)
+
+    # --- protocol ---
+    def negotiate_binary(self):
+        # Older firmware only has SCHEMA_ENV_V2 (unsynced timestamps are sent as 0)
+        proto = "BIN1 ENV3" if "ENV3" in self.greeting else "BIN1"
+        self.sock.sendall(b"PROTO " + proto.encode() + b"\n")
+        reply = self._read_line()
+        if reply != "PROTO_OK " + proto:
+            raise RuntimeError("device refused %s: %r" % (proto, reply))
+        self.binary = True
+
+    def request(self, command):
+        """Sends a command. In BIN1 mode returns its seq without waiting (pipelining)."""
+        if not self.binary:
+            self.sock.sendall(command.encode() + b"\n")
+            return None
+        seq = self.next_seq
+        self.next_seq = (self.next_seq + 1) & 0xFFFFFFFF
+        payload = command.encode()
+        self.sock.sendall(HEADER.pack(FRAME_MAGIC, FRAME_REQUEST, SCHEMA_TEXT, 0, seq, len(payload)) + payload)
+        return seq
+
+    def read_response(self):
+        """Reads one response: a Frame in BIN1 mode, a parsed JSON dict or status string in TEXT mode."""
+        if self.binary:
+            return self._read_frame()
+        line = self._read_line()
+        if line.startswith("{"):
+            return json.loads(line)
+        return line
+
+    def command(self, command):
+        """Convenience: send one command and return its first response."""
+        seq = self.request(command)
+        while True:
+            resp = self.read_response()
+            if not self.binary or resp.seq == seq:
+                return resp
+
+
+    def sync(self, last_seq):
+        """Yields every record with seq > last_seq (SD log first, then RAM) until SYNC_END.
+
+        Collection is idempotent: persist the highest seq seen and pass it back
+        after a reconnect to receive only newer records.
+        """
+        seq = self.request("SYNC %d" % last_seq)
+        while True:
+            resp = self.read_response()
+            if self.binary:
+                if resp.seq != seq:
+                    continue
+                if resp.type == FRAME_RECORDS:
+                    for record in resp.records:
+                        yield record
+                    continue
+                text = resp.text
+            elif isinstance(resp, dict):
+                yield resp
+                continue
+            else:
+                text = resp
+            if text.startswith("SYNC_END"):
+                return
+            raise RuntimeError("SYNC failed: %s" % text)
+
+
+def run_sync(host, port, state_path):
+    """Incremental collection: appends new records as JSON lines to stdout."""
+    try:
+        with open(state_path) as f:
+            last_seq = int(f.read().strip() or 0)
+    except FileNotFoundError:
+        last_seq = 0
+    client = SoundScapeClient(host, port)
+    client.negotiate_binary()
+    count = 0
+    for record in client.sync(last_seq):
+        print(json.dumps(record))
+        last_seq = max(last_seq, record["seq"])
+        count += 1
+        if count % 256 == 0:  # checkpoint so a dropped link resumes close to where it stopped
+            with open(state_path, "w") as f:
+                f.write(str(last_seq))
+    with open(state_path, "w") as f:
+        f.write(str(last_seq))
+    client.close()
+
+
+def run_benchmark(host, port, count):
+    """Compares bytes and wall time per record for TEXT (JSON) vs BIN1 (pipelined)."""
+    results = {}
+    for mode in ("TEXT", "BIN1"):
+        client = SoundScapeClient(host, port)
+        if mode == "BIN1":
+            client.negotiate_binary()
+        base = client.bytes_received
+        start = time.perf_counter()
+        if mode == "BIN1":
+            for _ in range(count):
+                client.request("GET_CURRENT")
+            for _ in range(count):
+                client.read_response()
+        else:
+            for _ in range(count):
+                client.request("GET_CURRENT")
+                client.read_response()
+        elapsed = time.perf_counter() - start
+        results[mode] = ((client.bytes_received - base) / count, elapsed * 1e6 / count)
+        device = client.command("BENCH WIRE 1000")
+        results[mode + "_device"] = device.text if mode == "BIN1" else device
+        client.close()
+
+    for mode in ("TEXT", "BIN1"):
+        bytes_per, us_per = results[mode]
+        print("%-5s %8.1f bytes/record %10.1f us/record (round trip)" % (mode, bytes_per, us_per))
+    print("device:", results["BIN1_device"])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host")
+    parser.add_argument("command", nargs="?", default="GET_CURRENT")
+    parser.add_argument("--port", type=int, default=8266)
+    parser.add_argument("--text", action="store_true", help="stay on the TEXT protocol")
+    parser.add_argument("--bench", type=int, metavar="N", help="benchmark N GET_CURRENT requests per protocol")
+    parser.add_argument("--sync", metavar="STATE_FILE", help="fetch records newer than the seq stored in STATE_FILE")
+    args = parser.parse_args()
+
+    if args.sync:
+        run_sync(args.host, args.port, args.sync)
+        return
+
+    if args.bench:
+        run_benchmark(args.host, args.port, args.bench)
+        return
+
+    client = SoundScapeClient(args.host, args.port)
+    print("greeting:", client.greeting)
+    if not args.text:
+        client.negotiate_binary()
+    resp = client.command(args.command)
+    if isinstance(resp, Frame):
+        print(resp.records if resp.type == FRAME_RECORDS else resp.text)
+    else:
+        print(resp)
+    client.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""
+SoundScape 上行采集端 (Stand-in HTTP collector for UplinkManager batches).
+
+接收设备 POST 的批量记录 (格式见 uplink_manager.h), 按 (device, seq) 去重,
+可追加写入 CSV, 并定期打印每台设备的批次数、记录数、重复数和平均批大小。
+用于在 Linux 主机上验证存储转发 (断网/恢复后的续传) 以及批量上传的效果。
+
+--fail-rate / --delay 可模拟不可靠或缓慢的采集端, 用于观察设备的退避重试。
+
+用法:
+    python3 tools/uplink_collector.py --port 8270 --csv uplink.csv
+    python3 tools/uplink_collector.py --fail-rate 0.3 --delay 2.0
+设备端把 SoundScape.ino 中的 UPLINK_URL 设为 http://<本机IP>:8270/ingest 并启用 UPLINK_ENABLED。
+"""
+
+import argparse
+import csv
+import math
+import random
+import struct
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+ENV_V2 = struct.Struct("<IIHhHI")   # seq, timestamp, dB*100, temp*100, hum*100, lux*100
+ENV_V3 = struct.Struct("<IIHhHIB")  # ENV_V2 + flags
+SCHEMAS = {"2": ENV_V2, "4": ENV_V3}  # X-SoundScape-Schema -> record layout
+
+FLAG_TIME_UNSYNCED = 0x01
+
+
+def decode_records(body, schema):
+    """Decodes a batch body (concatenated SCHEMA_ENV_V2 / SCHEMA_ENV_V3 records).
+
+    With FLAG_TIME_UNSYNCED set, "timestamp" is seconds since the device booted.
+    """
+    layout = SCHEMAS[schema]
+    if len(body) % layout.size:
+        raise ValueError("body length %d is not a multiple of %d" % (len(body), layout.size))
+    records = []
+    for off in range(0, len(body), layout.size):
+        seq, ts, db, temp, hum, lux, *rest = layout.unpack_from(body, off)
+        records.append({
+            "seq": seq,
+            "timestamp": ts,
+            "decibels": math.nan if db == 0xFFFF else db / 100.0,
+            "temperature": math.nan if temp == -32768 else temp / 100.0,
+            "humidity": math.nan if hum == 0xFFFF else hum / 100.0,
+            "lux": math.nan if lux == 0xFFFFFFFF else lux / 100.0,
+            "flags": rest[0] if rest else 0,
+        })
+    return records
+
+
+class DeviceState:
+    def __init__(self):
+        self.seen = set()
+        self.max_seq = 0
+        self.batches = 0
+        self.records = 0
+        self.duplicates = 0
+        self.bytes = 0
+        self.last_batch = 0.0
+
+
+class Collector:
+    def __init__(self, csv_path):
+        self.lock = threading.Lock()
+        self.devices = {}
+        self.failed = 0
+        self.csv_file = None
+        self.writer = None
+        if csv_path:
+            self.csv_file = open(csv_path, "a", newline="")
+            self.writer = csv.writer(self.csv_file)
+            if self.csv_file.tell() == 0:
+                self.writer.writerow(["received_at", "device", "seq", "timestamp",
+                                      "decibels", "temperature", "humidity", "lux", "time_unsynced"])
+
+    def ingest(self, device, body, records):
+        now = time.time()
+        with self.lock:
+            st = self.devices.setdefault(device, DeviceState())
+            st.batches += 1
+            st.bytes += len(body)
+            st.last_batch = now
+            fresh = 0
+            for r in records:
+                if r["seq"] in st.seen:
+                    st.duplicates += 1  # Resent after a timeout or reboot
+                    continue
+                st.seen.add(r["seq"])
+                st.max_seq = max(st.max_seq, r["seq"])
+                st.records += 1
+                fresh += 1
+                if self.writer:
+                    self.writer.writerow([round(now, 3), device, r["seq"], r["timestamp"], r["decibels"],
+                                          r["temperature"], r["humidity"], r["lux"],
+                                          int(bool(r["flags"] & FLAG_TIME_UNSYNCED))])
+            return fresh
+
+    def report(self):
+        with self.lock:
+            print("\n%-12s %8s %8s %6s %9s %10s %8s" %
+                  ("device", "batches", "records", "dups", "avg/batch", "bytes/rec", "max_seq"))
+            for device, st in sorted(self.devices.items()):
+                total = st.records + st.duplicates
+                print("%-12s %8d %8d %6d %9.1f %10.1f %8d" %
+                      (device, st.batches, st.records, st.duplicates,
+                       total / st.batches if st.batches else 0.0,
+                       st.bytes / total if total else 0.0, st.max_seq))
+            if self.failed:
+                print("injected failures: %d" % self.failed)
+            if self.csv_file:
+                self.csv_file.flush()
+        sys.stdout.flush()
+
+
+def make_handler(collector, args):
+    class Handler(BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"  # Keep-alive, as the device reuses its connection
+
+        def _reply(self, code, text):
+            data = text.encode()
+            self.send_response(code)
+            self.send_header("Content-Type", "text/plain")
+            self.send_header("Content-Length", str(len(data)))
+            self.end_headers()
+            self.wfile.write(data)
+
+        def do_POST(self):
+            length = int(self.headers.get("Content-Length", "0"))
+            body = self.rfile.read(length) if length else b""
+            if self.path != args.path:
+                self._reply(404, "not found")
+                return
+            if args.delay:
+                time.sleep(args.delay)
+            if args.fail_rate and random.random() < args.fail_rate:
+                collector.failed += 1
+                self._reply(503, "injected failure")
+                return
+            device = self.headers.get("X-SoundScape-Device", "")
+            schema = self.headers.get("X-SoundScape-Schema")
+            if not device or schema not in SCHEMAS:
+                self._reply(400, "missing device id or unsupported schema")
+                return
+            try:
+                records = decode_records(body, schema)
+            except ValueError as e:
+                self._reply(400, str(e))
+                return
+            fresh = collector.ingest(device, body, records)
+            if not args.quiet:
+                first = records[0]["seq"] if records else 0
+                last = records[-1]["seq"] if records else 0
+                print("%s %s: %d records (seq %d..%d), %d new" %
+                      (device, self.client_address[0], len(records), first, last, fresh))
+            self._reply(200, "ok %d" % len(records))
+
+        def log_message(self, fmt, *a):
+            pass  # Per-batch lines are printed by do_POST
+
+    return Handler
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", type=int, default=8270)
+    parser.add_argument("--path", default="/ingest")
+    parser.add_argument("--csv", help="append accepted records to this CSV file")
+    parser.add_argument("--fail-rate", type=float, default=0.0, help="fraction of requests answered with 503")
+    parser.add_argument("--delay", type=float, default=0.0, help="seconds to wait before answering")
+    parser.add_argument("--report", type=float, default=30.0, help="seconds between summary tables")
+    parser.add_argument("--quiet", action="store_true")
+    args = parser.parse_args()
+
+    collector = Collector(args.csv)
+    server = ThreadingHTTPServer(("", args.port), make_handler(collector, args))
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    print("collecting on :%d%s" % (args.port, args.path))
+    try:
+        while True:
+            time.sleep(args.report)
+            collector.report()
+    except KeyboardInterrupt:
+        collector.report()
+    finally:
+        server.shutdown()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""
+/audio WebSocket 扇出基准测试 (fan-out benchmark for the audio WebSocket).
+
+同时打开 N 个 /audio 客户端 (默认 8 个), 统计每个客户端收到的字节数/帧数与吞吐,
+并在结束前读取设备的 /metrics, 输出每个客户端在设备端被丢弃 (drop-oldest) 的帧数。
+可用 --slow 让部分客户端故意读得很慢, 观察慢客户端不会拖累其他客户端。
+
+只依赖 Python 标准库。
+
+用法:
+    python3 ws_fanout_bench.py <device-ip>
+    python3 ws_fanout_bench.py <device-ip> --clients 8 --seconds 20 --slow 2
+"""
+
+import argparse
+import base64
+import os
+import socket
+import struct
+import threading
+import time
+import urllib.request
+
+SAMPLE_RATE = 16000
+BYTES_PER_SAMPLE = 2
+EXPECTED_BPS = SAMPLE_RATE * BYTES_PER_SAMPLE
+
+
+class AudioClient(threading.Thread):
+    """Minimal RFC 6455 client: handshake, then counts binary frames until stopped."""
+
+    def __init__(self, host, port, path, slow_delay=0.0):
+        super().__init__(daemon=True)
+        self.host = host
+        self.port = port
+        self.path = path
+        self.slow_delay = slow_delay
+        self.frames = 0
+        self.bytes = 0
+        self.first_at = None
+        self.last_at = None
+        self.max_gap = 0.0
+        self.error = None
+        self.stop_event = threading.Event()
+        self.sock = None
+
+    def connect(self):
+        self.sock = socket.create_connection((self.host, self.port), timeout=5)
+        key = base64.b64encode(os.urandom(16)).decode()
+        request = (
+            "GET %s HTTP/1.1\r\nHost: %s\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+            "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n" % (self.path, self.host, key)
+        )
+        self.sock.sendall(request.encode())
+        response = b""
+        while b"\r\n\r\n" not in response:
+            chunk = self.sock.recv(1024)
+            if not chunk:
+                raise ConnectionError("connection closed during handshake")
+            response += chunk
+        status = response.split(b"\r\n", 1)[0]
+        if b" 101 " not in status:
+            raise ConnectionError("handshake failed: %r" % status)
+        self.buffer = response.split(b"\r\n\r\n", 1)[1]
+
+    def _read_exact(self, n):
+        while len(self.buffer) < n:
+            chunk = self.sock.recv(4096)
+            if not chunk:
+                raise ConnectionError("connection closed")
+            self.buffer += chunk
+        data, self.buffer = self.buffer[:n], self.buffer[n:]
+        return data
+
+    def _read_frame(self):
+        b0, b1 = self._read_exact(2)
+        opcode = b0 & 0x0F
+        length = b1 & 0x7F
+        if length == 126:
+            length = struct.unpack(">H", self._read_exact(2))[0]
+        elif length == 127:
+            length = struct.unpack(">Q", self._read_exact(8))[0]
+        if b1 & 0x80:
+            self._read_exact(4)  # Servers never mask, but skip it if present
+        return opcode, self._read_exact(length)
+
+    def run(self):
+        try:
+            self.sock.settimeout(1.0)
+            while not self.stop_event.is_set():
+                try:
+                    opcode, payload = self._read_frame()
+                except socket.timeout:
+                    continue
+                now = time.perf_counter()
+                if opcode == 0x8:  # Close
+                    break
+                if opcode != 0x2:  # Only binary frames carry audio
+                    continue
+                if self.last_at is not None:
+                    self.max_gap = max(self.max_gap, now - self.last_at)
+                else:
+                    self.first_at = now
+                self.last_at = now
+                self.frames += 1
+                self.bytes += len(payload)
+                if self.slow_delay:
+                    time.sleep(self.slow_delay)
+        except Exception as e:  # noqa: BLE001 - report any failure per client
+            self.error = str(e)
+
+    def close(self):
+        self.stop_event.set()
+        try:
+            # Masked close frame (clients must mask)
+            self.sock.sendall(bytes([0x88, 0x80]) + os.urandom(4))
+        except OSError:
+            pass
+        self.sock.close()
+
+
+def fetch_metrics(host, http_port):
+    """Returns {metric_line_name_with_labels: value} from the device's /metrics."""
+    url = "http://%s:%d/metrics" % (host, http_port)
+    with urllib.request.urlopen(url, timeout=5) as resp:
+        text = resp.read().decode()
+    values = {}
+    for line in text.splitlines():
+        if not line or line.startswith("#"):
+            continue
+        name, _, value = line.rpartition(" ")
+        try:
+            values[name] = float(value)
+        except ValueError:
+            pass
+    return values
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--clients", type=int, default=8)
+    parser.add_argument("--seconds", type=float, default=10.0)
+    parser.add_argument("--slow", type=int, default=0, metavar="K",
+                        help="make the last K clients read slowly (50 ms per frame)")
+    args = parser.parse_args()
+
+    clients = []
+    for i in range(args.clients):
+        slow = 0.05 if i >= args.clients - args.slow else 0.0
+        c = AudioClient(args.host, args.port, "/audio", slow)
+        try:
+            c.connect()
+        except Exception as e:  # noqa: BLE001
+            print("client %d: connect failed (%s) - device cap reached?" % (i, e))
+            continue
+        clients.append(c)
+    if not clients:
+        return
+
+    before = fetch_metrics(args.host, args.port)
+    for c in clients:
+        c.start()
+    time.sleep(args.seconds)
+    after = fetch_metrics(args.host, args.port)
+    for c in clients:
+        c.close()
+    for c in clients:
+        c.join(timeout=2)
+
+    print("%-3s %-5s %9s %8s %10s %9s %s" % ("#", "slow", "frames", "kB", "kB/s", "max_gap", "error"))
+    total = 0
+    for i, c in enumerate(clients):
+        span = (c.last_at - c.first_at) if c.frames > 1 else 0
+        rate = c.bytes / span / 1000 if span else 0.0
+        total += c.bytes
+        print("%-3d %-5s %9d %8.1f %10.2f %8.0fms %s" % (
+            i, "yes" if c.slow_delay else "no", c.frames, c.bytes / 1000, rate, c.max_gap * 1000, c.error or ""))
+    print("aggregate: %.2f kB/s over %d clients (live audio is %.1f kB/s per client)" % (
+        total / args.seconds / 1000, len(clients), EXPECTED_BPS / 1000))
+
+    def delta(name):
+        return after.get(name, 0) - before.get(name, 0)
+
+    print("device: sent %.1f kB, dropped %.1f kB, client cap %d" % (
+        delta("soundscape_ws_audio_bytes_sent_total") / 1000,
+        delta("soundscape_ws_audio_bytes_dropped_total") / 1000,
+        int(after.get("soundscape_ws_audio_client_limit", 0))))
+    for name, value in sorted(after.items()):
+        if name.startswith("soundscape_ws_client_dropped_frames_total"):
+            print("  %s %d (+%d)" % (name, value, delta(name)))
+
+
+if __name__ == "__main__":
+    main()
@@ -10,6 +10,8 @@
 #define LED_MODE_NOISE    1
 #define LED_MODE_TEMP     2
 #define LED_MODE_HUMIDITY 3
+#define LED_MODE_VU       4  // 实时声级 VU 表
+#define LED_MODE_COUNT    5
 
 // ScreenState enum is no longer used globally
 // EnvironmentData struct definition moved to screen.h
@@ -19,6 +19,8 @@ const int STATUS_Y = 280;       // 状态行Y坐标
 #define LED_MODE_NOISE    1
 #define LED_MODE_TEMP     2
 #define LED_MODE_HUMIDITY 3
+#define LED_MODE_VU       4  // 实时声级 VU 表
+#define LED_MODE_COUNT    5
 
 // 传感器阈值
 #define NOISE_THRESHOLD_LOW 50     // dB
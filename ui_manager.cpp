@@ -2,12 +2,24 @@
 #include "ui.h" // Include for LED_MODE definitions
 #include <Arduino.h> // For Serial, maybe millis() if needed later
 #include "memory_utils.h"
+#include "ui_widgets.h"
+#include "metrics.h"
+#include "heap_tracker.h"
+#include "glyph_cache.h"
+#include <esp_heap_caps.h>
+
+static void markFlusherDamage(int32_t x, int32_t y, int32_t w, int32_t h, void* context) {
+    static_cast<DisplayFlusher*>(context)->markDirty(x, y, w, h);
+}
 
 // Constructor
 UIManager::UIManager() :
     activeScreenIndex(-1),
     activeScreen(nullptr),
     redrawNeeded(true), // Start with a redraw needed
+    valuesDirty_(false),
+    lastAnimFrameUs_(0),
+    flusher_(nullptr),
     // Initialize state variables
     wifiConnected_(false),
     sdCardInitialized_(false),
@@ -17,7 +29,21 @@ UIManager::UIManager() :
     isTransitioning_(false),
     transitionStartTime_(0),
     transitionDuration_(300), // Default duration 300ms
-    outgoingScreen_(nullptr)
+    outgoingScreen_(nullptr),
+    outgoingSprite_(nullptr),
+    incomingSprite_(nullptr),
+    dmaBands_{nullptr, nullptr},
+    dmaBandIndex_(0),
+    dmaReady_(false),
+    busHeld_(false),
+    savedSwapBytes_(false),
+    frameScroll_(0),
+    bandRow_(0),
+    finalFrame_(false),
+    lastFrameUs_(0),
+    frameCount_(0),
+    frameUsTotal_(0),
+    frameUsMax_(0)
 {} // End of constructor initialization list
 
 // Add a screen to the manager
@@ -37,14 +63,14 @@ void UIManager::setInitialScreen() {
 }
 
 // Handle button input
-void UIManager::handleInput(int buttonPin) {
+bool UIManager::handleInput(int buttonPin) {
     if (screens.empty() || activeScreen == nullptr) {
-        return; // No screens or active screen to handle input
+        return false; // No screens or active screen to handle input
     }
 
     // Disable input during transition
     if (isTransitioning_) {
-        return;
+        return false;
     }
 
     bool handled = false; // Declare handled ONCE here at the beginning of the effective scope
@@ -74,61 +100,277 @@ void UIManager::handleInput(int buttonPin) {
 
     // If still not handled, could add default behavior here if needed
     // if (!handled) { ... }
+    return handled;
 }
 
 // Update the UI (call this in loop())
 void UIManager::update() {
+    HeapScope heapScope(HEAP_TAG_UI);
     extern TFT_eSPI tft;
+    // With a flusher everything is drawn into its back buffer and pushed by its task
+    TFT_eSPI& target = flusher_ ? flusher_->backBuffer() : tft;
+    if (activeScreen != nullptr) {
+        activeScreen->setOutput(target);
+    }
+    if (busHeld_ && !isTransitioning_) {
+        releaseTransitionBus(tft); // Before anything else draws to the panel
+    }
 
     if (isTransitioning_) {
-        // 检查是否有足够内存进行动画
-        if (isLowMemory(20000)) { // 使用20KB作为安全阈值
-            // 内存不足，立即结束过渡动画
-            isTransitioning_ = false;
-            outgoingScreen_ = nullptr;
-            tft.fillScreen(TFT_BLACK);
-            activeScreen->draw(0);
-            redrawNeeded = false;
-            Serial.println("内存不足，跳过过渡动画");
-            return;
+        uint32_t callStartUs = micros();
+        if (bandRow_ >= tft.height()) {
+            // Previous frame fully sent: start the next one when it is due
+            unsigned long elapsed = millis() - transitionStartTime_;
+            bool lastFrame = elapsed >= transitionDuration_;
+            if (!lastFrame && frameCount_ > 0 && callStartUs - lastFrameUs_ < TRANSITION_FRAME_US) {
+                return; // Frame pacing: leave the rest of the period to sampling and streaming
+            }
+            lastFrameUs_ = callStartUs;
+
+            float progress = lastFrame ? 1.0f : (float)elapsed / transitionDuration_;
+            // Add easing function for smoother animation
+            float easedProgress = progress * progress * (3 - 2 * progress); // Smooth step function
+            pushTransitionFrame(tft, (int)(easedProgress * tft.height()));
+            finalFrame_ = lastFrame;
+            frameCount_++;
         }
+        if (!flusher_ && bandRow_ < tft.height()) {
+            pumpTransitionBands(tft, callStartUs);
+        }
+
+        // Time this call kept the loop busy (a frame may span several calls)
+        uint32_t callUs = micros() - callStartUs;
+        systemMetrics.displayFrameUs.observe(callUs);
+        frameUsTotal_ += callUs;
+        frameUsMax_ = max(frameUsMax_, callUs);
 
-        unsigned long currentTime = millis();
-        float progress = (float)(currentTime - transitionStartTime_) / transitionDuration_;
-        
-        // Add easing function for smoother animation
-        float easedProgress = progress * progress * (3 - 2 * progress); // Smooth step function
-
-        if (progress >= 1.0f) {
-            // Transition finished
-            isTransitioning_ = false;
-            outgoingScreen_ = nullptr;
-            tft.fillScreen(TFT_BLACK); // Clear screen once at the end
-            activeScreen->draw(0); // Draw final screen
-            redrawNeeded = false;
-            Serial.printf("[UIManager] Transition finished. Active screen: %d\n", activeScreenIndex);
+        if (finalFrame_ && bandRow_ >= tft.height()) {
+            finishTransition(tft);
+        }
+    } else if (redrawNeeded && activeScreen != nullptr) {
+        redrawActiveScreen(target);
+    } else if (valuesDirty_ && activeScreen != nullptr) {
+        valuesDirty_ = false;
+        if (activeScreen->updateValues()) {
+            // Only the fields whose text changed were repainted
+            systemMetrics.displayPartialUpdates.inc();
+            systemMetrics.displayUpdateBytes.set((float)ValueField::takeBytes());
         } else {
-            // During transition, calculate positions with eased progress
-            int screenHeight = tft.height();
-            int outgoingY = (int)(easedProgress * -screenHeight);
-            int incomingY = screenHeight + (int)(easedProgress * -screenHeight);
+            redrawActiveScreen(target); // Screen has no widgets or its layout changed
+        }
+    } else if (activeScreen != nullptr) {
+        uint32_t interval = activeScreen->frameIntervalUs();
+        uint32_t nowUs = micros();
+        if (interval > 0 && nowUs - lastAnimFrameUs_ >= interval) {
+            // Late frames are not caught up: the next one is due a full interval from now
+            lastAnimFrameUs_ = nowUs;
+            activeScreen->renderFrame(interval / ANIM_BUDGET_DIVISOR);
+        }
+    }
+    ValueField::takeBytes();
+    if (flusher_) {
+        flusher_->submit(); // Returns at once; the task pushes the changed bands
+    }
+}
 
-            tft.fillScreen(TFT_BLACK); // Clear once per frame
+void UIManager::setDisplayFlusher(DisplayFlusher* flusher) {
+    flusher_ = flusher;
+    if (flusher_) {
+        ValueField::setDamageListener(markFlusherDamage, flusher_);
+    } else {
+        ValueField::setDamageListener(nullptr, nullptr);
+    }
+    redrawNeeded = true;
+}
 
-            // Draw both screens at their calculated positions
-            if (outgoingScreen_) {
-                outgoingScreen_->draw(outgoingY);
-            }
-            if (activeScreen) {
-                activeScreen->draw(incomingY);
+void UIManager::pushTransitionFrame(TFT_eSPI& tft, int scroll) {
+    int w = tft.width();
+    int h = tft.height();
+    scroll = constrain(scroll, 0, h);
+    // Rows [0, h - scroll) come from the outgoing sprite starting at row 'scroll', the rest
+    // from the top of the incoming sprite. Sprite rows are contiguous, so each part is a
+    // plain block copy: no per-frame compositing or redrawing.
+    if (flusher_) {
+        const uint16_t* out = (const uint16_t*)outgoingSprite_->getPointer();
+        const uint16_t* in = (const uint16_t*)incomingSprite_->getPointer();
+        uint16_t* back = (uint16_t*)flusher_->backBuffer().getPointer();
+        memcpy(back, out + (size_t)scroll * w, (size_t)(h - scroll) * w * sizeof(uint16_t));
+        memcpy(back + (size_t)(h - scroll) * w, in, (size_t)scroll * w * sizeof(uint16_t));
+        ValueField::countRect(0, 0, w, h);
+        bandRow_ = h; // The flusher task sends it
+        return;
+    }
+
+    // Sent in bands by pumpTransitionBands(), over one or more update() calls
+    frameScroll_ = scroll;
+    bandRow_ = 0;
+    if (dmaReady_ && !busHeld_) {
+        // Held until the transition ends, so the last band of a frame never has to be waited for
+        savedSwapBytes_ = tft.getSwapBytes();
+        tft.setSwapBytes(false); // Sprite pixels are already in panel byte order
+        tft.startWrite();
+        busHeld_ = true;
+    }
+}
+
+void UIManager::pumpTransitionBands(TFT_eSPI& tft, uint32_t callStartUs) {
+    int w = tft.width();
+    int h = tft.height();
+    int split = h - frameScroll_; // Panel rows above come from the outgoing sprite
+    const uint16_t* out = (const uint16_t*)outgoingSprite_->getPointer();
+    const uint16_t* in = (const uint16_t*)incomingSprite_->getPointer();
+
+    bool swap = false;
+    if (!dmaReady_) {
+        swap = tft.getSwapBytes();
+        tft.setSwapBytes(false);
+        tft.startWrite();
+    }
+    while (bandRow_ < h && micros() - callStartUs < TRANSITION_FRAME_US / ANIM_BUDGET_DIVISOR) {
+        int y = bandRow_;
+        int n = min((int)TRANSITION_BAND_ROWS, (y < split ? split : h) - y); // Bands do not straddle the split
+        const uint16_t* src = (y < split) ? out + (size_t)(y + frameScroll_) * w
+                                          : in + (size_t)(y - split) * w;
+        if (dmaReady_) {
+            // Copies the band into the bounce buffer while the previous band is still being
+            // sent from the other one, then queues it. The last one is left in flight.
+            tft.pushImageDMA(0, y, w, n, (uint16_t*)src, dmaBands_[dmaBandIndex_]);
+            dmaBandIndex_ ^= 1;
+        } else {
+            tft.pushImage(0, y, w, n, (uint16_t*)src);
+        }
+        ValueField::countRect(0, y, w, n);
+        bandRow_ += n;
+    }
+    if (!dmaReady_) {
+        tft.endWrite();
+        tft.setSwapBytes(swap);
+    }
+}
+
+// Collects the band left in flight by the last frame (long finished by the next update)
+void UIManager::releaseTransitionBus(TFT_eSPI& tft) {
+    tft.dmaWait();
+    tft.endWrite();
+    tft.setSwapBytes(savedSwapBytes_);
+    busHeld_ = false;
+    releaseTransition(); // Bounce buffers were kept for that band
+}
+
+bool UIManager::prepareTransition(TFT_eSPI& tft) {
+    if (busHeld_) {
+        releaseTransitionBus(tft); // Previous transition ended on this very loop iteration
+    }
+    // 检查是否有足够内存进行动画 (DMA 缓冲区必须在内部 RAM)
+    if (isLowMemory(20000)) {
+        Serial.println("内存不足，跳过过渡动画");
+        return false;
+    }
+    int w = tft.width();
+    int h = tft.height();
+
+    // Two full-screen sprites: TFT_eSprite takes them from PSRAM when present, otherwise
+    // from internal RAM, which must keep a margin for WiFi/BLE after they are allocated
+    size_t spriteBytes = (size_t)w * h * sizeof(uint16_t);
+    uint32_t spriteCaps = psramFound() ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT;
+    size_t margin = psramFound() ? 0 : 40000;
+    if (heap_caps_get_largest_free_block(spriteCaps) < spriteBytes ||
+        heap_caps_get_free_size(spriteCaps) < 2 * spriteBytes + margin) {
+        Serial.printf("[UIManager] No room for 2 x %u byte transition sprites, switching without animation\n",
+                      (unsigned)spriteBytes);
+        return false;
+    }
+
+    if (!dmaReady_ && !flusher_) {
+        dmaReady_ = tft.initDMA();
+    }
+    if (dmaReady_ && !flusher_) {
+        size_t bandBytes = (size_t)w * TRANSITION_BAND_ROWS * sizeof(uint16_t);
+        for (int i = 0; i < 2; i++) {
+            dmaBands_[i] = (uint16_t*)heapAlloc(HEAP_TAG_UI, bandBytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+            if (!dmaBands_[i]) {
+                releaseTransition();
+                return false;
             }
-            redrawNeeded = false;
         }
-    } else if (redrawNeeded && activeScreen != nullptr) {
-        tft.fillScreen(TFT_BLACK); // Clear screen before normal redraw
-        activeScreen->draw();
-        redrawNeeded = false;
+        dmaBandIndex_ = 0;
+    }
+
+    // 16-bit full-screen sprites (~150 KB each); TFT_eSprite puts them in PSRAM when present
+    outgoingSprite_ = new TFT_eSprite(&tft);
+    incomingSprite_ = new TFT_eSprite(&tft);
+    outgoingSprite_->setColorDepth(16);
+    incomingSprite_->setColorDepth(16);
+    if (!outgoingSprite_->createSprite(w, h) || !incomingSprite_->createSprite(w, h)) {
+        Serial.println("[UIManager] Transition sprites unavailable, switching without animation");
+        releaseTransition();
+        return false;
     }
+    GlyphCache::instance().addSprite(outgoingSprite_);
+    GlyphCache::instance().addSprite(incomingSprite_);
+
+    // Render each screen once; frames only move pixels
+    outgoingSprite_->fillSprite(TFT_BLACK);
+    if (outgoingScreen_) {
+        outgoingScreen_->renderTo(*outgoingSprite_);
+    }
+    incomingSprite_->fillSprite(TFT_BLACK);
+    activeScreen->renderTo(*incomingSprite_);
+    ValueField::discardBytes(); // Sprite drawing does not touch the SPI bus
+
+    frameCount_ = 0;
+    frameUsTotal_ = 0;
+    frameUsMax_ = 0;
+    bandRow_ = h; // No frame in progress
+    finalFrame_ = false;
+    return true;
+}
+
+void UIManager::releaseTransition() {
+    if (outgoingSprite_) {
+        GlyphCache::instance().removeSprite(outgoingSprite_);
+        outgoingSprite_->deleteSprite();
+        delete outgoingSprite_;
+        outgoingSprite_ = nullptr;
+    }
+    if (incomingSprite_) {
+        GlyphCache::instance().removeSprite(incomingSprite_);
+        incomingSprite_->deleteSprite();
+        delete incomingSprite_;
+        incomingSprite_ = nullptr;
+    }
+    if (busHeld_) {
+        return; // A band may still be sent from the bounce buffers; releaseTransitionBus() frees them
+    }
+    for (int i = 0; i < 2; i++) {
+        if (dmaBands_[i]) {
+            heapFree(dmaBands_[i]);
+            dmaBands_[i] = nullptr;
+        }
+    }
+}
+
+void UIManager::finishTransition(TFT_eSPI& tft) {
+    isTransitioning_ = false;
+    outgoingScreen_ = nullptr;
+    releaseTransition();
+    // The last frame was the incoming sprite at offset 0, which is exactly the screen
+    // draw(0) produces: its widgets are in place. Data that changed meanwhile is
+    // picked up by a partial update.
+    valuesDirty_ = true;
+    Serial.printf("[UIManager] Transition finished. Active screen: %d (%u frames, avg %.1f ms/frame, max %.1f ms/call, %s)\n",
+                  activeScreenIndex, frameCount_,
+                  frameCount_ ? frameUsTotal_ / 1000.0f / frameCount_ : 0.0f,
+                  frameUsMax_ / 1000.0f, flusher_ ? "async" : (dmaReady_ ? "DMA" : "blocking"));
+}
+
+void UIManager::redrawActiveScreen(TFT_eSPI& target) {
+    target.fillScreen(TFT_BLACK);
+    ValueField::countRect(0, 0, target.width(), target.height());
+    activeScreen->draw(0);
+    redrawNeeded = false;
+    valuesDirty_ = false;
+    systemMetrics.displayFullRedraws.inc();
 }
 
 // Force a redraw on the next update cycle
@@ -139,7 +381,7 @@ void UIManager::forceRedraw() {
 // Set flag indicating data has updated, potentially requiring a redraw
 void UIManager::setNeedsDataUpdate(bool needsUpdate) {
     if (needsUpdate) {
-        redrawNeeded = true;
+        valuesDirty_ = true;
     }
     // If needsUpdate is false, we don't necessarily clear the redrawNeeded flag,
     // as a redraw might be needed for other reasons (e.g., screen transition).
@@ -178,6 +420,14 @@ void UIManager::startTransition(int nextIndex) {
     activeScreen = screens[activeScreenIndex];
     activeScreen->onEnter(this); // Call onEnter for the new screen
 
+    extern TFT_eSPI tft;
+    if (!prepareTransition(tft)) {
+        // No memory for the sprites: switch immediately with a single full redraw
+        outgoingScreen_ = nullptr;
+        redrawNeeded = true;
+        return;
+    }
+
     // Start the transition timer
     isTransitioning_ = true;
     transitionStartTime_ = millis();
@@ -188,28 +438,28 @@ void UIManager::startTransition(int nextIndex) {
 void UIManager::setWifiStatus(bool connected) {
     if (wifiConnected_ != connected) {
         wifiConnected_ = connected;
-        redrawNeeded = true; // Redraw if status changes
+        valuesDirty_ = true; // Status widgets repaint (or the screen redraws if its layout changes)
     }
 }
 
 void UIManager::setSdCardStatus(bool initialized) {
     if (sdCardInitialized_ != initialized) {
         sdCardInitialized_ = initialized;
-        redrawNeeded = true; // Redraw if status changes
+        valuesDirty_ = true; // Status widgets repaint (or the screen redraws if its layout changes)
     }
 }
 
 void UIManager::setTimeStatus(bool initialized) {
      if (timeInitialized_ != initialized) {
         timeInitialized_ = initialized;
-        redrawNeeded = true; // Redraw if status changes
+        valuesDirty_ = true; // Status widgets repaint (or the screen redraws if its layout changes)
     }
 }
 
 void UIManager::setLedMode(uint8_t mode) {
     if (currentLedMode_ != mode) {
         currentLedMode_ = mode;
-        redrawNeeded = true; // Redraw if status changes
+        valuesDirty_ = true; // Status widgets repaint (or the screen redraws if its layout changes)
     }
 }
 
@@ -5,6 +5,7 @@
 #include <TFT_eSPI.h>
 #include "screen.h" // Needs Screen base class definition
 #include "memory_utils.h"
+#include "display_flusher.h"
 
 // Define button pins used by UIManager for navigation
 // (Moved from sketch_mar18b.ino)
@@ -13,6 +14,8 @@
 
 #define BTN_UP_PIN   2 // Define symbolic names for navigation pins used by UIManager
 #define BTN_DOWN_PIN 41 // Define symbolic names for navigation pins used by UIManager
+#define BTN_LEFT_PIN   40 // Offered to the active screen first (chart span), else Save
+#define BTN_CENTER_PIN 42 // Offered to the active screen first (chart field), else Refresh
 // Other button pins can be handled by individual screens or passed to handleInput
 
 class UIManager {
@@ -25,8 +28,9 @@ public:
     // Set the initial screen (usually the first one added)
     void setInitialScreen();
 
-    // Handle button input. Checks for global navigation first.
-    void handleInput(int buttonPin);
+    // Handle button input. Checks for global navigation first, then offers the button
+    // to the active screen. Returns true if the input was consumed.
+    bool handleInput(int buttonPin);
 
     // Update the UI. Should be called in the main loop. Checks if redraw is needed.
     void update();
@@ -34,7 +38,12 @@ public:
     // Force a redraw of the current screen
     void forceRedraw();
 
-    // Set flag indicating data has updated, potentially requiring a redraw
+    // Renders into the flusher's back buffer and leaves SPI to its task from now on.
+    // Call after the flusher started (begin() returned true) and before the first update().
+    void setDisplayFlusher(DisplayFlusher* flusher);
+
+    // Set flag indicating data has updated. The active screen repaints only the
+    // widgets whose text changed (Screen::updateValues), not the whole screen.
     void setNeedsDataUpdate(bool needsUpdate);
 
     // Getters for shared state (alternative to using extern in screens)
@@ -62,6 +71,10 @@ private:
     int activeScreenIndex;        // Index of the currently active screen
     Screen* activeScreen;         // Pointer to the active screen object
     bool redrawNeeded;            // Flag indicating if the screen needs redrawing
+    bool valuesDirty_;            // Data/status changed: repaint changed widgets only
+    uint32_t lastAnimFrameUs_;    // Last renderFrame() of an animated screen
+    DisplayFlusher* flusher_;     // Asynchronous flush; nullptr = draw to the TFT directly
+    static const uint32_t ANIM_BUDGET_DIVISOR = 3; // A frame may use 1/3 of its interval
 
     // Private members for shared state
     bool wifiConnected_;
@@ -70,11 +83,34 @@ private:
     uint8_t currentLedMode_;
 
     // --- Transition State ---
+    // Both screens are rendered once into full-screen sprites (PSRAM) when the transition
+    // starts; each frame, at most once per TRANSITION_FRAME_US, copies the visible rows of
+    // the two sprites into the flusher's back buffer, or without a flusher pushes them to
+    // the panel in bands through two DMA bounce buffers. A full frame takes longer than
+    // TRANSITION_FRAME_US on the SPI bus, so without a flusher each update() only sends
+    // bands for 1/ANIM_BUDGET_DIVISOR of the frame interval and continues on the next call.
+    static const uint32_t TRANSITION_FRAME_US = 33333; // ~30 fps
+    static const int TRANSITION_BAND_ROWS = 20;        // Rows per DMA transfer
+
     bool isTransitioning_;
     unsigned long transitionStartTime_;
     uint32_t transitionDuration_; // Duration in ms
     Screen* outgoingScreen_;
     // activeScreen serves as the incoming screen during transition
+    TFT_eSprite* outgoingSprite_;
+    TFT_eSprite* incomingSprite_;
+    uint16_t* dmaBands_[2];       // Internal DMA-capable memory; PSRAM cannot feed SPI DMA
+    uint8_t dmaBandIndex_;
+    bool dmaReady_;               // tft.initDMA() succeeded
+    bool busHeld_;                // SPI transaction kept open across frames for DMA
+    bool savedSwapBytes_;         // Restored when the bus is released
+    int frameScroll_;             // Scroll of the frame being sent
+    int bandRow_;                 // Next panel row of that frame to send (>= height: done)
+    bool finalFrame_;             // That frame is the last one
+    uint32_t lastFrameUs_;
+    uint16_t frameCount_;
+    uint32_t frameUsTotal_;
+    uint32_t frameUsMax_;
     // --- End Transition State ---
 
     // Internal method to change the active screen
@@ -82,6 +118,17 @@ private:
 
     // Internal method to start a transition
     void startTransition(int nextIndex);
+
+    // Clears the screen and draws the active screen completely
+    void redrawActiveScreen(TFT_eSPI& target);
+
+    // Transition helpers
+    bool prepareTransition(TFT_eSPI& tft);  // Allocates sprites/buffers and renders both screens
+    void releaseTransition();
+    void pushTransitionFrame(TFT_eSPI& tft, int scroll); // scroll: rows the outgoing screen has moved up
+    void pumpTransitionBands(TFT_eSPI& tft, uint32_t callStartUs);
+    void releaseTransitionBus(TFT_eSPI& tft);
+    void finishTransition(TFT_eSPI& tft);
 };
 
 #endif // UI_MANAGER_H
@@ -0,0 +1,140 @@
+#include "ui_widgets.h"
+#include "metrics.h"
+#include "glyph_cache.h"
+#include <cmath>
+
+uint32_t ValueField::pendingBytes_ = 0;
+ValueField::DamageFn ValueField::damageFn_ = nullptr;
+void* ValueField::damageContext_ = nullptr;
+
+ValueField::ValueField(uint8_t datum, uint8_t textSize, uint16_t fgColor, uint16_t bgColor,
+                       uint16_t clearColor) :
+    datum_(datum),
+    textSize_(textSize),
+    fg_(fgColor),
+    bg_(bgColor),
+    clear_(clearColor),
+    placed_(false),
+    colorDirty_(false),
+    x_(0), y_(0),
+    boxX_(0), boxY_(0), boxW_(0), boxH_(0)
+{
+    text_[0] = '\0';
+}
+
+void ValueField::place(int x, int y) {
+    x_ = x;
+    y_ = y;
+    placed_ = false;
+}
+
+void ValueField::paint(TFT_eSPI& tft, const char* text, int yOffset) {
+    if (yOffset != 0) {
+        // Mid-transition: draw, but the cached box would not match the settled screen
+        render(tft, text, x_, y_ + yOffset);
+        placed_ = false;
+        return;
+    }
+    render(tft, text, x_, y_);
+    strlcpy(text_, text, sizeof(text_));
+    colorDirty_ = false;
+    placed_ = true;
+}
+
+bool ValueField::update(TFT_eSPI& tft, const char* text) {
+    if (!placed_) return false;
+    if (!colorDirty_ && strncmp(text_, text, sizeof(text_) - 1) == 0) return true;
+
+    int16_t oldX = boxX_, oldY = boxY_, oldW = boxW_, oldH = boxH_;
+    render(tft, text, x_, y_);
+
+    // Clear whatever the old text covered outside the new box (same height for one field)
+    if (oldX < boxX_) {
+        int16_t w = min<int16_t>(oldW, boxX_ - oldX);
+        tft.fillRect(oldX, oldY, w, oldH, clear_);
+        countRect(oldX, oldY, w, oldH);
+    }
+    int16_t oldRight = oldX + oldW;
+    int16_t newRight = boxX_ + boxW_;
+    if (oldRight > newRight) {
+        int16_t start = max<int16_t>(oldX, newRight);
+        tft.fillRect(start, oldY, oldRight - start, oldH, clear_);
+        countRect(start, oldY, oldRight - start, oldH);
+    }
+
+    strlcpy(text_, text, sizeof(text_));
+    colorDirty_ = false;
+    return true;
+}
+
+void ValueField::setColor(uint16_t fgColor) {
+    if (fgColor != fg_) {
+        fg_ = fgColor;
+        colorDirty_ = true;
+    }
+}
+
+void ValueField::render(TFT_eSPI& tft, const char* text, int x, int y) {
+    tft.setTextDatum(datum_);
+    tft.setTextSize(textSize_);
+    tft.setTextColor(fg_, bg_); // Opaque glyph cells overwrite the previous value in place
+    textBox(tft, text, x, y, boxX_, boxY_, boxW_, boxH_);
+    // Large numbers are blitted from pre-rendered cells; anything else is rasterized
+    if (!GlyphCache::instance().drawText(tft, text, boxX_, boxY_, textSize_, fg_, bg_)) {
+        tft.drawString(text, x, y);
+    }
+
+    // GLCD text with a background is pushed one character cell (one window) at a time
+    pendingBytes_ += (uint32_t)boxW_ * boxH_ * 2 + strlen(text) * WINDOW_OVERHEAD_BYTES;
+    if (damageFn_) {
+        damageFn_(boxX_, boxY_, boxW_, boxH_, damageContext_);
+    }
+}
+
+void ValueField::textBox(TFT_eSPI& tft, const char* text, int x, int y,
+                         int16_t& bx, int16_t& by, int16_t& bw, int16_t& bh) const {
+    bw = tft.textWidth(text);
+    bh = tft.fontHeight();
+    // Datums 0-8 are TL TC TR / ML MC MR / BL BC BR; baseline datums are treated as top
+    uint8_t d = datum_ <= BR_DATUM ? datum_ : TL_DATUM;
+    switch (d % 3) {
+        case 1: bx = x - bw / 2; break;
+        case 2: bx = x - bw; break;
+        default: bx = x; break;
+    }
+    switch (d / 3) {
+        case 1: by = y - bh / 2; break;
+        case 2: by = y - bh; break;
+        default: by = y; break;
+    }
+}
+
+void ValueField::countRect(int32_t x, int32_t y, int32_t w, int32_t h) {
+    if (w <= 0 || h <= 0) return;
+    pendingBytes_ += (uint32_t)(w * h * 2) + WINDOW_OVERHEAD_BYTES;
+    if (damageFn_) {
+        damageFn_(x, y, w, h, damageContext_);
+    }
+}
+
+uint32_t ValueField::takeBytes() {
+    uint32_t bytes = pendingBytes_;
+    pendingBytes_ = 0;
+    if (bytes > 0 && damageFn_ == nullptr) {
+        systemMetrics.displaySpiBytes.inc(bytes);
+    }
+    return bytes;
+}
+
+void ValueField::setDamageListener(DamageFn fn, void* context) {
+    damageFn_ = fn;
+    damageContext_ = context;
+}
+
+void formatValue(char* out, size_t outLen, float value, uint8_t decimals, const char* suffix) {
+    if (isnan(value)) {
+        strlcpy(out, "---", outLen);
+    } else {
+        snprintf(out, outLen, "%.*f%s", (int)decimals, value, suffix);
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef UI_WIDGETS_H
+#define UI_WIDGETS_H
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+
+/**
+ * 局部刷新控件 (Dirty-region widgets)
+ *
+ * ValueField 是屏幕上一个会变化的文本 (数值、时间、状态字样)。它缓存上次绘制的文本、
+ * 颜色和包围盒, update() 只有在内容变化时才重绘, 并且只重绘自己的区域:
+ * 新文本带背景色直接覆盖, 旧文本比新文本宽出的部分用屏幕底色填掉。
+ *
+ * 字号 GlyphCache::MIN_SIZE 及以上的数值用预渲染的字形块传输绘制 (glyph_cache.h)。
+ *
+ * 使用方式: 屏幕的完整 draw() 先 place() 确定锚点, 再 paint() (整屏清空之后),
+ * 之后每次数据更新调用 update()。过渡动画中 (yOffset != 0) 绘制的结果不会被缓存,
+ * 因此在下一次完整绘制前 update() 返回 false, 由 UIManager 做整屏重绘。
+ *
+ * SPI 流量按 RGB565 像素数 * 2 加每个地址窗口的命令字节估算, 计入
+ * soundscape_display_spi_bytes_total。使用 DisplayFlusher 时绘制区域改为上报给它
+ * (setDamageListener), 字节数由刷新任务按实际推送的像素统计。
+ */
+class ValueField {
+public:
+    static const size_t MAX_TEXT = 24;
+
+    ValueField(uint8_t datum, uint8_t textSize, uint16_t fgColor, uint16_t bgColor,
+               uint16_t clearColor = TFT_BLACK);
+
+    // Sets the anchor (interpreted with the datum); forgets the cached box.
+    void place(int x, int y);
+    // Draws unconditionally at the anchor shifted by yOffset; cached only for yOffset == 0.
+    void paint(TFT_eSPI& tft, const char* text, int yOffset = 0);
+    // Repaints in place if the text or color changed.
+    // Returns false if the field has not been painted in place yet (full redraw needed).
+    bool update(TFT_eSPI& tft, const char* text);
+    // paint() during a full draw, update() for an in-place refresh
+    bool show(TFT_eSPI& tft, const char* text, int yOffset, bool inPlace) {
+        if (inPlace) return update(tft, text);
+        paint(tft, text, yOffset);
+        return true;
+    }
+
+    void setColor(uint16_t fgColor);   // Takes effect on the next paint()/update()
+    void invalidate() { placed_ = false; }
+
+    // Accounting for draws outside of widgets (full-screen clears, bars, plots)
+    static void countRect(int32_t x, int32_t y, int32_t w, int32_t h);
+    static uint32_t takeBytes();       // SPI bytes counted since the last call
+    static void discardBytes() { pendingBytes_ = 0; } // Drew into a sprite, not over SPI
+
+    // Receives every drawn area in screen coordinates while set (DisplayFlusher damage).
+    // The receiver then counts the SPI bytes it actually pushes; takeBytes() only reports.
+    typedef void (*DamageFn)(int32_t x, int32_t y, int32_t w, int32_t h, void* context);
+    static void setDamageListener(DamageFn fn, void* context);
+
+    static const uint32_t WINDOW_OVERHEAD_BYTES = 11; // CASET + RASET + RAMWR with arguments
+
+private:
+
+    uint8_t datum_;
+    uint8_t textSize_;
+    uint16_t fg_;
+    uint16_t bg_;
+    uint16_t clear_;
+    bool placed_;        // Drawn at yOffset 0 since the last full redraw
+    bool colorDirty_;
+    int16_t x_, y_;      // Anchor set by place()
+    int16_t boxX_, boxY_, boxW_, boxH_; // Area covered by the last rendered text
+    char text_[MAX_TEXT];
+
+    void render(TFT_eSPI& tft, const char* text, int x, int y);
+    void textBox(TFT_eSPI& tft, const char* text, int x, int y,
+                 int16_t& bx, int16_t& by, int16_t& bw, int16_t& bh) const;
+
+    static uint32_t pendingBytes_;
+    static DamageFn damageFn_;
+    static void* damageContext_;
+};
+
+// Formats a float like TFT_eSPI::drawFloat, or the placeholder when NaN.
+void formatValue(char* out, size_t outLen, float value, uint8_t decimals, const char* suffix = "");
+
+#endif // UI_WIDGETS_H
@@ -0,0 +1,245 @@
+#include "uplink_manager.h"
+#include "heap_tracker.h"
+#include <WiFi.h>
+#include <Preferences.h>
+#include <esp_random.h>
+
+static const char* UPLINK_PREFS_NAMESPACE = "soundscape";
+static const char* UPLINK_PREFS_KEY = "uplink_ack";
+static const uint32_t POST_US_BUCKETS[] = {10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000};
+
+UplinkManager::UplinkManager(DataManager& dataMgr, const char* url, bool enabled,
+                             uint16_t batchRecords, uint32_t batchIntervalMs) :
+    dataManager_(dataMgr),
+    url_(url),
+    enabled_(enabled && url != nullptr && url[0] != '\0'),
+    batchRecords_(constrain(batchRecords, (uint16_t)1, (uint16_t)MAX_BATCH_RECORDS)),
+    batchIntervalMs_(batchIntervalMs),
+    ackedSeq_(0),
+    persistedAckSeq_(0),
+    lastAckPersistMs_(0),
+    bodyLen_(0),
+    batchCount_(0),
+    batchLastSeq_(0),
+    inFlight_(false),
+    httpResult_(0),
+    lastBatchMs_(0),
+    retryAtMs_(0),
+    retryDelayMs_(RETRY_MIN_MS),
+    task_(nullptr),
+    postUs_(POST_US_BUCKETS, sizeof(POST_US_BUCKETS) / sizeof(POST_US_BUCKETS[0]), 1e-6f)
+{
+    deviceId_[0] = '\0';
+    MetricsRegistry& r = MetricsRegistry::instance();
+    r.addCounter("soundscape_uplink_batches_total", "Uplink batches by result", &batchesOk_, "result=\"ok\"");
+    r.addCounter("soundscape_uplink_batches_total", "Uplink batches by result", &batchesFailed_, "result=\"failed\"");
+    r.addCounter("soundscape_uplink_batches_total", "Uplink batches by result", &batchesRejected_, "result=\"rejected\"");
+    r.addCounter("soundscape_uplink_records_total", "Records acknowledged by the collector", &recordsSent_);
+    r.addCounter("soundscape_uplink_bytes_total", "Uplink request body bytes sent (all attempts)", &bytesSent_);
+    r.addCounter("soundscape_uplink_unsynced_records_total", "Records batched without wall-clock time (FLAG_TIME_UNSYNCED)", &unsyncedSent_);
+    r.addGauge("soundscape_uplink_backlog_records", "Records not yet acknowledged by the collector", &backlogGauge_);
+    r.addHistogram("soundscape_uplink_post_duration_seconds", "Uplink POST time, including connect", &postUs_);
+}
+
+void UplinkManager::begin() {
+    if (!enabled_) {
+        Serial.println("[UplinkManager] Disabled.");
+        return;
+    }
+
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    snprintf(deviceId_, sizeof(deviceId_), "%02x%02x%02x%02x%02x%02x",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+
+    // First enable starts at the current record instead of uploading the whole log
+    Preferences prefs;
+    bool haveAck = false;
+    if (prefs.begin(UPLINK_PREFS_NAMESPACE, true)) {
+        haveAck = prefs.isKey(UPLINK_PREFS_KEY);
+        ackedSeq_ = prefs.getUInt(UPLINK_PREFS_KEY, 0);
+        prefs.end();
+    }
+    if (!haveAck) {
+        ackedSeq_ = dataManager_.getLastSeq();
+        persistAck(true);
+    }
+    persistedAckSeq_ = ackedSeq_;
+    cursor_ = SyncCursor(ackedSeq_);
+    lastBatchMs_ = millis();
+
+    if (xTaskCreate(taskEntry, "uplink", TASK_STACK_SIZE, this, 1, &task_) != pdPASS) {
+        Serial.println("[UplinkManager] ERR: Failed to start uplink task.");
+        enabled_ = false;
+        return;
+    }
+    Serial.printf("[UplinkManager] Posting to %s, resuming after seq %lu\n", url_, (unsigned long)ackedSeq_);
+}
+
+// Records that may be uploaded: with an SD card only what has been flushed to the log
+// (re-stamped and persisted), otherwise everything in RAM.
+static uint32_t uploadableSeq(DataManager& dataManager) {
+    return dataManager.isSdCardInitialized() ? dataManager.getLastFlushedSeq() : dataManager.getLastSeq();
+}
+
+uint32_t UplinkManager::getBacklog() const {
+    uint32_t last = dataManager_.getLastSeq();
+    return last > ackedSeq_ ? last - ackedSeq_ : 0; // Approximate: seq may skip across reboots
+}
+
+void UplinkManager::update() {
+    HeapScope heapScope(HEAP_TAG_COMM);
+    if (!enabled_) return;
+    backlogGauge_.set((float)getBacklog());
+
+    if (inFlight_) return;
+    if (bodyLen_ > 0 && httpResult_ != 0) {
+        handleResult();
+    }
+
+    unsigned long now = millis();
+    if (retryAtMs_ != 0) {
+        if ((long)(now - retryAtMs_) < 0) return;
+    } else if (bodyLen_ == 0) {
+        // Start a new batch when enough records are waiting, or the interval has passed
+        uint32_t limit = uploadableSeq(dataManager_);
+        uint32_t pending = limit > cursor_.lastSeq ? limit - cursor_.lastSeq : 0;
+        if (pending == 0) {
+            lastBatchMs_ = now;
+            return;
+        }
+        if (pending < batchRecords_ && now - lastBatchMs_ < batchIntervalMs_) return;
+    }
+    if (!WiFi.isConnected()) return;
+
+    if (bodyLen_ == 0 && !buildBatch()) return;
+
+    // Hand the batch to the task (it owns body_ until inFlight_ is cleared)
+    retryAtMs_ = 0;
+    httpResult_ = 0;
+    inFlight_ = true;
+    xTaskNotifyGive(task_);
+}
+
+// Packs the next records after cursor_ into body_. Returns false if there is nothing to send.
+bool UplinkManager::buildBatch() {
+    uint32_t limit = uploadableSeq(dataManager_);
+    size_t maxRecords = min((size_t)MAX_BATCH_RECORDS, (size_t)batchRecords_ * 4); // Drain faster when behind
+    EnvironmentData chunk[16];
+    batchCount_ = 0;
+    bodyLen_ = 0;
+
+    for (int reads = 0; reads < 16 && batchCount_ < maxRecords; ++reads) {
+        if (cursor_.phase == SyncCursor::PHASE_DONE) {
+            cursor_ = SyncCursor(cursor_.lastSeq); // Re-position for records written since
+        }
+        uint32_t before = cursor_.lastSeq;
+        size_t n = dataManager_.readRecordsSince(cursor_, chunk, min(sizeof(chunk) / sizeof(chunk[0]), maxRecords - batchCount_));
+        bool reachedLimit = false;
+        for (size_t i = 0; i < n; ++i) {
+            if (chunk[i].seq > limit) {
+                // Not flushed yet: leave it (and everything after) for a later batch
+                cursor_ = SyncCursor(before);
+                reachedLimit = true;
+                break;
+            }
+            before = chunk[i].seq;
+            if (chunk[i].flags & EnvironmentData::FLAG_TIME_UNSYNCED) {
+                unsyncedSent_.inc(); // Sent with its flag; the collector sees a boot-relative time
+            }
+            bodyLen_ += WireProtocol::encodeEnvRecord(body_ + bodyLen_, chunk[i], WireProtocol::SCHEMA_ENV_V3);
+            batchCount_++;
+        }
+        if (reachedLimit) break;
+        if (n == 0 && cursor_.phase == SyncCursor::PHASE_DONE) break;
+    }
+    batchLastSeq_ = cursor_.lastSeq;
+    lastBatchMs_ = millis();
+
+    if (batchCount_ == 0) {
+        bodyLen_ = 0;
+        return false;
+    }
+    return true;
+}
+
+void UplinkManager::handleResult() {
+    int code = httpResult_;
+    bytesSent_.inc(bodyLen_);
+
+    if (code >= 200 && code < 300) {
+        batchesOk_.inc();
+        recordsSent_.inc(batchCount_);
+        ackedSeq_ = batchLastSeq_;
+        bodyLen_ = 0;
+        retryDelayMs_ = RETRY_MIN_MS;
+        persistAck(false);
+        return;
+    }
+    if (code >= 400 && code < 500 && code != 408 && code != 429) {
+        // The collector refuses this payload; retrying would block the queue forever
+        batchesRejected_.inc();
+        Serial.printf("[UplinkManager] Batch up to seq %lu rejected (HTTP %d), skipping.\n",
+                      (unsigned long)batchLastSeq_, code);
+        ackedSeq_ = batchLastSeq_;
+        bodyLen_ = 0;
+        persistAck(false);
+        return;
+    }
+
+    // Keep the batch and retry with exponential backoff (+/-25% jitter so a fleet spreads out)
+    batchesFailed_.inc();
+    uint32_t jitter = retryDelayMs_ / 4;
+    uint32_t delayMs = retryDelayMs_ - jitter + esp_random() % (2 * jitter + 1);
+    retryAtMs_ = millis() + delayMs;
+    if (retryAtMs_ == 0) retryAtMs_ = 1;
+    Serial.printf("[UplinkManager] POST failed (%d), retry in %lu ms\n", code, (unsigned long)delayMs);
+    retryDelayMs_ = min(retryDelayMs_ * 2, (uint32_t)RETRY_MAX_MS);
+    httpResult_ = 0;
+}
+
+void UplinkManager::persistAck(bool force) {
+    unsigned long now = millis();
+    bool drained = ackedSeq_ >= uploadableSeq(dataManager_);
+    if (!force && ackedSeq_ == persistedAckSeq_) return;
+    if (!force && !drained && now - lastAckPersistMs_ < ACK_PERSIST_INTERVAL_MS) return;
+
+    // After a reboot anything past the persisted ack is sent again; the collector dedupes by seq
+    Preferences prefs;
+    if (prefs.begin(UPLINK_PREFS_NAMESPACE, false)) {
+        prefs.putUInt(UPLINK_PREFS_KEY, ackedSeq_);
+        prefs.end();
+        persistedAckSeq_ = ackedSeq_;
+        lastAckPersistMs_ = now;
+    } else {
+        Serial.println("[UplinkManager] WARN: Failed to persist uplink ack to NVS.");
+    }
+}
+
+void UplinkManager::taskEntry(void* param) {
+    static_cast<UplinkManager*>(param)->taskLoop();
+}
+
+void UplinkManager::taskLoop() {
+    http_.setReuse(true); // Keep-alive: back-to-back batches skip the TCP handshake
+    http_.setTimeout(HTTP_TIMEOUT_MS);
+    http_.setConnectTimeout(HTTP_TIMEOUT_MS);
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (!inFlight_) continue;
+
+        uint32_t startUs = micros();
+        int code = HTTPC_ERROR_CONNECTION_REFUSED;
+        if (http_.begin(url_)) {
+            http_.addHeader("Content-Type", "application/octet-stream");
+            http_.addHeader("X-SoundScape-Device", deviceId_);
+            http_.addHeader("X-SoundScape-Schema", "4"); // WireProtocol::SCHEMA_ENV_V3
+            code = http_.POST(body_, bodyLen_);
+            http_.end();
+        }
+        postUs_.observe(micros() - startUs);
+
+        httpResult_ = (code == 0) ? HTTPC_ERROR_CONNECTION_LOST : code;
+        inFlight_ = false; // Releases body_ back to the main loop
+    }
+}
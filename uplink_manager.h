@@ -0,0 +1,94 @@
+#ifndef UPLINK_MANAGER_H
+#define UPLINK_MANAGER_H
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "data_manager.h"
+#include "wire_protocol.h"
+#include "metrics.h"
+
+/**
+ * 存储转发上行 (Store-and-forward uplink to an HTTP collector)
+ *
+ * 记录按批 (满 batchRecords 条或距上一批 batchIntervalMs) 以二进制 POST 到采集端:
+ *   Content-Type: application/octet-stream
+ *   X-SoundScape-Device: 设备 MAC (12 位十六进制)
+ *   X-SoundScape-Schema: 4
+ *   body: N 条 SCHEMA_ENV_V3 记录 (wire_protocol.h, 每条 19 字节, seq 升序, 末尾为 flags)
+ * 采集端返回 2xx 即确认整批; 采集端应按 (device, seq) 去重, 因为重启或超时后可能重发。
+ *
+ * 积压数据不另存副本: SD 日志本身就是待发送队列, 本模块只在 NVS 中保存"已确认的最大 seq",
+ * 离线期间记录照常写入 SD, 恢复联网后通过 DataManager::readRecordsSince() 续传。
+ * 有 SD 卡时只上传已写入 SD 的记录 (此时时间戳通常已完成 NTP 修正); 仍无法换算为真实时间的记录
+ * 照常上传, timestamp 为开机秒数并带 FLAG_TIME_UNSYNCED, 由采集端决定如何处理。
+ *
+ * 阻塞的 HTTP 请求在独立的 FreeRTOS 任务中执行, 主循环只负责组批和处理结果;
+ * 失败后按指数退避重试 (RETRY_MIN_MS..RETRY_MAX_MS), 除 408/429 外的 4xx 视为采集端拒收, 跳过该批。
+ */
+class UplinkManager {
+public:
+    UplinkManager(DataManager& dataMgr, const char* url, bool enabled,
+                  uint16_t batchRecords = 60, uint32_t batchIntervalMs = 60000);
+
+    void begin();  // After DataManager::begin() (needs the record seq)
+    void update(); // Called in loop
+
+    bool isEnabled() const { return enabled_; }
+    uint32_t getAckedSeq() const { return ackedSeq_; }
+    uint32_t getBacklog() const;
+
+private:
+    static const size_t MAX_BATCH_RECORDS = 240;          // Upper bound when draining a backlog
+    static const uint32_t RETRY_MIN_MS = 5000;
+    static const uint32_t RETRY_MAX_MS = 300000;
+    static const uint32_t ACK_PERSIST_INTERVAL_MS = 60000; // NVS write rate limit while draining
+    static const uint32_t HTTP_TIMEOUT_MS = 8000;
+    static const uint32_t TASK_STACK_SIZE = 8192;
+
+    DataManager& dataManager_;
+    const char* url_;
+    bool enabled_;
+    uint16_t batchRecords_;
+    uint32_t batchIntervalMs_;
+    char deviceId_[13];
+
+    // Record cursor: ackedSeq_ is confirmed by the collector, cursor_ is what has been batched
+    uint32_t ackedSeq_;
+    uint32_t persistedAckSeq_;
+    unsigned long lastAckPersistMs_;
+    SyncCursor cursor_;
+
+    // Batch being sent. Owned by the task while inFlight_ is true.
+    uint8_t body_[MAX_BATCH_RECORDS * WireProtocol::ENV_V3_RECORD_SIZE];
+    size_t bodyLen_;
+    uint16_t batchCount_;
+    uint32_t batchLastSeq_;
+    volatile bool inFlight_;
+    volatile int httpResult_;      // HTTP status or HTTPClient error (< 0) of the finished POST
+    unsigned long lastBatchMs_;
+    unsigned long retryAtMs_;      // 0 = no retry pending
+    uint32_t retryDelayMs_;
+
+    TaskHandle_t task_;
+    HTTPClient http_; // Only used by the task
+
+    MetricCounter batchesOk_;
+    MetricCounter batchesFailed_;
+    MetricCounter batchesRejected_;
+    MetricCounter recordsSent_;
+    MetricCounter bytesSent_;
+    MetricCounter unsyncedSent_;
+    MetricGauge backlogGauge_;
+    MetricHistogram postUs_;
+
+    bool buildBatch();
+    void handleResult();
+    void persistAck(bool force);
+
+    static void taskEntry(void* param);
+    void taskLoop();
+};
+
+#endif // UPLINK_MANAGER_H
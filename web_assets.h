@@ -0,0 +1,275 @@
+// Generated by tools/build_web_assets.py from web/ - do not edit.
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+
+struct WebAsset {
+    const char* path;         // Request path
+    const char* contentType;
+    const char* etag;         // Quoted strong ETag
+    const uint8_t* data;      // gzip-compressed body in flash
+    size_t length;
+};
+
+// /: 14554 bytes, 4014 gzipped
+static const uint8_t WEB_ASSET_ROOT[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0xff, 0xb5, 0x5b, 0x5b, 0x6f, 0x1b, 0xc7,
+    0x15, 0x7e, 0xe7, 0xaf, 0x18, 0xbb, 0x4e, 0xb8, 0x8c, 0xc9, 0x25, 0x25, 0xc3, 0x09, 0x20, 0x51,
+    0x0a, 0x64, 0x59, 0x2e, 0x8c, 0x3a, 0xb6, 0x6a, 0xc9, 0x0d, 0x82, 0x20, 0x85, 0x57, 0xbb, 0x43,
+    0x72, 0xe2, 0xe5, 0x0e, 0xb3, 0x33, 0x2b, 0x5a, 0x71, 0xd8, 0xa7, 0xb6, 0xee, 0x43, 0x9a, 0x02,
+    0xbd, 0x3c, 0xe5, 0x25, 0x28, 0x0a, 0xa4, 0x40, 0x81, 0x24, 0xe8, 0x4b, 0x92, 0xa2, 0x97, 0x3f,
+    0x53, 0xd9, 0xcd, 0xbf, 0xe8, 0x39, 0x33, 0xb3, 0xf7, 0xd9, 0xa5, 0xec, 0x20, 0x7c, 0x91, 0xb8,
+    0x3b, 0x73, 0x66, 0xce, 0xfd, 0x3b, 0x67, 0x86, 0xe3, 0x4b, 0x37, 0xef, 0xed, 0x1f, 0xbf, 0x73,
+    0x78, 0x40, 0x66, 0x72, 0x1e, 0xee, 0x76, 0xc6, 0xe9, 0x1f, 0xea, 0x05, 0xbb, 0x1d, 0x02, 0x9f,
+    0xb1, 0x64, 0x32, 0xa4, 0xbb, 0x07, 0x47, 0x87, 0xd7, 0x36, 0xc9, 0x5e, 0x12, 0x30, 0x4e, 0x8e,
+    0x64, 0x4c, 0xbd, 0xf9, 0x78, 0xa8, 0xdf, 0xe8, 0x51, 0x73, 0x2a, 0x3d, 0x12, 0x79, 0x73, 0xba,
+    0xd3, 0x3d, 0x65, 0x74, 0xb9, 0xe0, 0xb1, 0xec, 0x12, 0x9f, 0x47, 0x92, 0x46, 0x72, 0xa7, 0xbb,
+    0x64, 0x81, 0x9c, 0xed, 0x04, 0xf4, 0x94, 0xf9, 0x74, 0xa0, 0xbe, 0xf4, 0x09, 0x8b, 0x98, 0x64,
+    0x5e, 0x38, 0x10, 0xbe, 0x17, 0xd2, 0x9d, 0x8d, 0xae, 0x21, 0x24, 0xe4, 0x59, 0x4a, 0x14, 0x3f,
+    0x27, 0x3c, 0x38, 0x23, 0x4f, 0xc8, 0x04, 0x28, 0x0d, 0x26, 0xde, 0x9c, 0x85, 0x67, 0x5b, 0x44,
+    0x78, 0x91, 0x18, 0x08, 0x1a, 0xb3, 0xc9, 0x36, 0x91, 0xf4, 0xb1, 0x1c, 0x78, 0x21, 0x9b, 0x46,
+    0x5b, 0xc4, 0x87, 0xb5, 0x68, 0xbc, 0x4d, 0x16, 0x5e, 0x10, 0xb0, 0x68, 0xba, 0x45, 0x36, 0x47,
+    0x8b, 0xc7, 0xdb, 0x64, 0x95, 0x13, 0x4b, 0xa4, 0xe4, 0x51, 0x4a, 0x4e, 0xb0, 0x0f, 0xe9, 0x16,
+    0xd9, 0x70, 0x37, 0xe9, 0xbc, 0x30, 0x67, 0x03, 0xe6, 0x98, 0x89, 0x73, 0x2f, 0x9e, 0xb2, 0x48,
+    0x3f, 0xda, 0x26, 0x7e, 0x12, 0x0b, 0x1e, 0x6f, 0x91, 0x05, 0x67, 0x7a, 0x99, 0x9c, 0xee, 0x8f,
+    0x84, 0xf4, 0x64, 0x22, 0x80, 0xb0, 0x9e, 0x32, 0x90, 0x7c, 0x91, 0xae, 0xae, 0x96, 0x5a, 0x52,
+    0x36, 0x9d, 0xc9, 0x2d, 0xe0, 0x26, 0x0c, 0xd2, 0x89, 0xe3, 0xa1, 0x61, 0x75, 0x3c, 0xd4, 0xd2,
+    0x1e, 0x23, 0xaf, 0x46, 0x0a, 0xb3, 0x0d, 0x23, 0xf1, 0x3b, 0xec, 0x94, 0x56, 0xc4, 0x0e, 0xef,
+    0xf4, 0x20, 0xc3, 0x0e, 0x0b, 0x76, 0xba, 0x8b, 0xd0, 0x3b, 0xbb, 0xa1, 0xbe, 0x76, 0x77, 0x0f,
+    0xe1, 0xff, 0xf1, 0x50, 0xbf, 0xac, 0x8f, 0x14, 0xb0, 0x37, 0x33, 0x92, 0x04, 0x4c, 0x78, 0x27,
+    0x21, 0x0d, 0x76, 0x8f, 0xe0, 0x61, 0x65, 0x4a, 0xc0, 0x4e, 0xcd, 0x78, 0x64, 0xad, 0x0b, 0x43,
+    0xf0, 0xef, 0x16, 0xb9, 0xc9, 0x04, 0xa8, 0x35, 0xa2, 0xbe, 0xa4, 0xc1, 0x78, 0x08, 0xa3, 0x76,
+    0x3b, 0x46, 0x71, 0x7e, 0xcc, 0x16, 0x32, 0xd7, 0x5c, 0x48, 0x25, 0x59, 0x0a, 0xb2, 0x43, 0xa2,
+    0x24, 0x0c, 0xb7, 0x4b, 0x8f, 0x3d, 0xe4, 0x67, 0x1f, 0x8d, 0xe3, 0xb1, 0x6c, 0x1e, 0x70, 0x23,
+    0x99, 0x4c, 0x68, 0xfc, 0xd3, 0x84, 0x26, 0x14, 0x06, 0xbd, 0xfb, 0x5e, 0x79, 0x08, 0x13, 0xc8,
+    0x27, 0xa8, 0x0c, 0xde, 0x4d, 0xbc, 0x50, 0xd0, 0xea, 0x6b, 0x3d, 0x5d, 0x0f, 0x90, 0x71, 0x52,
+    0x79, 0x1f, 0xc1, 0xd2, 0xc0, 0x52, 0x2c, 0x8f, 0xd9, 0x1c, 0xc9, 0x8f, 0xf2, 0xd7, 0xc0, 0x9e,
+    0x90, 0x60, 0x64, 0xf3, 0x45, 0x48, 0xef, 0x7b, 0x12, 0xdf, 0x6e, 0xbc, 0x3e, 0x1a, 0x8d, 0xb6,
+    0xc9, 0x70, 0x48, 0xfe, 0xfb, 0xcd, 0x27, 0x44, 0x6b, 0xe6, 0xf6, 0xe6, 0x11, 0xf9, 0xee, 0xe9,
+    0xd3, 0x67, 0x9f, 0x7d, 0xfd, 0xfc, 0x93, 0xa7, 0xe7, 0x1f, 0x7f, 0xfb, 0xdd, 0xaf, 0x7e, 0x5b,
+    0x21, 0x71, 0xa2, 0x76, 0x70, 0x04, 0x66, 0x76, 0x44, 0xe1, 0x49, 0x80, 0xc2, 0x18, 0xb9, 0xd7,
+    0x15, 0x9d, 0xf3, 0x2f, 0xfe, 0xfc, 0xec, 0x37, 0x5f, 0x3f, 0xff, 0xdb, 0x97, 0xcf, 0xff, 0xf9,
+    0x87, 0xf3, 0x5f, 0xff, 0xfd, 0xf9, 0xe7, 0xbf, 0x7f, 0xf6, 0xa7, 0xaf, 0x2a, 0xf3, 0x61, 0x7b,
+    0x53, 0x2a, 0x6f, 0x64, 0x54, 0x60, 0x7a, 0x61, 0x57, 0xaf, 0xd5, 0xe9, 0x2b, 0xca, 0xcf, 0x3f,
+    0xfd, 0xe2, 0xd9, 0x67, 0x4f, 0x35, 0xd9, 0xf3, 0x8f, 0xff, 0x71, 0xfe, 0x97, 0xcf, 0xcf, 0xbf,
+    0xfa, 0x1d, 0x71, 0xf4, 0x4c, 0xd1, 0xeb, 0x54, 0xf9, 0x54, 0x7a, 0xbd, 0x09, 0xda, 0xde, 0x21,
+    0x01, 0xf7, 0x93, 0x39, 0x38, 0x91, 0x0b, 0xcb, 0x1e, 0x84, 0x14, 0xff, 0xbd, 0x71, 0x76, 0x3b,
+    0x70, 0x52, 0x23, 0xe8, 0x55, 0x85, 0x94, 0x9b, 0x5d, 0xdb, 0xec, 0x82, 0x71, 0xd6, 0x28, 0xe4,
+    0xe6, 0xd8, 0xbe, 0x7e, 0x66, 0xb4, 0x40, 0x21, 0x23, 0x31, 0x49, 0x22, 0x5f, 0x32, 0x98, 0x9a,
+    0x2c, 0x02, 0x10, 0x89, 0x36, 0x51, 0x67, 0x4e, 0x85, 0xf0, 0xa6, 0xb4, 0x47, 0x9e, 0x64, 0x03,
+    0xf1, 0x93, 0x31, 0xea, 0xa2, 0xd9, 0xed, 0xeb, 0xd0, 0x04, 0x8b, 0x76, 0x53, 0xcb, 0xee, 0x92,
+    0xab, 0xc4, 0xcc, 0xdd, 0x2e, 0xcd, 0xc4, 0x9d, 0xf2, 0x90, 0xba, 0x21, 0x9f, 0x3a, 0xe9, 0xe8,
+    0x6e, 0x3f, 0x1d, 0x5b, 0x60, 0x69, 0x65, 0xd9, 0x9a, 0x71, 0x96, 0xb7, 0xe9, 0xc9, 0x11, 0xf7,
+    0x1f, 0x51, 0xe9, 0x54, 0xf7, 0xc5, 0x26, 0xc4, 0x01, 0x3f, 0x79, 0xf5, 0x55, 0xf0, 0x16, 0x17,
+    0x3c, 0x3c, 0x38, 0xc3, 0x25, 0x40, 0xd9, 0x3b, 0x3b, 0x24, 0x9b, 0xe5, 0xde, 0x3b, 0x3c, 0xb8,
+    0x5b, 0x9d, 0x89, 0x9f, 0x12, 0xe7, 0xdd, 0xbd, 0x50, 0x11, 0x20, 0x99, 0x87, 0x16, 0x05, 0x9e,
+    0x7e, 0x62, 0x2a, 0x93, 0x38, 0x2a, 0x3f, 0x2f, 0xec, 0x3c, 0xd7, 0xcd, 0x52, 0x1c, 0xc6, 0x5c,
+    0x72, 0x9f, 0x87, 0x20, 0xa6, 0x25, 0x8b, 0x02, 0xbe, 0x04, 0x19, 0xf8, 0x1e, 0xf2, 0xe5, 0x2e,
+    0xb2, 0x57, 0xb0, 0xcf, 0xee, 0x4c, 0xca, 0x05, 0x08, 0x85, 0xbc, 0x49, 0xba, 0x4b, 0x81, 0xff,
+    0x6c, 0xe1, 0x3f, 0x5b, 0xdd, 0x6d, 0x2b, 0xd9, 0x07, 0x31, 0x52, 0x7c, 0x78, 0xe5, 0x49, 0xbe,
+    0xc2, 0x6a, 0x38, 0x84, 0xaf, 0x95, 0x35, 0x66, 0x5c, 0x48, 0xcc, 0x29, 0xab, 0xa1, 0x0a, 0x08,
+    0x0f, 0xb5, 0x07, 0xfe, 0xeb, 0x3f, 0xcf, 0xff, 0xf8, 0xd7, 0xe7, 0x9f, 0x7e, 0x73, 0xfe, 0xe5,
+    0xb7, 0xff, 0xfb, 0xfa, 0xcb, 0xf3, 0x7f, 0xff, 0x92, 0xe8, 0xd7, 0x9d, 0x46, 0xb9, 0x3c, 0xdc,
+    0xd7, 0xf2, 0xc0, 0x60, 0x20, 0x39, 0xc1, 0x75, 0x61, 0x0b, 0x2b, 0xd7, 0x75, 0x1f, 0x16, 0xcd,
+    0x09, 0x3f, 0x3a, 0x62, 0xd1, 0x65, 0x2e, 0x7a, 0x47, 0x0d, 0xae, 0x8f, 0x73, 0x79, 0xc4, 0x17,
+    0x14, 0xcd, 0x16, 0x54, 0xba, 0xb3, 0xbb, 0x56, 0x37, 0xfb, 0x6d, 0x3a, 0xc9, 0x5d, 0xc4, 0x4d,
+    0x83, 0x72, 0x3d, 0xae, 0xe5, 0x96, 0x9c, 0x7a, 0x43, 0x71, 0xb0, 0x8a, 0x71, 0x28, 0x20, 0x0c,
+    0xe6, 0x10, 0xff, 0xb2, 0xe8, 0x4e, 0x92, 0x48, 0xb2, 0x50, 0x2d, 0x81, 0x4e, 0x10, 0x4b, 0x51,
+    0xa3, 0x68, 0x89, 0x96, 0x9a, 0x12, 0x8c, 0x36, 0x61, 0x06, 0x5f, 0xe5, 0xe6, 0x5c, 0xa3, 0x60,
+    0x8f, 0xd8, 0x48, 0x64, 0x3f, 0xa4, 0x5e, 0x4c, 0x3e, 0x50, 0x0f, 0x81, 0x00, 0xca, 0xd6, 0x10,
+    0x01, 0x15, 0xd7, 0xe8, 0xd4, 0xe3, 0x32, 0xd2, 0xb8, 0x4f, 0x05, 0xc4, 0x6c, 0xe1, 0xcf, 0x68,
+    0x90, 0x84, 0x4a, 0x8b, 0xf8, 0xb6, 0x9d, 0xda, 0xca, 0xa6, 0x31, 0xe3, 0xb3, 0xa8, 0x34, 0x7a,
+    0x0a, 0xfe, 0xdf, 0xa0, 0x39, 0xf4, 0x49, 0xf5, 0xde, 0x05, 0x0d, 0x7a, 0x00, 0x55, 0x40, 0x6e,
+    0x91, 0x4f, 0xf9, 0x84, 0xdc, 0x08, 0xf9, 0x89, 0xcd, 0x0f, 0xf1, 0xa3, 0x36, 0xea, 0x05, 0x44,
+    0xce, 0x28, 0x39, 0x81, 0x71, 0xc4, 0x13, 0xc4, 0x8b, 0xc8, 0x5e, 0x1c, 0xa3, 0x72, 0x51, 0x34,
+    0xd6, 0x69, 0xf9, 0x42, 0xae, 0x97, 0x0f, 0x75, 0x7a, 0x2e, 0xd0, 0x89, 0x9c, 0xc2, 0x23, 0xfb,
+    0x5e, 0x0b, 0xab, 0xef, 0x09, 0x91, 0xcc, 0x95, 0x78, 0x60, 0x07, 0x7a, 0xe7, 0x02, 0x72, 0xd7,
+    0xe0, 0x84, 0x49, 0x72, 0xb8, 0xff, 0x96, 0xc9, 0x1e, 0xa2, 0x91, 0x84, 0x09, 0xea, 0xfe, 0xfc,
+    0x26, 0xce, 0xd5, 0x7e, 0x70, 0x3b, 0x92, 0x1b, 0xaf, 0x2b, 0x16, 0x8a, 0x5b, 0xb1, 0x98, 0x70,
+    0x93, 0x25, 0xb8, 0x8b, 0x44, 0xcc, 0x1c, 0x43, 0xb4, 0xa7, 0xd4, 0xb9, 0x17, 0x04, 0x05, 0xba,
+    0xe8, 0x92, 0xca, 0x3c, 0x3a, 0x6d, 0xbc, 0xed, 0xcf, 0xa8, 0xff, 0x08, 0x15, 0xb3, 0xa4, 0xb0,
+    0x2f, 0xb0, 0x6a, 0x98, 0xa5, 0xac, 0x59, 0x19, 0x36, 0x32, 0xed, 0x4d, 0x00, 0x96, 0xe5, 0xd6,
+    0xda, 0x48, 0x0c, 0x95, 0x5b, 0x30, 0xf8, 0x5e, 0x8b, 0x4c, 0x53, 0xb4, 0x00, 0xd8, 0x2f, 0xc6,
+    0x64, 0xa4, 0xe6, 0xd0, 0xe0, 0x48, 0xcb, 0x11, 0x24, 0x54, 0x63, 0x16, 0xde, 0x26, 0x3e, 0x75,
+    0x1c, 0x50, 0x44, 0x9f, 0x80, 0xc0, 0x94, 0x81, 0xc1, 0x17, 0xc8, 0x2d, 0xf0, 0xcd, 0x0d, 0x69,
+    0x34, 0x45, 0xf0, 0x3b, 0x6a, 0x11, 0x60, 0x3d, 0x7c, 0x65, 0x7b, 0x85, 0x88, 0x05, 0xd1, 0xeb,
+    0x2d, 0x4f, 0xce, 0xdc, 0x98, 0x27, 0x51, 0xe0, 0x38, 0x0d, 0x3b, 0x1b, 0xd6, 0xc0, 0x43, 0x0f,
+    0x00, 0xc3, 0xc6, 0x68, 0xd4, 0x5b, 0xbd, 0xf2, 0x70, 0xcd, 0xda, 0x28, 0x9f, 0x06, 0xb2, 0xbb,
+    0x3b, 0x16, 0xba, 0xed, 0xe2, 0xab, 0x87, 0x97, 0x86, 0xa8, 0xd6, 0x1e, 0x3d, 0x73, 0x02, 0x3e,
+    0xc7, 0xbd, 0x48, 0xea, 0x2a, 0x67, 0x53, 0xd6, 0x83, 0x16, 0xe0, 0x76, 0x7b, 0xeb, 0x69, 0x6a,
+    0xd5, 0x1b, 0xe0, 0x08, 0x3b, 0x47, 0xc3, 0xba, 0x3d, 0xd1, 0xa1, 0x71, 0x09, 0xde, 0xba, 0x88,
+    0x21, 0x3e, 0x80, 0x6d, 0x05, 0x89, 0x5a, 0x6a, 0xbd, 0x2d, 0x55, 0x00, 0x46, 0x2c, 0x91, 0xf6,
+    0x89, 0xe7, 0x3f, 0x72, 0x2e, 0xb0, 0x9b, 0x55, 0xe7, 0xe5, 0xde, 0xda, 0xdf, 0xac, 0x2c, 0x2b,
+    0xae, 0x08, 0x05, 0x59, 0x37, 0x68, 0xa8, 0x04, 0x6b, 0xee, 0x53, 0x9f, 0x42, 0xa9, 0x11, 0x90,
+    0x88, 0x47, 0x10, 0x2f, 0x22, 0x2f, 0x3e, 0x4b, 0x01, 0x0e, 0x62, 0x9d, 0x3c, 0x46, 0xd9, 0x56,
+    0x59, 0x1f, 0x77, 0x69, 0x1c, 0xf3, 0x58, 0x45, 0x5d, 0xfc, 0xe7, 0x42, 0xf9, 0x32, 0x4b, 0xc0,
+    0xe4, 0x00, 0xe7, 0xd8, 0xd4, 0x9b, 0x72, 0xa0, 0x88, 0xd6, 0x66, 0xa8, 0x7d, 0xab, 0xe5, 0x2c,
+    0x33, 0x21, 0x29, 0x45, 0xc9, 0x42, 0x15, 0x56, 0x55, 0x55, 0x59, 0x19, 0xf0, 0x43, 0x2e, 0xd6,
+    0xa6, 0x8d, 0xb2, 0xd7, 0x16, 0x2b, 0x25, 0xe2, 0xec, 0xf3, 0x00, 0xaa, 0xcd, 0x2b, 0x4f, 0xb4,
+    0x24, 0x7d, 0xf8, 0xb6, 0xea, 0xa3, 0x05, 0x0b, 0x1e, 0xe5, 0x8f, 0x63, 0xf5, 0x9d, 0x7c, 0xf4,
+    0x11, 0xe9, 0xde, 0x1d, 0xee, 0x75, 0x57, 0xbd, 0x87, 0x2d, 0x5c, 0x2b, 0xbd, 0xe5, 0x3c, 0xab,
+    0x1d, 0x06, 0x99, 0xb2, 0x5e, 0x9c, 0xe9, 0x36, 0x14, 0x6b, 0x52, 0x2f, 0xd5, 0x6e, 0x28, 0xac,
+    0x20, 0xf6, 0x52, 0x5e, 0x92, 0x01, 0x03, 0x97, 0x8a, 0x45, 0x9e, 0x71, 0x35, 0x1d, 0xc3, 0x4b,
+    0xd5, 0x1f, 0x38, 0xdd, 0x92, 0x86, 0xe1, 0xcb, 0x83, 0xd4, 0x88, 0x2f, 0xd3, 0x38, 0x6c, 0x68,
+    0xba, 0x26, 0x78, 0x21, 0x82, 0xb0, 0xe1, 0xcf, 0x90, 0xf3, 0x47, 0x1e, 0x96, 0xdc, 0x29, 0xc4,
+    0x70, 0x37, 0x55, 0x56, 0x3a, 0x8e, 0x55, 0x30, 0x49, 0x59, 0x25, 0xbf, 0xd8, 0x1c, 0x8d, 0xe6,
+    0x90, 0xc1, 0x71, 0x68, 0xa7, 0x9a, 0x11, 0xd2, 0x51, 0xc1, 0xcd, 0x24, 0x56, 0x60, 0x35, 0xc3,
+    0x2a, 0xc7, 0x31, 0xb8, 0x3f, 0x46, 0x10, 0xaf, 0x24, 0xb9, 0x00, 0x50, 0x04, 0xe4, 0x65, 0x48,
+    0xc8, 0xbe, 0x07, 0xfc, 0x76, 0x2e, 0x90, 0xde, 0xe2, 0x2a, 0xea, 0x09, 0x00, 0x42, 0xc1, 0xf3,
+    0xb9, 0xf7, 0x3e, 0x38, 0x53, 0xe8, 0x01, 0x20, 0x8b, 0xd3, 0x36, 0x8a, 0x8e, 0x3e, 0x35, 0x9d,
+    0x94, 0xe1, 0xd4, 0x18, 0xa5, 0x65, 0x0d, 0xd8, 0xa9, 0x4d, 0x2d, 0xbd, 0x38, 0x72, 0x1e, 0x1e,
+    0xe5, 0x4b, 0xe2, 0x2a, 0x01, 0x44, 0x5b, 0x34, 0xe2, 0xad, 0x0a, 0x3a, 0x73, 0xae, 0x3c, 0x29,
+    0x3d, 0x70, 0x25, 0xbf, 0xc5, 0x1e, 0xd3, 0xc0, 0xb9, 0xd6, 0x5b, 0xf5, 0xf4, 0x62, 0x6a, 0x0c,
+    0x40, 0xfa, 0xe2, 0x1b, 0x57, 0xc3, 0x39, 0x44, 0xe3, 0xae, 0x35, 0x17, 0x55, 0x31, 0x20, 0xd2,
+    0xb9, 0x0a, 0x6a, 0x1a, 0x5d, 0x2f, 0x80, 0xc1, 0x2c, 0xfd, 0x8b, 0x10, 0x7b, 0x2b, 0xe1, 0x99,
+    0x56, 0x14, 0x01, 0x8c, 0x06, 0xe3, 0x3b, 0xe4, 0x82, 0x10, 0xf7, 0x38, 0x66, 0xd3, 0x69, 0x11,
+    0x36, 0xa8, 0x3a, 0x91, 0x12, 0x6f, 0xea, 0x81, 0xbe, 0xb4, 0x3e, 0x40, 0x06, 0x53, 0xd0, 0xc8,
+    0x89, 0x17, 0x84, 0x67, 0x6d, 0x06, 0x09, 0xe4, 0x06, 0x83, 0x01, 0xec, 0x6f, 0xc2, 0x22, 0x18,
+    0x6f, 0x40, 0x5b, 0x41, 0x98, 0x77, 0xf8, 0x94, 0xf9, 0x38, 0xa6, 0x1c, 0x5f, 0x66, 0x0c, 0xac,
+    0xcd, 0xa9, 0x41, 0x09, 0x8d, 0x15, 0xc8, 0x2e, 0x19, 0x61, 0x71, 0x68, 0xd1, 0x24, 0x08, 0xa5,
+    0x6c, 0xcb, 0x57, 0xeb, 0x66, 0x69, 0x3c, 0xef, 0x28, 0x35, 0xea, 0xb2, 0xb4, 0x3a, 0xeb, 0x10,
+    0x60, 0x6d, 0x53, 0x62, 0xc6, 0x26, 0xd2, 0x96, 0xdc, 0x54, 0x04, 0x48, 0x27, 0x82, 0xff, 0x9b,
+    0x7f, 0x53, 0x2e, 0xb0, 0x4a, 0x1c, 0xf5, 0x54, 0x47, 0x90, 0x45, 0x69, 0x79, 0xf1, 0x88, 0x2d,
+    0x08, 0x9d, 0x2f, 0xe4, 0x99, 0x11, 0xbf, 0xe8, 0x34, 0x6c, 0x68, 0x12, 0x72, 0x4f, 0x5e, 0xdb,
+    0x2c, 0xc0, 0xd2, 0x5b, 0xfa, 0x89, 0x06, 0xa6, 0xe5, 0xb5, 0x1a, 0x42, 0xa6, 0x04, 0xbf, 0x79,
+    0xac, 0x50, 0xe7, 0xcf, 0xbc, 0x50, 0x15, 0x28, 0xd7, 0x36, 0xdf, 0x78, 0xfd, 0x0d, 0x57, 0x7b,
+    0xed, 0xe6, 0xcf, 0x37, 0xae, 0x93, 0x01, 0xd9, 0x20, 0xce, 0x44, 0x39, 0x15, 0x0c, 0xeb, 0xd5,
+    0xc8, 0xe0, 0x2b, 0x47, 0x75, 0x97, 0xb4, 0xb7, 0x33, 0xd0, 0x43, 0x79, 0x6d, 0x78, 0x76, 0xf5,
+    0x6a, 0x13, 0x24, 0x2a, 0x70, 0xf1, 0x2e, 0x7b, 0x0f, 0x48, 0x98, 0xb9, 0xf8, 0x65, 0x58, 0xde,
+    0x9d, 0xda, 0xd3, 0x5d, 0x1e, 0xcf, 0xbd, 0x10, 0x1b, 0x3f, 0x6a, 0x3f, 0x68, 0xf2, 0x8a, 0x04,
+    0x19, 0x6c, 0xb8, 0x23, 0xfc, 0x06, 0x7f, 0x2c, 0xc9, 0xb8, 0x63, 0x41, 0xcf, 0x87, 0xb1, 0x4a,
+    0x0a, 0xc4, 0x87, 0x0c, 0xa3, 0xca, 0xe0, 0x0f, 0x69, 0xcc, 0x07, 0x46, 0x37, 0xa9, 0xf0, 0x6d,
+    0x2a, 0x2d, 0xec, 0xb9, 0xa2, 0xca, 0x76, 0x50, 0xa1, 0x02, 0xc9, 0x65, 0xd4, 0xf0, 0xa2, 0xba,
+    0x9c, 0xb2, 0x29, 0xb3, 0xa8, 0x7b, 0xb9, 0x01, 0x27, 0x65, 0x86, 0x72, 0x11, 0x06, 0x25, 0x44,
+    0xee, 0xe6, 0xed, 0x94, 0xda, 0x89, 0xb5, 0x5c, 0x81, 0x02, 0x31, 0x69, 0xcd, 0xd9, 0xe8, 0x93,
+    0x3a, 0xbf, 0xfd, 0x42, 0xd3, 0xad, 0x61, 0xb3, 0x05, 0xfa, 0x90, 0xd9, 0x17, 0x67, 0xc7, 0x7c,
+    0x7f, 0xe6, 0x41, 0xe6, 0x0f, 0x8b, 0xe2, 0xd3, 0xa0, 0xbf, 0x65, 0x97, 0x82, 0x27, 0xb1, 0x4f,
+    0xef, 0x02, 0x32, 0x68, 0xdb, 0xe4, 0x91, 0x1a, 0xd5, 0x04, 0x2f, 0x73, 0x1a, 0xee, 0x49, 0x89,
+    0x5f, 0x3d, 0x79, 0xed, 0x24, 0x03, 0x58, 0x9c, 0xd2, 0xf2, 0x01, 0x15, 0xa0, 0x0b, 0x1d, 0x4e,
+    0x1a, 0x38, 0x00, 0x13, 0x83, 0xe0, 0x66, 0xa9, 0xd0, 0x21, 0xd2, 0x80, 0x19, 0x09, 0x36, 0x8d,
+    0xd8, 0x84, 0xf9, 0x5e, 0x84, 0xa1, 0x27, 0x60, 0xaa, 0xaa, 0x88, 0x64, 0x13, 0x29, 0x34, 0x3c,
+    0x55, 0xe4, 0x78, 0x27, 0xa2, 0x92, 0xc2, 0x06, 0x8d, 0xa9, 0xbe, 0x87, 0x91, 0xd2, 0xdd, 0x68,
+    0x29, 0xce, 0x6b, 0xe8, 0xa9, 0x98, 0xe8, 0x8c, 0xb8, 0x20, 0x7d, 0x64, 0xa9, 0xfb, 0xca, 0x93,
+    0x62, 0x50, 0x76, 0xd3, 0xe7, 0xbd, 0x62, 0x36, 0x03, 0x7c, 0x20, 0x49, 0x4b, 0x1e, 0x84, 0x14,
+    0xcc, 0x97, 0x08, 0xf0, 0xaa, 0x59, 0xb0, 0xa9, 0x0a, 0x83, 0x7d, 0xae, 0xd6, 0x69, 0x49, 0x25,
+    0xbe, 0xb2, 0x60, 0x1a, 0xa8, 0x95, 0x85, 0x77, 0xb5, 0x64, 0x0c, 0x19, 0x43, 0xdb, 0xa5, 0x0c,
+    0x81, 0x53, 0x52, 0x69, 0xc4, 0x98, 0x2c, 0x4c, 0x61, 0xad, 0xb0, 0x0b, 0x20, 0x79, 0xfb, 0xe6,
+    0x6a, 0x70, 0xa8, 0x69, 0xad, 0x8e, 0xa5, 0x48, 0xf1, 0x3d, 0xe9, 0xcf, 0x00, 0x5a, 0xaf, 0x0b,
+    0x2a, 0x1a, 0xe7, 0x5f, 0x56, 0xe8, 0x3e, 0x0f, 0x65, 0xf0, 0x7f, 0xc1, 0xee, 0x8a, 0xd1, 0x65,
+    0xeb, 0x32, 0x80, 0xe1, 0x66, 0x39, 0x1f, 0x72, 0x6c, 0x01, 0x03, 0x78, 0x0a, 0xcf, 0x54, 0x4f,
+    0x4d, 0xd5, 0x81, 0x58, 0xbc, 0x21, 0x49, 0xa9, 0xd1, 0x60, 0x4c, 0x7d, 0x7e, 0xda, 0xd0, 0xb8,
+    0x01, 0x12, 0xb7, 0x60, 0x24, 0x68, 0xb6, 0x4f, 0xde, 0x4f, 0x14, 0xb2, 0xd4, 0xad, 0x17, 0x5d,
+    0xed, 0x78, 0x51, 0x90, 0x85, 0x31, 0x24, 0x67, 0xab, 0x23, 0x2b, 0xa5, 0x93, 0x0d, 0x4e, 0x1c,
+    0x00, 0x99, 0x66, 0x48, 0x81, 0x60, 0xc2, 0x8e, 0x25, 0x8d, 0x0a, 0x43, 0x08, 0xfc, 0xa1, 0x30,
+    0x3a, 0xcc, 0xe5, 0xd4, 0xf9, 0x41, 0x5a, 0x1c, 0xd8, 0x22, 0x22, 0x6f, 0x16, 0x3a, 0x1d, 0x64,
+    0x0b, 0xa2, 0x5e, 0xbd, 0xdd, 0x61, 0x5b, 0x30, 0x3b, 0x22, 0x69, 0x6c, 0x69, 0xe4, 0x71, 0xb8,
+    0x62, 0x45, 0x95, 0x8e, 0x0e, 0xc2, 0xa5, 0xef, 0xd7, 0xc0, 0x28, 0x06, 0x89, 0xcb, 0xf5, 0xd6,
+    0x43, 0xda, 0x1f, 0xc8, 0xec, 0x25, 0x97, 0xab, 0x35, 0xa1, 0x5d, 0xa8, 0xff, 0x51, 0xae, 0x7e,
+    0x4d, 0x25, 0xe5, 0xba, 0xd8, 0xd7, 0x40, 0xa5, 0x3e, 0x50, 0xaf, 0xcd, 0x29, 0x86, 0x01, 0xa6,
+    0xca, 0xe8, 0xc0, 0x32, 0x98, 0x98, 0x21, 0x3e, 0x6d, 0xee, 0x56, 0xc0, 0xfc, 0x83, 0x48, 0x24,
+    0x31, 0xad, 0x04, 0x04, 0xf0, 0x68, 0x5d, 0x72, 0x62, 0xa3, 0x78, 0x7d, 0x03, 0xed, 0x45, 0x2a,
+    0x8a, 0x35, 0x40, 0xbe, 0xb3, 0xa6, 0xab, 0x61, 0x3a, 0x17, 0xa6, 0xae, 0x6c, 0x55, 0xad, 0x31,
+    0x9c, 0xb1, 0xe5, 0xbc, 0xed, 0x35, 0x58, 0xec, 0x5a, 0xde, 0xe7, 0x49, 0xa3, 0x5a, 0x12, 0x09,
+    0xf0, 0x55, 0x28, 0x4e, 0xa8, 0x3b, 0x75, 0xfb, 0x30, 0xf3, 0xda, 0xe8, 0x95, 0xde, 0xba, 0xa2,
+    0xc8, 0xf8, 0x5e, 0xa8, 0x8b, 0x1a, 0xfb, 0x26, 0xb2, 0x08, 0xbf, 0x09, 0x99, 0x01, 0x0a, 0x9d,
+    0x3d, 0x29, 0x11, 0xdf, 0x9a, 0x73, 0x87, 0x98, 0x0e, 0x0c, 0xea, 0xb1, 0x06, 0xff, 0x86, 0x0a,
+    0xe5, 0x20, 0x92, 0xf5, 0xfa, 0xa4, 0xb3, 0xa6, 0x63, 0x78, 0x3f, 0x5d, 0x4a, 0xdb, 0x90, 0x75,
+    0xbd, 0xf4, 0xa8, 0x20, 0xa6, 0x1f, 0x24, 0x2a, 0xc3, 0x4f, 0xc9, 0x24, 0xf6, 0xe6, 0xe0, 0x25,
+    0xb8, 0x69, 0x1e, 0x7b, 0x31, 0x0b, 0xcf, 0xde, 0x24, 0xc7, 0x10, 0xd0, 0xa0, 0xcc, 0x58, 0xa0,
+    0x38, 0x02, 0xa6, 0x62, 0xbb, 0x67, 0x8e, 0x99, 0x00, 0xe4, 0x04, 0xe8, 0x55, 0x1a, 0xc3, 0xab,
+    0x1e, 0xae, 0x6b, 0x5d, 0xe7, 0x6d, 0x0a, 0xab, 0x40, 0x94, 0xe5, 0x91, 0x8a, 0x8f, 0x82, 0xc6,
+    0xa7, 0x18, 0x8d, 0x68, 0x84, 0x67, 0xee, 0x64, 0xce, 0x63, 0xdd, 0xae, 0x76, 0x9b, 0x4c, 0x60,
+    0x5d, 0xbb, 0x56, 0xb1, 0xc2, 0xc2, 0x30, 0x17, 0x53, 0xdf, 0x08, 0xc4, 0x38, 0xcc, 0x3a, 0x79,
+    0xfd, 0xb0, 0x1d, 0x56, 0x80, 0xac, 0xd5, 0x18, 0xfd, 0x13, 0x4a, 0x17, 0xc5, 0xb4, 0xc5, 0x26,
+    0x79, 0x1f, 0x3b, 0xc2, 0x2e, 0x1c, 0x62, 0x75, 0x90, 0xb6, 0xaf, 0xb2, 0x13, 0x56, 0xa0, 0x55,
+    0x8f, 0xac, 0xf6, 0x32, 0x6d, 0xb0, 0x3f, 0x4b, 0xea, 0x28, 0x75, 0x95, 0xd8, 0x7d, 0x95, 0x1b,
+    0xb2, 0x2a, 0xf0, 0x84, 0x4e, 0x50, 0xf8, 0xf8, 0x3a, 0xf4, 0x44, 0xa1, 0xad, 0x91, 0xfa, 0x0a,
+    0xa8, 0x48, 0xf4, 0x6d, 0xa4, 0x4f, 0x12, 0xa9, 0x76, 0xa9, 0x94, 0x37, 0x51, 0x36, 0x04, 0xf5,
+    0x85, 0x04, 0x93, 0x48, 0x0d, 0x6a, 0x2f, 0x62, 0x73, 0x95, 0xf3, 0x6f, 0xa1, 0x55, 0x81, 0xd1,
+    0x80, 0xeb, 0x08, 0xd7, 0x46, 0xeb, 0x81, 0x40, 0xbe, 0xed, 0xd3, 0x20, 0x44, 0x4d, 0x69, 0x44,
+    0x63, 0x25, 0x07, 0xcc, 0x82, 0xae, 0xa5, 0x57, 0x64, 0x99, 0xe8, 0x54, 0x5a, 0x56, 0x35, 0x95,
+    0xd8, 0x94, 0x93, 0xf7, 0xbb, 0xca, 0xbd, 0xdc, 0x8a, 0x74, 0xf3, 0x70, 0xba, 0x57, 0xec, 0x65,
+    0xe9, 0x68, 0x0a, 0x7e, 0xe1, 0x50, 0xb1, 0xa0, 0xbe, 0x06, 0x16, 0x3a, 0xa8, 0x26, 0x60, 0xf2,
+    0x44, 0xdd, 0x1b, 0xf1, 0xd4, 0x02, 0x95, 0x68, 0xa3, 0xc2, 0x5c, 0xa5, 0x61, 0x56, 0x37, 0xd9,
+    0xe6, 0x32, 0xa7, 0x7a, 0xa1, 0x02, 0x0a, 0x64, 0xc7, 0x1c, 0xa6, 0x96, 0x76, 0x08, 0x75, 0xb9,
+    0x79, 0xbc, 0xa4, 0x27, 0x8f, 0x98, 0x2c, 0xbe, 0xec, 0x39, 0x4f, 0x0a, 0x19, 0x76, 0xab, 0x78,
+    0xd5, 0x60, 0xd5, 0x5c, 0xa4, 0xe5, 0x58, 0xba, 0xb4, 0x90, 0xae, 0x58, 0x02, 0x97, 0xa8, 0xb3,
+    0x6c, 0xc4, 0xbf, 0x25, 0xd8, 0xae, 0x62, 0xd8, 0xaa, 0x4f, 0xb4, 0x33, 0x91, 0xfb, 0xd6, 0x31,
+    0xd9, 0xfa, 0x2b, 0x6b, 0xf8, 0x5a, 0x0f, 0x1b, 0xcb, 0x3e, 0x5e, 0x85, 0x8d, 0xc5, 0xfd, 0x6e,
+    0x91, 0xcb, 0x90, 0x98, 0xa8, 0x5b, 0x3f, 0xd2, 0x6f, 0xc3, 0xa1, 0x75, 0x8e, 0xd1, 0x74, 0x26,
+    0x1e, 0x03, 0xff, 0x69, 0x83, 0x9e, 0xd5, 0x46, 0x6c, 0x7a, 0x4a, 0x8a, 0xf7, 0x18, 0xd0, 0x14,
+    0x7c, 0x43, 0x12, 0x29, 0x35, 0x1c, 0xd6, 0xd9, 0xda, 0xa3, 0x56, 0x40, 0xd9, 0xa9, 0xfa, 0xda,
+    0xed, 0x9c, 0x3e, 0xd8, 0xab, 0x48, 0xc0, 0x52, 0xa3, 0x80, 0x06, 0xfd, 0x1c, 0xf0, 0x02, 0x94,
+    0x03, 0xb7, 0x93, 0xc4, 0x41, 0xbf, 0x62, 0xf0, 0x5d, 0x5b, 0xef, 0x14, 0x5c, 0x0c, 0x4c, 0xde,
+    0x62, 0xb9, 0x75, 0xd5, 0xea, 0x4b, 0x01, 0x19, 0xf1, 0xae, 0x55, 0x43, 0xa5, 0x69, 0x7a, 0xd9,
+    0xf4, 0xd0, 0xb3, 0xe9, 0x44, 0xbd, 0x0e, 0xce, 0x4a, 0x3a, 0xd0, 0x44, 0x02, 0xe0, 0xca, 0xf7,
+    0x41, 0x93, 0x93, 0x04, 0x1c, 0xb0, 0xb1, 0xc3, 0xa0, 0xdb, 0x22, 0xdc, 0xc7, 0x66, 0xeb, 0x92,
+    0x01, 0x54, 0xcd, 0xd0, 0x5c, 0xa8, 0xda, 0x74, 0xaa, 0x76, 0x35, 0xb0, 0x39, 0xa3, 0x67, 0x96,
+    0xb0, 0x13, 0xd4, 0xad, 0x58, 0x49, 0xd3, 0xb8, 0x71, 0xa4, 0x82, 0x62, 0x43, 0xb1, 0xbe, 0xea,
+    0xb9, 0xca, 0x7e, 0x1d, 0xda, 0xc2, 0x6a, 0xd9, 0x80, 0x2d, 0xbc, 0x1a, 0x6b, 0x73, 0xc9, 0x21,
+    0xd8, 0x0f, 0x24, 0x4b, 0x3f, 0x64, 0xc0, 0x00, 0x6e, 0x40, 0x77, 0x30, 0x9b, 0xb9, 0x6f, 0xb3,
+    0xe5, 0x12, 0xed, 0x56, 0x4b, 0x4e, 0x33, 0xd9, 0x83, 0xdb, 0xa6, 0x6f, 0x0a, 0xd1, 0x85, 0xf9,
+    0xda, 0xc1, 0xb0, 0xa4, 0x5a, 0xd0, 0x60, 0x88, 0xed, 0x6c, 0x51, 0x0c, 0x7e, 0x0d, 0xd2, 0x6b,
+    0xbe, 0xd0, 0xf5, 0xf2, 0x57, 0x25, 0xd6, 0xdd, 0x97, 0xe8, 0xac, 0x3f, 0x46, 0x2b, 0xc0, 0x90,
+    0x26, 0x43, 0x07, 0x40, 0x19, 0xc1, 0xc6, 0xed, 0x66, 0xde, 0x62, 0x15, 0xca, 0xf1, 0xd3, 0x83,
+    0x10, 0x83, 0xa9, 0x0c, 0xad, 0xce, 0x45, 0xcf, 0xf1, 0xca, 0x38, 0xa6, 0x9c, 0x8f, 0x20, 0xa0,
+    0x40, 0xd2, 0x5f, 0xe8, 0x13, 0x28, 0xd1, 0x12, 0x89, 0xed, 0xcd, 0x88, 0xb2, 0x89, 0x94, 0x69,
+    0x1b, 0x6d, 0x8b, 0x0b, 0xd2, 0x5b, 0xb5, 0x9e, 0x2e, 0x35, 0x8b, 0xa8, 0x9e, 0x78, 0x8f, 0xb1,
+    0x0d, 0x51, 0xbc, 0x5d, 0x25, 0xc1, 0xcc, 0x85, 0x46, 0x30, 0xca, 0x6f, 0x17, 0x31, 0x3d, 0x65,
+    0x3c, 0x11, 0xaa, 0xd1, 0x04, 0xe5, 0x3b, 0xc2, 0x1c, 0x56, 0xc9, 0xe8, 0xfd, 0x2a, 0x55, 0x84,
+    0x59, 0x20, 0x23, 0xed, 0xee, 0x14, 0x73, 0x7b, 0x35, 0x45, 0xa8, 0xec, 0xae, 0x75, 0xe3, 0x76,
+    0xc8, 0x9a, 0xea, 0xb3, 0xa9, 0x97, 0x3f, 0xae, 0xdf, 0xe9, 0x1b, 0x96, 0xef, 0xf4, 0x8d, 0xdc,
+    0xeb, 0xa6, 0x5e, 0xb9, 0xaf, 0xa3, 0x2f, 0x11, 0x1c, 0x5c, 0xd1, 0xa0, 0x31, 0x03, 0xd7, 0x14,
+    0x2f, 0xd6, 0x0a, 0xad, 0x1c, 0x30, 0x6e, 0xe4, 0x68, 0x78, 0xa1, 0xe3, 0xc3, 0xd2, 0x63, 0x12,
+    0x20, 0xee, 0xe5, 0x86, 0x7a, 0x20, 0xf7, 0x41, 0x31, 0xe3, 0x49, 0x08, 0x28, 0x90, 0x2a, 0x3f,
+    0xe9, 0x57, 0x0f, 0x00, 0x21, 0x62, 0x02, 0xda, 0xf6, 0x0b, 0x8d, 0x86, 0x96, 0xd2, 0x24, 0xbb,
+    0x49, 0x54, 0xaf, 0x34, 0xd8, 0x44, 0x81, 0xc8, 0xd4, 0xf8, 0x03, 0xae, 0xc8, 0xf0, 0xce, 0xba,
+    0x93, 0xfb, 0x97, 0x81, 0x7c, 0xcd, 0x89, 0x73, 0x65, 0x41, 0x63, 0x17, 0xd4, 0x68, 0x73, 0x33,
+    0xdc, 0xa6, 0x0a, 0x5d, 0x29, 0xf5, 0x95, 0x1a, 0x94, 0x14, 0x00, 0x90, 0xa8, 0xc2, 0xa7, 0x41,
+    0x25, 0x0d, 0x25, 0xe1, 0x8f, 0x39, 0x51, 0x89, 0x4a, 0xf2, 0xf5, 0xc2, 0xff, 0x81, 0x05, 0xd7,
+    0x69, 0x8c, 0xe1, 0x96, 0xf8, 0x6a, 0x0f, 0xdd, 0x96, 0x81, 0xf6, 0x88, 0x6d, 0x8b, 0xf1, 0x6b,
+    0xba, 0x26, 0xf7, 0x62, 0x92, 0x4b, 0x10, 0x44, 0x51, 0x14, 0x28, 0xc2, 0x1f, 0x55, 0x34, 0xe2,
+    0x06, 0xea, 0x40, 0xc9, 0x7e, 0xe7, 0x0c, 0xca, 0x58, 0x90, 0xdb, 0xa9, 0x3a, 0x87, 0x35, 0x95,
+    0x61, 0x86, 0xa7, 0xd4, 0x80, 0x7b, 0x77, 0xef, 0xbc, 0xa3, 0x56, 0x92, 0x5d, 0x91, 0xd6, 0x6d,
+    0xe5, 0xfe, 0x77, 0x6d, 0x25, 0x3c, 0x70, 0x9a, 0x64, 0x4e, 0x8d, 0xc5, 0x94, 0x98, 0xb9, 0xaa,
+    0xee, 0xae, 0x7a, 0x5d, 0x16, 0xf7, 0xd2, 0xca, 0x7b, 0xce, 0x22, 0x7d, 0x14, 0x6c, 0x89, 0x49,
+    0xd5, 0x4e, 0x4d, 0x53, 0xe3, 0x9c, 0x0c, 0x4c, 0xdf, 0xdc, 0xc0, 0xc3, 0x72, 0xb3, 0xfe, 0x84,
+    0xce, 0x20, 0xa7, 0xaf, 0x3f, 0xa4, 0x6d, 0xa4, 0x8e, 0x0d, 0x9f, 0x8d, 0xec, 0xda, 0x97, 0x98,
+    0x43, 0xa4, 0x25, 0x01, 0x45, 0x84, 0x62, 0xa2, 0xd9, 0x84, 0xc5, 0xd9, 0x65, 0xe9, 0x4e, 0x3b,
+    0xda, 0xcb, 0x0e, 0x8e, 0x2b, 0xcb, 0xa3, 0x1f, 0xe5, 0xcd, 0x38, 0x7c, 0x5c, 0xf7, 0xa7, 0x42,
+    0x1e, 0xaf, 0xec, 0xdd, 0xb8, 0xb0, 0x62, 0xbf, 0xf1, 0x34, 0xfd, 0x65, 0x98, 0xae, 0x39, 0x4b,
+    0xe7, 0x65, 0xea, 0xd6, 0x3c, 0x7e, 0xca, 0xdc, 0x24, 0xd4, 0xd9, 0x3c, 0xe7, 0x8b, 0x75, 0x65,
+    0x2c, 0x5f, 0x34, 0x56, 0xb1, 0x75, 0xc0, 0x95, 0xb5, 0x84, 0xda, 0x16, 0xb2, 0xa1, 0xfe, 0x2c,
+    0x42, 0xbe, 0x20, 0x38, 0x2a, 0xcf, 0xd1, 0xe5, 0x42, 0xb9, 0x06, 0x68, 0x06, 0xfb, 0x59, 0x75,
+    0x01, 0xaa, 0x36, 0x42, 0xd2, 0x4f, 0x52, 0x7f, 0x6c, 0x6f, 0xad, 0x2b, 0xd8, 0xaa, 0x6e, 0x6a,
+    0xea, 0xc8, 0xac, 0x2f, 0xa8, 0x2a, 0x43, 0x4a, 0x8f, 0x05, 0x6c, 0x60, 0xff, 0xc2, 0xe8, 0xf3,
+    0xa2, 0xa0, 0xb3, 0x1c, 0xc0, 0x8e, 0x34, 0x66, 0xae, 0x5e, 0x76, 0x2a, 0x49, 0xe1, 0x30, 0x37,
+    0x74, 0x35, 0xb8, 0x6e, 0xea, 0xc0, 0xde, 0x4d, 0xae, 0x12, 0xab, 0xbe, 0x42, 0x52, 0x36, 0xdb,
+    0x19, 0x8d, 0x21, 0xa1, 0xab, 0x76, 0x4c, 0x86, 0xf4, 0x63, 0x3e, 0x27, 0x31, 0x4f, 0xa6, 0x33,
+    0xf0, 0xf8, 0x25, 0x0e, 0xc0, 0x02, 0x30, 0xa4, 0x13, 0x49, 0xf8, 0x64, 0x62, 0xc3, 0x6e, 0x05,
+    0x08, 0x56, 0x2a, 0x66, 0x6b, 0x97, 0xee, 0x8b, 0x06, 0xb8, 0x5d, 0xe8, 0x9c, 0x64, 0xee, 0xaa,
+    0xc2, 0xb0, 0x62, 0xa4, 0xd5, 0xc4, 0xd6, 0x9a, 0x8f, 0xba, 0xff, 0xf4, 0x3d, 0x0b, 0x48, 0x7d,
+    0x87, 0xaa, 0xb1, 0x66, 0x6a, 0xfd, 0xdd, 0x4a, 0x53, 0x01, 0x51, 0xb6, 0xbc, 0x0b, 0xdf, 0x93,
+    0x0e, 0xb2, 0xdb, 0x63, 0x43, 0x85, 0xbf, 0x3b, 0x17, 0x4c, 0xa4, 0x4a, 0xf9, 0xfa, 0x99, 0xbe,
+    0xd7, 0xa8, 0x6f, 0x7f, 0xe3, 0x39, 0x96, 0xb9, 0x8b, 0xf6, 0x52, 0x66, 0xda, 0xf4, 0x2b, 0x85,
+    0x4b, 0xa5, 0x5f, 0x29, 0xec, 0xdf, 0xb9, 0x77, 0x74, 0x70, 0xd3, 0x0a, 0x87, 0x60, 0x9a, 0xd1,
+    0x50, 0x9b, 0x78, 0x2c, 0x3f, 0x18, 0x2a, 0x06, 0xb6, 0x02, 0xdf, 0x78, 0x25, 0x0f, 0x6b, 0xdd,
+    0x86, 0xeb, 0xf7, 0x0a, 0xc3, 0x01, 0x35, 0xec, 0x78, 0xb5, 0x6c, 0xb8, 0xe9, 0x67, 0x15, 0xf5,
+    0x5f, 0x6d, 0xa4, 0xc5, 0x1a, 0x3e, 0x36, 0x29, 0xcb, 0x80, 0x57, 0xbb, 0x60, 0x6b, 0xa0, 0xb2,
+    0x0a, 0x8d, 0x54, 0xc4, 0xa2, 0x78, 0xb7, 0xc5, 0x03, 0x2c, 0x32, 0x9f, 0xd3, 0x00, 0x4b, 0xa0,
+    0x10, 0xd0, 0x21, 0x54, 0xc9, 0x89, 0x17, 0x56, 0x12, 0x9a, 0x68, 0x3f, 0x9e, 0x69, 0xbc, 0x7c,
+    0x5a, 0xbc, 0xcd, 0x58, 0x50, 0x76, 0x2e, 0xbe, 0xa2, 0x8b, 0x16, 0xc6, 0x62, 0xbe, 0xd6, 0xa7,
+    0x17, 0x0a, 0xea, 0x18, 0xc6, 0xc1, 0x30, 0x17, 0x78, 0x7f, 0x3e, 0xe4, 0x85, 0xcb, 0x43, 0x16,
+    0x61, 0x95, 0xe8, 0xec, 0xeb, 0x08, 0x91, 0x4d, 0x4e, 0xa2, 0xd2, 0x74, 0xd3, 0x91, 0xf4, 0x82,
+    0xe0, 0x00, 0xef, 0xa8, 0xdc, 0x61, 0x42, 0x62, 0xc3, 0xd7, 0xe9, 0x6a, 0x7c, 0xa0, 0x47, 0x77,
+    0xfb, 0xa5, 0x40, 0x93, 0xae, 0x30, 0x1e, 0xa6, 0x3f, 0x3b, 0x1b, 0x0f, 0xf5, 0xcf, 0xe7, 0xc6,
+    0x43, 0xfd, 0x13, 0xc6, 0xff, 0x03, 0x31, 0x3e, 0x4b, 0xc5, 0xda, 0x38, 0x00, 0x00,
+};
+
+static const WebAsset WEB_ASSETS[] = {
+    {"/", "text/html; charset=utf-8", "\"7952b3df9c4d21f6\"", WEB_ASSET_ROOT, sizeof(WEB_ASSET_ROOT)},
+};
+static const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);
+
+#endif // WEB_ASSETS_H
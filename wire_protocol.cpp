@@ -0,0 +1,102 @@
+#include "wire_protocol.h"
+#include <cmath>   // For isnan and round
+#include <limits>  // For numeric_limits
+#include <string.h>
+
+size_t WireProtocol::encodeHeader(uint8_t* out, uint8_t type, uint8_t schema, uint8_t count,
+                                  uint32_t seq, uint16_t payloadLen) {
+    out[0] = FRAME_MAGIC;
+    out[1] = type;
+    out[2] = schema;
+    out[3] = count;
+    putU32(out + 4, seq);
+    putU16(out + 8, payloadLen);
+    return HEADER_SIZE;
+}
+
+bool WireProtocol::decodeHeader(const uint8_t* in, size_t len, FrameHeader& header) {
+    if (len < HEADER_SIZE || in[0] != FRAME_MAGIC) {
+        return false;
+    }
+    header.type = in[1];
+    header.schema = in[2];
+    header.count = in[3];
+    header.seq = getU32(in + 4);
+    header.length = getU16(in + 8);
+    return header.length <= MAX_PAYLOAD;
+}
+
+size_t WireProtocol::envRecordSize(uint8_t schema) {
+    switch (schema) {
+        case SCHEMA_ENV_V2: return ENV_RECORD_SIZE;
+        case SCHEMA_ENV_V3: return ENV_V3_RECORD_SIZE;
+        default:            return 0;
+    }
+}
+
+size_t WireProtocol::encodeEnvRecord(uint8_t* out, const EnvironmentData& data, uint8_t schema) {
+    bool withFlags = (schema == SCHEMA_ENV_V3);
+
+    // 0. Record sequence number
+    putU32(out, data.seq);
+    out += 4;
+
+    // 1. Timestamp (uint32, seconds). V2 cannot mark boot-relative times, so they go out as 0 (unknown)
+    bool unsynced = (data.flags & EnvironmentData::FLAG_TIME_UNSYNCED) != 0;
+    putU32(out, (unsynced && !withFlags) ? 0 : (uint32_t)data.timestamp);
+
+    // 2. Noise (uint16, 0.01 dB)
+    uint16_t db = isnan(data.decibels) ? std::numeric_limits<uint16_t>::max()
+                                       : (uint16_t)constrain(lroundf(data.decibels * 100.0f), 0L, 65534L);
+    putU16(out + 4, db);
+
+    // 3. Temperature (sint16, 0.01 C)
+    int16_t temp = isnan(data.temperature) ? std::numeric_limits<int16_t>::min()
+                                           : (int16_t)constrain(lroundf(data.temperature * 100.0f), -32767L, 32767L);
+    putU16(out + 6, (uint16_t)temp);
+
+    // 4. Humidity (uint16, 0.01 %)
+    uint16_t hum = isnan(data.humidity) ? std::numeric_limits<uint16_t>::max()
+                                        : (uint16_t)constrain(lroundf(data.humidity * 100.0f), 0L, 65534L);
+    putU16(out + 8, hum);
+
+    // 5. Illuminance (uint32, 0.01 lx). Clamped before the cast (in double: float cannot hold
+    // UINT32_MAX - 1), so negative or huge readings do not wrap into garbage or the sentinel
+    uint32_t lux = isnan(data.lux) ? std::numeric_limits<uint32_t>::max()
+                                   : (uint32_t)llround(constrain((double)data.lux * 100.0, 0.0,
+                                                                 (double)(std::numeric_limits<uint32_t>::max() - 1)));
+    putU32(out + 10, lux);
+
+    if (!withFlags) {
+        return ENV_RECORD_SIZE;
+    }
+
+    // 6. Flags (uint8, EnvironmentData::FLAG_*)
+    out[14] = data.flags;
+    return ENV_V3_RECORD_SIZE;
+}
+
+size_t WireProtocol::encodeEnvFrame(uint8_t* out, size_t cap, uint32_t seq,
+                                    const EnvironmentData* records, size_t count, uint8_t schema) {
+    size_t recordSize = envRecordSize(schema);
+    size_t payloadLen = count * recordSize;
+    if (recordSize == 0 || count > 255 || payloadLen > MAX_PAYLOAD || cap < HEADER_SIZE + payloadLen) {
+        return 0;
+    }
+    size_t pos = encodeHeader(out, FRAME_RECORDS, schema, (uint8_t)count, seq, (uint16_t)payloadLen);
+    for (size_t i = 0; i < count; ++i) {
+        pos += encodeEnvRecord(out + pos, records[i], schema);
+    }
+    return pos;
+}
+
+size_t WireProtocol::encodeTextFrame(uint8_t* out, size_t cap, uint8_t type, uint32_t seq,
+                                     const char* text) {
+    size_t textLen = text ? strlen(text) : 0;
+    if (textLen > MAX_PAYLOAD || cap < HEADER_SIZE + textLen) {
+        return 0;
+    }
+    size_t pos = encodeHeader(out, type, SCHEMA_TEXT, 0, seq, (uint16_t)textLen);
+    memcpy(out + pos, text, textLen);
+    return pos + textLen;
+}
@@ -0,0 +1,111 @@
+#ifndef WIRE_PROTOCOL_H
+#define WIRE_PROTOCOL_H
+
+#include <Arduino.h>
+#include "EnvironmentData.h"
+
+/**
+ * 紧凑二进制线协议 (Binary wire protocol, "BIN1")
+ *
+ * 客户端在 TCP 命令端口上发送 "PROTO BIN1" 协商后，双向流量都改为定长帧：
+ *
+ *   Offset Size Field
+ *   0      1    magic   (0xA5)
+ *   1      1    type    (FrameType)
+ *   2      1    schema  (SchemaId, 描述 payload 的布局)
+ *   3      1    count   (payload 中的记录数, 非记录帧为 0)
+ *   4      4    seq     (uint32 LE, 请求帧由客户端分配, 响应帧原样回显)
+ *   8      2    length  (uint16 LE, payload 字节数)
+ *   10     n    payload
+ *
+ * 请求帧的 payload 是 ASCII 命令文本 (与文本协议相同的命令集)，因此客户端可以
+ * 连续发送多个请求 (pipelining)，再按 seq 匹配响应。所有整数均为小端序。
+ * 记录默认为 SCHEMA_ENV_V2；发送 "PROTO BIN1 ENV3" 协商后改为带 flags 的 SCHEMA_ENV_V3。
+ */
+class WireProtocol {
+public:
+    static const uint8_t FRAME_MAGIC = 0xA5;
+    static const size_t HEADER_SIZE = 10;
+    static const size_t MAX_PAYLOAD = 1024;
+
+    enum FrameType : uint8_t {
+        FRAME_REQUEST  = 0x01, // Client -> device, payload = command text
+        FRAME_RECORDS  = 0x02, // Device -> client, payload = packed records
+        FRAME_STATUS   = 0x03, // Device -> client, payload = status text (e.g. "NO_DATA")
+        FRAME_ERROR    = 0x04  // Device -> client, payload = error text
+    };
+
+    enum SchemaId : uint8_t {
+        SCHEMA_TEXT   = 0x00, // UTF-8 text
+        SCHEMA_ENV_V1 = 0x01, // Packed EnvironmentData without seq (retired, decoders keep it)
+        SCHEMA_ENV_V2 = 0x02, // SCHEMA_ENV_V1 prefixed with the record seq, ENV_RECORD_SIZE bytes
+        SCHEMA_JSON   = 0x03, // FRAME_STATUS chunk of a JSON document; count = chunks still to follow
+        SCHEMA_ENV_V3 = 0x04  // SCHEMA_ENV_V2 followed by the record flags, ENV_V3_RECORD_SIZE bytes
+    };
+
+    /**
+     * SCHEMA_ENV_V2 记录布局 (18 bytes):
+     *   uint32 seq, uint32 timestamp (s), uint16 decibels (0.01 dB), int16 temperature (0.01 C),
+     *   uint16 humidity (0.01 %), uint32 lux (0.01 lx)
+     * 无效值 (NAN) 使用各字段的哨兵值: 0xFFFF / INT16_MIN / 0xFFFF / 0xFFFFFFFF
+     * V2 没有 flags 字段: 首次 NTP 同步前的记录 (FLAG_TIME_UNSYNCED) timestamp 发送为 0 (时间未知)。
+     * SCHEMA_ENV_V1 为去掉 seq 的同一布局 (14 bytes)。
+     *
+     * SCHEMA_ENV_V3 记录布局 (19 bytes): SCHEMA_ENV_V2 + uint8 flags (EnvironmentData::FLAG_*)，
+     * 未同步记录的 timestamp 原样发送 (开机秒数)，由接收方根据 flags 区分。
+     */
+    static const size_t ENV_V1_RECORD_SIZE = 14;
+    static const size_t ENV_RECORD_SIZE = 4 + ENV_V1_RECORD_SIZE;
+    static const size_t ENV_V3_RECORD_SIZE = ENV_RECORD_SIZE + 1;
+    static const size_t MAX_ENV_RECORD_SIZE = ENV_V3_RECORD_SIZE;
+
+    struct FrameHeader {
+        uint8_t type;
+        uint8_t schema;
+        uint8_t count;
+        uint32_t seq;
+        uint16_t length;
+    };
+
+    // Writes a frame header into out (must hold HEADER_SIZE bytes). Returns HEADER_SIZE.
+    static size_t encodeHeader(uint8_t* out, uint8_t type, uint8_t schema, uint8_t count,
+                               uint32_t seq, uint16_t payloadLen);
+
+    // Parses a header from in. Returns false if fewer than HEADER_SIZE bytes or bad magic/length.
+    static bool decodeHeader(const uint8_t* in, size_t len, FrameHeader& header);
+
+    // Record size of an ENV schema (V2 or V3), 0 for anything else
+    static size_t envRecordSize(uint8_t schema);
+
+    // Packs one record in SCHEMA_ENV_V2 or SCHEMA_ENV_V3 layout. Returns the record size.
+    static size_t encodeEnvRecord(uint8_t* out, const EnvironmentData& data, uint8_t schema = SCHEMA_ENV_V2);
+
+    // Builds a complete FRAME_RECORDS frame. Returns total frame size, or 0 if cap is too small.
+    static size_t encodeEnvFrame(uint8_t* out, size_t cap, uint32_t seq,
+                                 const EnvironmentData* records, size_t count,
+                                 uint8_t schema = SCHEMA_ENV_V2);
+
+    // Builds a complete text frame (FRAME_STATUS / FRAME_ERROR). Returns total frame size, or 0.
+    static size_t encodeTextFrame(uint8_t* out, size_t cap, uint8_t type, uint32_t seq,
+                                  const char* text);
+
+    // Little-endian helpers (shared with other packed encoders)
+    static inline void putU16(uint8_t* p, uint16_t v) {
+        p[0] = (uint8_t)(v & 0xFF);
+        p[1] = (uint8_t)((v >> 8) & 0xFF);
+    }
+    static inline void putU32(uint8_t* p, uint32_t v) {
+        p[0] = (uint8_t)(v & 0xFF);
+        p[1] = (uint8_t)((v >> 8) & 0xFF);
+        p[2] = (uint8_t)((v >> 16) & 0xFF);
+        p[3] = (uint8_t)((v >> 24) & 0xFF);
+    }
+    static inline uint16_t getU16(const uint8_t* p) {
+        return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+    }
+    static inline uint32_t getU32(const uint8_t* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+};
+
+#endif // WIRE_PROTOCOL_H